@@ -0,0 +1,42 @@
+#include <dlr_compressed_params.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "dmlc/logging.h"
+
+/*! \brief Converts a TVM .params file into a chunked .params.zst or .params.lz4 file which DLR
+ * decompresses in parallel at load time.
+ */
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    LOG(FATAL) << "Usage: " << argv[0] << " <in.params> <out.params.zst|out.params.lz4>"
+               << " [chunk_kb] [level]";
+    return 1;
+  }
+  const std::string in_path(argv[1]);
+  const std::string out_path(argv[2]);
+  const size_t chunk_bytes = (argc >= 4 ? std::atol(argv[3]) : 1024) * 1024;
+  const int level = argc >= 5 ? std::atoi(argv[4]) : 0;
+  const dlr::ParamsCodec codec = dlr::GetParamsCodecFromFilename(out_path);
+  if (!dlr::IsParamsCodecSupported(codec)) {
+    LOG(FATAL) << "libdlr was built without support for the codec of " << out_path
+               << ". Rebuild with -DUSE_ZSTD=ON or -DUSE_LZ4=ON.";
+    return 1;
+  }
+
+  const std::string params = dlr::LoadFileToString(in_path, std::ios::in | std::ios::binary);
+  const std::string compressed = dlr::CompressParams(
+      dlr::ParseParams(params.data(), params.size()), codec, chunk_bytes, level);
+  std::ofstream out(out_path, std::ios::out | std::ios::binary);
+  out.write(compressed.data(), compressed.size());
+  if (!out) {
+    LOG(FATAL) << "Could not write " << out_path;
+    return 1;
+  }
+  std::cout << in_path << ": " << params.size() << " bytes -> " << out_path << ": "
+            << compressed.size() << " bytes" << std::endl;
+  return 0;
+}
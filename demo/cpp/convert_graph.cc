@@ -0,0 +1,39 @@
+#include <dlr_binary_graph.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "dmlc/logging.h"
+
+/*! \brief Encodes the graph JSON and metadata of a TVM model folder into a binary graph file,
+ * written next to the graph JSON, which DLR loads without JSON parsing.
+ */
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    LOG(FATAL) << "Usage: " << argv[0] << " <model dir>";
+    return 1;
+  }
+  dlr::ModelPath path;
+  dlr::InitModelPath(dlr::FindFiles({argv[1]}), &path);
+  if (path.model_json.empty()) {
+    LOG(FATAL) << "No graph JSON was found in " << argv[1];
+    return 1;
+  }
+  const std::string graph_json = dlr::LoadFileToString(path.model_json);
+  const std::string metadata_json =
+      path.metadata.empty() ? "" : dlr::LoadFileToString(path.metadata);
+  const std::string binary = dlr::ConvertGraphToBinary(graph_json, metadata_json);
+
+  const std::string out_path =
+      path.model_json.substr(0, path.model_json.size() - 5) + dlr::BINARY_GRAPH_EXT;
+  std::ofstream out(out_path, std::ios::out | std::ios::binary);
+  out.write(binary.data(), binary.size());
+  if (!out) {
+    LOG(FATAL) << "Could not write " << out_path;
+    return 1;
+  }
+  std::cout << path.model_json << ": " << graph_json.size() << " bytes -> " << out_path << ": "
+            << binary.size() << " bytes" << std::endl;
+  return 0;
+}
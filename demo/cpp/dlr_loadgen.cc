@@ -0,0 +1,258 @@
+#include <dlr.h>
+#include <dlr_data_convert.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dmlc/logging.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadgenOptions {
+  std::string model_dir;
+  int device_type = 1;
+  int threads = 1;
+  int instances = 1;
+  double duration = 10.0;
+  // Empty for closed-loop runs.
+  std::vector<double> qps;
+  unsigned int seed = 0;
+};
+
+/*! \brief A model instance with synthetic inputs. Threads sharing an instance take turns. */
+struct Instance {
+  DLRModelHandle model = NULL;
+  std::mutex mutex;
+};
+
+/*! \brief Result of a run at one load: the number of requests completed and their latencies. */
+struct LoadPoint {
+  std::string load;
+  double elapsed;
+  std::vector<double> latencies;
+};
+
+void print_usage(const char* name) {
+  LOG(FATAL) << "Usage: " << name
+             << " <model dir> [--device=cpu|gpu|opencl] [--threads=N] [--instances=N]"
+                " [--duration=seconds] [--qps=Q1,Q2,...] [--seed=N]";
+}
+
+LoadgenOptions parse_options(int argc, char** argv) {
+  if (argc < 2) print_usage(argv[0]);
+  LoadgenOptions options;
+  options.model_dir = argv[1];
+  for (int i = 2; i < argc; i++) {
+    const std::string arg(argv[i]);
+    const size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) print_usage(argv[0]);
+    const std::string key = arg.substr(2, eq - 2);
+    const std::string value = arg.substr(eq + 1);
+    if (key == "device") {
+      if (value == "cpu") {
+        options.device_type = 1;
+      } else if (value == "gpu") {
+        options.device_type = 2;
+      } else if (value == "opencl") {
+        options.device_type = 4;
+      } else {
+        LOG(FATAL) << "Unsupported device type!";
+      }
+    } else if (key == "threads") {
+      options.threads = std::max(1, std::atoi(value.c_str()));
+    } else if (key == "instances") {
+      options.instances = std::max(1, std::atoi(value.c_str()));
+    } else if (key == "duration") {
+      options.duration = std::max(0.1, std::atof(value.c_str()));
+    } else if (key == "qps") {
+      std::stringstream ss(value);
+      std::string item;
+      while (std::getline(ss, item, ',')) {
+        const double qps = std::atof(item.c_str());
+        if (qps <= 0) LOG(FATAL) << "Invalid target QPS: " << item;
+        options.qps.push_back(qps);
+      }
+    } else if (key == "seed") {
+      options.seed = static_cast<unsigned int>(std::strtoul(value.c_str(), nullptr, 10));
+    } else {
+      print_usage(argv[0]);
+    }
+  }
+  return options;
+}
+
+/*! \brief Sets every input of the model to random data of its shape and type. Dynamic dimensions
+ * are set to 1. Floats are uniform in [0, 1) and integers are 0, a valid index for embeddings.
+ */
+void set_synthetic_inputs(DLRModelHandle model, std::mt19937* rng) {
+  int num_inputs;
+  if (GetDLRNumInputs(&model, &num_inputs) != 0) LOG(FATAL) << DLRGetLastError();
+  for (int i = 0; i < num_inputs; i++) {
+    const char* name;
+    const char* type;
+    int64_t size;
+    int dim;
+    if (GetDLRInputName(&model, i, &name) != 0 || GetDLRInputType(&model, i, &type) != 0 ||
+        GetDLRInputSizeDim(&model, i, &size, &dim) != 0) {
+      LOG(FATAL) << DLRGetLastError();
+    }
+    std::vector<int64_t> shape(dim);
+    if (GetDLRInputShape(&model, i, shape.data()) != 0) LOG(FATAL) << DLRGetLastError();
+    size = 1;
+    for (int64_t& d : shape) {
+      if (d < 0) d = 1;
+      size *= d;
+    }
+
+    const DLDataType dtype = dlr::GetDLDataTypeFromString(type);
+    std::vector<float> values(size, 0.0f);
+    if (dtype.code == kDLFloat || dtype.code == kDLBfloat) {
+      std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+      for (float& v : values) v = dist(*rng);
+    }
+    std::vector<char> data(size * ((dtype.bits * dtype.lanes + 7) / 8), 0);
+    if (dlr::IsConvertibleDLDataType(dtype)) {
+      dlr::ConvertData(values.data(), {kDLFloat, 32, 1}, data.data(), dtype, size);
+    }
+    if (SetDLRInput(&model, name, shape.data(), data.data(), dim) != 0) {
+      LOG(FATAL) << DLRGetLastError();
+    }
+  }
+}
+
+/*! \brief Runs the model of the instance and returns the latency from start, in milliseconds. */
+double run_request(Instance* instance, Clock::time_point start) {
+  std::lock_guard<std::mutex> lock(instance->mutex);
+  if (RunDLRModel(&instance->model) != 0) LOG(FATAL) << DLRGetLastError();
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/*! \brief Closed loop: each of the threads sends its next request as soon as the previous one
+ * completes, for the duration.
+ */
+LoadPoint run_closed_loop(std::vector<std::unique_ptr<Instance>>& instances, int threads,
+                          double duration) {
+  std::vector<std::vector<double>> latencies(threads);
+  const Clock::time_point begin = Clock::now();
+  const Clock::time_point end =
+      begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      Instance* instance = instances[t % instances.size()].get();
+      while (Clock::now() < end) {
+        latencies[t].push_back(run_request(instance, Clock::now()));
+      }
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+
+  LoadPoint point;
+  point.load = std::to_string(threads) + " threads";
+  point.elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+  for (const auto& l : latencies) point.latencies.insert(point.latencies.end(), l.begin(), l.end());
+  return point;
+}
+
+/*! \brief Open loop: requests arrive as a Poisson process of rate qps for the duration, whether or
+ * not earlier ones completed. Latencies are measured from the arrival, so they include the time a
+ * request waits for a free thread.
+ */
+LoadPoint run_open_loop(std::vector<std::unique_ptr<Instance>>& instances, int threads,
+                        double duration, double qps, std::mt19937* rng) {
+  std::vector<Clock::time_point> arrivals;
+  std::exponential_distribution<double> interval(qps);
+  const Clock::time_point begin = Clock::now();
+  for (double t = interval(*rng); t < duration; t += interval(*rng)) {
+    arrivals.push_back(begin + std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>(t)));
+  }
+
+  std::vector<std::vector<double>> latencies(threads);
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      Instance* instance = instances[t % instances.size()].get();
+      for (size_t i = next++; i < arrivals.size(); i = next++) {
+        std::this_thread::sleep_until(arrivals[i]);
+        latencies[t].push_back(run_request(instance, arrivals[i]));
+      }
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+
+  LoadPoint point;
+  std::ostringstream load;
+  load << qps << " qps";
+  point.load = load.str();
+  point.elapsed = std::max(duration, std::chrono::duration<double>(Clock::now() - begin).count());
+  for (const auto& l : latencies) point.latencies.insert(point.latencies.end(), l.begin(), l.end());
+  return point;
+}
+
+/*! \brief Nearest-rank percentile of sorted latencies. */
+double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+void print_point(LoadPoint* point) {
+  std::sort(point->latencies.begin(), point->latencies.end());
+  const std::vector<double>& l = point->latencies;
+  std::cout << std::setw(14) << point->load << std::setw(10) << l.size() << std::setw(12)
+            << l.size() / point->elapsed;
+  for (double p : {50.0, 90.0, 99.0, 99.9}) std::cout << std::setw(10) << percentile(l, p);
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+  const LoadgenOptions options = parse_options(argc, argv);
+  std::mt19937 rng(options.seed);
+
+  std::vector<std::unique_ptr<Instance>> instances;
+  for (int i = 0; i < options.instances; i++) {
+    instances.emplace_back(new Instance());
+    if (CreateDLRModel(&instances.back()->model, options.model_dir.c_str(), options.device_type,
+                       0) != 0) {
+      LOG(FATAL) << DLRGetLastError();
+    }
+    set_synthetic_inputs(instances.back()->model, &rng);
+    // Warm up, the first run allocates and initializes lazily.
+    run_request(instances.back().get(), Clock::now());
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(14) << "load" << std::setw(10) << "requests" << std::setw(12) << "qps"
+            << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms"
+            << std::setw(10) << "p99.9 ms" << std::endl;
+  if (options.qps.empty()) {
+    // Closed loop, doubling the number of threads up to the maximum.
+    for (int threads = 1;; threads = std::min(2 * threads, options.threads)) {
+      LoadPoint point = run_closed_loop(instances, threads, options.duration);
+      print_point(&point);
+      if (threads == options.threads) break;
+    }
+  } else {
+    for (double qps : options.qps) {
+      LoadPoint point = run_open_loop(instances, options.threads, options.duration, qps, &rng);
+      print_point(&point);
+    }
+  }
+
+  for (auto& instance : instances) DeleteDLRModel(&instance->model);
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include <dlr.h>
+#include <dlr_serve.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif  // _WIN32
+
+#include "dmlc/logging.h"
+
+struct ServeOptions {
+  std::string socket_path;
+  // Name and directory of each model.
+  std::vector<std::pair<std::string, std::string>> models;
+  int device_type = 1;
+  // 0 to use the tuned config of the model, or 1.
+  int instances = 0;
+  int64_t max_batch = 1;
+  int batch_timeout_us = 0;
+};
+
+void print_usage(const char* name) {
+  LOG(FATAL) << "Usage: " << name
+             << " --socket=PATH <name>=<model dir> [<name>=<model dir> ...]"
+                " [--device=cpu|gpu|opencl] [--instances=N] [--max-batch=N]"
+                " [--batch-timeout-us=N]";
+}
+
+ServeOptions parse_options(int argc, char** argv) {
+  ServeOptions options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg(argv[i]);
+    const size_t eq = arg.find('=');
+    if (eq == std::string::npos || eq == 0) print_usage(argv[0]);
+    if (arg.compare(0, 2, "--") != 0) {
+      options.models.emplace_back(arg.substr(0, eq), arg.substr(eq + 1));
+      continue;
+    }
+    const std::string key = arg.substr(2, eq - 2);
+    const std::string value = arg.substr(eq + 1);
+    if (key == "socket") {
+      options.socket_path = value;
+    } else if (key == "device") {
+      if (value == "cpu") {
+        options.device_type = 1;
+      } else if (value == "gpu") {
+        options.device_type = 2;
+      } else if (value == "opencl") {
+        options.device_type = 4;
+      } else {
+        LOG(FATAL) << "Unsupported device type!";
+      }
+    } else if (key == "instances") {
+      options.instances = std::max(1, std::atoi(value.c_str()));
+    } else if (key == "max-batch") {
+      options.max_batch = std::max(1, std::atoi(value.c_str()));
+    } else if (key == "batch-timeout-us") {
+      options.batch_timeout_us = std::max(0, std::atoi(value.c_str()));
+    } else {
+      print_usage(argv[0]);
+    }
+  }
+  if (options.socket_path.empty() || options.models.empty()) print_usage(argv[0]);
+  return options;
+}
+
+/*! \brief Create a model owned by a DLRModelPtr. */
+dlr::DLRModelPtr create_model(const std::string& model_dir, int device_type) {
+  DLRModelHandle handle = NULL;
+  if (CreateDLRModel(&handle, model_dir.c_str(), device_type, 0) != 0) {
+    LOG(FATAL) << DLRGetLastError();
+  }
+  return dlr::DLRModelPtr(static_cast<dlr::DLRModel*>(handle), [](dlr::DLRModel* model) {
+    DLRModelHandle handle = model;
+    DeleteDLRModel(&handle);
+  });
+}
+
+int main(int argc, char** argv) {
+  const ServeOptions options = parse_options(argc, argv);
+#ifndef _WIN32
+  // Blocked before any thread starts, so that only sigwait() below sees them.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+#endif  // _WIN32
+
+  dlr::ModelServer server;
+  for (const auto& model : options.models) {
+    int instances = options.instances;
+    if (instances == 0) {
+      int threads;
+      int64_t batch_size;
+      if (GetDLRTunedConfig(model.second.c_str(), &instances, &threads, &batch_size) != 0) {
+        instances = 1;
+      }
+    }
+    std::vector<dlr::DLRModelPtr> models;
+    for (int i = 0; i < instances; i++) {
+      models.push_back(create_model(model.second, options.device_type));
+    }
+    server.AddModel(model.first, models, options.max_batch, options.batch_timeout_us);
+    std::cout << "Serving " << model.first << " from " << model.second << " with " << instances
+              << " instances" << std::endl;
+  }
+  server.Start(options.socket_path);
+  std::cout << "Listening on " << options.socket_path << std::endl;
+
+#ifndef _WIN32
+  int signum;
+  sigwait(&signals, &signum);
+#else
+  std::cout << "Press enter to stop" << std::endl;
+  std::cin.get();
+#endif  // _WIN32
+  server.Stop();
+  return 0;
+}
@@ -0,0 +1,240 @@
+#include <dlr_data_convert.h>
+#include <dlr_serve.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+#include "dmlc/logging.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+  // Either a dlr_serve socket and a model served by it, or an MMS endpoint.
+  std::string socket_path;
+  std::string model;
+  std::string mms;
+  std::string path = "/invocations";
+  std::string payload;
+  std::string content_type = "application/x-npy";
+  int threads = 1;
+  double duration = 10.0;
+};
+
+/*! \brief A client sending requests one at a time. */
+class Client {
+ public:
+  virtual ~Client() = default;
+  virtual void Request() = 0;
+};
+
+void print_usage(const char* name) {
+  LOG(FATAL) << "Usage: " << name
+             << " (--socket=PATH --model=NAME | --mms=HOST:PORT --payload=FILE"
+                " [--path=/invocations] [--content-type=TYPE]) [--threads=N]"
+                " [--duration=seconds]";
+}
+
+BenchOptions parse_options(int argc, char** argv) {
+  BenchOptions options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg(argv[i]);
+    const size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) print_usage(argv[0]);
+    const std::string key = arg.substr(2, eq - 2);
+    const std::string value = arg.substr(eq + 1);
+    if (key == "socket") {
+      options.socket_path = value;
+    } else if (key == "model") {
+      options.model = value;
+    } else if (key == "mms") {
+      options.mms = value;
+    } else if (key == "path") {
+      options.path = value;
+    } else if (key == "payload") {
+      options.payload = value;
+    } else if (key == "content-type") {
+      options.content_type = value;
+    } else if (key == "threads") {
+      options.threads = std::max(1, std::atoi(value.c_str()));
+    } else if (key == "duration") {
+      options.duration = std::max(0.1, std::atof(value.c_str()));
+    } else {
+      print_usage(argv[0]);
+    }
+  }
+  const bool serve = !options.socket_path.empty() && !options.model.empty();
+  const bool mms = !options.mms.empty() && !options.payload.empty();
+  if (serve == mms) print_usage(argv[0]);
+  return options;
+}
+
+#ifndef _WIN32
+/*! \brief Requests to dlr_serve, with zeros for inputs. Dynamic dimensions are set to 1. */
+class ServeBenchClient : public Client {
+ public:
+  ServeBenchClient(const std::string& socket_path, const std::string& model)
+      : client_(socket_path), model_(model) {
+    for (const dlr::ServeTensorInfo& input : client_.GetModelInfo(model).inputs) {
+      dlr::ServeTensor tensor;
+      tensor.shape = input.shape;
+      int64_t size = 1;
+      for (int64_t& d : tensor.shape) {
+        if (d < 0) d = 1;
+        size *= d;
+      }
+      const DLDataType dtype = dlr::GetDLDataTypeFromString(input.dtype);
+      tensor.data.resize(size * ((dtype.bits * dtype.lanes + 7) / 8), 0);
+      inputs_.push_back(tensor);
+    }
+  }
+  void Request() override { client_.Infer(model_, inputs_); }
+
+ private:
+  dlr::ServeClient client_;
+  std::string model_;
+  std::vector<dlr::ServeTensor> inputs_;
+};
+
+/*! \brief HTTP/1.1 POSTs of a payload over a keep-alive connection, as sent to MMS. */
+class HttpBenchClient : public Client {
+ public:
+  HttpBenchClient(const std::string& endpoint, const std::string& path,
+                  const std::string& content_type, const std::string& payload) {
+    const size_t colon = endpoint.rfind(':');
+    if (colon == std::string::npos) LOG(FATAL) << "Expected HOST:PORT, got " << endpoint;
+    const std::string host = endpoint.substr(0, colon);
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses;
+    if (getaddrinfo(host.c_str(), endpoint.substr(colon + 1).c_str(), &hints, &addresses) != 0) {
+      LOG(FATAL) << "Could not resolve " << endpoint;
+    }
+    fd_ = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+    if (fd_ < 0 || connect(fd_, addresses->ai_addr, addresses->ai_addrlen) != 0) {
+      LOG(FATAL) << "Could not connect to " << endpoint << ": " << strerror(errno);
+    }
+    freeaddrinfo(addresses);
+    std::ostringstream request;
+    request << "POST " << path << " HTTP/1.1\r\nHost: " << host
+            << "\r\nConnection: keep-alive\r\nContent-Type: " << content_type
+            << "\r\nContent-Length: " << payload.size() << "\r\n\r\n"
+            << payload;
+    request_ = request.str();
+  }
+  ~HttpBenchClient() override { close(fd_); }
+
+  void Request() override {
+    for (size_t sent = 0; sent < request_.size();) {
+      const ssize_t ret = send(fd_, request_.data() + sent, request_.size() - sent, 0);
+      if (ret <= 0) LOG(FATAL) << "Could not send a request: " << strerror(errno);
+      sent += ret;
+    }
+    // Read the headers, then as many bytes as the Content-Length.
+    size_t end;
+    while ((end = buffer_.find("\r\n\r\n")) == std::string::npos) Receive();
+    const std::string headers = buffer_.substr(0, end);
+    if (headers.compare(0, 12, "HTTP/1.1 200") != 0) {
+      LOG(FATAL) << "Request failed: " << headers.substr(0, headers.find("\r\n"));
+    }
+    std::string lower = headers;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    const size_t length = lower.find("\r\ncontent-length:");
+    if (length == std::string::npos) LOG(FATAL) << "Response has no Content-Length";
+    const size_t size = end + 4 + std::strtoul(lower.c_str() + length + 17, nullptr, 10);
+    while (buffer_.size() < size) Receive();
+    buffer_.erase(0, size);
+  }
+
+ private:
+  int fd_;
+  std::string request_;
+  std::string buffer_;
+  void Receive() {
+    char data[65536];
+    const ssize_t ret = recv(fd_, data, sizeof(data), 0);
+    if (ret <= 0) LOG(FATAL) << "Connection closed by the server";
+    buffer_.append(data, ret);
+  }
+};
+#endif  // _WIN32
+
+/*! \brief Nearest-rank percentile of sorted latencies. */
+double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+int main(int argc, char** argv) {
+  const BenchOptions options = parse_options(argc, argv);
+  std::string payload;
+  if (!options.payload.empty()) {
+    std::ifstream file(options.payload, std::ios::binary);
+    if (!file) LOG(FATAL) << "Could not open " << options.payload;
+    payload.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  // Closed loop: each thread sends its next request as soon as the previous one completes.
+  std::vector<std::unique_ptr<Client>> clients;
+  for (int t = 0; t < options.threads; t++) {
+#ifndef _WIN32
+    if (options.mms.empty()) {
+      clients.emplace_back(new ServeBenchClient(options.socket_path, options.model));
+    } else {
+      clients.emplace_back(
+          new HttpBenchClient(options.mms, options.path, options.content_type, payload));
+    }
+#else
+    LOG(FATAL) << "Benchmarks are not supported on this platform";
+#endif  // _WIN32
+    // Warm up, the first requests allocate on both sides.
+    clients.back()->Request();
+  }
+  std::vector<std::vector<double>> latencies(options.threads);
+  const Clock::time_point begin = Clock::now();
+  const Clock::time_point end = begin + std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(options.duration));
+  std::vector<std::thread> workers;
+  for (int t = 0; t < options.threads; t++) {
+    workers.emplace_back([&, t]() {
+      while (Clock::now() < end) {
+        const Clock::time_point start = Clock::now();
+        clients[t]->Request();
+        latencies[t].push_back(
+            std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+      }
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+  const double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+  std::vector<double> all;
+  for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(10) << "requests" << std::setw(12) << "qps" << std::setw(10) << "p50 ms"
+            << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms" << std::endl;
+  std::cout << std::setw(10) << all.size() << std::setw(12) << all.size() / elapsed;
+  for (double p : {50.0, 90.0, 99.0}) std::cout << std::setw(10) << percentile(all, p);
+  std::cout << std::endl;
+  return 0;
+}
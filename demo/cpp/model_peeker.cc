@@ -118,13 +118,36 @@ void peek_model(DLRModelHandle model) {
   }
 }
 
+/*! \brief Prints the cost of a model estimated from its files, without loading it.
+ */
+void peek_model_cost(const char* model_path) {
+  DLRModelCost cost;
+  if (EstimateDLRModelCost(model_path, &cost) != 0) {
+    LOG(INFO) << DLRGetLastError() << std::endl;
+    throw std::runtime_error("Could not estimate DLR Model cost");
+  }
+  std::cout << "flops = ";
+  if (cost.flops >= 0) {
+    std::cout << cost.flops << std::endl;
+  } else {
+    std::cout << "unknown" << std::endl;
+  }
+  std::cout << "weight_bytes = " << cost.weight_bytes << std::endl;
+  std::cout << "activation_bytes = " << cost.activation_bytes << std::endl;
+  std::cout << "peak_memory_bytes = " << cost.peak_memory_bytes << std::endl;
+}
+
 int main(int argc, char** argv) {
   int device_type = 1;
   std::string input_name = "data";
   if (argc < 2) {
-    LOG(FATAL) << "Usage: " << argv[0] << " <model dir> [device_type]";
+    LOG(FATAL) << "Usage: " << argv[0] << " <model dir> [device_type | --cost]";
     return 1;
   }
+  if (argc >= 3 && std::string(argv[2]) == "--cost") {
+    peek_model_cost(argv[1]);
+    return 0;
+  }
   if (argc >= 3) {
     std::string argv2(argv[2]);
     if (argv2 == "cpu") {
@@ -0,0 +1,60 @@
+#include <dlr.h>
+#include <dlr_common.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "dmlc/logging.h"
+
+/*! \brief Drops the files of a model folder from the page cache so that the next load reads them
+ * from disk.
+ */
+void evict_page_cache(const std::string& model_dir) {
+  for (const std::string& path : dlr::FindFiles({model_dir})) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) continue;
+    fdatasync(fd);
+    if (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) != 0) {
+      LOG(WARNING) << "Could not evict " << path << " from the page cache";
+    }
+    close(fd);
+  }
+}
+
+/*! \brief Measures the time to create a model from a cold page cache, in milliseconds. */
+std::vector<double> time_cold_loads(const std::string& model_dir, int iterations) {
+  std::vector<double> times;
+  for (int i = 0; i < iterations; i++) {
+    evict_page_cache(model_dir);
+    auto start = std::chrono::steady_clock::now();
+    DLRModelHandle model = NULL;
+    if (CreateDLRModel(&model, model_dir.c_str(), 1, 0) != 0) {
+      LOG(FATAL) << DLRGetLastError();
+    }
+    auto end = std::chrono::steady_clock::now();
+    DeleteDLRModel(&model);
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  return times;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    LOG(FATAL) << "Usage: " << argv[0] << " <iterations> <model dir> [model dir ...]";
+    return 1;
+  }
+  const int iterations = std::max(1, std::atoi(argv[1]));
+  for (int i = 2; i < argc; i++) {
+    std::vector<double> times = time_cold_loads(argv[i], iterations);
+    std::cout << argv[i] << ": min " << times.front() << " ms, median " << times[times.size() / 2]
+              << " ms, max " << times.back() << " ms" << std::endl;
+  }
+  return 0;
+}
@@ -37,6 +37,16 @@ extern "C" {  // Open extern "C" block
  */
 typedef void* DLRModelHandle;
 
+/*!
+ \brief Handle for an execution group of DLRModels.
+ */
+typedef void* DLRExecutionGroupHandle;
+
+/*!
+ \brief Handle for a session carrying the state of a recurrent DLRModel between runs.
+ */
+typedef void* DLRSessionHandle;
+
 #ifndef DLR_ALLOC_TYPEDEF
 #define DLR_ALLOC_TYPEDEF
 /*! \brief A pointer to a malloc-like function. */
@@ -110,6 +120,41 @@ DLR_DLL
 int CreateDLRPipeline(DLRModelHandle* handle, int num_models, const char** model_paths,
                       int dev_type, int dev_id);
 
+/*!
+ \brief Creates a DLR cascade model, which runs a batch through stages of increasing cost and
+ only forwards to the next stage the rows the current one is not confident about. All stages take
+ the same inputs and produce the same outputs, with the batch as first dimension. The spec is a
+ JSON string such as:
+
+   {"Stages": [{"path": "/models/small",
+                "exit": {"output": "probs", "criterion": "max_prob", "threshold": 0.9}},
+               {"path": "/models/large"}]}
+
+ Rows exit a stage when its exit predicate holds for their row of the float32 output, given by
+ name or index: with "max_prob", the largest value is at least the threshold; with "margin", it
+ exceeds the second largest by at least the threshold. The last stage has no exit predicate and
+ takes every row left.
+ \param handle The pointer to save the model handle.
+ \param spec The cascade spec. Paths are the ones of CreateDLRModel().
+ \param dev_type Device type. Valid values are in the DLDeviceType enum in dlpack.h.
+ \param dev_id Device ID.
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int CreateDLRCascade(DLRModelHandle* handle, const char* spec, int dev_type, int dev_id);
+
+/*!
+ \brief Gets the number of rows which exited at each stage of a cascade model over all its runs.
+ Dividing them by their sum gives the exit ratios of the stages.
+ \param handle The model handle returned from CreateDLRCascade().
+ \param exit_counts The pointer to save the counts, an array of the number of stages. Can be NULL
+                    to only get the number of stages, e.g. to size the array.
+ \param num_stages The pointer to save the number of stages. Can be NULL.
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRCascadeExitCounts(DLRModelHandle* handle, int64_t* exit_counts, int* num_stages);
+
 /*!
  \brief Deletes a DLR model.
  \param handle The model handle returned from CreateDLRModel().
@@ -195,9 +240,30 @@ DLR_DLL
 int SetDLRInput(DLRModelHandle* handle, const char* name, const int64_t* shape, const void* input,
                 int dim);
 
+/*!
+ \brief Sets the input according the node name, from data of another type. The data is converted
+ to the type of the input while it is copied, e.g. from float64 to float32 or from float32 to
+ float16 or bfloat16. Float data for a quantized input (see GetDLRInputQuantization) is
+ quantized.
+ \param handle The model handle returned from CreateDLRModel().
+ \param name The input node name.
+ \param shape The input node shape as an array.
+ \param input The data for the input as an array.
+ \param dim The dimension of the input data.
+ \param dtype The type of the data: float64, float32, float16, bfloat16, int8, uint8, int16,
+ uint16, int32, uint32, int64 or uint64.
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error
+ message.
+ */
+DLR_DLL
+int SetDLRInputTyped(DLRModelHandle* handle, const char* name, const int64_t* shape,
+                     const void* input, int dim, const char* dtype);
+
 /*!
  * \brief Sets the input according the node name from existing DLTensor. Can only be
- *        used with TVM models (GraphRuntime and VMRuntime)
+ *        used with TVM models (GraphRuntime and VMRuntime). Tensors on the CPU may have strides,
+ *        e.g. slices or transpositions of other tensors: their elements are gathered into the
+ *        input in a single pass.
  * \param handle The model handle returned from CreateDLRModel().
  * \param name The input node name.
  * \param tensor The input DLTensor.
@@ -209,8 +275,8 @@ int SetDLRInputTensor(DLRModelHandle* handle, const char* name, void* tensor);
 /*!
  * \brief Sets the input from existing DLTensor without copying data. Can only be
  *        used with TVM models (GraphRuntime). Input tensor device must match the device of the
- *        model, and data must be alligned to 128 bytes. GetDLRInput cannot be used for inputs set
- *        via SetDLRInputZeroCopy.
+ *        model, and data must be alligned to 128 bytes. Strides are allowed if they describe
+ *        contiguous data. GetDLRInput cannot be used for inputs set via SetDLRInputZeroCopy.
  * \param handle The model handle returned from CreateDLRModel().
  * \param name The input node name.
  * \param tensor The input DLTensor.
@@ -219,6 +285,49 @@ int SetDLRInputTensor(DLRModelHandle* handle, const char* name, void* tensor);
 DLR_DLL
 int SetDLRInputTensorZeroCopy(DLRModelHandle* handle, const char* name, void* tensor);
 
+/*!
+ * \brief Makes an input a sliding window over the last samples appended with
+ *        AppendDLRInputWindow(), e.g. the last W samples of a time series for an input of shape
+ *        (1, W, F). Appending K samples costs O(K) instead of setting the whole window again. The
+ *        window starts filled with zeros. Can only be used with TVM models (GraphRuntime) on the
+ *        CPU. The input must not be set by other means afterwards.
+ * \param handle The model handle returned from CreateDLRModel().
+ * \param name The input node name.
+ * \param axis The axis of the window. Dimensions before it must be 1. A sample is a slice of the
+ *        input along the axis, e.g. F elements for an input of shape (1, W, F) and axis 1.
+ * \param rotated 1 if the model tolerates a rotation of the window, as models which do not depend
+ *        on the order of samples do. Samples are then written in place over the oldest one, and
+ *        GetDLRInputWindowOffset() gives the position of the oldest sample. 0 to present the
+ *        samples oldest first, without copies of the window. Samples which are not a multiple of
+ *        64 bytes are then written up to 64 times, once per alignment of the window.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int SetDLRInputWindow(DLRModelHandle* handle, const char* name, int axis, int rotated);
+
+/*!
+ * \brief Appends samples to the window of an input, dropping the oldest ones.
+ * \param handle The model handle returned from CreateDLRModel().
+ * \param name The input node name.
+ * \param samples The samples, of the type of the input.
+ * \param count The number of samples.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int AppendDLRInputWindow(DLRModelHandle* handle, const char* name, const void* samples,
+                         int64_t count);
+
+/*!
+ * \brief Gets the position of the oldest sample in the window of an input along its axis. Always
+ *        0 unless the window is rotated.
+ * \param handle The model handle returned from CreateDLRModel().
+ * \param name The input node name.
+ * \param offset The pointer to save the position.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRInputWindowOffset(DLRModelHandle* handle, const char* name, int64_t* offset);
+
 /*!
  \brief Gets the current value of the input according the node name.
  \param handle The model handle returned from CreateDLRModel().
@@ -276,6 +385,47 @@ int GetDLROutputShape(DLRModelHandle* handle, int index, int64_t* shape);
 DLR_DLL
 int GetDLROutput(DLRModelHandle* handle, int index, void* out);
 
+/*!
+ \brief Gets the index-th output from the model as data of another type. The data is converted
+ while it is copied. Quantized outputs (see GetDLROutputQuantization) are dequantized when
+ fetched as float32, float16, bfloat16 or float64.
+ \param handle The model handle returned from CreateDLRModel().
+ \param index The index-th output.
+ \param out The pointer to save the output data. This should be a pointer to an
+ array of size "size" from GetDLROutputSizeDim(), of elements of type dtype.
+ \param dtype The type of the data, see SetDLRInputTyped().
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLROutputTyped(DLRModelHandle* handle, int index, void* out, const char* dtype);
+
+/*!
+ \brief Gets the quantization of an input, declared in the metadata of the model. Float data
+ given to SetDLRInputTyped for a quantized input is quantized while it is copied.
+ \param handle The model handle returned from CreateDLRModel().
+ \param name The input node name.
+ \param quantized Set to 1 if the input is quantized, 0 otherwise.
+ \param scale Set to the scale of the quantization: real value = scale * (value - zero_point).
+ \param zero_point Set to the zero point of the quantization.
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRInputQuantization(DLRModelHandle* handle, const char* name, int* quantized, float* scale,
+                            int* zero_point);
+
+/*!
+ \brief Gets the quantization of the index-th output, declared in the metadata of the model.
+ \param handle The model handle returned from CreateDLRModel().
+ \param index The index-th output.
+ \param quantized Set to 1 if the output is quantized, 0 otherwise.
+ \param scale Set to the scale of the quantization: real value = scale * (value - zero_point).
+ \param zero_point Set to the zero point of the quantization.
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLROutputQuantization(DLRModelHandle* handle, int index, int* quantized, float* scale,
+                             int* zero_point);
+
 /*!
  \brief Gets the index-th output from the model.
  \param handle The model handle returned from CreateDLRModel().
@@ -286,6 +436,63 @@ int GetDLROutput(DLRModelHandle* handle, int index, void* out);
 DLR_DLL
 int GetDLROutputPtr(DLRModelHandle* handle, int index, const void** out);
 
+/*!
+ \brief Turns on ping-pong output buffering. The outputs of each run are copied to one of
+ num_sets buffer sets, identified by a ticket (see GetDLROutputTicket()), and the set is held until
+ the ticket is released with ReleaseDLROutputs(). The outputs of a run can thus be read, e.g. by
+ another thread, while the next inference runs on the same model. RunDLRModel() waits for a set to
+ be released when all of them are held. Supported by TVM and Relay VM models. Must not be called
+ while the model runs.
+ \param handle The model handle returned from CreateDLRModel().
+ \param num_sets The number of buffer sets, usually 2. 0 turns buffering off.
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int SetDLROutputBuffers(DLRModelHandle* handle, int num_sets);
+
+/*!
+ \brief Gets the ticket of the buffered outputs of the last run, see SetDLROutputBuffers(). Every
+ ticket must be released with ReleaseDLROutputs(), even if its outputs are not read.
+ \param handle The model handle returned from CreateDLRModel().
+ \param ticket Storage to save the ticket.
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLROutputTicket(DLRModelHandle* handle, int64_t* ticket);
+
+/*!
+ \brief Gets a pointer to the index-th buffered output of a ticket. It stays valid until the ticket
+ is released, whatever runs in between.
+ \param handle The model handle returned from CreateDLRModel().
+ \param ticket The ticket from GetDLROutputTicket().
+ \param index The index-th output.
+ \param out Storage to save the output pointer.
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRTicketOutputPtr(DLRModelHandle* handle, int64_t ticket, int index, const void** out);
+
+/*!
+ \brief Gets the shape of the index-th buffered output of a ticket.
+ \param handle The model handle returned from CreateDLRModel().
+ \param ticket The ticket from GetDLROutputTicket().
+ \param index The index-th output.
+ \param shape The pointer to save the shape, an array of size "dim" from GetDLROutputSizeDim().
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRTicketOutputShape(DLRModelHandle* handle, int64_t ticket, int index, int64_t* shape);
+
+/*!
+ \brief Releases the buffered outputs of a ticket, letting a later run reuse their buffer set.
+ Pointers from GetDLRTicketOutputPtr() must not be used afterwards.
+ \param handle The model handle returned from CreateDLRModel().
+ \param ticket The ticket from GetDLROutputTicket().
+ \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int ReleaseDLROutputs(DLRModelHandle* handle, int64_t ticket);
+
 /*!
  * \brief Gets the index-th output from the model and copies it into the given DLTensor.
  *        Can only be used with TVM models (GraphRuntime and VMRuntime)
@@ -401,6 +608,26 @@ int GetDLRBackend(DLRModelHandle* handle, const char** name);
 DLR_DLL
 int GetDLRDeviceType(const char* model_path);
 
+/*!
+ \brief Gets the CPU features of the host used to select model variants.
+ \param features The pointer to save the null-terminated, space separated list of features, e.g.
+ "avx512 avx2 avx sse42". Model folders can hold a variant of their files for each of these
+ features, named like "compiled.avx512.so". \return 0 for success, -1 for error. Call
+ DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRCPUFeatures(const char** features);
+
+/*!
+ \brief Gets the CPU feature of the model variant loaded for the host.
+ \param handle The model handle returned from CreateDLRModel().
+ \param variant The pointer to save the null-terminated feature name, or an empty string if the
+ untagged model files were loaded. \return 0 for success, -1 for error. Call DLRGetLastError() to
+ get the error message.
+ */
+DLR_DLL
+int GetDLRCPUVariant(DLRModelHandle* handle, const char** variant);
+
 /*!
  \brief Get DLR version
  \param out The pointer to save the null-terminated string containing the
@@ -460,6 +687,325 @@ int SetDLRCustomAllocatorFree(DLRFreeFunctionPtr custom_free_fn);
 DLR_DLL
 int SetDLRCustomAllocatorMemalign(DLRMemalignFunctionPtr custom_memalign_fn);
 
+/*!
+ * \brief Share the weights of TVM models between processes. Models created afterwards on the CPU
+ *        place their weights in a read-only segment named after the contents of their params:
+ *        the first process to load a model populates it, and the other processes loading the same
+ *        model map it instead of loading their own copy. Segments are not removed when the
+ *        processes exit. The initial location is taken from the DLR_SHARED_WEIGHT_STORE
+ *        environment variable. Not supported on Windows and Android.
+ * \param location "shm" for POSIX shared memory, the path of a directory (e.g. on a hugetlbfs
+ *        mount) to hold the segments, or NULL to keep weights private, which is the default.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int SetDLRSharedWeightStore(const char* location);
+
+/*!
+ * \brief Enable or disable prefork mode, for servers which load and warm up models in a parent
+ *        process and then fork workers. In prefork mode, inference runs on short-lived threads so
+ *        that the parent holds no TVM worker threads when it forks, and the weights of TVM models
+ *        created afterwards on the CPU are placed in read-only pages of their own, which the
+ *        workers keep sharing copy-on-write. Fork with DLRPrepareFork, DLRPostForkParent and
+ *        DLRPostForkChild around fork(). Only the TVM and RelayVM backends are fork-safe.
+ * \param enable 1 to enable, 0 to disable.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int SetDLRPreforkMode(int enable);
+
+/*!
+ * \brief Prepare for fork(): wait for running inferences to finish and block new ones until
+ *        DLRPostForkParent or DLRPostForkChild is called by the same thread.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int DLRPrepareFork();
+
+/*!
+ * \brief Resume inference in the parent process after fork().
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int DLRPostForkParent();
+
+/*!
+ * \brief Resume inference in the child process after fork(). Prefork mode is disabled in the
+ *        child, which runs models on its own thread pool from then on.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int DLRPostForkChild();
+
+/*!
+ * \brief Create an execution group. Models in the same group share one activation arena sized
+ *        to the largest member instead of each owning its own, so a group should only contain
+ *        models which are not run concurrently, e.g. models used by the same worker thread. Runs
+ *        of group members are serialized.
+ * \param handle The pointer to save the execution group handle.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int CreateDLRExecutionGroup(DLRExecutionGroupHandle* handle);
+
+/*!
+ * \brief Add a model to an execution group. Only supported by the TVM backend. A model can belong
+ *        to a single group and stays in it until it is deleted. Inputs set with
+ *        SetDLRInputTensorZeroCopy() must be set again after joining.
+ * \param handle The execution group handle returned from CreateDLRExecutionGroup().
+ * \param model The model handle returned from CreateDLRModel().
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int JoinDLRExecutionGroup(DLRExecutionGroupHandle* handle, DLRModelHandle* model);
+
+/*!
+ * \brief Get the activation memory saved by an execution group.
+ * \param handle The execution group handle returned from CreateDLRExecutionGroup().
+ * \param saved_bytes The pointer to save the number of bytes saved compared to every member
+ *        owning its own activation storage.
+ * \param arena_bytes The pointer to save the size of the shared arena in bytes. Can be NULL.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRExecutionGroupSavedBytes(DLRExecutionGroupHandle* handle, int64_t* saved_bytes,
+                                   int64_t* arena_bytes);
+
+/*!
+ * \brief Delete an execution group handle. The group itself is released once all its members
+ *        have been deleted.
+ * \param handle The execution group handle returned from CreateDLRExecutionGroup().
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int DeleteDLRExecutionGroup(DLRExecutionGroupHandle* handle);
+
+/*!
+ * \brief Create a session of a recurrent or streaming model. Each state binding feeds an output
+ *        of a run, e.g. a hidden state, to an input of the next run of the session, without
+ *        copying it back to the host. States start at zero. Sessions own their state, so one model
+ *        can serve many streams, each with its own session, as long as they do not run at the same
+ *        time. Only supported by the TVM and Relay VM backends. Outputs are found by the names in
+ *        the metadata of the model.
+ * \param handle The pointer to save the session handle.
+ * \param model The model handle returned from CreateDLRModel(). It must outlive the session.
+ * \param num_states The number of state bindings.
+ * \param output_names The names of the outputs which hold the state after a run.
+ * \param input_names The names of the inputs they feed, of the same shape and type.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int CreateDLRSession(DLRSessionHandle* handle, DLRModelHandle* model, int num_states,
+                     const char** output_names, const char** input_names);
+
+/*!
+ * \brief Run the model of a session on its current state, then advance the state to the new
+ *        outputs. Other inputs are set on the model with SetDLRInput() and outputs are read from
+ *        it with GetDLROutput() as usual.
+ * \param handle The session handle returned from CreateDLRSession().
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int RunDLRSession(DLRSessionHandle* handle);
+
+/*!
+ * \brief Set every state of a session to zero, to start a new stream.
+ * \param handle The session handle returned from CreateDLRSession().
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int ResetDLRSession(DLRSessionHandle* handle);
+
+/*!
+ * \brief Copy the state fed to an input of a session, e.g. to save a stream.
+ * \param handle The session handle returned from CreateDLRSession().
+ * \param input_name The name of the input.
+ * \param data The pointer to save the state, of the size and type of the input.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRSessionState(DLRSessionHandle* handle, const char* input_name, void* data);
+
+/*!
+ * \brief Set the state fed to an input of a session, e.g. to restore a stream.
+ * \param handle The session handle returned from CreateDLRSession().
+ * \param input_name The name of the input.
+ * \param data The state, of the size and type of the input.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int SetDLRSessionState(DLRSessionHandle* handle, const char* input_name, const void* data);
+
+/*!
+ * \brief Delete a session.
+ * \param handle The session handle returned from CreateDLRSession().
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int DeleteDLRSession(DLRSessionHandle* handle);
+
+/*!
+ * \brief Find the number of model instances, threads per instance and batch size which serve a
+ *        model best on this host. Sweeps powers of two instances and threads whose product does
+ *        not exceed the hardware threads, for each batch size, measuring the throughput and p99
+ *        latency of every combination. The result is written to a config file, which
+ *        CreateDLRModel() applies when it is in the model folder.
+ * \param model_path Path to the folder containing the model files.
+ * \param dev_type Device type. Valid values are in the DLDeviceType enum in dlpack.h.
+ * \param dev_id Device ID.
+ * \param batch_sizes Batch sizes to try, or NULL for 1 only. Those the model does not accept are
+ *        skipped.
+ * \param num_batch_sizes Number of batch sizes.
+ * \param time_budget Duration of the whole sweep in seconds.
+ * \param max_p99_ms Maximum p99 latency in milliseconds, or 0 for no limit. The combination of
+ *        highest throughput within it is selected, or the one of lowest p99 if none is.
+ * \param config_path Path of the config file to write, or NULL for dlr_tuned_config.json in the
+ *        model folder.
+ * \param instances The pointer to save the number of instances, or NULL.
+ * \param threads The pointer to save the number of threads per instance, or NULL.
+ * \param batch_size The pointer to save the batch size, or NULL.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int TuneDLRModel(const char* model_path, int dev_type, int dev_id, const int64_t* batch_sizes,
+                 int num_batch_sizes, float time_budget, float max_p99_ms, const char* config_path,
+                 int* instances, int* threads, int64_t* batch_size);
+
+/*!
+ * \brief Read the config file written by TuneDLRModel() in a model folder, e.g. to size a pool of
+ *        model instances. CreateDLRModel() applies the number of threads on its own.
+ * \param model_path Path to the folder containing the model files.
+ * \param instances The pointer to save the number of instances.
+ * \param threads The pointer to save the number of threads per instance.
+ * \param batch_size The pointer to save the batch size.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRTunedConfig(const char* model_path, int* instances, int* threads, int64_t* batch_size);
+
+/*!
+ * \brief Enable or disable hardware performance counters around each RunDLRModel(), with Linux
+ *        perf_event_open(). Counting covers every thread of the process, including the thread
+ *        pools of the runtime. Pipelines also count each of their stages. Enabling resets the
+ *        counts.
+ * \param handle The model handle returned from CreateDLRModel().
+ * \param enable 0 to disable, 1 to enable.
+ * \return 0 for success, -1 for error, e.g. when no counter can be opened on this host. Call
+ *         DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int EnableDLRPerfCounters(DLRModelHandle* handle, int enable);
+
+/*!
+ * \brief Get the performance counters summed over the runs since they were enabled.
+ * \param handle The model handle returned from CreateDLRModel().
+ * \param counters The pointer to save 5 counters: cycles, instructions, LLC misses, branch misses
+ *        and context switches. Counters unavailable on this host are -1. Cycles, instructions and
+ *        misses count user space only.
+ * \param num_runs The pointer to save the number of runs counted.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRPerfCounters(DLRModelHandle* handle, int64_t* counters, int64_t* num_runs);
+
+/*!
+ * \brief Get the performance counters of a stage of a pipeline, like GetDLRPerfCounters().
+ * \param handle The model handle returned from CreateDLRPipeline().
+ * \param stage The index of the model in the pipeline.
+ * \param counters The pointer to save 5 counters, see GetDLRPerfCounters().
+ * \param num_runs The pointer to save the number of runs counted.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRPipelineStagePerfCounters(DLRModelHandle* handle, int stage, int64_t* counters,
+                                    int64_t* num_runs);
+
+/*!
+ * \brief Record the last requests of a model in a ring buffer: when their inputs were set with
+ *        SetDLRInput(), when they ran with RunDLRModel() and when their outputs were read with
+ *        GetDLROutput(), with the input sizes, batch size and thread. Requests slower than a
+ *        threshold from their first input to the end of their run are logged with their phases.
+ *        Must not be called while the model runs.
+ * \param handle The model handle returned from CreateDLRModel().
+ * \param capacity Number of requests to keep, 0 to disable the recorder.
+ * \param slow_threshold_ms Threshold of the requests to log in milliseconds, 0 to log none.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int EnableDLRFlightRecorder(DLRModelHandle* handle, int capacity, float slow_threshold_ms);
+
+/*!
+ * \brief Append the requests recorded for a model to a file, oldest first, one JSON object per
+ *        line. Requests being recorded are skipped, the model keeps running meanwhile.
+ * \param handle The model handle returned from CreateDLRModel().
+ * \param path The file to append to.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int DumpDLRFlightRecorder(DLRModelHandle* handle, const char* path);
+
+/*!
+ * \brief Append the requests recorded for every model of the process to a file whenever the
+ *        process receives a signal, e.g. SIGUSR1. Not supported on Windows.
+ * \param signum The signal.
+ * \param path The file to append to.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int SetDLRFlightRecorderDumpSignal(int signum, const char* path);
+
+/*! \brief Cost of a model estimated by EstimateDLRModelCost(). */
+typedef struct DLRModelCost {
+  /*! \brief Floating point operations of a run, -1 if unknown for the backend. */
+  int64_t flops;
+  /*! \brief Bytes of the weights. */
+  int64_t weight_bytes;
+  /*! \brief Bytes of the intermediate tensors, inputs and outputs included. */
+  int64_t activation_bytes;
+  /*! \brief Bytes held by the model while it runs, besides its code. */
+  int64_t peak_memory_bytes;
+} DLRModelCost;
+
+/*!
+ * \brief Estimate the FLOPs and memory of a model from its files, without loading it, e.g. to
+ *        place models on hosts. TVM models are estimated from their graph JSON and the headers
+ *        of their params. RelayVM models are estimated from their metadata and the size of their
+ *        executable, and their FLOPs are unknown. Other backends are not supported.
+ * \param model_path Path to the folder containing the model files,
+ *                   or colon-separated list of folders containing model files,
+ *                   or colon-separated list of paths to model files
+ * \param report The pointer to save the cost.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int EstimateDLRModelCost(const char* model_path, DLRModelCost* report);
+
+/*!
+ * \brief Enable or disable the metrics of a model, rendered by GetDLRMetricsText(): runs, errors,
+ *        latency of the calls setting inputs, running the model or a session of it and getting
+ *        outputs, batch sizes and bytes copied. Disabling drops the metrics. Must not be called
+ *        while the model runs.
+ * \param handle The model handle returned from CreateDLRModel().
+ * \param enable 1 to enable the metrics, 0 to disable them.
+ * \param name Value of the "model" label of the metrics, e.g. the model path. Models of the same
+ *        backend with metrics enabled must have distinct names.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int EnableDLRMetrics(DLRModelHandle* handle, int enable, const char* name);
+
+/*!
+ * \brief Render the metrics of every model with metrics enabled, and the resident memory of the
+ *        process, in the Prometheus text exposition format. Call with a null buffer to get the
+ *        size to allocate; the text may grow by the next call if models are added.
+ * \param buf The buffer to save the NUL-terminated text, or nullptr.
+ * \param len The size of the buffer in bytes.
+ * \param size The pointer to save the size of the text in bytes, NUL included.
+ * \return 0 for success, -1 for error. Call DLRGetLastError() to get the error message.
+ */
+DLR_DLL
+int GetDLRMetricsText(char* buf, int64_t len, int64_t* size);
+
 /*! \} */
 
 #ifdef __cplusplus
@@ -0,0 +1,111 @@
+#ifndef DLR_BATCH_VARIANT_H_
+#define DLR_BATCH_VARIANT_H_
+
+#include "dlr_common.h"
+#include "dlr_execution_group.h"
+#include "dlr_tvm.h"
+
+#if defined(_MSC_VER) || defined(_WIN32)
+#define DLR_DLL __declspec(dllexport)
+#else
+#define DLR_DLL
+#endif  // defined(_MSC_VER) || defined(_WIN32)
+
+namespace dlr {
+
+/*! \brief A run of a batch variant on rows [offset, offset + count) of the batch, padded up to the
+ *  batch size of the variant when count is smaller.
+ */
+struct BatchVariantRun {
+  size_t variant;
+  int64_t offset;
+  int64_t count;
+};
+
+/*! \brief Plan the runs of a batch: chunks of the largest variant, then the rest on the smallest
+ *  variant it fits in.
+ *  \param batch_sizes Batch sizes of the variants, in increasing order.
+ */
+DLR_DLL std::vector<BatchVariantRun> PlanBatchVariantRuns(const std::vector<int64_t>& batch_sizes,
+                                                          int64_t batch_size);
+
+/*! \brief class BatchVariantModel
+ *
+ * Model folder holding several TVM models compiled for different static batch sizes, listed in a
+ * manifest file:
+ *
+ *   dlr_batch_variants.json: {"BatchVariants": [{"batch_size": 1, "path": "bs1"},
+ *                                               {"batch_size": 16, "path": "bs16"}]}
+ *
+ * Each path is a TVM model folder relative to the manifest. Inputs accept any batch size; Run()
+ * dispatches the batch to the smallest variant that fits, splitting it over the largest variant
+ * and padding the last chunk as needed. Variants never run concurrently, so they share their
+ * activation memory through an execution group.
+ */
+class DLR_DLL BatchVariantModel : public DLRModel {
+ private:
+  struct Variant {
+    int64_t batch_size;
+    std::shared_ptr<TVMModel> model;
+  };
+  struct StagedInput {
+    std::vector<char> data;
+    int64_t batch_size = -1;
+  };
+  // Sorted by increasing batch size.
+  std::vector<Variant> variants_;
+  std::shared_ptr<ExecutionGroup> execution_group_;
+  std::vector<size_t> input_row_bytes_;
+  std::vector<StagedInput> inputs_;
+  std::vector<std::string> output_types_;
+  std::vector<size_t> output_row_bytes_;
+  std::vector<std::vector<int64_t>> output_shapes_;
+  std::vector<std::vector<char>> outputs_;
+  std::vector<char> scratch_;
+  void SetupBatchVariantModel(const std::vector<std::string>& files);
+  int GetInputIndex(const char* name) const;
+  void RunChunk(const Variant& variant, int64_t offset, int64_t count);
+
+ public:
+  /*! \brief Load model files from given folder path.
+   */
+  explicit BatchVariantModel(const std::vector<std::string>& files, const DLContext& ctx)
+      : DLRModel(ctx, DLRBackend::kBATCHVARIANT) {
+    SetupBatchVariantModel(files);
+  }
+
+  /*! \brief Batch sizes of the loaded variants, in increasing order. */
+  std::vector<int64_t> GetBatchSizes() const;
+
+  virtual const int GetInputDim(int index) const override;
+  virtual const int64_t GetInputSize(int index) const override;
+  virtual const char* GetInputName(int index) const override;
+  virtual const char* GetInputType(int index) const override;
+  virtual void GetInput(const char* name, void* input) override;
+  virtual void SetInput(const char* name, const int64_t* shape, const void* input,
+                        int dim) override;
+
+  virtual void GetOutput(int index, void* out) override;
+  virtual const void* GetOutputPtr(int index) const override;
+  virtual void GetOutputShape(int index, int64_t* shape) const override;
+  virtual void GetOutputSizeDim(int index, int64_t* size, int* dim) override;
+  virtual const char* GetOutputType(int index) const override;
+
+  virtual const char* GetWeightName(int index) const override;
+  virtual std::vector<std::string> GetWeightNames() const override;
+
+  virtual void Run() override;
+  virtual void SetNumThreads(int threads) override;
+  virtual void UseCPUAffinity(bool use) override;
+
+  /*
+    Following methods use metadata file to lookup input and output names.
+  */
+  virtual const char* GetOutputName(const int index) const override;
+  virtual int GetOutputIndex(const char* name) const override;
+  virtual void GetOutputByName(const char* name, void* out) override;
+};
+
+}  // namespace dlr
+
+#endif  // DLR_BATCH_VARIANT_H_
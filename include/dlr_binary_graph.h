@@ -0,0 +1,47 @@
+#ifndef DLR_BINARY_GRAPH_H_
+#define DLR_BINARY_GRAPH_H_
+
+#include <string>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Extension of binary graph files, written next to the graph JSON by convert_graph. */
+constexpr const char* BINARY_GRAPH_EXT = ".dlrgraph";
+
+/*! \brief Binary encoding of a graph JSON and the model metadata, loaded without JSON parsing.
+ *
+ * Layout, little endian:
+ *
+ *   uint64 magic, uint32 version, uint32 reserved
+ *   uint64 graph_bytes, graph encoded by DLRGraphRuntime::SerializeGraph()
+ *   uint64 metadata_bytes, metadata encoded as CBOR (0 bytes if the model has no metadata)
+ *
+ * Sections are read in place, so the file can be used straight from a memory mapped buffer.
+ */
+constexpr uint64_t kBinaryGraphMagic = 0x3148505247524C44;  // "DLRGRPH1"
+constexpr uint32_t kBinaryGraphVersion = 1;
+
+/*! \brief Sections of a binary graph file. The graph points into the file's buffer. */
+struct BinaryGraph {
+  const char* graph;
+  size_t graph_size;
+  nlohmann::json metadata;
+};
+
+/*! \brief Whether data holds a binary graph file. */
+DLR_DLL bool IsBinaryGraph(const void* data, size_t size);
+
+/*! \brief Encode a graph JSON and optional metadata JSON into a binary graph file. */
+DLR_DLL std::string ConvertGraphToBinary(const std::string& graph_json,
+                                         const std::string& metadata_json);
+
+/*! \brief Split a binary graph file in its sections and decode the metadata. Throws if the file
+ *  was written by an incompatible version.
+ */
+DLR_DLL BinaryGraph ParseBinaryGraph(const void* data, size_t size);
+
+}  // namespace dlr
+
+#endif  // DLR_BINARY_GRAPH_H_
@@ -0,0 +1,88 @@
+#ifndef DLR_BINARY_IO_H_
+#define DLR_BINARY_IO_H_
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Bounds checked reader of the little endian binary files written by BinaryWriter. */
+class BinaryReader {
+ public:
+  BinaryReader(const void* data, size_t size)
+      : data_(static_cast<const char*>(data)), size_(size) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    std::memcpy(&value, ReadBytes(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  /*! \brief Get a pointer to the next nbytes bytes, which stay owned by the caller's buffer. */
+  const char* ReadBytes(size_t nbytes) {
+    if (nbytes > size_ - pos_) throw dmlc::Error("Invalid binary file: unexpected end of data.");
+    const char* ret = data_ + pos_;
+    pos_ += nbytes;
+    return ret;
+  }
+
+  std::string ReadString() {
+    const uint64_t length = Read<uint64_t>();
+    return std::string(ReadBytes(length), length);
+  }
+
+  template <typename T>
+  std::vector<T> ReadVector() {
+    const uint64_t length = Read<uint64_t>();
+    if (length > (size_ - pos_) / sizeof(T)) {
+      throw dmlc::Error("Invalid binary file: unexpected end of data.");
+    }
+    std::vector<T> values(length);
+    if (length > 0) std::memcpy(values.data(), ReadBytes(length * sizeof(T)), length * sizeof(T));
+    return values;
+  }
+
+  size_t Tell() const { return pos_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+/*! \brief Writer of little endian binary files. */
+class BinaryWriter {
+ public:
+  template <typename T>
+  void Write(const T& value) {
+    Write(&value, sizeof(T));
+  }
+
+  void Write(const void* data, size_t nbytes) {
+    buffer_.append(static_cast<const char*>(data), nbytes);
+  }
+
+  void WriteString(const std::string& str) {
+    Write<uint64_t>(str.size());
+    Write(str.data(), str.size());
+  }
+
+  template <typename T>
+  void WriteVector(const std::vector<T>& values) {
+    Write<uint64_t>(values.size());
+    Write(values.data(), values.size() * sizeof(T));
+  }
+
+  std::string& buffer() { return buffer_; }
+
+ private:
+  std::string buffer_;
+};
+
+}  // namespace dlr
+
+#endif  // DLR_BINARY_IO_H_
@@ -0,0 +1,116 @@
+#ifndef DLR_CASCADE_H_
+#define DLR_CASCADE_H_
+
+#include <nlohmann/json.hpp>
+
+#include "dlr_common.h"
+
+#if defined(_MSC_VER) || defined(_WIN32)
+#define DLR_DLL __declspec(dllexport)
+#else
+#define DLR_DLL
+#endif  // defined(_MSC_VER) || defined(_WIN32)
+
+namespace dlr {
+
+/*! \brief Confidence predicate on a float32 output of a cascade stage. Rows of the batch which
+ *  satisfy it exit the cascade with the outputs of the stage.
+ */
+struct CascadeExit {
+  enum Criterion {
+    // The largest value of the row is at least the threshold.
+    kMaxProb,
+    // The largest value of the row exceeds the second largest by at least the threshold.
+    kMargin
+  };
+  // Output holding the confidences, by name or, if the name is empty, by index.
+  std::string output_name;
+  int output_index = -1;
+  Criterion criterion = kMaxProb;
+  float threshold = 1.0f;
+};
+
+/*! \brief Parse an exit predicate such as {"output": "probs", "criterion": "margin",
+ *  "threshold": 0.5}. The output can be a name or an index, and the criterion "max_prob" or
+ *  "margin".
+ */
+DLR_DLL CascadeExit ParseCascadeExit(const nlohmann::json& spec);
+
+/*! \brief class CascadeModel
+ *
+ * Stages of increasing cost which all take the inputs of the cascade and produce its outputs, e.g.
+ * a small and a large classifier. Every row of the batch runs through the first stage. Rows for
+ * which the exit predicate of a stage holds take their outputs from it, and the others are
+ * compacted into a smaller batch for the next stage. The last stage takes every row left.
+ *
+ * The first dimension of inputs and outputs is the batch. Stages with a static batch size run the
+ * rows in chunks of it, padding the last chunk.
+ */
+class DLR_DLL CascadeModel : public DLRModel {
+ private:
+  struct Stage {
+    DLRModelPtr model;
+    // -1 for stages taking any batch size.
+    int64_t batch_size;
+    CascadeExit exit;
+    int64_t exit_count = 0;
+  };
+  std::vector<Stage> stages_;
+  std::vector<size_t> input_row_bytes_;
+  std::vector<std::vector<char>> inputs_;
+  std::vector<int64_t> input_batch_sizes_;
+  std::vector<std::string> output_types_;
+  std::vector<size_t> output_row_bytes_;
+  std::vector<std::vector<int64_t>> output_shapes_;
+  std::vector<std::vector<char>> outputs_;
+  // Inputs and outputs of the rows running through a stage after the first one.
+  std::vector<std::vector<char>> stage_inputs_;
+  std::vector<std::vector<char>> stage_outputs_;
+  std::vector<char> scratch_;
+  void SetupCascadeModel(const std::vector<CascadeExit>& exits);
+  int GetInputIndex(const char* name) const;
+  void RunStage(const Stage& stage, const std::vector<std::vector<char>>& inputs, int64_t count);
+  bool IsConfident(const Stage& stage, int64_t row) const;
+
+ public:
+  /*! \brief Create a cascade of the stage models, with the exit predicates of all the stages but
+   *  the last one.
+   */
+  explicit CascadeModel(const std::vector<DLRModelPtr>& stages,
+                        const std::vector<CascadeExit>& exits, const DLContext& ctx);
+
+  /*! \brief Number of rows which exited at each stage, over all runs. */
+  std::vector<int64_t> GetExitCounts() const;
+
+  virtual const int GetInputDim(int index) const override;
+  virtual const int64_t GetInputSize(int index) const override;
+  virtual const char* GetInputName(int index) const override;
+  virtual const char* GetInputType(int index) const override;
+  virtual void GetInput(const char* name, void* input) override;
+  virtual void SetInput(const char* name, const int64_t* shape, const void* input,
+                        int dim) override;
+
+  virtual void GetOutput(int index, void* out) override;
+  virtual const void* GetOutputPtr(int index) const override;
+  virtual void GetOutputShape(int index, int64_t* shape) const override;
+  virtual void GetOutputSizeDim(int index, int64_t* size, int* dim) override;
+  virtual const char* GetOutputType(int index) const override;
+
+  virtual const char* GetWeightName(int index) const override;
+  virtual std::vector<std::string> GetWeightNames() const override;
+
+  virtual void Run() override;
+  virtual void SetNumThreads(int threads) override;
+  virtual void UseCPUAffinity(bool use) override;
+
+  /*
+    Following methods use metadata file to lookup input and output names.
+  */
+  virtual const char* GetOutputName(const int index) const override;
+  virtual int GetOutputIndex(const char* name) const override;
+  virtual void GetOutputByName(const char* name, void* out) override;
+};
+
+}  // namespace dlr
+
+#endif  // DLR_CASCADE_H_
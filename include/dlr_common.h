@@ -6,6 +6,8 @@
 #include <runtime_base.h>
 #include <sys/types.h>
 
+#include <functional>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <vector>
@@ -56,10 +58,17 @@ namespace dlr {
  * as model JSON */
 constexpr const char* SAGEMAKER_AUXILIARY_JSON_FILES[] = {"model-shapes.json", "hyperparams.json"};
 
+/* Manifest listing the batch size variants of a model, see BatchVariantModel */
+constexpr const char* BATCH_VARIANTS_MANIFEST = "dlr_batch_variants.json";
+
+/* Configuration written by the tuner and applied when the model folder is loaded, see TuneModel */
+constexpr const char* TUNED_CONFIG_FILE = "dlr_tuned_config.json";
+
 typedef struct {
   std::string model_lib;
   std::string params;
   std::string model_json;
+  std::string binary_graph;
   std::string metadata;
   std::string relay_executable;
 } ModelPath;
@@ -95,8 +104,17 @@ inline bool EndsWith(const std::string& mainStr, const std::string& toMatch) {
     return false;
 }
 
-enum class DLRBackend { kTVM, kTREELITE, kHEXAGON, kRELAYVM, kPIPELINE, kUNKNOWN };
-extern const char* kBackendToStr[6];
+enum class DLRBackend {
+  kTVM,
+  kTREELITE,
+  kHEXAGON,
+  kRELAYVM,
+  kPIPELINE,
+  kBATCHVARIANT,
+  kCASCADE,
+  kUNKNOWN
+};
+extern const char* kBackendToStr[8];
 
 /*! \brief Get the backend based on the contents of the model folder.
  */
@@ -120,6 +138,23 @@ bool HasNegative(const int64_t* arr, const size_t size);
 #define CHECK_SHAPE(msg, value, expected) \
   CHECK_EQ(value, expected) << (msg) << ". Value read: " << (value) << ", Expected: " << (expected);
 
+/*! \brief Affine quantization of a tensor: real value = scale * (quantized value - zero_point). */
+struct QuantizationParams {
+  float scale = 1.0f;
+  int32_t zero_point = 0;
+};
+
+/*! \brief State carried by a Session from an output of one run to an input of the next one. */
+struct StateBinding {
+  int input_index;
+  int output_index;
+};
+
+class OutputBuffers;
+class PerfCounters;
+class FlightRecorder;
+class ModelMetrics;
+
 // Abstract class
 class DLR_DLL DLRModel {
  protected:
@@ -132,8 +167,28 @@ class DLR_DLL DLRModel {
   std::vector<std::string> input_names_;
   std::vector<std::string> input_types_;
   std::vector<std::vector<int64_t>> input_shapes_;
+  std::string cpu_variant_;
   virtual void ValidateDeviceTypeIfExists();
 
+  /*! \brief Convert data to the dtype of an input, quantizing floats if the input is quantized. */
+  void ConvertInputData(const char* name, const void* src, const DLDataType& src_dtype, void* dst,
+                        const DLDataType& dst_dtype, int64_t count) const;
+  /*! \brief Convert data of an output to dtype, dequantizing it if the output is quantized. */
+  void ConvertOutputData(int index, const void* src, const DLDataType& src_dtype, void* dst,
+                         const DLDataType& dst_dtype, int64_t count) const;
+  /*! \brief Buffer sets of the outputs, null unless SetNumOutputBuffers() turned them on. */
+  std::shared_ptr<OutputBuffers> output_buffers_;
+  /*! \brief Run an inference with run, then copy its outputs to a buffer set if they are
+   *  buffered. Backends supporting SetNumOutputBuffers() wrap their Run() with it.
+   */
+  void RunBuffered(const std::function<void()>& run);
+  /*! \brief Counters of the runs, null unless EnablePerfCounters() turned them on. */
+  std::shared_ptr<PerfCounters> perf_counters_;
+  /*! \brief Recorder of the last requests, null unless EnableFlightRecorder() turned it on. */
+  std::shared_ptr<FlightRecorder> flight_recorder_;
+  /*! \brief Metrics of the calls, null unless EnableMetrics() turned them on. */
+  std::shared_ptr<ModelMetrics> metrics_;
+
  public:
   nlohmann::json metadata_ = nullptr;
   DLRModel(const DLContext& ctx, const DLRBackend& backend) : ctx_(ctx), backend_(backend) {}
@@ -148,6 +203,11 @@ class DLR_DLL DLRModel {
   virtual const std::vector<int64_t>& GetInputShape(int index) const;
   virtual void GetInput(const char* name, void* input) = 0;
   virtual void SetInput(const char* name, const int64_t* shape, const void* input, int dim) = 0;
+  /*! \brief Set an input from data of another dtype, converting it to the dtype of the input.
+   *  The default implementation converts it to a temporary buffer passed to SetInput.
+   */
+  virtual void SetInputTyped(const char* name, const int64_t* shape, const void* input, int dim,
+                             const char* dtype);
 
   /* Output related functions */
   virtual int GetNumOutputs() { return num_outputs_; }
@@ -164,9 +224,61 @@ class DLR_DLL DLRModel {
   virtual void GetOutputSizeDim(int index, int64_t* size, int* dim) = 0;
   virtual void GetOutput(int index, void* out) = 0;
   virtual const void* GetOutputPtr(int index) const = 0;
+  /*! \brief Get an output as data of another dtype, converting it to dtype. The default
+   *  implementation converts the data copied by GetOutput.
+   */
+  virtual void GetOutputTyped(int index, void* out, const char* dtype);
   virtual void GetOutputByName(const char* name, void* out) {
     throw dmlc::Error("GetOutputByName is not supported yet!");
   }
+  /*! \brief Keep the outputs of each run in one of num_sets buffer sets until ReleaseOutputs(),
+   *  so that they can be read while the next inference runs. 0 turns it off. Supported by TVM and
+   *  Relay VM models, and must not be called while the model runs.
+   */
+  void SetNumOutputBuffers(int num_sets);
+  /*! \brief Ticket of the buffered outputs of the last run. */
+  int64_t GetOutputTicket() const;
+  /*! \brief Pointer to the index-th buffered output of a ticket, valid until it is released. */
+  const void* GetTicketOutputPtr(int64_t ticket, int index) const;
+  /*! \brief Shape of the index-th buffered output of a ticket. */
+  void GetTicketOutputShape(int64_t ticket, int index, int64_t* shape) const;
+  /*! \brief Release the buffer set of a ticket for reuse by a later run. */
+  void ReleaseOutputs(int64_t ticket);
+
+  /*! \brief Count cycles, instructions, LLC misses, branch misses and context switches of the
+   *  runs with Linux perf_event_open(), or stop counting. Enabling resets the counts.
+   */
+  virtual void EnablePerfCounters(bool enable);
+  /*! \brief Counts of the runs since the counters were enabled, null if they are not. */
+  const PerfCounters* GetPerfCounters() const { return perf_counters_.get(); }
+  /*! \brief Run(), counted if the counters are enabled. */
+  void RunCounted();
+
+  /*! \brief Record the phases of the last capacity requests made through the C API, logging the
+   *  ones slower than slow_threshold_ms unless it is 0. A capacity of 0 turns it off. Must not be
+   *  called while the model runs.
+   */
+  void EnableFlightRecorder(int capacity, double slow_threshold_ms);
+  /*! \brief Recorder of the last requests, null if it is not enabled. */
+  FlightRecorder* GetFlightRecorder() const { return flight_recorder_.get(); }
+
+  /*! \brief Measure the calls made through the C API for GetMetricsText(), labelled with name.
+   *  Disabling drops the metrics. Must not be called while the model runs.
+   */
+  void EnableMetrics(bool enable, const std::string& name);
+  /*! \brief Metrics of the calls, null if they are not enabled. */
+  ModelMetrics* GetMetrics() const { return metrics_.get(); }
+
+  /*! \brief Get the quantization of an input, declared in its entry of Model.Inputs in the
+   *  metadata as "quantization": {"scale": <float>, "zero_point": <int>}.
+   *  \return Whether the input is quantized.
+   */
+  virtual bool GetInputQuantization(const char* name, QuantizationParams* params) const;
+  /*! \brief Get the quantization of an output, declared in its entry of Model.Outputs in the
+   *  metadata like the ones of inputs.
+   *  \return Whether the output is quantized.
+   */
+  virtual bool GetOutputQuantization(int index, QuantizationParams* params) const;
 
   /* Weights related functions */
   virtual int GetNumWeights() const { return num_weights_; }
@@ -175,10 +287,15 @@ class DLR_DLL DLRModel {
 
   virtual DLDeviceType GetDeviceTypeFromMetadata() const;
   virtual DLRBackend GetBackend() { return backend_; }
+  const DLContext& GetContext() const { return ctx_; }
   virtual void SetNumThreads(int threads) = 0;
   virtual bool HasMetadata() const;
   virtual void UseCPUAffinity(bool use) = 0;
   virtual void Run() = 0;
+
+  /* Tag of the CPU variant the model was loaded from, empty for untagged files */
+  const std::string& GetCPUVariant() const { return cpu_variant_; }
+  void SetCPUVariant(const std::string& tag) { cpu_variant_ = tag; }
 };
 
 typedef std::shared_ptr<DLRModel> DLRModelPtr;
@@ -0,0 +1,76 @@
+#ifndef DLR_COMPRESSED_PARAMS_H_
+#define DLR_COMPRESSED_PARAMS_H_
+
+#include <graph/graph_runtime.h>
+
+#include <string>
+#include <vector>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Compression codec of a compressed params file.
+ *
+ * A compressed params file (.params.zst or .params.lz4) holds the same tensors as a TVM .params
+ * file, with the data of each tensor split in independently compressed chunks so that they can be
+ * decompressed in parallel, directly into the graph's parameter arrays. Layout, little endian:
+ *
+ *   uint64 magic, uint32 codec, uint32 reserved, uint64 num_tensors
+ *   num_tensors x {uint64 name_length, name, int32 ndim, DLDataType dtype, int64 shape[ndim],
+ *                  uint64 nbytes, uint64 num_chunks,
+ *                  num_chunks x {uint64 raw_bytes, uint64 compressed_bytes}}
+ *   compressed chunks, in the order of the table above
+ */
+enum class ParamsCodec : uint32_t { kNone = 0, kZSTD = 1, kLZ4 = 2 };
+
+constexpr uint64_t kCompressedParamsMagic = 0x315A4D5250524C44;  // "DLRPRMZ1"
+
+/*! \brief View of a tensor of a params file. */
+struct ParamsTensor {
+  std::string name;
+  DLDataType dtype;
+  std::vector<int64_t> shape;
+  const char* data;
+  size_t nbytes;
+};
+
+/*! \brief Whether the file name is the one of a plain or compressed params file. */
+DLR_DLL bool IsParamsFile(const std::string& filename);
+
+/*! \brief Whether data holds a compressed params file. */
+DLR_DLL bool IsCompressedParams(const void* data, size_t size);
+
+/*! \brief Whether libdlr was built with support for the codec. */
+DLR_DLL bool IsParamsCodecSupported(ParamsCodec codec);
+
+/*! \brief Get the codec matching the extension of a compressed params file name. */
+DLR_DLL ParamsCodec GetParamsCodecFromFilename(const std::string& filename);
+
+/*! \brief Parse a plain TVM params file. The returned tensors point into data. */
+DLR_DLL std::vector<ParamsTensor> ParseParams(const void* data, size_t size);
+
+/*! \brief Read the names, types, shapes and sizes of the tensors of a plain or compressed params
+ *  file without reading their data. data of the returned tensors is null.
+ */
+DLR_DLL std::vector<ParamsTensor> ReadParamsHeaders(const std::string& filename);
+
+/*! \brief Serialize tensors into a compressed params file.
+ *  \param chunk_bytes Maximum uncompressed size of a chunk.
+ *  \param level Compression level, 0 for the codec default.
+ */
+DLR_DLL std::string CompressParams(const std::vector<ParamsTensor>& tensors, ParamsCodec codec,
+                                   size_t chunk_bytes, int level = 0);
+
+/*! \brief Decompress a compressed params file into the parameters of a graph runtime.
+ *  \param num_threads Number of decompression threads, 0 to use all cores.
+ *  \return Names of the parameters found in the graph, which GraphRuntime::GetWeightNames() does
+ *  not report since they bypass GraphRuntime::LoadParams().
+ */
+DLR_DLL std::vector<std::string> LoadCompressedParams(tvm::runtime::GraphRuntime* runtime,
+                                                      const void* data, size_t size,
+                                                      int num_threads = 0);
+
+}  // namespace dlr
+
+#endif  // DLR_COMPRESSED_PARAMS_H_
@@ -0,0 +1,45 @@
+#ifndef DLR_COST_H_
+#define DLR_COST_H_
+
+#include <string>
+#include <vector>
+
+#include "dlr_common.h"
+#include "dlr_compressed_params.h"
+
+namespace dlr {
+
+/*! \brief Cost of a model estimated statically from its files, without loading it. */
+struct ModelCost {
+  DLRBackend backend = DLRBackend::kUNKNOWN;
+  // Floating point operations of a run, -1 if they cannot be estimated for the backend.
+  int64_t flops = -1;
+  int64_t weight_bytes = 0;
+  // Memory of the intermediate tensors, inputs and outputs included.
+  int64_t activation_bytes = 0;
+  // Memory held by a loaded model while it runs, besides its code.
+  int64_t peak_memory_bytes = 0;
+};
+
+/*! \brief Estimate the cost of a TVM graph.
+ *
+ * Memory follows the storage plan of the graph runtime: each storage id is as large as the
+ * largest entry placed in it, and storage of the params counts as weights. FLOPs count two per
+ * multiply-add of the convolutions, dense layers and batch matmuls, which are found by the name
+ * of their fused kernels, and one per output element of any other kernel.
+ *
+ * \param graph The graph JSON.
+ * \param params Headers of the params of the graph, as read by ReadParamsHeaders().
+ */
+DLR_DLL ModelCost EstimateGraphCost(const nlohmann::json& graph,
+                                    const std::vector<ParamsTensor>& params);
+
+/*! \brief Estimate the cost of the model of a folder from its graph JSON and params headers for
+ *  TVM models, or from its metadata and the size of its executable, which embeds the weights,
+ *  for RelayVM models. FLOPs of RelayVM models are unknown.
+ */
+DLR_DLL ModelCost EstimateModelCost(const std::vector<std::string>& files);
+
+}  // namespace dlr
+
+#endif  // DLR_COST_H_
@@ -0,0 +1,41 @@
+#ifndef DLR_CPU_FEATURES_H_
+#define DLR_CPU_FEATURES_H_
+
+#include <string>
+#include <vector>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief ISA tags a model file can be compiled for, from the most to the least capable.
+ *
+ * A model folder may hold variants of its files for several tags, named <name>.<tag><ext>, e.g.
+ * compiled.avx512.so, compiled.avx2.so and compiled.so. Graph and params files can also be
+ * tagged if they differ between variants (compiled.avx512.json, compiled.avx512.params).
+ */
+constexpr const char* CPU_VARIANT_TAGS[] = {"avx512vnni", "avx512",  "avx2", "avx", "sse42",
+                                            "sve",        "dotprod", "neon"};
+
+/*! \brief Get the tags of CPU_VARIANT_TAGS supported by the host CPU and operating system.
+ */
+DLR_DLL const std::vector<std::string>& GetCPUFeatures();
+
+/*! \brief Keep only the files of the best variant supported by the given CPU features.
+ *  Untagged files are used by default and are replaced by the files of the selected tag.
+ *  \param files Files of the model folder.
+ *  \param features Tags supported by the CPU, see GetCPUFeatures().
+ *  \param tag If not null, receives the selected tag, or an empty string for untagged files.
+ *  \return Files of the selected variant. Unchanged if the folder holds no tagged file.
+ */
+DLR_DLL std::vector<std::string> SelectCPUVariant(const std::vector<std::string>& files,
+                                                  const std::vector<std::string>& features,
+                                                  std::string* tag);
+
+/*! \brief Select the best variant for the host CPU, logging the choice. */
+DLR_DLL std::vector<std::string> SelectCPUVariant(const std::vector<std::string>& files,
+                                                  std::string* tag);
+
+}  // namespace dlr
+
+#endif  // DLR_CPU_FEATURES_H_
@@ -0,0 +1,64 @@
+#ifndef DLR_DATA_CONVERT_H_
+#define DLR_DATA_CONVERT_H_
+
+#include <dlpack/dlpack.h>
+
+#include <cstdint>
+#include <string>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Get the DLDataType of a dtype string, e.g. "float32", "bfloat16" or "uint8". */
+DLR_DLL DLDataType GetDLDataTypeFromString(const std::string& dtype);
+
+/*! \brief Whether two data types are the same. */
+inline bool IsSameDLDataType(const DLDataType& a, const DLDataType& b) {
+  return a.code == b.code && a.bits == b.bits && a.lanes == b.lanes;
+}
+
+/*! \brief Whether ConvertData() supports the data type: scalar float64, float32, float16,
+ *  bfloat16 and 8 to 64-bit signed and unsigned integers.
+ */
+DLR_DLL bool IsConvertibleDLDataType(const DLDataType& dtype);
+
+/*! \brief Convert count elements of src to dst in a single pass, as a C cast would. Floats are
+ *  rounded to the nearest float16 or bfloat16 and truncated toward zero when converted to integers.
+ *  Conversions between float32 and float16 use the F16C instructions of the host CPU if it has
+ *  them.
+ */
+DLR_DLL void ConvertData(const void* src, const DLDataType& src_dtype, void* dst,
+                         const DLDataType& dst_dtype, int64_t count);
+
+/*! \brief Whether data of the type can be quantized: 8 and 16-bit integers. */
+DLR_DLL bool IsQuantizedDLDataType(const DLDataType& dtype);
+
+/*! \brief Quantize count floats of src to dst, an 8 or 16-bit integer type, rounding to the nearest
+ *  value and saturating. Float32 to int8 and uint8 use AVX2 if the host CPU has it.
+ */
+DLR_DLL void QuantizeData(const void* src, const DLDataType& src_dtype, void* dst,
+                          const DLDataType& dst_dtype, int64_t count,
+                          const QuantizationParams& params);
+
+/*! \brief Dequantize count integers of src to dst, a float type. Int8 and uint8 to float32 use
+ *  AVX2 if the host CPU has it.
+ */
+DLR_DLL void DequantizeData(const void* src, const DLDataType& src_dtype, void* dst,
+                            const DLDataType& dst_dtype, int64_t count,
+                            const QuantizationParams& params);
+
+/*! \brief Whether the elements of a tensor are laid out in row-major order without gaps: it has no
+ *  strides, or strides which are the ones of its shape.
+ */
+DLR_DLL bool IsCompactTensor(const DLTensor& tensor);
+
+/*! \brief Gather the elements of a strided tensor on the CPU into dst, in row-major order and in a
+ *  single pass. Runs of contiguous elements are copied whole, and 4-byte elements are gathered
+ *  with AVX2 if the host CPU has it.
+ */
+DLR_DLL void CopyStridedData(const DLTensor& src, void* dst);
+
+}  // namespace dlr
+
+#endif  // DLR_DATA_CONVERT_H_
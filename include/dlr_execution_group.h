@@ -0,0 +1,44 @@
+#ifndef DLR_EXECUTION_GROUP_H_
+#define DLR_EXECUTION_GROUP_H_
+
+#include <mutex>
+#include <unordered_map>
+
+#include "dlr_common.h"
+#include "dlr_graph_runtime.h"
+
+namespace dlr {
+
+/*! \brief Group of models which never run at the same time, e.g. models used by one worker thread.
+ *
+ * Members share a single activation arena sized to the largest member instead of each owning its
+ * own intermediate storage. Runs of members are serialized by the group mutex.
+ */
+class DLR_DLL ExecutionGroup {
+ private:
+  DLContext ctx_;
+  // Held while a member runs or while members are being rebound to a new arena.
+  std::mutex mutex_;
+  tvm::runtime::NDArray arena_;
+  size_t arena_bytes_ = 0;
+  // Member runtime -> bytes of intermediate storage it would own on its own.
+  std::unordered_map<DLRGraphRuntime*, size_t> members_;
+  void ResizeArena(size_t nbytes);
+
+ public:
+  /*! \brief Add a runtime loaded on ctx to the group, moving its intermediate storage to the arena.
+   */
+  void Join(DLRGraphRuntime* runtime, const DLContext& ctx);
+  /*! \brief Remove a runtime from the group. Must be called before the runtime is destroyed. */
+  void Leave(DLRGraphRuntime* runtime);
+  /*! \brief Mutex to hold while running a member. */
+  std::mutex& GetMutex() { return mutex_; }
+  /*! \brief Size of the shared arena in bytes. */
+  size_t GetArenaBytes();
+  /*! \brief Bytes saved compared to every member owning its own intermediate storage. */
+  size_t GetSavedBytes();
+};
+
+}  // namespace dlr
+
+#endif  // DLR_EXECUTION_GROUP_H_
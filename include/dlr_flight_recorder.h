@@ -0,0 +1,91 @@
+#ifndef DLR_FLIGHT_RECORDER_H_
+#define DLR_FLIGHT_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Phases of one request on a model, in nanoseconds of the steady clock. */
+struct FlightRecord {
+  uint64_t request = 0;
+  uint64_t thread = 0;
+  int64_t batch_size = 0;
+  // Elements of the inputs set.
+  int64_t input_size = 0;
+  int64_t num_inputs = 0;
+  int64_t num_outputs = 0;
+  // First SetInput() of the request to the end of the last one, 0 if inputs were not set.
+  uint64_t set_input_start = 0;
+  uint64_t set_input_end = 0;
+  uint64_t run_start = 0;
+  uint64_t run_end = 0;
+  // End of the last GetOutput() after the run, 0 if no output was read.
+  uint64_t get_output_end = 0;
+};
+
+/*! \brief Ring buffer of the last requests of a model, a request being the inputs set since the
+ *  previous run, a run and the outputs read after it.
+ *
+ * Recording never blocks: each request is written to its slot under a sequence number, and a dump
+ * skips the slots being written. Requests from the first SetInput() to the end of the run slower
+ * than the threshold are logged with their phases when the run ends.
+ */
+class DLR_DLL FlightRecorder {
+ public:
+  /*! \brief Record the last capacity requests of model, logging those slower than
+   *  slow_threshold_ms, or none if it is 0.
+   */
+  FlightRecorder(DLRModel* model, int capacity, double slow_threshold_ms);
+  ~FlightRecorder();
+
+  static uint64_t Now();
+
+  /*! \brief Record a SetInput() of size elements in a batch of batch_size, from start to end. */
+  void OnSetInput(uint64_t start, uint64_t end, int64_t batch_size, int64_t size);
+  /*! \brief Record a run from start to end, completing the phases of the inputs of the request. */
+  void OnRun(uint64_t start, uint64_t end);
+  /*! \brief Record a GetOutput() ending at end, after the last run. */
+  void OnGetOutput(uint64_t end);
+
+  /*! \brief Copy of the recorded requests, oldest first. */
+  std::vector<FlightRecord> GetRecords() const;
+  /*! \brief Write the recorded requests as JSON lines, oldest first. */
+  void Dump(std::ostream& os) const;
+
+  /*! \brief Dump the recorders of every model to path on signal signum, on POSIX systems. */
+  static void InstallDumpSignal(int signum, const std::string& path);
+  /*! \brief Dump the recorders of every model to path. */
+  static void DumpAll(const std::string& path);
+
+ private:
+  static constexpr int kNumFields = 11;
+  struct Slot {
+    // Even when the record is stable, odd while it is written. 0 until the first write.
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> fields[kNumFields];
+  };
+  const DLRModel* model_;
+  const char* backend_;
+  std::unique_ptr<Slot[]> slots_;
+  int capacity_;
+  uint64_t slow_threshold_ns_;
+  std::atomic<uint64_t> next_request_{0};
+  // Request being assembled by the thread driving the model.
+  FlightRecord pending_;
+  bool pending_ran_ = true;
+  // Slot of the last run, for the outputs read after it.
+  int last_slot_ = -1;
+  void Write(int slot, const FlightRecord& record);
+  bool Read(int slot, FlightRecord* record) const;
+};
+
+}  // namespace dlr
+
+#endif  // DLR_FLIGHT_RECORDER_H_
@@ -0,0 +1,44 @@
+#ifndef DLR_FORK_H_
+#define DLR_FORK_H_
+
+#include <functional>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Enable or disable prefork mode, for processes which load models and then fork workers.
+ *
+ * TVM keeps a pool of worker threads per calling thread and threads do not survive fork(), so a
+ * child forked from a thread which ran a model would wait forever on its parent's workers. In
+ * prefork mode, inference runs on a short-lived thread whose pool is released when it exits, and
+ * the weights of TVM models created on the CPU are placed in read-only pages of their own so that
+ * children keep sharing them.
+ */
+DLR_DLL void SetPreforkMode(bool enable);
+
+/*! \brief Whether prefork mode is enabled. */
+DLR_DLL bool IsPreforkMode();
+
+/*! \brief Wait for running inferences to finish and block new ones until PostForkParent() or
+ *  PostForkChild() is called by the same thread.
+ */
+DLR_DLL void PrepareFork();
+
+/*! \brief Resume inference in the parent after fork(). */
+DLR_DLL void PostForkParent();
+
+/*! \brief Resume inference in the child after fork(), leaving prefork mode so that the child
+ *  runs models on its own thread pool.
+ */
+DLR_DLL void PostForkChild();
+
+/*! \brief Run inference fn, holding off fork() while it runs once prefork mode has been enabled
+ *  or PrepareFork() called; until then fn runs without locking. In prefork mode, fn runs on a
+ *  short-lived thread.
+ */
+DLR_DLL void RunForkSafe(const std::function<void()>& fn);
+
+}  // namespace dlr
+
+#endif  // DLR_FORK_H_
@@ -0,0 +1,77 @@
+#ifndef DLR_GRAPH_RUNTIME_H_
+#define DLR_GRAPH_RUNTIME_H_
+
+#include <graph/graph_runtime.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dlr_binary_io.h"
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief GraphRuntime extended with the hooks DLR needs to rearrange the memory of a loaded graph.
+ *
+ * Everything that depends on GraphRuntime internals is kept in this class, so that it can be
+ * updated in one place together with TVM.
+ */
+class DLR_DLL DLRGraphRuntime : public tvm::runtime::GraphRuntime {
+ public:
+  /*! \brief Alignment of each storage entry placed in an external buffer. */
+  static constexpr size_t kStorageAlignment = 64;
+
+  /*! \brief Bytes of external buffer needed by BindIntermediateStorage(). */
+  size_t GetIntermediateStorageBytes();
+
+  /*! \brief Place the storage entries that only hold intermediate activations (not inputs,
+   *  weights or outputs) in the given buffer and release the runtime's own copy of them.
+   *  \param arena Buffer on the runtime's context of at least GetIntermediateStorageBytes() bytes.
+   */
+  void BindIntermediateStorage(const tvm::runtime::NDArray& arena);
+
+  /*! \brief Bytes of the storage entry holding the given input or weight. */
+  size_t GetInputStorageBytes(int index) const;
+
+  /*! \brief Place inputs or weights in external buffers and release the runtime's own copy of
+   *  them. The buffers must hold GetInputStorageBytes() bytes and may be read-only, since the
+   *  storage of graph inputs is never reused for intermediate activations.
+   *  \param storage Pairs of input index and buffer on the runtime's context.
+   */
+  void BindInputStorage(const std::vector<std::pair<int, tvm::runtime::NDArray>>& storage);
+
+  /*! \brief Initialize from a graph encoded by SerializeGraph(), without parsing JSON.
+   *  Equivalent to GraphRuntime::Init() with the graph JSON it was encoded from.
+   */
+  void InitFromBinary(const void* data, size_t size, tvm::runtime::Module module,
+                      const std::vector<TVMContext>& ctxs);
+
+  /*! \brief Parse a graph JSON and encode the parsed graph for InitFromBinary(). */
+  static std::string SerializeGraph(const std::string& graph_json);
+
+ protected:
+  /*! \brief Write the parsed graph structure and attributes. */
+  void SaveGraph(BinaryWriter* writer) const;
+
+  /*! \brief Read the graph structure and attributes written by SaveGraph(). */
+  void LoadGraph(BinaryReader* reader);
+
+  /*! \brief Storage ids only used by intermediate activations. */
+  std::vector<int> GetIntermediateStorageIds() const;
+
+  /*! \brief Point data entries of the given storage id to a new buffer. */
+  void RebindStorage(int storage_id, tvm::runtime::NDArray storage);
+
+  /*! \brief Recreate the operator closures after data entries have been rebound. */
+  void RebuildOpExecs();
+};
+
+/*! \brief Get a view of nbytes bytes of buffer starting at offset. The view keeps buffer alive.
+ */
+tvm::runtime::NDArray SliceNDArray(const tvm::runtime::NDArray& buffer, size_t offset,
+                                   size_t nbytes);
+
+}  // namespace dlr
+
+#endif  // DLR_GRAPH_RUNTIME_H_
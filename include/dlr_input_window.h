@@ -0,0 +1,55 @@
+#ifndef DLR_INPUT_WINDOW_H_
+#define DLR_INPUT_WINDOW_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Sliding window over the last rows appended to an input, e.g. the last samples of a time
+ *  series. Appending rows costs the same whatever the length of the window.
+ *
+ * By default, rows are written twice to a buffer of twice the length of the window, so that the
+ * window is always a contiguous run of rows, oldest first, starting at a 64-byte aligned address.
+ * Rows whose size is not a multiple of 64 bytes are written to up to 64 such buffers, shifted so
+ * that one of them is aligned wherever the window starts. In rotated mode, for models which
+ * tolerate a rotation of the window, each row is written once over the oldest one, in a buffer of
+ * the length of the window.
+ */
+class DLR_DLL InputWindow {
+ private:
+  int64_t length_;
+  size_t row_bytes_;
+  std::vector<char> storage_;
+  // Buffers the rows are written to. A single one in rotated mode.
+  std::vector<char*> replicas_;
+  // Misalignment of the window between consecutive replicas.
+  size_t replica_shift_ = 1;
+  // Index of the oldest row, where the next one is written.
+  int64_t head_ = 0;
+  bool rotated_;
+
+ public:
+  /*! \brief Create a window of length rows of row_bytes each, initially zero.
+   *  \param rotated_buffer Buffer of length rows to write rows to in rotated mode, null for the
+   *         default mode.
+   */
+  InputWindow(int64_t length, size_t row_bytes, void* rotated_buffer = nullptr);
+  /*! \brief Append count rows, dropping the oldest ones. */
+  void Append(const void* rows, int64_t count);
+  /*! \brief The rows of the window. Oldest first, except in rotated mode where the oldest row is
+   *  at GetOffset().
+   */
+  const void* GetData() const;
+  /*! \brief Index of the oldest row in GetData(), always 0 except in rotated mode. */
+  int64_t GetOffset() const { return rotated_ ? head_ : 0; }
+  bool IsRotated() const { return rotated_; }
+  int64_t GetLength() const { return length_; }
+  size_t GetRowBytes() const { return row_bytes_; }
+};
+
+}  // namespace dlr
+
+#endif  // DLR_INPUT_WINDOW_H_
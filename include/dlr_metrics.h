@@ -0,0 +1,81 @@
+#ifndef DLR_METRICS_H_
+#define DLR_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Calls to a model measured by its metrics. */
+enum MetricPhase { kMetricSetInput, kMetricRun, kMetricGetOutput, kNumMetricPhases };
+
+/*! \brief Counters and histograms of the calls to a model, rendered with the ones of every other
+ *  model by GetMetricsText().
+ *
+ * Updates never lock: each thread updates one of a fixed set of shards, picked once per thread,
+ * with relaxed atomic additions, and rendering sums the shards. A rendering concurrent with calls
+ * may see a call counted in some metrics and not yet in others.
+ */
+class DLR_DLL ModelMetrics {
+ public:
+  /*! \brief Metrics of a model, labelled with name and the backend. Throws if another model
+   *  already has metrics with the same labels.
+   */
+  ModelMetrics(DLRModel* model, const std::string& name);
+  ~ModelMetrics();
+  ModelMetrics(const ModelMetrics&) = delete;
+  ModelMetrics& operator=(const ModelMetrics&) = delete;
+
+  static uint64_t Now();
+
+  /*! \brief Record a call which took nanoseconds and copied bytes. Runs are observed with the
+   *  batch size of the last inputs set.
+   */
+  void OnCall(MetricPhase phase, uint64_t nanoseconds, uint64_t bytes);
+  /*! \brief Record a call which failed. */
+  void OnError(MetricPhase phase);
+  /*! \brief Set the batch size of the next runs. */
+  void SetBatchSize(int64_t batch_size) {
+    batch_size_.store(batch_size, std::memory_order_relaxed);
+  }
+
+  /*! \brief Write the samples of the model of a metric family, an index of the families listed
+   *  in dlr_metrics.cc.
+   */
+  void Render(std::ostream& os, int family) const;
+
+ private:
+  static constexpr int kNumShards = 16;
+  static constexpr int kNumLatencyBuckets = 16;
+  static constexpr int kNumBatchBuckets = 10;
+  struct Shard {
+    std::atomic<uint64_t> calls[kNumMetricPhases];
+    std::atomic<uint64_t> errors[kNumMetricPhases];
+    std::atomic<uint64_t> bytes[kNumMetricPhases];
+    std::atomic<uint64_t> latency_ns[kNumMetricPhases];
+    // Non-cumulative, the last bucket counts the calls above the largest bound.
+    std::atomic<uint64_t> latency_buckets[kNumMetricPhases][kNumLatencyBuckets + 1];
+    std::atomic<uint64_t> batch_sizes;
+    std::atomic<uint64_t> batch_buckets[kNumBatchBuckets + 1];
+  };
+  std::string labels_;
+  const DLRModel* model_;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<int64_t> batch_size_{0};
+  Shard& GetShard();
+  /*! \brief Sum over the shards of the value of get(shard). */
+  template <typename Get>
+  uint64_t Sum(Get get) const;
+};
+
+/*! \brief Metrics of every model with metrics enabled, in the Prometheus text format. */
+DLR_DLL std::string GetMetricsText();
+
+}  // namespace dlr
+
+#endif  // DLR_METRICS_H_
@@ -0,0 +1,113 @@
+#ifndef DLR_MODULE_CACHE_H_
+#define DLR_MODULE_CACHE_H_
+
+#include <tvm/runtime/module.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Get the cache key of a model artifact on disk: its canonical path followed by a hash of
+ *  its contents, so that a file replaced in place is not mistaken for the one already loaded.
+ */
+DLR_DLL std::string GetArtifactKey(const std::string& path);
+
+/*! \brief Get the cache key of a model artifact held in memory. */
+DLR_DLL std::string GetArtifactKey(const void* data, size_t size);
+
+/*! \brief Process-wide, reference-counted cache of loaded model artifacts.
+ *
+ * The cache only keeps weak references: an entry stays alive as long as one of the pointers
+ * returned by GetOrLoad() does, and is loaded again on the next request once all handles of the
+ * model have been deleted.
+ */
+template <typename T>
+class ModuleCache {
+ public:
+  using Loader = std::function<std::shared_ptr<T>()>;
+
+  /*! \brief Return the entry stored under key, calling loader to create it if there is none.
+   *  Loads run outside the lock of the cache, so that only loads of the same key wait on each
+   *  other.
+   */
+  std::shared_ptr<T> GetOrLoad(const std::string& key, const Loader& loader) {
+    std::shared_ptr<std::mutex> load_mutex;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::shared_ptr<T> entry = Find(key);
+      if (entry) return entry;
+      PruneExpired();
+      std::shared_ptr<std::mutex>& slot = loading_[key];
+      if (!slot) slot = std::make_shared<std::mutex>();
+      load_mutex = slot;
+    }
+    std::lock_guard<std::mutex> load_lock(*load_mutex);
+    {
+      // Loaded by the thread which held load_mutex before us.
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::shared_ptr<T> entry = Find(key);
+      if (entry) return entry;
+    }
+    std::shared_ptr<T> entry = loader();
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = entry;
+    return entry;
+  }
+
+  /*! \brief Number of entries currently alive. */
+  size_t Size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    PruneExpired();
+    return entries_.size();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::weak_ptr<T>> entries_;
+  // Serializes the loads of each key. Held by the cache and by the threads loading the key.
+  std::unordered_map<std::string, std::shared_ptr<std::mutex>> loading_;
+
+  std::shared_ptr<T> Find(const std::string& key) {
+    auto it = entries_.find(key);
+    return it != entries_.end() ? it->second.lock() : nullptr;
+  }
+
+  void PruneExpired() {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->second.expired()) {
+        it = entries_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    // Copies of the mutexes are only taken under mutex_, so a count of 1 means no load is running.
+    for (auto it = loading_.begin(); it != loading_.end();) {
+      if (it->second.use_count() == 1) {
+        it = loading_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+};
+
+/*! \brief Load a compiled TVM library, sharing it with every model loaded from the same artifact.
+ *  The caller must keep the returned pointer for as long as it uses the module.
+ *  \param path Path to the compiled library.
+ *  \param key If not null, receives the artifact key of the library.
+ */
+DLR_DLL std::shared_ptr<tvm::runtime::Module> LoadSharedTVMModule(const std::string& path,
+                                                                  std::string* key = nullptr);
+
+/*! \brief Number of distinct TVM libraries currently shared through LoadSharedTVMModule(). */
+DLR_DLL size_t GetNumSharedTVMModules();
+
+}  // namespace dlr
+
+#endif  // DLR_MODULE_CACHE_H_
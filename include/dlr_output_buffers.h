@@ -0,0 +1,62 @@
+#ifndef DLR_OUTPUT_BUFFERS_H_
+#define DLR_OUTPUT_BUFFERS_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Sets of buffers keeping the outputs of the last runs of a model, so that the outputs of
+ *  one run can be read while the next inference runs.
+ *
+ * The outputs of each run are identified by a ticket, and the set holding them is not reused until
+ * the ticket is released. A run waits for a set to be released when all of them are held.
+ */
+class DLR_DLL OutputBuffers {
+ public:
+  explicit OutputBuffers(int num_sets);
+
+  /*! \brief Reserve a set for the outputs of a run, waiting until one is not held. */
+  int Reserve();
+  /*! \brief Buffer of the index-th output in a reserved set, resized to nbytes. */
+  void* GetBuffer(int set, int index, size_t nbytes);
+  /*! \brief Shape of the index-th output in a reserved set. */
+  std::vector<int64_t>& GetShape(int set, int index);
+  /*! \brief Hold a reserved set under a new ticket, which becomes the last one. */
+  int64_t Publish(int set);
+  /*! \brief Give a reserved set back, e.g. when its run failed. */
+  void Cancel(int set);
+
+  /*! \brief Ticket of the outputs of the last run, -1 if there was none. */
+  int64_t GetLastTicket() const;
+  /*! \brief Pointer to the index-th output of a ticket, valid until the ticket is released. */
+  const void* GetOutputPtr(int64_t ticket, int index) const;
+  /*! \brief Shape of the index-th output of a ticket. */
+  const std::vector<int64_t>& GetOutputShape(int64_t ticket, int index) const;
+  /*! \brief Release a ticket, letting a run reuse its set. */
+  void Release(int64_t ticket);
+
+ private:
+  static constexpr int64_t kFree = -1;
+  static constexpr int64_t kReserved = -2;
+  struct BufferSet {
+    std::vector<std::vector<char>> buffers;
+    std::vector<std::vector<int64_t>> shapes;
+    // Ticket of the outputs in the set, or kFree or kReserved.
+    int64_t ticket = kFree;
+  };
+  std::vector<BufferSet> sets_;
+  int64_t next_ticket_ = 0;
+  int64_t last_ticket_ = -1;
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+  // Set holding the outputs of a ticket. mutex_ must be held.
+  const BufferSet& FindSet(int64_t ticket) const;
+};
+
+}  // namespace dlr
+
+#endif  // DLR_OUTPUT_BUFFERS_H_
@@ -0,0 +1,68 @@
+#ifndef DLR_PERF_COUNTERS_H_
+#define DLR_PERF_COUNTERS_H_
+
+#include <array>
+#include <memory>
+#include <mutex>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Hardware and software counters measured around runs of a model. */
+enum PerfCounter {
+  kPerfCycles,
+  kPerfInstructions,
+  kPerfLLCMisses,
+  kPerfBranchMisses,
+  kPerfContextSwitches,
+  kNumPerfCounters
+};
+
+class PerfEventSet;
+
+/*! \brief Counters of the runs of a model, with Linux perf_event_open(), summed over the runs.
+ *
+ * Counting follows every thread of the process, so that the thread pools of the runtimes are
+ * counted along with the thread calling Run(). Counters are opened on the threads alive when the
+ * first PerfCounters of the process is created and inherited by the threads they start, so that
+ * threads started later, even during a run, are counted, and the counts of threads which exited
+ * remain. Work of other threads running at the same time is counted too. The counters of every
+ * model in the process, e.g. of a pipeline and its stages, share one set of file descriptors per
+ * thread. Cycles, instructions, LLC misses and branch misses count user space only, so that they
+ * are available without privileges. Counters multiplexed by the kernel are scaled to the time they
+ * were enabled.
+ */
+class DLR_DLL PerfCounters {
+ public:
+  /*! \brief Open the counters, failing if none of them is available on this host. */
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  using Counts = std::array<double, kNumPerfCounters>;
+
+  /*! \brief Start counting a run. Runs may be counted concurrently.
+   *  \return The counts at the start of the run, to pass to Stop().
+   */
+  Counts Start() const;
+  /*! \brief Stop counting a run and add its counts since start to the totals. */
+  void Stop(const Counts& start);
+  /*! \brief Totals of the runs so far, -1 for counters unavailable on this host.
+   *  \param values Array of kNumPerfCounters values.
+   *  \return The number of runs counted.
+   */
+  int64_t Get(int64_t* values) const;
+
+ private:
+  // Counters opened on the threads of the process, shared by every PerfCounters.
+  std::shared_ptr<PerfEventSet> events_;
+  Counts totals_;
+  int64_t num_runs_ = 0;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace dlr
+
+#endif  // DLR_PERF_COUNTERS_H_
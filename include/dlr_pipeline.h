@@ -23,6 +23,8 @@ class DLR_DLL PipelineModel : public DLRModel {
   void CheckModelsCompatibility(const DLRModelPtr& m0, const DLRModelPtr& m1, const int m1_id,
                                 const bool is_runtime_check);
   void SetupPipelineModel();
+  /*! \brief Run the index-th model, counted and traced. */
+  void RunStage(int index);
 
  public:
   /*! \brief Load model files from given folder path.
@@ -49,6 +51,13 @@ class DLR_DLL PipelineModel : public DLRModel {
   virtual const char* GetWeightName(int index) const override;
   virtual std::vector<std::string> GetWeightNames() const override;
 
+  /*! \brief Number of models in the pipeline. */
+  int GetNumStages() const { return count_; }
+  /*! \brief The index-th model of the pipeline. */
+  const DLRModelPtr& GetStage(int index) const;
+
+  /*! \brief Also count each stage, see GetStage(). */
+  virtual void EnablePerfCounters(bool enable) override;
   virtual void Run() override;
   virtual void SetNumThreads(int threads) override;
   virtual void UseCPUAffinity(bool use) override;
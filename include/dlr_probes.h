@@ -0,0 +1,72 @@
+#ifndef DLR_PROBES_H_
+#define DLR_PROBES_H_
+
+#include <chrono>
+#include <cstdint>
+
+/*! \brief Static tracepoints (USDT) of provider "dlr", built in with -DUSE_USDT=ON.
+ *
+ * Each probe has a semaphore which tracers such as bpftrace raise while they are attached, and
+ * its arguments, durations included, are only computed then. Without tracers a probe costs a test
+ * of its semaphore, and builds without USE_USDT have no probes at all. Probes are listed in
+ * dlr_probes.cc with their arguments.
+ */
+#ifdef DLR_USDT
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define DLR_DECLARE_PROBE(name) extern "C" volatile unsigned short dlr_##name##_semaphore
+// Semaphores live in the .probes section, where tracers find them. Defined in dlr_probes.cc.
+#define DLR_DEFINE_PROBE(name) \
+  __attribute__((section(".probes"))) volatile unsigned short dlr_##name##_semaphore = 0
+#define DLR_PROBE_ENABLED(name) __builtin_expect(dlr_##name##_semaphore != 0, 0)
+#define DLR_PROBE(name, ...)                                          \
+  do {                                                                \
+    if (DLR_PROBE_ENABLED(name)) STAP_PROBEV(dlr, name, __VA_ARGS__); \
+  } while (0)
+#else
+#define DLR_DECLARE_PROBE(name) static_assert(true, "")
+#define DLR_PROBE_ENABLED(name) false
+// Arguments are type-checked but never evaluated.
+#define DLR_PROBE(name, ...)                             \
+  do {                                                   \
+    if (false) dlr::IgnoreProbeArguments(__VA_ARGS__);   \
+  } while (0)
+#endif  // DLR_USDT
+
+DLR_DECLARE_PROBE(load__start);
+DLR_DECLARE_PROBE(load__done);
+DLR_DECLARE_PROBE(set__input);
+DLR_DECLARE_PROBE(run__start);
+DLR_DECLARE_PROBE(run__done);
+DLR_DECLARE_PROBE(get__output);
+DLR_DECLARE_PROBE(pipeline__stage);
+DLR_DECLARE_PROBE(transform__input);
+DLR_DECLARE_PROBE(transform__output);
+
+namespace dlr {
+
+template <typename... Args>
+inline void IgnoreProbeArguments(const Args&...) {}
+
+/*! \brief Measures the duration passed to a probe, reading the clock only if the probe is enabled
+ *  when the timer starts.
+ */
+class ProbeTimer {
+ public:
+  explicit ProbeTimer(bool enabled) : start_(enabled ? Now() : 0) {}
+  /*! \brief Nanoseconds since the timer started, 0 if the probe was disabled then. */
+  uint64_t Elapsed() const { return start_ != 0 ? Now() - start_ : 0; }
+
+ private:
+  uint64_t start_;
+  static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+};
+
+}  // namespace dlr
+
+#endif  // DLR_PROBES_H_
@@ -32,13 +32,20 @@
 
 namespace dlr {
 
+/*! \brief Number of distinct Relay VM executables currently shared between RelayVMModel instances.
+ */
+DLR_DLL size_t GetNumSharedRelayVMExecutables();
+
 class DLR_DLL RelayVMModel : public DLRModel {
  private:
   static const std::string ENTRY_FUNCTION;
   std::vector<std::string> output_names_;
   std::vector<std::string> output_types_;
-  std::shared_ptr<tvm::runtime::Module> vm_module_;
+  std::shared_ptr<tvm::runtime::Module> vm_lib_;
+  // Immutable bytecode and constant pool, shared by every VM loaded from the same artifact.
+  // Declared before vm_module_ so that it outlives the VM which points into it.
   std::shared_ptr<tvm::runtime::Module> vm_executable_;
+  std::shared_ptr<tvm::runtime::Module> vm_module_;
   std::vector<tvm::runtime::NDArray> inputs_;
   tvm::runtime::ObjectRef output_ref_;
   std::vector<tvm::runtime::NDArray> outputs_;
@@ -76,9 +83,16 @@ class DLR_DLL RelayVMModel : public DLRModel {
   virtual void GetInput(const char* name, void* input) override;
   virtual void SetInput(const char* name, const int64_t* shape, const void* input,
                         int dim) override;
+  virtual void SetInputTyped(const char* name, const int64_t* shape, const void* input, int dim,
+                             const char* dtype) override;
   void SetInputTensor(const char* name, DLTensor* tensor);
   virtual int GetNumInputs() const override;
   virtual void Run() override;
+  /*! \brief Run with the arrays in states as state inputs, then replace them with the state
+   *  outputs. Neither is copied, since every run allocates new outputs.
+   */
+  void RunWithStates(const std::vector<StateBinding>& bindings,
+                     std::vector<tvm::runtime::NDArray>* states);
   tvm::runtime::NDArray GetOutput(int index);
   virtual void GetOutput(int index, void* out) override;
   void GetOutputManagedTensorPtr(int index, const DLManagedTensor** out);
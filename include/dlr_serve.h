@@ -0,0 +1,159 @@
+#ifndef DLR_SERVE_H_
+#define DLR_SERVE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Local inference serving over a Unix domain socket, with tensors passed through shared
+ *  memory.
+ *
+ * Each client creates an anonymous shared memory segment used as a ring of requests and passes its
+ * descriptor to the server when it connects. A request reserves a region of the ring holding its
+ * inputs, followed by room for its outputs, and the socket only carries the offsets, shapes and
+ * status. Regions are released in order once their responses are read, so several requests can be
+ * in flight on one connection.
+ *
+ * Messages on the socket are a uint32 length followed by a body written with BinaryWriter, whose
+ * first field is a uint32 ServeMessage.
+ */
+constexpr uint64_t kServeMagic = 0x3156525352524C44;  // "DLRSRV1"
+constexpr uint32_t kServeVersion = 1;
+
+enum ServeMessage : uint32_t {
+  // Client: magic, version, shm size, with the shm descriptor passed as SCM_RIGHTS. Server: status.
+  kServeHello = 1,
+  // Client: model name. Server: status, then inputs {name, dtype, shape} and outputs {dtype,
+  // shape}, and the maximum batch.
+  kServeModelInfo = 2,
+  // Client: model name, request id, inputs {offset, nbytes, shape} in the order of the model,
+  // output offset and capacity. Server: request id, status, then outputs {offset, nbytes, shape}.
+  kServeInfer = 3,
+};
+
+/*! \brief Shape and type of a tensor of a served model. */
+struct ServeTensorInfo {
+  std::string name;
+  std::string dtype;
+  std::vector<int64_t> shape;
+};
+
+/*! \brief Inputs and outputs of a served model. */
+struct ServeModelInfo {
+  std::vector<ServeTensorInfo> inputs;
+  std::vector<ServeTensorInfo> outputs;
+  int64_t max_batch = 1;
+};
+
+/*! \brief A tensor passed to or returned by ServeClient. */
+struct ServeTensor {
+  std::vector<int64_t> shape;
+  std::vector<char> data;
+};
+
+/*! \brief Server of models over a Unix domain socket.
+ *
+ * Each model has a pool of instances, each with a thread taking requests from the queue of the
+ * model. A thread batches the requests queued behind the first one, up to max_batch rows, waiting
+ * at most batch_timeout_us for more: requests are concatenated along their first dimension, run
+ * once and their outputs split by rows. Requests whose inputs do not all have the same, non-zero
+ * number of rows run on their own. Batching needs a model accepting any batch up to max_batch,
+ * such as batch-variant models or RelayVM models with a dynamic batch dimension.
+ */
+class DLR_DLL ModelServer {
+ public:
+  ModelServer() = default;
+  ~ModelServer();
+  ModelServer(const ModelServer&) = delete;
+  ModelServer& operator=(const ModelServer&) = delete;
+
+  /*! \brief Serve instances of a model under name. Must be called before Start(). */
+  void AddModel(const std::string& name, const std::vector<DLRModelPtr>& instances,
+                int64_t max_batch = 1, int batch_timeout_us = 0);
+  /*! \brief Listen on socket_path, replacing a stale socket file, and start serving. Only the
+   *  user of the server may connect to the socket.
+   */
+  void Start(const std::string& socket_path);
+  /*! \brief Stop serving, failing the requests still queued, and remove the socket file. */
+  void Stop();
+
+ private:
+  struct Connection;
+  struct Request;
+  struct Pool;
+  std::map<std::string, std::shared_ptr<Pool>> pools_;
+  std::string socket_path_;
+  int listen_fd_ = -1;
+  std::atomic<bool> stopping_{false};
+  std::thread accept_thread_;
+  std::mutex connections_mutex_;
+  std::vector<std::shared_ptr<Connection>> connections_;
+  std::vector<std::thread> threads_;
+  void Accept();
+  void ReadRequests(std::shared_ptr<Connection> connection);
+  void RunRequests(Pool* pool, DLRModel* model);
+};
+
+/*! \brief Client of a ModelServer. Not thread-safe: use a client per thread. */
+class DLR_DLL ServeClient {
+ public:
+  /*! \brief Connect to the server listening on socket_path, with a ring of ring_bytes. */
+  explicit ServeClient(const std::string& socket_path, size_t ring_bytes = 64 << 20);
+  ~ServeClient();
+  ServeClient(const ServeClient&) = delete;
+  ServeClient& operator=(const ServeClient&) = delete;
+
+  /*! \brief Inputs and outputs of a model, fetched once per model. */
+  const ServeModelInfo& GetModelInfo(const std::string& model);
+  /*! \brief Send a request with the inputs of the model, in its order, and return its id without
+   *  waiting for the response. Waits for earlier responses if the ring is full.
+   *  \param output_bytes Room for the outputs, 0 to size it from the output shapes of the model
+   *  and the batch of the first input, which needs outputs of static shapes.
+   */
+  uint64_t Submit(const std::string& model, const std::vector<ServeTensor>& inputs,
+                  size_t output_bytes = 0);
+  /*! \brief Wait for the response of a request and get its outputs. Throws if it failed. */
+  std::vector<ServeTensor> Wait(uint64_t id);
+  /*! \brief Run a request and wait for its outputs. */
+  std::vector<ServeTensor> Infer(const std::string& model, const std::vector<ServeTensor>& inputs,
+                                 size_t output_bytes = 0);
+
+ private:
+  struct Region {
+    uint64_t id;
+    uint64_t end;
+    bool done;
+  };
+  struct Response {
+    std::string error;
+    std::vector<ServeTensor> outputs;
+  };
+  int fd_ = -1;
+  char* ring_ = nullptr;
+  size_t ring_bytes_;
+  // Positions in the ring grow without bound and wrap modulo ring_bytes_.
+  uint64_t head_ = 0;
+  uint64_t tail_ = 0;
+  uint64_t next_id_ = 0;
+  std::deque<Region> regions_;
+  std::map<uint64_t, Response> responses_;
+  std::map<std::string, ServeModelInfo> models_;
+  /*! \brief Reserve nbytes of the ring for request id, waiting for responses if it is full. */
+  uint64_t Reserve(uint64_t id, size_t nbytes);
+  /*! \brief Read the next response and release the regions of the requests answered. */
+  void ReadResponse();
+};
+
+}  // namespace dlr
+
+#endif  // DLR_SERVE_H_
@@ -0,0 +1,46 @@
+#ifndef DLR_SESSION_H_
+#define DLR_SESSION_H_
+
+#include <tvm/runtime/ndarray.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Stream of runs of a recurrent model, carrying its state from run to run.
+ *
+ * Each state binding feeds an output of a run, e.g. a hidden state, to an input of the next run.
+ * The session owns the state of its stream, so any number of sessions can share one model, as
+ * long as they do not run it at the same time. Inputs which are not states are set on the model
+ * and outputs are read from it as usual.
+ */
+class DLR_DLL Session {
+ private:
+  DLRModel* model_;
+  std::vector<StateBinding> bindings_;
+  std::vector<tvm::runtime::NDArray> states_;
+  int GetStateIndex(const char* input_name) const;
+
+ public:
+  /*! \brief Create a session of a TVM or Relay VM model, with its states set to zero.
+   *  \param bindings Pairs of the name of an output and of the input it feeds.
+   */
+  Session(DLRModel* model, const std::vector<std::pair<std::string, std::string>>& bindings);
+  DLRModel* GetModel() const { return model_; }
+  /*! \brief Run the model on the current state, then advance the state to the new outputs. */
+  void Run();
+  /*! \brief Set every state to zero, to start a new stream. */
+  void Reset();
+  /*! \brief Copy the data of the state fed to an input, in the dtype of the input. */
+  void GetState(const char* input_name, void* data) const;
+  /*! \brief Replace the state fed to an input with a copy of data, in the dtype of the input. */
+  void SetState(const char* input_name, const void* data);
+};
+
+}  // namespace dlr
+
+#endif  // DLR_SESSION_H_
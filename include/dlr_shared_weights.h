@@ -0,0 +1,62 @@
+#ifndef DLR_SHARED_WEIGHTS_H_
+#define DLR_SHARED_WEIGHTS_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "dlr_common.h"
+#include "dlr_graph_runtime.h"
+
+namespace dlr {
+
+/*! \brief Location of weights shared between processes: POSIX shared memory. */
+constexpr const char* SHARED_WEIGHTS_SHM = "shm";
+
+/*! \brief Set where TVM models created afterwards place their weights so that all processes
+ *  loading the same params share one read-only copy of them.
+ *  \param location SHARED_WEIGHTS_SHM for POSIX shared memory, a directory (e.g. a hugetlbfs
+ *  mount) to hold the shared files, or an empty string to keep weights private.
+ */
+DLR_DLL void SetSharedWeightStore(const std::string& location);
+
+/*! \brief Get the location set by SetSharedWeightStore(). */
+DLR_DLL std::string GetSharedWeightStore();
+
+/*! \brief Get the key of a params file from its device, inode, size and modification time, so
+ *  that processes attaching to its shared weights never read the file. Rewriting the file
+ *  changes its key.
+ */
+DLR_DLL std::string GetSharedWeightKey(const std::string& params_path);
+
+/*! \brief Name of the shared memory segment, or file in the store directory, holding the weights
+ *  of the params with the given key: an artifact key, or a key from GetSharedWeightKey().
+ *  Segments outlive the processes which use them and are named after the identity of the params,
+ *  so a new model never reuses a stale segment.
+ */
+DLR_DLL std::string GetSharedWeightSegmentName(const std::string& params_key);
+
+/*! \brief Bind the weights of a runtime to the shared copy of its params.
+ *
+ * The first process to get here creates the segment, loads the params with load_params and
+ * copies them into it; the others wait for it to be populated and map it read-only, without
+ * loading the params at all. The runtime's private weights are released either way. A segment
+ * left unpopulated by a creator which died is removed and created again. If the segment cannot
+ * be used, the params are loaded privately with load_params.
+ *
+ * \param load_params Load the params into the runtime and return the names of the weights.
+ * \return Names of the weights.
+ */
+DLR_DLL std::vector<std::string> BindSharedWeights(
+    DLRGraphRuntime* runtime, const std::string& location, const std::string& params_key,
+    const std::function<std::vector<std::string>()>& load_params);
+
+/*! \brief Move the given weights of a runtime to page-aligned, read-only memory of their own.
+ *  Pages holding weights are then never written, so processes forked afterwards keep sharing
+ *  them instead of duplicating them copy-on-write.
+ */
+DLR_DLL void BindReadOnlyWeights(DLRGraphRuntime* runtime, const std::vector<std::string>& names);
+
+}  // namespace dlr
+
+#endif  // DLR_SHARED_WEIGHTS_H_
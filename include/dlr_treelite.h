@@ -3,6 +3,9 @@
 
 #include <treelite/c_api_runtime.h>
 
+#include <memory>
+#include <mutex>
+
 #include "dlr_allocator.h"
 #include "dlr_common.h"
 
@@ -25,6 +28,17 @@ struct TreeliteInput {
   CSRBatchHandle handle;
 };
 
+/*! \brief Treelite predictor shared by every model handle loaded from the same library.
+ */
+struct TreelitePredictor {
+  PredictorHandle handle = nullptr;
+  // The predictor's worker pool is not reentrant, so predictions are serialized.
+  std::mutex mutex;
+  ~TreelitePredictor() {
+    if (handle != nullptr) TreelitePredictorFree(handle);
+  }
+};
+
 /*! \brief Get the paths of the Treelite model files.
  */
 ModelPath SetTreelitePaths(const std::vector<std::string>& files);
@@ -38,7 +52,7 @@ class DLR_DLL TreeliteModel : public DLRModel {
   static const std::string OUTPUT_TYPE;
   static const int kInputDim = 2;
   // fields for Treelite model
-  PredictorHandle treelite_model_;
+  std::shared_ptr<TreelitePredictor> treelite_model_;
   size_t treelite_num_feature_;
   // size of temporary buffer per instance
   size_t treelite_output_buffer_size_;
@@ -0,0 +1,63 @@
+#ifndef DLR_TUNER_H_
+#define DLR_TUNER_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "dlr_common.h"
+
+namespace dlr {
+
+/*! \brief Configuration of the instances serving a model: the number of model instances running
+ *  concurrently, the threads of each and the batch size of the requests.
+ */
+struct TunedConfig {
+  int instances = 1;
+  int threads = 1;
+  int64_t batch_size = 1;
+  // Measured on the host which tuned it. Throughput in rows per second.
+  double throughput = 0.0;
+  double p99_ms = 0.0;
+};
+
+/*! \brief Candidates swept by TuneModel() and the time budget of the sweep. */
+struct TunerOptions {
+  std::vector<int> instances;
+  std::vector<int> threads;
+  std::vector<int64_t> batch_sizes = {1};
+  double time_budget = 60.0;
+  // Configurations above this p99 latency are rejected. 0 for no limit.
+  double max_p99_ms = 0.0;
+  // Combinations of more instances x threads are skipped. 0 for no limit.
+  int max_total_threads = 0;
+};
+
+/*! \brief Default candidates: powers of two instances and threads whose product does not exceed
+ *  the number of hardware threads.
+ */
+DLR_DLL TunerOptions GetDefaultTunerOptions();
+
+/*! \brief Sweep instances x threads x batch sizes, measuring the throughput and p99 latency of each
+ *  combination with instances from create, each run by its own thread on zero inputs, for an equal
+ *  share of the time budget. Instances are created as the sweep needs them. Combinations above
+ *  max_total_threads, batch sizes which the model does not accept and combinations which complete
+ *  no request within their share are skipped.
+ *  \param results Measurements of every combination kept, if not null.
+ *  \return The configuration of highest throughput within the p99 limit, or of lowest p99 if none
+ *          is within it.
+ */
+DLR_DLL TunedConfig TuneModel(const std::function<DLRModelPtr()>& create,
+                              const TunerOptions& options,
+                              std::vector<TunedConfig>* results = nullptr);
+
+DLR_DLL void WriteTunedConfig(const std::string& path, const TunedConfig& config);
+DLR_DLL TunedConfig ReadTunedConfig(const std::string& path);
+
+/*! \brief Apply the TUNED_CONFIG_FILE of a model folder, if it has one, to a model loaded from it.
+ */
+void ApplyTunedConfig(const std::vector<std::string>& files, DLRModel* model);
+
+}  // namespace dlr
+
+#endif  // DLR_TUNER_H_
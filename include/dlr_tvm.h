@@ -5,7 +5,13 @@
 #include <tvm/runtime/memory.h>
 #include <tvm/runtime/registry.h>
 
+#include <memory>
+#include <unordered_map>
+
 #include "dlr_common.h"
+#include "dlr_execution_group.h"
+#include "dlr_graph_runtime.h"
+#include "dlr_input_window.h"
 
 #if defined(_MSC_VER) || defined(_WIN32)
 #define DLR_DLL __declspec(dllexport)
@@ -19,14 +25,23 @@ namespace dlr {
  */
 class DLR_DLL TVMModel : public DLRModel {
  private:
-  tvm::runtime::ObjectPtr<tvm::runtime::GraphRuntime> tvm_graph_runtime_;
+  tvm::runtime::ObjectPtr<DLRGraphRuntime> tvm_graph_runtime_;
   std::shared_ptr<tvm::runtime::Module> tvm_module_;
+  std::shared_ptr<tvm::runtime::Module> tvm_lib_;
   std::vector<const DLTensor*> outputs_;
   std::vector<std::string> output_types_;
   std::vector<std::string> weight_names_;
+  std::shared_ptr<ExecutionGroup> execution_group_;
+  // Input index -> sliding window presented to the graph as the input.
+  std::unordered_map<int, std::unique_ptr<InputWindow>> input_windows_;
   void SetupTVMModule(const std::vector<std::string>& files);
   void SetupTVMModule(const std::vector<DLRModelElem>& model_elems);
   void UpdateInputShapes();
+  /*! \brief Get the index in the graph of the input with the given DLR input index. Inputs are
+   *  sorted by name in DLR, while the graph keeps its own order, weights included.
+   */
+  int GetGraphInputIndex(int index) const;
+  void BindInputWindow(int index);
 
  public:
   /*! \brief Load model files from given folder path.
@@ -39,6 +54,7 @@ class DLR_DLL TVMModel : public DLRModel {
       : DLRModel(ctx, DLRBackend::kTVM) {
     SetupTVMModule(model_elems);
   }
+  ~TVMModel();
 
   virtual const int GetInputDim(int index) const override;
   virtual const int64_t GetInputSize(int index) const override;
@@ -47,11 +63,24 @@ class DLR_DLL TVMModel : public DLRModel {
   virtual void GetInput(const char* name, void* input) override;
   virtual void SetInput(const char* name, const int64_t* shape, const void* input,
                         int dim) override;
+  /*! \brief Convert the data directly into the input of the graph, without copying it first. */
+  virtual void SetInputTyped(const char* name, const int64_t* shape, const void* input, int dim,
+                             const char* dtype) override;
   void SetInputTensor(const char* name, DLTensor* tensor);
   void SetInputTensorZeroCopy(const char* name, DLTensor* tensor);
+  /*! \brief Make an input a sliding window over an axis, whose dimensions before must be 1. The
+   *  window is bound to the graph without copies. In rotated mode, rows are written in place.
+   */
+  void SetInputWindow(const char* name, int axis, bool rotated);
+  /*! \brief Append count rows to the window of an input, dropping the oldest ones. */
+  void AppendInputWindow(const char* name, const void* rows, int64_t count);
+  /*! \brief Index of the oldest row in the window of an input. */
+  int64_t GetInputWindowOffset(const char* name) const;
 
   virtual void GetOutput(int index, void* out) override;
   void GetOutputManagedTensorPtr(int index, const DLManagedTensor** out);
+  /*! \brief Convert the data directly from the output of the graph on the CPU. */
+  virtual void GetOutputTyped(int index, void* out, const char* dtype) override;
   virtual const void* GetOutputPtr(int index) const override;
   virtual void GetOutputShape(int index, int64_t* shape) const override;
   virtual void GetOutputSizeDim(int index, int64_t* size, int* dim) override;
@@ -62,9 +91,17 @@ class DLR_DLL TVMModel : public DLRModel {
   virtual std::vector<std::string> GetWeightNames() const override;
 
   virtual void Run() override;
+  /*! \brief Run with the state inputs bound to the arrays in states, without copying them, then
+   *  copy the state outputs to the same arrays. The inputs are bound back to the graph after.
+   */
+  void RunWithStates(const std::vector<StateBinding>& bindings,
+                     std::vector<tvm::runtime::NDArray>* states);
   virtual void SetNumThreads(int threads) override;
   virtual void UseCPUAffinity(bool use) override;
 
+  /*! \brief Move intermediate activations to the shared arena of an execution group. */
+  void JoinExecutionGroup(const std::shared_ptr<ExecutionGroup>& group);
+
   /*
     Following methods use metadata file to lookup input and output names.
   */
@@ -292,3 +292,99 @@ class DLRModel(IDLRModel):
         except Exception as ex:
             self.neo_logger.exception("error in getting output data type {} {}".format(self._impl.__class__.__name__, ex))
             raise ex
+
+    def enable_perf_counters(self, enable=True):
+        """
+        Count hardware performance counters around each run, with Linux perf_event_open().
+        Enabling resets the counts.
+
+        Parameters
+        ----------
+        enable : bool
+            Whether to count
+        """
+        try:
+            return self._impl.enable_perf_counters(enable)
+        except Exception as ex:
+            self.neo_logger.exception("error in enabling perf counters {} {}".format(self._impl.__class__.__name__, ex))
+            raise ex
+
+    def get_perf_counters(self):
+        """
+        Get the performance counters summed over the runs since they were enabled.
+
+        Returns
+        -------
+        counters : dict
+            cycles, instructions, llc_misses, branch_misses and context_switches, None for
+            counters unavailable on this host, and the number of runs counted
+        """
+        try:
+            return self._impl.get_perf_counters()
+        except Exception as ex:
+            self.neo_logger.exception("error in getting perf counters {} {}".format(self._impl.__class__.__name__, ex))
+            raise ex
+
+    def enable_flight_recorder(self, capacity, slow_threshold_ms=0):
+        """
+        Record the phases of the last requests: set_input, run and get_output.
+
+        Parameters
+        ----------
+        capacity : int
+            Number of requests to keep, 0 to turn the recorder off
+        slow_threshold_ms : float
+            Requests slower than this are logged with their phases, 0 to log none
+        """
+        try:
+            return self._impl.enable_flight_recorder(capacity, slow_threshold_ms)
+        except Exception as ex:
+            self.neo_logger.exception("error in enabling flight recorder {} {}".format(self._impl.__class__.__name__, ex))
+            raise ex
+
+    def dump_flight_recorder(self, path):
+        """
+        Append the recorded requests to a file, one JSON object per line, oldest first.
+
+        Parameters
+        ----------
+        path : str
+            File to append to
+        """
+        try:
+            return self._impl.dump_flight_recorder(path)
+        except Exception as ex:
+            self.neo_logger.exception("error in dumping flight recorder {} {}".format(self._impl.__class__.__name__, ex))
+            raise ex
+
+    def enable_metrics(self, enable=True, name=None):
+        """
+        Measure the calls to the model: runs, errors, latencies, batch sizes and bytes copied.
+
+        Parameters
+        ----------
+        enable : bool
+            Whether to measure
+        name : str
+            Value of the "model" label of the metrics, the model path by default
+        """
+        try:
+            return self._impl.enable_metrics(enable, name)
+        except Exception as ex:
+            self.neo_logger.exception("error in enabling metrics {} {}".format(self._impl.__class__.__name__, ex))
+            raise ex
+
+    def get_metrics_text(self):
+        """
+        Get the metrics of every model with metrics enabled, for a Prometheus scrape.
+
+        Returns
+        -------
+        text : str
+            Metrics in the Prometheus text exposition format
+        """
+        try:
+            return self._impl.get_metrics_text()
+        except Exception as ex:
+            self.neo_logger.exception("error in getting metrics {} {}".format(self._impl.__class__.__name__, ex))
+            raise ex
@@ -3,6 +3,8 @@ CALL_HOME_URL = "https://api.neo-dlr.amazonaws.com"
 CALL_HOME_USER_CONFIG_FILE = "ccm_config.json"
 CALL_HOME_MODEL_RUN_COUNT_TIME_SECS = 300
 CALL_HOME_REQ_STOP_MAX_COUNT = 3
+CALL_HOME_REQ_TIMEOUT_SECS = 2
+CALL_HOME_QUEUE_MAX_SIZE = 64
 CALL_HOME_USR_NOTIFICATION = """\n CALL HOME FEATURE ENABLED
                             \n\n You acknowledge and agree that DLR collects the following metrics to help improve its performance. \
                             \n By default, Amazon will collect and store the following information from your device: \
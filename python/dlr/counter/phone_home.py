@@ -2,12 +2,15 @@ import json
 import platform
 import logging
 import os
+import queue
+import threading
 
 from .config import (
     CALL_HOME_USR_NOTIFICATION,
     CALL_HOME_USER_CONFIG_FILE,
     CALL_HOME_REQ_STOP_MAX_COUNT,
     CALL_HOME_MODEL_RUN_COUNT_TIME_SECS,
+    CALL_HOME_QUEUE_MAX_SIZE,
 )
 from .utils.helper import get_hash_string
 from .utils import resturlutils
@@ -36,6 +39,10 @@ class PhoneHome:
     instance = None
     _enable_feature = None
     _resp_err_count = 0
+    # Messages of every instance are sent by one background thread per process.
+    _queue = None
+    _worker = None
+    _worker_lock = threading.Lock()
     RUNTIME_LOAD = 1
     MODEL_LOAD = 2
     MODEL_RUN = 3
@@ -111,9 +118,29 @@ class PhoneHome:
             return PhoneHome.instance
 
     def __init__(self):
-        try:
-            self.client = resturlutils.RestUrlUtils()
+        self.client = resturlutils.RestUrlUtils()
+        self.system = None
+        PhoneHome._start_worker()
+        self._submit(self._init_system)
 
+    @staticmethod
+    def _start_worker():
+        """ Start the background thread of the process, unless it is already running.
+            Messages are sent from it so that neither importing dlr nor loading a model ever
+            waits on the network.
+        """
+        with PhoneHome._worker_lock:
+            if PhoneHome._worker is not None and PhoneHome._worker.is_alive():
+                return
+            if PhoneHome._queue is None:
+                PhoneHome._queue = queue.Queue(maxsize=CALL_HOME_QUEUE_MAX_SIZE)
+            PhoneHome._worker = threading.Thread(
+                target=PhoneHome._process_queue, name="dlr-phone-home", daemon=True
+            )
+            PhoneHome._worker.start()
+
+    def _init_system(self):
+        try:
             machine_type = platform.machine()
             os_name = platform.system()
             os_supt = "{}_{}".format(os_name, machine_type)
@@ -122,12 +149,44 @@ class PhoneHome:
             if self.system is None:
                 raise Exception("system is not supported")
 
-            self.send_runtime_loaded()
+            self._send_runtime_loaded()
             print(CALL_HOME_USR_NOTIFICATION)
-        
+
         except Exception as ex:
             logging.debug("phone init error")
 
+    @staticmethod
+    def _process_queue():
+        while True:
+            job = PhoneHome._queue.get()
+            try:
+                job()
+            except Exception:
+                logging.debug("phone home job error")
+            finally:
+                PhoneHome._queue.task_done()
+
+    def _submit(self, job):
+        """ Queue a job for the background thread, dropping it if the queue is full.
+        """
+        try:
+            self._queue.put_nowait(job)
+        except queue.Full:
+            logging.debug("phone home queue is full, message dropped")
+
+    def flush(self, timeout=None):
+        """ Wait for the messages queued so far to be sent.
+
+        Args:
+            timeout float: seconds to wait at most, forever if None
+
+        Returns:
+            bool: if all the messages were sent within the timeout
+        """
+        done = threading.Event()
+        self._submit(done.set)
+        return done.wait(timeout)
+
     def _is_device_info_sent(self):
         """ check if device information send only single time in DLR installation life time.
             create a dummy binary file in DLR installation path to record process state.
@@ -152,18 +211,26 @@ class PhoneHome:
         finally:
             return is_sent
 
-    @exception_handler
     def send_runtime_loaded(self):
-        """ Push device information on DLR library load
+        """ Push device information on DLR library load, in the background
         """
+        self._submit(self._send_runtime_loaded)
+
+    @exception_handler
+    def _send_runtime_loaded(self):
         if not self._is_device_info_sent():
             msg = {"record_type": self.RUNTIME_LOAD}
             if self.system:
                 msg.update(self.system.get_device_info())
             self.client.send(json.dumps(msg))
 
-    @exception_handler
     def send_model_loaded(self, model):
+        """ Push the hashed model name on model load, in the background
+        """
+        self._submit(lambda: self._send_model_loaded(model))
+
+    @exception_handler
+    def _send_model_loaded(self, model):
         model_name = self.get_model_hash(model)
         data = {"record_type": self.MODEL_LOAD, "model": model_name}
         if self.system:
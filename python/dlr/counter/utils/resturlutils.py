@@ -2,12 +2,24 @@
 import logging
 import requests
 
-from ..config import CALL_HOME_URL
+from ..config import CALL_HOME_URL, CALL_HOME_REQ_TIMEOUT_SECS
 
 
 class RestUrlUtils(object):
     """Rest client used to push messages"""
 
+    def __init__(self, url=None, timeout=CALL_HOME_REQ_TIMEOUT_SECS):
+        """
+        Parameters
+        ----------
+        url: str
+            endpoint to push messages to, CALL_HOME_URL by default
+        timeout: float
+            seconds to wait for the endpoint to connect and to respond
+        """
+        self.url = url if url else CALL_HOME_URL
+        self.timeout = timeout
+
     def send(self, message):
         """send data to AWS Rest server
         Parameters
@@ -25,9 +37,12 @@ class RestUrlUtils(object):
             headers = {"Content-Type": "application/x-amz-json-1.1"}
             data = message.encode("utf-8")
             
-            resp = requests.post(CALL_HOME_URL, data=data, headers=headers)
+            resp = requests.post(self.url, data=data, headers=headers, timeout=self.timeout)
             status_code = resp.status_code
             return status_code
+        except requests.exceptions.Timeout:
+            logging.debug("rest api timed out")
+            status_code = -1
         except Exception:
             logging.exception("rest api miscellaneous error")
             status_code = -1
@@ -1,6 +1,6 @@
 # coding: utf-8
 import ctypes
-from ctypes import c_void_p, c_int, c_char_p, byref, POINTER, c_longlong
+from ctypes import c_void_p, c_int, c_char_p, byref, POINTER, c_longlong, c_float
 import json
 import numpy as np
 import os
@@ -16,6 +16,37 @@ class DLRError(Exception):
     """Error thrown by DLR"""
     pass
 
+# dtypes SetDLRInputTyped converts from while copying into an input
+_CONVERTIBLE_DTYPES = ("float64", "float32", "float16", "int8", "uint8", "int16", "uint16",
+                       "int32", "uint32", "int64", "uint64")
+
+# Counters of GetDLRPerfCounters, in order
+_PERF_COUNTER_NAMES = ("cycles", "instructions", "llc_misses", "branch_misses", "context_switches")
+
+# DLDataTypeCode of numpy dtype kinds
+_DL_TYPE_CODES = {"i": 0, "u": 1, "f": 2}
+
+
+class _DLContext(ctypes.Structure):
+    _fields_ = [("device_type", c_int),
+                ("device_id", c_int)]
+
+
+class _DLDataType(ctypes.Structure):
+    _fields_ = [("code", ctypes.c_uint8),
+                ("bits", ctypes.c_uint8),
+                ("lanes", ctypes.c_uint16)]
+
+
+class _DLTensor(ctypes.Structure):
+    _fields_ = [("data", c_void_p),
+                ("ctx", _DLContext),
+                ("ndim", c_int),
+                ("dtype", _DLDataType),
+                ("shape", POINTER(c_longlong)),
+                ("strides", POINTER(c_longlong)),
+                ("byte_offset", ctypes.c_uint64)]
+
 def _load_lib(lib_path):
     """Load DLR library."""
     try:
@@ -98,7 +129,8 @@ class DLRModelImpl(IDLRModel):
             self.weight_names.append(self._get_weight_name(i))
 
         self.num_outputs = self._get_num_outputs()
-        if self.backend != "relayvm":
+        # Output shapes of these backends are only known after a run
+        if self.backend not in ("relayvm", "batch_variant"):
             self._lazy_init_output_shape()
         self._fetch_input_names()
         self._fetch_input_dtypes()
@@ -290,6 +322,40 @@ class DLRModelImpl(IDLRModel):
             return "float32"
         return self.get_input_dtype(self._get_input_index(name))
 
+    def _set_strided_input(self, name, data):
+        """Set the input using the input name with a strided view of data, without copying it"""
+        shape = np.array(data.shape, dtype=np.int64)
+        strides = np.array([stride // data.itemsize for stride in data.strides], dtype=np.int64)
+        tensor = _DLTensor()
+        tensor.data = data.ctypes.data
+        tensor.ctx = _DLContext(1, 0)
+        tensor.ndim = data.ndim
+        tensor.dtype = _DLDataType(_DL_TYPE_CODES[data.dtype.kind], data.itemsize * 8, 1)
+        tensor.shape = shape.ctypes.data_as(POINTER(c_longlong))
+        tensor.strides = strides.ctypes.data_as(POINTER(c_longlong))
+        tensor.byte_offset = 0
+        self.input_shapes[name] = shape
+        self._check_call(self._lib.SetDLRInputTensor(byref(self.handle),
+                                     c_char_p(name.encode('utf-8')),
+                                     byref(tensor)))
+
+    def _is_quantized(self, input_name=None, output_index=None):
+        """Whether the metadata of the model declares the quantization of an input or output"""
+        if not hasattr(self._lib, "GetDLRInputQuantization"):
+            return False
+        quantized = c_int()
+        scale = ctypes.c_float()
+        zero_point = c_int()
+        if input_name is not None:
+            self._check_call(self._lib.GetDLRInputQuantization(byref(self.handle),
+                             c_char_p(input_name.encode('utf-8')), byref(quantized),
+                             byref(scale), byref(zero_point)))
+        else:
+            self._check_call(self._lib.GetDLROutputQuantization(byref(self.handle),
+                             c_int(output_index), byref(quantized), byref(scale),
+                             byref(zero_point)))
+        return quantized.value == 1
+
     def _set_input(self, name, data):
         """Set the input using the input name with data
 
@@ -301,6 +367,7 @@ class DLRModelImpl(IDLRModel):
             The data to be set.
         """
         input_dtype = self._get_input_or_weight_dtype_by_name(name)
+        data_dtype = input_dtype
         if input_dtype == "json":
             # Special case for DataTransformed inputs. DLR will expect input as a serialized json
             # string.
@@ -312,26 +379,46 @@ class DLRModelImpl(IDLRModel):
             if input_dtype == "float32":
                 type_match = True
             else:
-                type_match = (data.dtype.name == input_dtype)
+                # Float data is quantized for quantized inputs.
+                type_match = (data.dtype.name == input_dtype) or \
+                    (data.dtype.kind == 'f' and self._is_quantized(input_name=name))
             if not type_match:
                 raise ValueError("input data with name {} should have dtype {} but {} is provided".
                                 format(name, input_dtype, data.dtype.name))
-            in_data = np.ascontiguousarray(data, dtype=input_dtype)
+            if data.dtype.name == input_dtype and data.dtype.kind in _DL_TYPE_CODES and \
+               not data.flags.c_contiguous and self.backend in ("tvm", "relayvm") and \
+               data.strides and all(stride % data.itemsize == 0 for stride in data.strides):
+                # DLR gathers strided data into the input, saving a copy.
+                self._set_strided_input(name, data)
+                return
+            if data.dtype.name != input_dtype and data.dtype.name in _CONVERTIBLE_DTYPES and \
+               hasattr(self._lib, "SetDLRInputTyped"):
+                # DLR converts the data while copying it, saving a pass over it.
+                data_dtype = data.dtype.name
+            in_data = np.ascontiguousarray(data, dtype=data_dtype)
             in_data_pointer = in_data.ctypes._as_parameter_
             shape = np.array(in_data.shape, dtype=np.int64)
         self.input_shapes[name] = shape
-        self._check_call(self._lib.SetDLRInput(byref(self.handle),
-                                     c_char_p(name.encode('utf-8')),
-                                     shape.ctypes.data_as(POINTER(c_longlong)),
-                                     in_data_pointer,
-                                     c_int(len(shape))))
+        if data_dtype != input_dtype:
+            self._check_call(self._lib.SetDLRInputTyped(byref(self.handle),
+                                         c_char_p(name.encode('utf-8')),
+                                         shape.ctypes.data_as(POINTER(c_longlong)),
+                                         in_data_pointer,
+                                         c_int(len(shape)),
+                                         c_char_p(data_dtype.encode('utf-8'))))
+        else:
+            self._check_call(self._lib.SetDLRInput(byref(self.handle),
+                                         c_char_p(name.encode('utf-8')),
+                                         shape.ctypes.data_as(POINTER(c_longlong)),
+                                         in_data_pointer,
+                                         c_int(len(shape))))
         if self.backend == 'treelite':
             self._lazy_init_output_shape()
 
     def _run(self):
         """A light wrapper to call run in the DLR backend."""
         self._check_call(self._lib.RunDLRModel(byref(self.handle)))
-        if self.backend == "relayvm":
+        if self.backend in ("relayvm", "batch_variant"):
             self._lazy_init_output_shape()
 
     def _get_num_outputs(self):
@@ -403,9 +490,15 @@ class DLRModelImpl(IDLRModel):
             raise ValueError("index is expected between 0 and "
                              "len(output_shapes)-1, but got %d" % index)
         output_dtype = self.get_output_dtype(index)
-        output = np.zeros(self.output_size_dim[index][0], dtype=output_dtype)
-        self._check_call(self._lib.GetDLROutput(byref(self.handle), c_int(index),
-                         output.ctypes._as_parameter_))
+        if self._is_quantized(output_index=index):
+            # Quantized outputs are dequantized while they are fetched.
+            output = np.zeros(self.output_size_dim[index][0], dtype="float32")
+            self._check_call(self._lib.GetDLROutputTyped(byref(self.handle), c_int(index),
+                             output.ctypes._as_parameter_, c_char_p(b"float32")))
+        else:
+            output = np.zeros(self.output_size_dim[index][0], dtype=output_dtype)
+            self._check_call(self._lib.GetDLROutput(byref(self.handle), c_int(index),
+                             output.ctypes._as_parameter_))
         out = output.reshape(self.output_shapes[index])
         return out
 
@@ -481,3 +574,52 @@ class DLRModelImpl(IDLRModel):
                                      out.ctypes._as_parameter_))
         out = out.reshape(shape)
         return out
+
+    def enable_perf_counters(self, enable=True):
+        """Count cycles, instructions, LLC misses, branch misses and context switches
+        around each run, with Linux perf_event_open(). Enabling resets the counts."""
+        self._check_call(self._lib.EnableDLRPerfCounters(byref(self.handle),
+                                                         c_int(1 if enable else 0)))
+
+    def get_perf_counters(self):
+        """Get the performance counters summed over the runs since they were enabled,
+        as a dict with the number of runs. Counters unavailable on this host are None."""
+        counters = (c_longlong * len(_PERF_COUNTER_NAMES))()
+        num_runs = c_longlong()
+        self._check_call(self._lib.GetDLRPerfCounters(byref(self.handle), counters,
+                                                      byref(num_runs)))
+        result = {name: (value if value >= 0 else None)
+                  for name, value in zip(_PERF_COUNTER_NAMES, counters)}
+        result["runs"] = num_runs.value
+        return result
+
+    def enable_flight_recorder(self, capacity, slow_threshold_ms=0):
+        """Record the phases of the last capacity requests, logging the ones slower than
+        slow_threshold_ms unless it is 0. A capacity of 0 turns the recorder off."""
+        self._check_call(self._lib.EnableDLRFlightRecorder(byref(self.handle), c_int(capacity),
+                                                           c_float(slow_threshold_ms)))
+
+    def dump_flight_recorder(self, path):
+        """Append the recorded requests to a file, one JSON object per line."""
+        self._check_call(self._lib.DumpDLRFlightRecorder(byref(self.handle),
+                                                         c_char_p(path.encode())))
+
+    def enable_metrics(self, enable=True, name=None):
+        """Measure the calls to the model for get_metrics_text(), labelled with name,
+        the model path by default. Disabling drops the metrics."""
+        name = self.model_path if name is None else name
+        self._check_call(self._lib.EnableDLRMetrics(byref(self.handle), c_int(1 if enable else 0),
+                                                    c_char_p(name.encode())))
+
+    def get_metrics_text(self):
+        """Get the metrics of every model of this library with metrics enabled, in the
+        Prometheus text format."""
+        size = c_longlong()
+        self._check_call(self._lib.GetDLRMetricsText(None, c_longlong(0), byref(size)))
+        while True:
+            buf = ctypes.create_string_buffer(size.value)
+            # Models added since the size was read may make the text grow.
+            if self._lib.GetDLRMetricsText(buf, c_longlong(len(buf)), byref(size)) == 0:
+                return buf.value.decode('utf-8')
+            if size.value <= len(buf):
+                raise DLRError(self._lib.DLRGetLastError().decode('ascii'))
@@ -1,7 +1,10 @@
 import time
 import os
 import json
+import socket
+import threading
 from dlr.counter.phone_home import call_phone_home, PhoneHome, ENABLE_PHONE_HOME_CONFIG
+from dlr.counter.utils import resturlutils
 
 import unittest
 from unittest.mock import MagicMock, patch, mock_open
@@ -78,6 +81,53 @@ class TestPhoneHome(unittest.TestCase):
         call_phone_home(func)(mock_dlr, mock_path)
         assert PhoneHome.get_instance() is not None
 
+    def hanging_endpoint(self):
+        """ Start a local endpoint which accepts connections and never responds """
+        server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        server.bind(("127.0.0.1", 0))
+        server.listen(8)
+        conns = []
+
+        def accept():
+            while True:
+                try:
+                    conns.append(server.accept()[0])
+                except OSError:
+                    return
+
+        threading.Thread(target=accept, daemon=True).start()
+        self.addCleanup(lambda: [sock.close() for sock in conns + [server]])
+        return "http://127.0.0.1:{}".format(server.getsockname()[1])
+
+    def test_hanging_endpoint(self):
+        url = self.hanging_endpoint()
+        with patch.object(resturlutils, "CALL_HOME_URL", url):
+            start = time.time()
+            PhoneHome.enable_feature()
+            mgr = PhoneHome.get_instance()
+            func = self.mock_func()
+            func.__name__ = "__init__"
+            with patch("dlr.counter.phone_home.MGR", mgr):
+                call_phone_home(func)(MagicMock(), "/path/to/model")
+            # Neither the device info nor the model load is sent on the calling thread.
+            assert time.time() - start < 0.5
+            # The sends give up on the endpoint after the timeout.
+            assert mgr.flush(timeout=3 * mgr.client.timeout + 1)
+
+        client = resturlutils.RestUrlUtils(url, timeout=0.2)
+        start = time.time()
+        assert client.send("{}") == -1
+        assert time.time() - start < 1
+
+    def test_single_worker(self):
+        with patch.object(resturlutils.RestUrlUtils, "send", return_value=0):
+            for _ in range(5):
+                PhoneHome.enable_feature()
+                PhoneHome.get_instance().send_model_loaded("/path/to/model")
+            workers = [t for t in threading.enumerate() if t.name == "dlr-phone-home"]
+            assert len(workers) == 1
+            assert PhoneHome.get_instance().flush(timeout=5)
+
     def test_phone_home(self):
         self.check_send_model_loaded()
         self.check_enable_by_default()
@@ -1,19 +1,126 @@
 #include "dlr.h"
 
+#include "dlr_batch_variant.h"
+#include "dlr_cascade.h"
 #include "dlr_common.h"
+#include "dlr_cost.h"
+#include "dlr_cpu_features.h"
+#include "dlr_data_convert.h"
+#include "dlr_flight_recorder.h"
+#include "dlr_fork.h"
+#include "dlr_metrics.h"
+#include "dlr_perf_counters.h"
 #include "dlr_pipeline.h"
+#include "dlr_probes.h"
 #include "dlr_relayvm.h"
+#include "dlr_session.h"
+#include "dlr_shared_weights.h"
 #include "dlr_treelite.h"
+#include "dlr_tuner.h"
 #include "dlr_tvm.h"
 
 #ifdef DLR_HEXAGON
 #include "dlr_hexagon/dlr_hexagon.h"
 #endif  // DLR_HEXAGON
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <locale>
+#include <numeric>
 
 using namespace dlr;
 
+namespace {
+
+/*! \brief Backend name of a model, for probes. */
+const char* GetBackendName(DLRModel* model) {
+  return kBackendToStr[static_cast<int>(model->GetBackend())];
+}
+
+/*! \brief Number of elements of an output, for probes and metrics. */
+int64_t GetOutputSize(DLRModel* model, int index) {
+  int64_t size;
+  int dim;
+  model->GetOutputSizeDim(index, &size, &dim);
+  return size;
+}
+
+/*! \brief Start time of a call for the flight recorder of the model, 0 if it has none. */
+uint64_t GetRecorderTime(DLRModel* model) {
+  return model->GetFlightRecorder() != nullptr ? FlightRecorder::Now() : 0;
+}
+
+/*! \brief Record a SetInput() of the shape started at start, if the model has a flight recorder. */
+void RecordSetInput(DLRModel* model, uint64_t start, const int64_t* shape, int dim) {
+  FlightRecorder* recorder = model->GetFlightRecorder();
+  if (recorder == nullptr) return;
+  recorder->OnSetInput(start, FlightRecorder::Now(), dim > 0 ? shape[0] : 1,
+                       std::accumulate(shape, shape + dim, int64_t{1}, std::multiplies<int64_t>()));
+}
+
+/*! \brief Measures a call to a model for its metrics, counting it as an error unless Done() is
+ *  called before the scope ends.
+ */
+class MetricsScope {
+ public:
+  MetricsScope(DLRModel* model, MetricPhase phase)
+      : metrics_(model->GetMetrics()),
+        phase_(phase),
+        start_(metrics_ != nullptr ? ModelMetrics::Now() : 0) {}
+  ~MetricsScope() {
+    if (metrics_ != nullptr && !done_) metrics_->OnError(phase_);
+  }
+  ModelMetrics* metrics() const { return metrics_; }
+  void Done(uint64_t bytes) {
+    metrics_->OnCall(phase_, ModelMetrics::Now() - start_, bytes);
+    done_ = true;
+  }
+
+ private:
+  ModelMetrics* metrics_;
+  MetricPhase phase_;
+  uint64_t start_;
+  bool done_ = false;
+};
+
+/*! \brief Bytes of count elements of dtype, 0 for types without a fixed size. */
+uint64_t GetBytes(int64_t count, const char* dtype) {
+  try {
+    const DLDataType type = GetDLDataTypeFromString(dtype);
+    return count * ((type.bits * type.lanes + 7) / 8);
+  } catch (dmlc::Error&) {
+    return 0;
+  }
+}
+
+/*! \brief Type of the input of the model named name, for metrics. */
+const char* GetInputType(DLRModel* model, const char* name) {
+  for (int i = 0; i < model->GetNumInputs(); i++) {
+    if (std::strcmp(model->GetInputName(i), name) == 0) return model->GetInputType(i);
+  }
+  return "";
+}
+
+/*! \brief Record a SetInput() of the shape and dtype in the metrics of the scope. */
+void RecordSetInputMetrics(MetricsScope* scope, const int64_t* shape, int dim, const char* dtype) {
+  scope->metrics()->SetBatchSize(dim > 0 ? shape[0] : 1);
+  scope->Done(GetBytes(
+      std::accumulate(shape, shape + dim, int64_t{1}, std::multiplies<int64_t>()), dtype));
+}
+
+/*! \brief Record a SetInput() of a tensor in the metrics of the scope. Zero-copy inputs copy no
+ *  bytes.
+ */
+void RecordSetInputMetrics(MetricsScope* scope, const DLTensor* tensor, bool copied) {
+  scope->metrics()->SetBatchSize(tensor->ndim > 0 ? tensor->shape[0] : 1);
+  const int64_t count = std::accumulate(tensor->shape, tensor->shape + tensor->ndim, int64_t{1},
+                                        std::multiplies<int64_t>());
+  scope->Done(copied ? count * ((tensor->dtype.bits * tensor->dtype.lanes + 7) / 8) : 0);
+}
+
+}  // namespace
+
 /* DLR C API implementation */
 
 extern "C" int GetDLRNumInputs(DLRModelHandle* handle, int* num_inputs) {
@@ -79,7 +186,29 @@ extern "C" int SetDLRInput(DLRModelHandle* handle, const char* name, const int64
   API_BEGIN();
   DLRModel* model = static_cast<DLRModel*>(*handle);
   CHECK(model != nullptr) << "model is nullptr, create it first";
+  const ProbeTimer timer(DLR_PROBE_ENABLED(set__input));
+  MetricsScope metrics(model, kMetricSetInput);
+  const uint64_t start = GetRecorderTime(model);
   model->SetInput(name, shape, input, dim);
+  RecordSetInput(model, start, shape, dim);
+  if (metrics.metrics()) RecordSetInputMetrics(&metrics, shape, dim, GetInputType(model, name));
+  DLR_PROBE(set__input, model, GetBackendName(model), name,
+            std::accumulate(shape, shape + dim, int64_t{1}, std::multiplies<int64_t>()),
+            timer.Elapsed());
+  API_END();
+}
+
+extern "C" int SetDLRInputTyped(DLRModelHandle* handle, const char* name, const int64_t* shape,
+                                const void* input, int dim, const char* dtype) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  CHECK(dtype != nullptr) << "dtype is nullptr";
+  MetricsScope metrics(model, kMetricSetInput);
+  const uint64_t start = GetRecorderTime(model);
+  model->SetInputTyped(name, shape, input, dim, dtype);
+  RecordSetInput(model, start, shape, dim);
+  if (metrics.metrics()) RecordSetInputMetrics(&metrics, shape, dim, dtype);
   API_END();
 }
 
@@ -92,6 +221,7 @@ extern "C" int SetDLRInputTensor(DLRModelHandle* handle, const char* name, void*
       << kBackendToStr[static_cast<int>(backend)] << "' but expected 'tvm' or 'relayvm'";
 
   DLTensor* dltensor = static_cast<DLTensor*>(tensor);
+  MetricsScope metrics(dlr_model, kMetricSetInput);
   if (backend == DLRBackend::kTVM) {
     TVMModel* tvm_model = static_cast<TVMModel*>(*handle);
     CHECK(tvm_model != nullptr) << "model is nullptr, create it first";
@@ -101,6 +231,7 @@ extern "C" int SetDLRInputTensor(DLRModelHandle* handle, const char* name, void*
     CHECK(vm_model != nullptr) << "model is nullptr, create it first";
     vm_model->SetInputTensor(name, dltensor);
   }
+  if (metrics.metrics()) RecordSetInputMetrics(&metrics, dltensor, true);
   API_END();
 }
 
@@ -115,7 +246,43 @@ extern "C" int SetDLRInputTensorZeroCopy(DLRModelHandle* handle, const char* nam
   DLTensor* dltensor = static_cast<DLTensor*>(tensor);
   TVMModel* tvm_model = static_cast<TVMModel*>(*handle);
   CHECK(tvm_model != nullptr) << "model is nullptr, create it first";
+  MetricsScope metrics(tvm_model, kMetricSetInput);
   tvm_model->SetInputTensorZeroCopy(name, dltensor);
+  if (metrics.metrics()) RecordSetInputMetrics(&metrics, dltensor, false);
+  API_END();
+}
+
+extern "C" int SetDLRInputWindow(DLRModelHandle* handle, const char* name, int axis, int rotated) {
+  API_BEGIN();
+  DLRModel* dlr_model = static_cast<DLRModel*>(*handle);
+  CHECK(dlr_model != nullptr) << "model is nullptr, create it first";
+  CHECK(dlr_model->GetBackend() == DLRBackend::kTVM)
+      << "model is not a TVMModel. Found '"
+      << kBackendToStr[static_cast<int>(dlr_model->GetBackend())] << "' but expected 'tvm'";
+  static_cast<TVMModel*>(dlr_model)->SetInputWindow(name, axis, rotated != 0);
+  API_END();
+}
+
+extern "C" int AppendDLRInputWindow(DLRModelHandle* handle, const char* name, const void* samples,
+                                    int64_t count) {
+  API_BEGIN();
+  DLRModel* dlr_model = static_cast<DLRModel*>(*handle);
+  CHECK(dlr_model != nullptr) << "model is nullptr, create it first";
+  CHECK(dlr_model->GetBackend() == DLRBackend::kTVM)
+      << "model is not a TVMModel. Found '"
+      << kBackendToStr[static_cast<int>(dlr_model->GetBackend())] << "' but expected 'tvm'";
+  static_cast<TVMModel*>(dlr_model)->AppendInputWindow(name, samples, count);
+  API_END();
+}
+
+extern "C" int GetDLRInputWindowOffset(DLRModelHandle* handle, const char* name, int64_t* offset) {
+  API_BEGIN();
+  DLRModel* dlr_model = static_cast<DLRModel*>(*handle);
+  CHECK(dlr_model != nullptr) << "model is nullptr, create it first";
+  CHECK(dlr_model->GetBackend() == DLRBackend::kTVM)
+      << "model is not a TVMModel. Found '"
+      << kBackendToStr[static_cast<int>(dlr_model->GetBackend())] << "' but expected 'tvm'";
+  *offset = static_cast<TVMModel*>(dlr_model)->GetInputWindowOffset(name);
   API_END();
 }
 
@@ -131,7 +298,51 @@ extern "C" int GetDLROutput(DLRModelHandle* handle, int index, void* out) {
   API_BEGIN();
   DLRModel* model = static_cast<DLRModel*>(*handle);
   CHECK(model != nullptr) << "model is nullptr, create it first";
+  const ProbeTimer timer(DLR_PROBE_ENABLED(get__output));
+  MetricsScope metrics(model, kMetricGetOutput);
   model->GetOutput(index, out);
+  if (model->GetFlightRecorder()) model->GetFlightRecorder()->OnGetOutput(FlightRecorder::Now());
+  if (metrics.metrics()) {
+    metrics.Done(GetBytes(GetOutputSize(model, index), model->GetOutputType(index)));
+  }
+  DLR_PROBE(get__output, model, GetBackendName(model), index, GetOutputSize(model, index),
+            timer.Elapsed());
+  API_END();
+}
+
+extern "C" int GetDLROutputTyped(DLRModelHandle* handle, int index, void* out, const char* dtype) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  CHECK(dtype != nullptr) << "dtype is nullptr";
+  MetricsScope metrics(model, kMetricGetOutput);
+  model->GetOutputTyped(index, out, dtype);
+  if (model->GetFlightRecorder()) model->GetFlightRecorder()->OnGetOutput(FlightRecorder::Now());
+  if (metrics.metrics()) metrics.Done(GetBytes(GetOutputSize(model, index), dtype));
+  API_END();
+}
+
+extern "C" int GetDLRInputQuantization(DLRModelHandle* handle, const char* name, int* quantized,
+                                       float* scale, int* zero_point) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  QuantizationParams params;
+  *quantized = model->GetInputQuantization(name, &params);
+  *scale = params.scale;
+  *zero_point = params.zero_point;
+  API_END();
+}
+
+extern "C" int GetDLROutputQuantization(DLRModelHandle* handle, int index, int* quantized,
+                                        float* scale, int* zero_point) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  QuantizationParams params;
+  *quantized = model->GetOutputQuantization(index, &params);
+  *scale = params.scale;
+  *zero_point = params.zero_point;
   API_END();
 }
 
@@ -139,7 +350,52 @@ extern "C" int GetDLROutputPtr(DLRModelHandle* handle, int index, const void** o
   API_BEGIN();
   DLRModel* model = static_cast<DLRModel*>(*handle);
   CHECK(model != nullptr) << "model is nullptr, create it first";
+  MetricsScope metrics(model, kMetricGetOutput);
   *out = model->GetOutputPtr(index);
+  // The output is not copied.
+  if (metrics.metrics()) metrics.Done(0);
+  API_END();
+}
+
+extern "C" int SetDLROutputBuffers(DLRModelHandle* handle, int num_sets) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  model->SetNumOutputBuffers(num_sets);
+  API_END();
+}
+
+extern "C" int GetDLROutputTicket(DLRModelHandle* handle, int64_t* ticket) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  *ticket = model->GetOutputTicket();
+  API_END();
+}
+
+extern "C" int GetDLRTicketOutputPtr(DLRModelHandle* handle, int64_t ticket, int index,
+                                     const void** out) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  *out = model->GetTicketOutputPtr(ticket, index);
+  API_END();
+}
+
+extern "C" int GetDLRTicketOutputShape(DLRModelHandle* handle, int64_t ticket, int index,
+                                       int64_t* shape) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  model->GetTicketOutputShape(ticket, index, shape);
+  API_END();
+}
+
+extern "C" int ReleaseDLROutputs(DLRModelHandle* handle, int64_t ticket) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  model->ReleaseOutputs(ticket);
   API_END();
 }
 
@@ -152,6 +408,7 @@ extern "C" int GetDLROutputTensor(DLRModelHandle* handle, int index, void* tenso
       << kBackendToStr[static_cast<int>(backend)] << "' but expected 'tvm' or 'relayvm'";
 
   DLTensor* dltensor = static_cast<DLTensor*>(tensor);
+  MetricsScope metrics(dlr_model, kMetricGetOutput);
   if (backend == DLRBackend::kTVM) {
     TVMModel* tvm_model = static_cast<TVMModel*>(*handle);
     CHECK(tvm_model != nullptr) << "model is nullptr, create it first";
@@ -161,6 +418,9 @@ extern "C" int GetDLROutputTensor(DLRModelHandle* handle, int index, void* tenso
     CHECK(vm_model != nullptr) << "model is nullptr, create it first";
     vm_model->GetOutputTensor(index, dltensor);
   }
+  if (metrics.metrics()) {
+    metrics.Done(GetBytes(GetOutputSize(dlr_model, index), dlr_model->GetOutputType(index)));
+  }
   API_END();
 }
 
@@ -256,24 +516,33 @@ extern "C" int GetDLROutputByName(DLRModelHandle* handle, const char* name, void
   API_BEGIN();
   DLRModel* model = static_cast<DLRModel*>(*handle);
   CHECK(model != nullptr) << "model is nullptr, create it first";
+  MetricsScope metrics(model, kMetricGetOutput);
   model->GetOutputByName(name, out);
+  if (metrics.metrics()) {
+    const int index = model->GetOutputIndex(name);
+    metrics.Done(GetBytes(GetOutputSize(model, index), model->GetOutputType(index)));
+  }
   API_END();
 }
 
 
 DLRModelPtr CreateDLRModelPtr(const char* model_path, DLContext& ctx) {
   std::vector<std::string> path_vec = dlr::MakePathVec(model_path);
-  std::vector<std::string> files = FindFiles(path_vec);
+  std::string cpu_variant;
+  std::vector<std::string> files = dlr::SelectCPUVariant(FindFiles(path_vec), &cpu_variant);
   DLRBackend backend = dlr::GetBackend(files);
+  DLRModelPtr model;
   if (backend == DLRBackend::kTVM) {
-    return std::make_shared<TVMModel>(files, ctx);
+    model = std::make_shared<TVMModel>(files, ctx);
   } else if (backend == DLRBackend::kRELAYVM) {
-    return std::make_shared<RelayVMModel>(files, ctx);
+    model = std::make_shared<RelayVMModel>(files, ctx);
   } else if (backend == DLRBackend::kTREELITE) {
-    return std::make_shared<TreeliteModel>(files, ctx);
+    model = std::make_shared<TreeliteModel>(files, ctx);
+  } else if (backend == DLRBackend::kBATCHVARIANT) {
+    model = std::make_shared<BatchVariantModel>(files, ctx);
 #ifdef DLR_HEXAGON
   } else if (backend == DLRBackend::kHEXAGON) {
-    return std::make_shared<HexagonModel>(files, ctx, 1 /*debug_level*/);
+    model = std::make_shared<HexagonModel>(files, ctx, 1 /*debug_level*/);
 #endif  // DLR_HEXAGON
   } else {
     std::string err = "Unable to determine backend from path: '";
@@ -281,6 +550,9 @@ DLRModelPtr CreateDLRModelPtr(const char* model_path, DLContext& ctx) {
     throw dmlc::Error(err);
     return nullptr;  // unreachable
   }
+  if (!cpu_variant.empty()) model->SetCPUVariant(cpu_variant);
+  ApplyTunedConfig(files, model.get());
+  return model;
 }
 
 #ifdef DLR_HEXAGON
@@ -306,12 +578,21 @@ int CreateDLRModelFromHexagon(DLRModelHandle* handle, const char* model_path, in
 extern "C" int CreateDLRModel(DLRModelHandle* handle, const char* model_path, int dev_type,
                               int dev_id) {
   API_BEGIN();
+  DLR_PROBE(load__start, model_path, dev_type);
+  const ProbeTimer timer(DLR_PROBE_ENABLED(load__done));
   DLContext ctx;
   ctx.device_type = static_cast<DLDeviceType>(dev_type);
   ctx.device_id = dev_id;
 
   std::vector<std::string> path_vec = dlr::MakePathVec(model_path);
-  std::vector<std::string> files = FindFiles(path_vec);
+  std::string cpu_variant;
+  std::vector<std::string> files;
+  try {
+    files = dlr::SelectCPUVariant(FindFiles(path_vec), &cpu_variant);
+  } catch (dmlc::Error& e) {
+    LOG(ERROR) << e.what();
+    return -1;
+  }
 
   DLRBackend backend = dlr::GetBackend(files);
   DLRModel* model;
@@ -322,6 +603,8 @@ extern "C" int CreateDLRModel(DLRModelHandle* handle, const char* model_path, in
       model = new RelayVMModel(files, ctx);
     } else if (backend == DLRBackend::kTREELITE) {
       model = new TreeliteModel(files, ctx);
+    } else if (backend == DLRBackend::kBATCHVARIANT) {
+      model = new BatchVariantModel(files, ctx);
 #ifdef DLR_HEXAGON
     } else if (backend == DLRBackend::kHEXAGON) {
       model = new HexagonModel(files, ctx, 1 /*debug_level*/);
@@ -336,8 +619,16 @@ extern "C" int CreateDLRModel(DLRModelHandle* handle, const char* model_path, in
     LOG(ERROR) << e.what();
     return -1;
   }
+  if (!cpu_variant.empty()) model->SetCPUVariant(cpu_variant);
+  try {
+    ApplyTunedConfig(files, model);
+  } catch (dmlc::Error& e) {
+    delete model;
+    throw;
+  }
 
   *handle = model;
+  DLR_PROBE(load__done, model, GetBackendName(model), timer.Elapsed());
   API_END();
 }
 
@@ -393,6 +684,44 @@ extern "C" int CreateDLRPipeline(DLRModelHandle* handle, int num_models, const c
   API_END();
 }
 
+extern "C" int CreateDLRCascade(DLRModelHandle* handle, const char* spec, int dev_type,
+                                int dev_id) {
+  API_BEGIN();
+  DLContext ctx;
+  ctx.device_type = static_cast<DLDeviceType>(dev_type);
+  ctx.device_id = dev_id;
+  nlohmann::json cascade;
+  LoadJsonFromString(spec, cascade);
+  std::vector<DLRModelPtr> stages;
+  std::vector<CascadeExit> exits;
+  try {
+    const nlohmann::json& stage_specs = cascade.at("Stages");
+    for (size_t i = 0; i < stage_specs.size(); i++) {
+      const nlohmann::json& stage_spec = stage_specs[i];
+      stages.push_back(CreateDLRModelPtr(stage_spec.at("path").get<std::string>().c_str(), ctx));
+      if (i + 1 < stage_specs.size()) exits.push_back(ParseCascadeExit(stage_spec.at("exit")));
+    }
+  } catch (nlohmann::json::exception& e) {
+    throw dmlc::Error("Invalid cascade spec: " + std::string(e.what()));
+  }
+  *handle = new CascadeModel(stages, exits, ctx);
+  API_END();
+}
+
+extern "C" int GetDLRCascadeExitCounts(DLRModelHandle* handle, int64_t* exit_counts,
+                                       int* num_stages) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  CHECK(model->GetBackend() == DLRBackend::kCASCADE)
+      << "model is not a CascadeModel. Found '"
+      << kBackendToStr[static_cast<int>(model->GetBackend())] << "' but expected 'cascade'";
+  const std::vector<int64_t> counts = static_cast<CascadeModel*>(model)->GetExitCounts();
+  if (exit_counts != nullptr) std::copy(counts.begin(), counts.end(), exit_counts);
+  if (num_stages != nullptr) *num_stages = counts.size();
+  API_END();
+}
+
 extern "C" int DeleteDLRModel(DLRModelHandle* handle) {
   API_BEGIN();
   DLRModel* model = static_cast<DLRModel*>(*handle);
@@ -403,7 +732,16 @@ extern "C" int DeleteDLRModel(DLRModelHandle* handle) {
 
 extern "C" int RunDLRModel(DLRModelHandle* handle) {
   API_BEGIN();
-  static_cast<DLRModel*>(*handle)->Run();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  DLR_PROBE(run__start, model, GetBackendName(model));
+  const ProbeTimer timer(DLR_PROBE_ENABLED(run__done));
+  MetricsScope metrics(model, kMetricRun);
+  const uint64_t start = GetRecorderTime(model);
+  model->RunCounted();
+  if (model->GetFlightRecorder()) model->GetFlightRecorder()->OnRun(start, FlightRecorder::Now());
+  if (metrics.metrics()) metrics.Done(0);
+  DLR_PROBE(run__done, model, GetBackendName(model), timer.Elapsed());
   API_END();
 }
 
@@ -428,6 +766,27 @@ extern "C" int GetDLRDeviceType(const char* model_path) {
   API_END();
 }
 
+extern "C" int GetDLRCPUFeatures(const char** features) {
+  API_BEGIN();
+  static const std::string joined = [] {
+    std::string s;
+    for (const std::string& feature : dlr::GetCPUFeatures()) {
+      s += (s.empty() ? "" : " ") + feature;
+    }
+    return s;
+  }();
+  *features = joined.c_str();
+  API_END();
+}
+
+extern "C" int GetDLRCPUVariant(DLRModelHandle* handle, const char** variant) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  *variant = model->GetCPUVariant().c_str();
+  API_END();
+}
+
 extern "C" int GetDLRVersion(const char** out) {
   API_BEGIN();
   static const std::string version_str =
@@ -469,3 +828,257 @@ extern "C" int SetDLRCustomAllocatorMemalign(DLRMemalignFunctionPtr custom_memal
   DLRAllocatorFunctions::SetMemalignFunction(custom_memalign_fn);
   API_END();
 }
+
+extern "C" int SetDLRSharedWeightStore(const char* location) {
+  API_BEGIN();
+  dlr::SetSharedWeightStore(location == nullptr ? "" : location);
+  API_END();
+}
+
+extern "C" int SetDLRPreforkMode(int enable) {
+  API_BEGIN();
+  dlr::SetPreforkMode(enable != 0);
+  API_END();
+}
+
+extern "C" int DLRPrepareFork() {
+  API_BEGIN();
+  dlr::PrepareFork();
+  API_END();
+}
+
+extern "C" int DLRPostForkParent() {
+  API_BEGIN();
+  dlr::PostForkParent();
+  API_END();
+}
+
+extern "C" int DLRPostForkChild() {
+  API_BEGIN();
+  dlr::PostForkChild();
+  API_END();
+}
+
+extern "C" int CreateDLRExecutionGroup(DLRExecutionGroupHandle* handle) {
+  API_BEGIN();
+  *handle = new std::shared_ptr<ExecutionGroup>(std::make_shared<ExecutionGroup>());
+  API_END();
+}
+
+extern "C" int JoinDLRExecutionGroup(DLRExecutionGroupHandle* handle, DLRModelHandle* model) {
+  API_BEGIN();
+  auto* group = static_cast<std::shared_ptr<ExecutionGroup>*>(*handle);
+  CHECK(group != nullptr) << "execution group is nullptr, create it first";
+  DLRModel* dlr_model = static_cast<DLRModel*>(*model);
+  CHECK(dlr_model != nullptr) << "model is nullptr, create it first";
+  if (dlr_model->GetBackend() != DLRBackend::kTVM) {
+    throw dmlc::Error("Execution groups are only supported by the TVM backend.");
+  }
+  static_cast<TVMModel*>(dlr_model)->JoinExecutionGroup(*group);
+  API_END();
+}
+
+extern "C" int GetDLRExecutionGroupSavedBytes(DLRExecutionGroupHandle* handle,
+                                              int64_t* saved_bytes, int64_t* arena_bytes) {
+  API_BEGIN();
+  auto* group = static_cast<std::shared_ptr<ExecutionGroup>*>(*handle);
+  CHECK(group != nullptr) << "execution group is nullptr, create it first";
+  *saved_bytes = static_cast<int64_t>((*group)->GetSavedBytes());
+  if (arena_bytes != nullptr) *arena_bytes = static_cast<int64_t>((*group)->GetArenaBytes());
+  API_END();
+}
+
+extern "C" int DeleteDLRExecutionGroup(DLRExecutionGroupHandle* handle) {
+  API_BEGIN();
+  delete static_cast<std::shared_ptr<ExecutionGroup>*>(*handle);
+  *handle = NULL;
+  API_END();
+}
+
+extern "C" int CreateDLRSession(DLRSessionHandle* handle, DLRModelHandle* model, int num_states,
+                                const char** output_names, const char** input_names) {
+  API_BEGIN();
+  DLRModel* dlr_model = static_cast<DLRModel*>(*model);
+  CHECK(dlr_model != nullptr) << "model is nullptr, create it first";
+  std::vector<std::pair<std::string, std::string>> bindings;
+  for (int i = 0; i < num_states; i++) {
+    bindings.emplace_back(output_names[i], input_names[i]);
+  }
+  *handle = new Session(dlr_model, bindings);
+  API_END();
+}
+
+extern "C" int RunDLRSession(DLRSessionHandle* handle) {
+  API_BEGIN();
+  Session* session = static_cast<Session*>(*handle);
+  CHECK(session != nullptr) << "session is nullptr, create it first";
+  MetricsScope metrics(session->GetModel(), kMetricRun);
+  session->Run();
+  if (metrics.metrics()) metrics.Done(0);
+  API_END();
+}
+
+extern "C" int ResetDLRSession(DLRSessionHandle* handle) {
+  API_BEGIN();
+  Session* session = static_cast<Session*>(*handle);
+  CHECK(session != nullptr) << "session is nullptr, create it first";
+  session->Reset();
+  API_END();
+}
+
+extern "C" int GetDLRSessionState(DLRSessionHandle* handle, const char* input_name, void* data) {
+  API_BEGIN();
+  Session* session = static_cast<Session*>(*handle);
+  CHECK(session != nullptr) << "session is nullptr, create it first";
+  session->GetState(input_name, data);
+  API_END();
+}
+
+extern "C" int SetDLRSessionState(DLRSessionHandle* handle, const char* input_name,
+                                  const void* data) {
+  API_BEGIN();
+  Session* session = static_cast<Session*>(*handle);
+  CHECK(session != nullptr) << "session is nullptr, create it first";
+  session->SetState(input_name, data);
+  API_END();
+}
+
+extern "C" int DeleteDLRSession(DLRSessionHandle* handle) {
+  API_BEGIN();
+  delete static_cast<Session*>(*handle);
+  *handle = NULL;
+  API_END();
+}
+
+extern "C" int TuneDLRModel(const char* model_path, int dev_type, int dev_id,
+                            const int64_t* batch_sizes, int num_batch_sizes, float time_budget,
+                            float max_p99_ms, const char* config_path, int* instances,
+                            int* threads, int64_t* batch_size) {
+  API_BEGIN();
+  DLContext ctx;
+  ctx.device_type = static_cast<DLDeviceType>(dev_type);
+  ctx.device_id = dev_id;
+  TunerOptions options = GetDefaultTunerOptions();
+  if (batch_sizes != nullptr) {
+    options.batch_sizes.assign(batch_sizes, batch_sizes + num_batch_sizes);
+  }
+  options.time_budget = time_budget;
+  options.max_p99_ms = max_p99_ms;
+  const TunedConfig config =
+      TuneModel([&]() { return CreateDLRModelPtr(model_path, ctx); }, options);
+  WriteTunedConfig(config_path != nullptr
+                       ? std::string(config_path)
+                       : std::string(model_path) + "/" + TUNED_CONFIG_FILE,
+                   config);
+  if (instances != nullptr) *instances = config.instances;
+  if (threads != nullptr) *threads = config.threads;
+  if (batch_size != nullptr) *batch_size = config.batch_size;
+  API_END();
+}
+
+extern "C" int GetDLRTunedConfig(const char* model_path, int* instances, int* threads,
+                                 int64_t* batch_size) {
+  API_BEGIN();
+  std::string config_path;
+  for (const std::string& filename : FindFiles(dlr::MakePathVec(model_path))) {
+    if (GetBasename(filename) == TUNED_CONFIG_FILE) config_path = filename;
+  }
+  CHECK(!config_path.empty()) << "No " << TUNED_CONFIG_FILE << " found in " << model_path;
+  const TunedConfig config = ReadTunedConfig(config_path);
+  *instances = config.instances;
+  *threads = config.threads;
+  *batch_size = config.batch_size;
+  API_END();
+}
+
+extern "C" int EnableDLRPerfCounters(DLRModelHandle* handle, int enable) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  model->EnablePerfCounters(enable != 0);
+  API_END();
+}
+
+extern "C" int GetDLRPerfCounters(DLRModelHandle* handle, int64_t* counters, int64_t* num_runs) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  CHECK(model->GetPerfCounters() != nullptr)
+      << "Performance counters are not enabled, call EnableDLRPerfCounters() first.";
+  *num_runs = model->GetPerfCounters()->Get(counters);
+  API_END();
+}
+
+extern "C" int GetDLRPipelineStagePerfCounters(DLRModelHandle* handle, int stage,
+                                               int64_t* counters, int64_t* num_runs) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  CHECK(model->GetBackend() == DLRBackend::kPIPELINE)
+      << "model is not a PipelineModel. Found '"
+      << kBackendToStr[static_cast<int>(model->GetBackend())] << "' but expected 'pipeline'";
+  const DLRModelPtr& stage_model = static_cast<PipelineModel*>(model)->GetStage(stage);
+  CHECK(stage_model->GetPerfCounters() != nullptr)
+      << "Performance counters are not enabled, call EnableDLRPerfCounters() first.";
+  *num_runs = stage_model->GetPerfCounters()->Get(counters);
+  API_END();
+}
+
+extern "C" int EnableDLRFlightRecorder(DLRModelHandle* handle, int capacity,
+                                       float slow_threshold_ms) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  model->EnableFlightRecorder(capacity, slow_threshold_ms);
+  API_END();
+}
+
+extern "C" int DumpDLRFlightRecorder(DLRModelHandle* handle, const char* path) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  CHECK(model->GetFlightRecorder() != nullptr)
+      << "Flight recorder is not enabled, call EnableDLRFlightRecorder() first.";
+  std::ofstream out(path, std::ios::app);
+  CHECK(out.good()) << "Could not open " << path;
+  model->GetFlightRecorder()->Dump(out);
+  API_END();
+}
+
+extern "C" int SetDLRFlightRecorderDumpSignal(int signum, const char* path) {
+  API_BEGIN();
+  FlightRecorder::InstallDumpSignal(signum, path);
+  API_END();
+}
+
+extern "C" int EstimateDLRModelCost(const char* model_path, DLRModelCost* report) {
+  API_BEGIN();
+  std::string cpu_variant;
+  const ModelCost cost = EstimateModelCost(
+      dlr::SelectCPUVariant(FindFiles(dlr::MakePathVec(model_path)), &cpu_variant));
+  report->flops = cost.flops;
+  report->weight_bytes = cost.weight_bytes;
+  report->activation_bytes = cost.activation_bytes;
+  report->peak_memory_bytes = cost.peak_memory_bytes;
+  API_END();
+}
+
+extern "C" int EnableDLRMetrics(DLRModelHandle* handle, int enable, const char* name) {
+  API_BEGIN();
+  DLRModel* model = static_cast<DLRModel*>(*handle);
+  CHECK(model != nullptr) << "model is nullptr, create it first";
+  CHECK(!enable || name != nullptr) << "name is nullptr";
+  model->EnableMetrics(enable != 0, enable ? name : "");
+  API_END();
+}
+
+extern "C" int GetDLRMetricsText(char* buf, int64_t len, int64_t* size) {
+  API_BEGIN();
+  const std::string text = GetMetricsText();
+  *size = text.size() + 1;
+  if (buf == nullptr) return 0;
+  CHECK_GE(len, *size) << "Buffer of " << len << " bytes is too small for the metrics, "
+                       << *size << " bytes are needed";
+  std::memcpy(buf, text.c_str(), *size);
+  API_END();
+}
@@ -0,0 +1,301 @@
+#include "dlr_batch_variant.h"
+
+#include <tvm/runtime/data_type.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "dlr_cpu_features.h"
+
+using namespace dlr;
+
+namespace {
+
+size_t GetTypeBytes(const std::string& type) {
+  DLDataType dtype = tvm::runtime::String2DLDataType(type);
+  return (dtype.bits * dtype.lanes + 7) / 8;
+}
+
+/*! \brief Bytes of one batch row of a tensor of the given shape and type. */
+size_t GetRowBytes(const std::vector<int64_t>& shape, const std::string& type) {
+  CHECK(!shape.empty()) << "Batch variants must have a batch dimension.";
+  return std::accumulate(shape.begin() + 1, shape.end(), static_cast<size_t>(1),
+                         std::multiplies<size_t>()) *
+         GetTypeBytes(type);
+}
+
+}  // namespace
+
+std::vector<BatchVariantRun> dlr::PlanBatchVariantRuns(const std::vector<int64_t>& batch_sizes,
+                                                       int64_t batch_size) {
+  CHECK(!batch_sizes.empty()) << "No batch variant to run.";
+  CHECK_GT(batch_size, 0) << "Batch size must be positive.";
+  std::vector<BatchVariantRun> runs;
+  int64_t offset = 0;
+  while (offset < batch_size) {
+    const int64_t remaining = batch_size - offset;
+    size_t variant = 0;
+    while (variant + 1 < batch_sizes.size() && batch_sizes[variant] < remaining) variant++;
+    const int64_t count = std::min(batch_sizes[variant], remaining);
+    runs.push_back({variant, offset, count});
+    offset += count;
+  }
+  return runs;
+}
+
+void BatchVariantModel::SetupBatchVariantModel(const std::vector<std::string>& files) {
+  std::string manifest_path;
+  for (const std::string& filename : files) {
+    if (GetBasename(filename) == BATCH_VARIANTS_MANIFEST) manifest_path = filename;
+  }
+  if (manifest_path.empty()) {
+    throw dmlc::Error("Invalid batch variant model artifact. Must have " +
+                      std::string(BATCH_VARIANTS_MANIFEST) + " file.");
+  }
+  nlohmann::json manifest;
+  LoadJsonFromFile(manifest_path, manifest);
+  const std::string folder = GetParentFolder(manifest_path);
+  try {
+    for (const nlohmann::json& entry : manifest.at("BatchVariants")) {
+      const int64_t batch_size = entry.at("batch_size").get<int64_t>();
+      const std::string path = folder + "/" + entry.at("path").get<std::string>();
+      CHECK_GT(batch_size, 0) << "Invalid batch size of variant " << path;
+      std::vector<std::string> variant_files = SelectCPUVariant(FindFiles({path}), &cpu_variant_);
+      variants_.push_back({batch_size, std::make_shared<TVMModel>(variant_files, ctx_)});
+    }
+  } catch (nlohmann::json::exception& e) {
+    throw dmlc::Error("Invalid " + std::string(BATCH_VARIANTS_MANIFEST) + ": " + e.what());
+  }
+  CHECK(!variants_.empty()) << "No variant found in " << manifest_path;
+  std::sort(variants_.begin(), variants_.end(),
+            [](const Variant& a, const Variant& b) { return a.batch_size < b.batch_size; });
+
+  const std::shared_ptr<TVMModel>& base = variants_[0].model;
+  metadata_ = base->metadata_;
+  num_inputs_ = base->GetNumInputs();
+  num_weights_ = base->GetNumWeights();
+  num_outputs_ = base->GetNumOutputs();
+  for (int i = 0; i < num_inputs_; i++) {
+    input_names_.push_back(base->GetInputName(i));
+    input_types_.push_back(base->GetInputType(i));
+    std::vector<int64_t> shape = base->GetInputShape(i);
+    input_row_bytes_.push_back(GetRowBytes(shape, input_types_[i]));
+    shape[0] = -1;
+    input_shapes_.push_back(shape);
+  }
+  inputs_.resize(num_inputs_);
+  for (int i = 0; i < num_outputs_; i++) {
+    int64_t size;
+    int dim;
+    base->GetOutputSizeDim(i, &size, &dim);
+    std::vector<int64_t> shape(dim);
+    base->GetOutputShape(i, shape.data());
+    output_types_.push_back(base->GetOutputType(i));
+    output_row_bytes_.push_back(GetRowBytes(shape, output_types_[i]));
+    shape[0] = -1;
+    output_shapes_.push_back(shape);
+  }
+  outputs_.resize(num_outputs_);
+
+  // All variants must be the same model, only differing by the batch dimension.
+  for (size_t v = 0; v < variants_.size(); v++) {
+    const Variant& variant = variants_[v];
+    CHECK(v == 0 || variant.batch_size != variants_[v - 1].batch_size)
+        << "Found multiple variants for batch size " << variant.batch_size;
+    CHECK_EQ(variant.model->GetNumInputs(), num_inputs_) << "Number of inputs mismatch";
+    CHECK_EQ(variant.model->GetNumOutputs(), num_outputs_) << "Number of outputs mismatch";
+    for (int i = 0; i < num_inputs_; i++) {
+      CHECK_EQ(input_names_[i], variant.model->GetInputName(i)) << "Input name mismatch";
+      CHECK_EQ(input_types_[i], variant.model->GetInputType(i)) << "Input type mismatch";
+      std::vector<int64_t> shape = variant.model->GetInputShape(i);
+      CHECK_EQ(shape.size(), input_shapes_[i].size()) << "Input dimension mismatch";
+      CHECK_SHAPE("Mismatch found in batch size of input " + input_names_[i], shape[0],
+                  variant.batch_size);
+      CHECK(std::equal(shape.begin() + 1, shape.end(), input_shapes_[i].begin() + 1))
+          << "Input shape mismatch for " << input_names_[i];
+    }
+    for (int i = 0; i < num_outputs_; i++) {
+      CHECK_EQ(output_types_[i], variant.model->GetOutputType(i)) << "Output type mismatch";
+      std::vector<int64_t> shape(output_shapes_[i].size());
+      variant.model->GetOutputShape(i, shape.data());
+      CHECK_SHAPE("Mismatch found in batch size of output " + std::to_string(i), shape[0],
+                  variant.batch_size);
+      CHECK(std::equal(shape.begin() + 1, shape.end(), output_shapes_[i].begin() + 1))
+          << "Output shape mismatch for output " << i;
+    }
+  }
+
+  // Only one variant runs at a time, so they can share their activation memory.
+  execution_group_ = std::make_shared<ExecutionGroup>();
+  for (const Variant& variant : variants_) {
+    variant.model->JoinExecutionGroup(execution_group_);
+  }
+}
+
+std::vector<int64_t> BatchVariantModel::GetBatchSizes() const {
+  std::vector<int64_t> batch_sizes;
+  for (const Variant& variant : variants_) {
+    batch_sizes.push_back(variant.batch_size);
+  }
+  return batch_sizes;
+}
+
+int BatchVariantModel::GetInputIndex(const char* name) const {
+  auto it = std::find(input_names_.begin(), input_names_.end(), name);
+  if (it == input_names_.end()) {
+    throw dmlc::Error("Input with name '" + std::string(name) + "' not found.");
+  }
+  return static_cast<int>(it - input_names_.begin());
+}
+
+const int BatchVariantModel::GetInputDim(int index) const {
+  CHECK_LT(index, num_inputs_) << "Input index is out of range.";
+  return input_shapes_[index].size();
+}
+
+const int64_t BatchVariantModel::GetInputSize(int index) const {
+  CHECK_LT(index, num_inputs_) << "Input index is out of range.";
+  // The batch dimension is dynamic.
+  return -1;
+}
+
+const char* BatchVariantModel::GetInputName(int index) const {
+  CHECK_LT(index, num_inputs_) << "Input index is out of range.";
+  return input_names_[index].c_str();
+}
+
+const char* BatchVariantModel::GetInputType(int index) const {
+  CHECK_LT(index, num_inputs_) << "Input index is out of range.";
+  return input_types_[index].c_str();
+}
+
+const char* BatchVariantModel::GetWeightName(int index) const {
+  return variants_[0].model->GetWeightName(index);
+}
+
+std::vector<std::string> BatchVariantModel::GetWeightNames() const {
+  return variants_[0].model->GetWeightNames();
+}
+
+void BatchVariantModel::SetInput(const char* name, const int64_t* shape, const void* input,
+                                 int dim) {
+  const int index = GetInputIndex(name);
+  const std::vector<int64_t>& expected_shape = input_shapes_[index];
+  CHECK_SHAPE("Mismatch found in input dimension", dim, expected_shape.size());
+  for (int i = 1; i < dim; i++) {
+    CHECK_SHAPE("Mismatch found in input shape at dimension " + std::to_string(i), shape[i],
+                expected_shape[i]);
+  }
+  CHECK_GT(shape[0], 0) << "Batch size must be positive.";
+  StagedInput& staged = inputs_[index];
+  const char* data = static_cast<const char*>(input);
+  staged.data.assign(data, data + shape[0] * input_row_bytes_[index]);
+  staged.batch_size = shape[0];
+}
+
+void BatchVariantModel::GetInput(const char* name, void* input) {
+  const StagedInput& staged = inputs_[GetInputIndex(name)];
+  CHECK_GE(staged.batch_size, 0) << "Input '" << name << "' has not been set.";
+  std::memcpy(input, staged.data.data(), staged.data.size());
+}
+
+void BatchVariantModel::RunChunk(const Variant& variant, int64_t offset, int64_t count) {
+  const bool padded = count < variant.batch_size;
+  for (int i = 0; i < num_inputs_; i++) {
+    const size_t row_bytes = input_row_bytes_[i];
+    const char* data = inputs_[i].data.data() + offset * row_bytes;
+    if (padded) {
+      scratch_.resize(variant.batch_size * row_bytes);
+      std::memcpy(scratch_.data(), data, count * row_bytes);
+      std::memset(scratch_.data() + count * row_bytes, 0,
+                  (variant.batch_size - count) * row_bytes);
+      data = scratch_.data();
+    }
+    std::vector<int64_t> shape = input_shapes_[i];
+    shape[0] = variant.batch_size;
+    variant.model->SetInput(input_names_[i].c_str(), shape.data(), data, shape.size());
+  }
+  variant.model->Run();
+  for (int i = 0; i < num_outputs_; i++) {
+    const size_t row_bytes = output_row_bytes_[i];
+    char* out = outputs_[i].data() + offset * row_bytes;
+    if (padded) {
+      scratch_.resize(variant.batch_size * row_bytes);
+      variant.model->GetOutput(i, scratch_.data());
+      std::memcpy(out, scratch_.data(), count * row_bytes);
+    } else {
+      variant.model->GetOutput(i, out);
+    }
+  }
+}
+
+void BatchVariantModel::Run() {
+  const int64_t batch_size = inputs_[0].batch_size;
+  for (int i = 0; i < num_inputs_; i++) {
+    CHECK_GE(inputs_[i].batch_size, 0) << "Input '" << input_names_[i] << "' has not been set.";
+    CHECK_EQ(inputs_[i].batch_size, batch_size) << "All inputs must have the same batch size.";
+  }
+  for (int i = 0; i < num_outputs_; i++) {
+    output_shapes_[i][0] = batch_size;
+    outputs_[i].resize(batch_size * output_row_bytes_[i]);
+  }
+  for (const BatchVariantRun& run : PlanBatchVariantRuns(GetBatchSizes(), batch_size)) {
+    RunChunk(variants_[run.variant], run.offset, run.count);
+  }
+}
+
+void BatchVariantModel::GetOutput(int index, void* out) {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  CHECK_GE(output_shapes_[index][0], 0) << "Run() must be called before getting outputs.";
+  std::memcpy(out, outputs_[index].data(), outputs_[index].size());
+}
+
+const void* BatchVariantModel::GetOutputPtr(int index) const {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  return outputs_[index].data();
+}
+
+void BatchVariantModel::GetOutputShape(int index, int64_t* shape) const {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  std::copy(output_shapes_[index].begin(), output_shapes_[index].end(), shape);
+}
+
+void BatchVariantModel::GetOutputSizeDim(int index, int64_t* size, int* dim) {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  const std::vector<int64_t>& shape = output_shapes_[index];
+  *size = dlr::HasNegative(shape.data(), shape.size())
+              ? -1
+              : std::accumulate(shape.begin(), shape.end(), static_cast<int64_t>(1),
+                                std::multiplies<int64_t>());
+  *dim = shape.size();
+}
+
+const char* BatchVariantModel::GetOutputType(int index) const {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  return output_types_[index].c_str();
+}
+
+void BatchVariantModel::SetNumThreads(int threads) {
+  for (const Variant& variant : variants_) {
+    variant.model->SetNumThreads(threads);
+  }
+}
+
+void BatchVariantModel::UseCPUAffinity(bool use) {
+  for (const Variant& variant : variants_) {
+    variant.model->UseCPUAffinity(use);
+  }
+}
+
+const char* BatchVariantModel::GetOutputName(const int index) const {
+  return variants_[0].model->GetOutputName(index);
+}
+
+int BatchVariantModel::GetOutputIndex(const char* name) const {
+  return variants_[0].model->GetOutputIndex(name);
+}
+
+void BatchVariantModel::GetOutputByName(const char* name, void* out) {
+  GetOutput(GetOutputIndex(name), out);
+}
@@ -0,0 +1,57 @@
+#include "dlr_binary_graph.h"
+
+#include <cstring>
+
+#include "dlr_binary_io.h"
+#include "dlr_graph_runtime.h"
+
+using namespace dlr;
+
+bool dlr::IsBinaryGraph(const void* data, size_t size) {
+  uint64_t magic;
+  if (size < sizeof(magic)) return false;
+  std::memcpy(&magic, data, sizeof(magic));
+  return magic == kBinaryGraphMagic;
+}
+
+std::string dlr::ConvertGraphToBinary(const std::string& graph_json,
+                                      const std::string& metadata_json) {
+  const std::string graph = DLRGraphRuntime::SerializeGraph(graph_json);
+  std::vector<uint8_t> metadata;
+  if (!metadata_json.empty()) {
+    nlohmann::json metadata_obj;
+    LoadJsonFromString(metadata_json, metadata_obj);
+    metadata = nlohmann::json::to_cbor(metadata_obj);
+  }
+  BinaryWriter writer;
+  writer.Write<uint64_t>(kBinaryGraphMagic);
+  writer.Write<uint32_t>(kBinaryGraphVersion);
+  writer.Write<uint32_t>(0);  // reserved
+  writer.WriteString(graph);
+  writer.WriteVector(metadata);
+  return std::move(writer.buffer());
+}
+
+BinaryGraph dlr::ParseBinaryGraph(const void* data, size_t size) {
+  BinaryReader reader(data, size);
+  CHECK_EQ(reader.Read<uint64_t>(), kBinaryGraphMagic) << "Invalid binary graph file.";
+  const uint32_t version = reader.Read<uint32_t>();
+  if (version != kBinaryGraphVersion) {
+    throw dmlc::Error("Unsupported binary graph version " + std::to_string(version) +
+                      ", expected " + std::to_string(kBinaryGraphVersion) + ".");
+  }
+  reader.Read<uint32_t>();  // reserved
+  BinaryGraph graph;
+  graph.graph_size = reader.Read<uint64_t>();
+  graph.graph = reader.ReadBytes(graph.graph_size);
+  const uint64_t metadata_size = reader.Read<uint64_t>();
+  const uint8_t* metadata = reinterpret_cast<const uint8_t*>(reader.ReadBytes(metadata_size));
+  if (metadata_size > 0) {
+    try {
+      graph.metadata = nlohmann::json::from_cbor(metadata, metadata + metadata_size);
+    } catch (nlohmann::json::exception& e) {
+      throw dmlc::Error(std::string("Invalid metadata in binary graph file: ") + e.what());
+    }
+  }
+  return graph;
+}
@@ -0,0 +1,365 @@
+#include "dlr_cascade.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+#include "dlr_data_convert.h"
+
+using namespace dlr;
+
+namespace {
+
+/*! \brief Bytes of one batch row of a tensor of the given shape and type. */
+size_t GetRowBytes(const std::vector<int64_t>& shape, const std::string& type) {
+  CHECK(!shape.empty()) << "Cascade stages must have a batch dimension.";
+  CHECK(!HasNegative(shape.data() + 1, shape.size() - 1))
+      << "Cascade stages must have static shapes, except for the batch dimension.";
+  const DLDataType dtype = GetDLDataTypeFromString(type);
+  return std::accumulate(shape.begin() + 1, shape.end(), static_cast<size_t>(1),
+                         std::multiplies<size_t>()) *
+         ((dtype.bits * dtype.lanes + 7) / 8);
+}
+
+}  // namespace
+
+CascadeExit dlr::ParseCascadeExit(const nlohmann::json& spec) {
+  CascadeExit exit;
+  try {
+    const nlohmann::json& output = spec.at("output");
+    if (output.is_number_integer()) {
+      exit.output_index = output.get<int>();
+    } else {
+      exit.output_name = output.get<std::string>();
+    }
+    const std::string criterion = spec.value("criterion", "max_prob");
+    if (criterion == "max_prob") {
+      exit.criterion = CascadeExit::kMaxProb;
+    } else if (criterion == "margin") {
+      exit.criterion = CascadeExit::kMargin;
+    } else {
+      throw dmlc::Error("Unknown cascade exit criterion " + criterion);
+    }
+    exit.threshold = spec.at("threshold").get<float>();
+  } catch (nlohmann::json::exception& e) {
+    throw dmlc::Error("Invalid cascade exit: " + std::string(e.what()));
+  }
+  return exit;
+}
+
+CascadeModel::CascadeModel(const std::vector<DLRModelPtr>& stages,
+                           const std::vector<CascadeExit>& exits, const DLContext& ctx)
+    : DLRModel(ctx, DLRBackend::kCASCADE) {
+  for (const DLRModelPtr& model : stages) {
+    stages_.push_back({model, -1});
+  }
+  SetupCascadeModel(exits);
+}
+
+void CascadeModel::SetupCascadeModel(const std::vector<CascadeExit>& exits) {
+  CHECK(!stages_.empty()) << "List of models is empty";
+  CHECK_EQ(exits.size(), stages_.size() - 1)
+      << "Every stage of a cascade but the last one needs an exit predicate";
+  const DLRModelPtr& base = stages_[0].model;
+  metadata_ = stages_.back().model->metadata_;
+  num_inputs_ = base->GetNumInputs();
+  num_weights_ = base->GetNumWeights();
+  num_outputs_ = base->GetNumOutputs();
+  for (int i = 0; i < num_inputs_; i++) {
+    input_names_.push_back(base->GetInputName(i));
+    input_types_.push_back(base->GetInputType(i));
+    std::vector<int64_t> shape = base->GetInputShape(i);
+    input_row_bytes_.push_back(GetRowBytes(shape, input_types_[i]));
+    shape[0] = -1;
+    input_shapes_.push_back(shape);
+  }
+  inputs_.resize(num_inputs_);
+  input_batch_sizes_.assign(num_inputs_, -1);
+  stage_inputs_.resize(num_inputs_);
+  for (int i = 0; i < num_outputs_; i++) {
+    int64_t size;
+    int dim;
+    base->GetOutputSizeDim(i, &size, &dim);
+    std::vector<int64_t> shape(dim);
+    base->GetOutputShape(i, shape.data());
+    output_types_.push_back(base->GetOutputType(i));
+    output_row_bytes_.push_back(GetRowBytes(shape, output_types_[i]));
+    shape[0] = -1;
+    output_shapes_.push_back(shape);
+  }
+  outputs_.resize(num_outputs_);
+  stage_outputs_.resize(num_outputs_);
+
+  // All stages take the same inputs and produce the same outputs, whatever their batch size.
+  for (size_t s = 0; s < stages_.size(); s++) {
+    Stage& stage = stages_[s];
+    const DLRModelPtr& model = stage.model;
+    CHECK_EQ(model->GetNumInputs(), num_inputs_) << "Number of inputs mismatch, stage " << s;
+    CHECK_EQ(model->GetNumOutputs(), num_outputs_) << "Number of outputs mismatch, stage " << s;
+    stage.batch_size = model->GetInputShape(0)[0];
+    for (int i = 0; i < num_inputs_; i++) {
+      CHECK_EQ(input_names_[i], model->GetInputName(i)) << "Input name mismatch, stage " << s;
+      CHECK_EQ(input_types_[i], model->GetInputType(i)) << "Input type mismatch, stage " << s;
+      const std::vector<int64_t>& shape = model->GetInputShape(i);
+      CHECK_EQ(shape.size(), input_shapes_[i].size()) << "Input dimension mismatch, stage " << s;
+      CHECK_EQ(shape[0], stage.batch_size) << "Inputs of stage " << s << " differ in batch size";
+      CHECK(std::equal(shape.begin() + 1, shape.end(), input_shapes_[i].begin() + 1))
+          << "Input shape mismatch for " << input_names_[i] << ", stage " << s;
+    }
+    for (int i = 0; i < num_outputs_; i++) {
+      CHECK_EQ(output_types_[i], model->GetOutputType(i)) << "Output type mismatch, stage " << s;
+      std::vector<int64_t> shape(output_shapes_[i].size());
+      model->GetOutputShape(i, shape.data());
+      CHECK(std::equal(shape.begin() + 1, shape.end(), output_shapes_[i].begin() + 1))
+          << "Output shape mismatch for output " << i << ", stage " << s;
+    }
+    if (s < exits.size()) {
+      stage.exit = exits[s];
+      if (stage.exit.output_index < 0) {
+        stage.exit.output_index = model->GetOutputIndex(stage.exit.output_name.c_str());
+      }
+      CHECK(stage.exit.output_index >= 0 && stage.exit.output_index < num_outputs_)
+          << "Invalid exit output of stage " << s;
+      CHECK_EQ(output_types_[stage.exit.output_index], "float32")
+          << "The exit output of stage " << s << " must be float32";
+    }
+  }
+}
+
+std::vector<int64_t> CascadeModel::GetExitCounts() const {
+  std::vector<int64_t> exit_counts;
+  for (const Stage& stage : stages_) {
+    exit_counts.push_back(stage.exit_count);
+  }
+  return exit_counts;
+}
+
+int CascadeModel::GetInputIndex(const char* name) const {
+  auto it = std::find(input_names_.begin(), input_names_.end(), name);
+  if (it == input_names_.end()) {
+    throw dmlc::Error("Input with name '" + std::string(name) + "' not found.");
+  }
+  return static_cast<int>(it - input_names_.begin());
+}
+
+const int CascadeModel::GetInputDim(int index) const {
+  CHECK_LT(index, num_inputs_) << "Input index is out of range.";
+  return input_shapes_[index].size();
+}
+
+const int64_t CascadeModel::GetInputSize(int index) const {
+  CHECK_LT(index, num_inputs_) << "Input index is out of range.";
+  // The batch dimension is dynamic.
+  return -1;
+}
+
+const char* CascadeModel::GetInputName(int index) const {
+  CHECK_LT(index, num_inputs_) << "Input index is out of range.";
+  return input_names_[index].c_str();
+}
+
+const char* CascadeModel::GetInputType(int index) const {
+  CHECK_LT(index, num_inputs_) << "Input index is out of range.";
+  return input_types_[index].c_str();
+}
+
+const char* CascadeModel::GetWeightName(int index) const {
+  return stages_[0].model->GetWeightName(index);
+}
+
+std::vector<std::string> CascadeModel::GetWeightNames() const {
+  return stages_[0].model->GetWeightNames();
+}
+
+void CascadeModel::SetInput(const char* name, const int64_t* shape, const void* input, int dim) {
+  const int index = GetInputIndex(name);
+  const std::vector<int64_t>& expected_shape = input_shapes_[index];
+  CHECK_SHAPE("Mismatch found in input dimension", dim, expected_shape.size());
+  for (int i = 1; i < dim; i++) {
+    CHECK_SHAPE("Mismatch found in input shape at dimension " + std::to_string(i), shape[i],
+                expected_shape[i]);
+  }
+  CHECK_GT(shape[0], 0) << "Batch size must be positive.";
+  const char* data = static_cast<const char*>(input);
+  inputs_[index].assign(data, data + shape[0] * input_row_bytes_[index]);
+  input_batch_sizes_[index] = shape[0];
+}
+
+void CascadeModel::GetInput(const char* name, void* input) {
+  const int index = GetInputIndex(name);
+  CHECK_GE(input_batch_sizes_[index], 0) << "Input '" << name << "' has not been set.";
+  std::memcpy(input, inputs_[index].data(), inputs_[index].size());
+}
+
+void CascadeModel::RunStage(const Stage& stage, const std::vector<std::vector<char>>& inputs,
+                            int64_t count) {
+  for (int i = 0; i < num_outputs_; i++) {
+    stage_outputs_[i].resize(count * output_row_bytes_[i]);
+  }
+  int64_t offset = 0;
+  while (offset < count) {
+    const int64_t batch_size = stage.batch_size < 0 ? count - offset : stage.batch_size;
+    const int64_t chunk = std::min(batch_size, count - offset);
+    const bool padded = chunk < batch_size;
+    for (int i = 0; i < num_inputs_; i++) {
+      const size_t row_bytes = input_row_bytes_[i];
+      const char* data = inputs[i].data() + offset * row_bytes;
+      if (padded) {
+        scratch_.resize(batch_size * row_bytes);
+        std::memcpy(scratch_.data(), data, chunk * row_bytes);
+        std::memset(scratch_.data() + chunk * row_bytes, 0, (batch_size - chunk) * row_bytes);
+        data = scratch_.data();
+      }
+      std::vector<int64_t> shape = input_shapes_[i];
+      shape[0] = batch_size;
+      stage.model->SetInput(input_names_[i].c_str(), shape.data(), data, shape.size());
+    }
+    stage.model->Run();
+    for (int i = 0; i < num_outputs_; i++) {
+      const size_t row_bytes = output_row_bytes_[i];
+      char* out = stage_outputs_[i].data() + offset * row_bytes;
+      if (padded) {
+        scratch_.resize(batch_size * row_bytes);
+        stage.model->GetOutput(i, scratch_.data());
+        std::memcpy(out, scratch_.data(), chunk * row_bytes);
+      } else {
+        stage.model->GetOutput(i, out);
+      }
+    }
+    offset += chunk;
+  }
+}
+
+bool CascadeModel::IsConfident(const Stage& stage, int64_t row) const {
+  const int index = stage.exit.output_index;
+  const size_t row_size = output_row_bytes_[index] / sizeof(float);
+  const float* begin =
+      reinterpret_cast<const float*>(stage_outputs_[index].data()) + row * row_size;
+  const float* end = begin + row_size;
+  if (stage.exit.criterion == CascadeExit::kMaxProb) {
+    return *std::max_element(begin, end) >= stage.exit.threshold;
+  }
+  float top1 = -std::numeric_limits<float>::infinity();
+  float top2 = -std::numeric_limits<float>::infinity();
+  for (const float* value = begin; value != end; value++) {
+    if (*value > top1) {
+      top2 = top1;
+      top1 = *value;
+    } else if (*value > top2) {
+      top2 = *value;
+    }
+  }
+  return top1 - top2 >= stage.exit.threshold;
+}
+
+void CascadeModel::Run() {
+  const int64_t batch_size = input_batch_sizes_[0];
+  for (int i = 0; i < num_inputs_; i++) {
+    CHECK_GE(input_batch_sizes_[i], 0) << "Input '" << input_names_[i] << "' has not been set.";
+    CHECK_EQ(input_batch_sizes_[i], batch_size) << "All inputs must have the same batch size.";
+  }
+  for (int i = 0; i < num_outputs_; i++) {
+    output_shapes_[i][0] = batch_size;
+    outputs_[i].resize(batch_size * output_row_bytes_[i]);
+  }
+  // Rows of the batch which have not exited yet.
+  std::vector<int64_t> rows(batch_size);
+  std::iota(rows.begin(), rows.end(), 0);
+  for (size_t s = 0; s < stages_.size() && !rows.empty(); s++) {
+    Stage& stage = stages_[s];
+    const int64_t count = rows.size();
+    // The first stage runs the whole batch, later ones the rows left, gathered.
+    if (s > 0) {
+      for (int i = 0; i < num_inputs_; i++) {
+        const size_t row_bytes = input_row_bytes_[i];
+        stage_inputs_[i].resize(count * row_bytes);
+        for (int64_t r = 0; r < count; r++) {
+          std::memcpy(stage_inputs_[i].data() + r * row_bytes,
+                      inputs_[i].data() + rows[r] * row_bytes, row_bytes);
+        }
+      }
+    }
+    RunStage(stage, s > 0 ? stage_inputs_ : inputs_, count);
+    const bool last = s + 1 == stages_.size();
+    int64_t remaining = 0;
+    for (int64_t r = 0; r < count; r++) {
+      if (!last && !IsConfident(stage, r)) {
+        rows[remaining++] = rows[r];
+        continue;
+      }
+      for (int i = 0; i < num_outputs_; i++) {
+        const size_t row_bytes = output_row_bytes_[i];
+        std::memcpy(outputs_[i].data() + rows[r] * row_bytes,
+                    stage_outputs_[i].data() + r * row_bytes, row_bytes);
+      }
+    }
+    stage.exit_count += count - remaining;
+    rows.resize(remaining);
+  }
+}
+
+void CascadeModel::GetOutput(int index, void* out) {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  CHECK_GE(output_shapes_[index][0], 0) << "Run() must be called before getting outputs.";
+  std::memcpy(out, outputs_[index].data(), outputs_[index].size());
+}
+
+const void* CascadeModel::GetOutputPtr(int index) const {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  return outputs_[index].data();
+}
+
+void CascadeModel::GetOutputShape(int index, int64_t* shape) const {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  std::copy(output_shapes_[index].begin(), output_shapes_[index].end(), shape);
+}
+
+void CascadeModel::GetOutputSizeDim(int index, int64_t* size, int* dim) {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  const std::vector<int64_t>& shape = output_shapes_[index];
+  *size = dlr::HasNegative(shape.data(), shape.size())
+              ? -1
+              : std::accumulate(shape.begin(), shape.end(), static_cast<int64_t>(1),
+                                std::multiplies<int64_t>());
+  *dim = shape.size();
+}
+
+const char* CascadeModel::GetOutputType(int index) const {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  return output_types_[index].c_str();
+}
+
+void CascadeModel::SetNumThreads(int threads) {
+  // Ignore the errors in case some of the stages do not support this feature.
+  for (const Stage& stage : stages_) {
+    try {
+      stage.model->SetNumThreads(threads);
+    } catch (dmlc::Error& e) {
+      // ignore
+    }
+  }
+}
+
+void CascadeModel::UseCPUAffinity(bool use) {
+  // Ignore the errors in case some of the stages do not support this feature.
+  for (const Stage& stage : stages_) {
+    try {
+      stage.model->UseCPUAffinity(use);
+    } catch (dmlc::Error& e) {
+      // ignore
+    }
+  }
+}
+
+const char* CascadeModel::GetOutputName(const int index) const {
+  return stages_.back().model->GetOutputName(index);
+}
+
+int CascadeModel::GetOutputIndex(const char* name) const {
+  return stages_.back().model->GetOutputIndex(name);
+}
+
+void CascadeModel::GetOutputByName(const char* name, void* out) {
+  GetOutput(GetOutputIndex(name), out);
+}
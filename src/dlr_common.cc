@@ -2,12 +2,25 @@
 
 #include <dmlc/filesystem.h>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <locale>
+#include <numeric>
+
+#include "dlr_binary_graph.h"
+#include "dlr_compressed_params.h"
+#include "dlr_data_convert.h"
+#include "dlr_flight_recorder.h"
+#include "dlr_metrics.h"
+#include "dlr_output_buffers.h"
+#include "dlr_perf_counters.h"
 
 using namespace dlr;
 
-const char* dlr::kBackendToStr[] = {"tvm", "treelite", "hexagon", "relayvm", "pipeline", "unknown"};
+const char* dlr::kBackendToStr[] = {"tvm",      "treelite",      "hexagon", "relayvm",
+                                    "pipeline", "batch_variant", "cascade", "unknown"};
 
 bool dlr::IsFileEmpty(const std::string& filePath) {
   std::ifstream pFile(filePath);
@@ -113,10 +126,14 @@ std::vector<std::string> dlr::FindFiles(const std::vector<std::string>& paths) {
 }
 
 DLRBackend dlr::GetBackend(const std::vector<std::string>& files) {
+  // A manifest of batch size variants takes precedence over the files next to it.
+  for (auto filename : files) {
+    if (GetBasename(filename) == BATCH_VARIANTS_MANIFEST) return DLRBackend::kBATCHVARIANT;
+  }
   // Scan files to guess the backend.
   bool has_tvm_lib = false;
   for (auto filename : files) {
-    if (EndsWith(filename, ".params")) {
+    if (IsParamsFile(filename)) {
       return DLRBackend::kTVM;
     } else if (EndsWith(filename, ".ro")) {
       return DLRBackend::kRELAYVM;
@@ -156,13 +173,21 @@ void dlr::InitModelPath(const std::vector<std::string>& files, ModelPath* paths)
         std::all_of(std::begin(SAGEMAKER_AUXILIARY_JSON_FILES),
                     std::end(SAGEMAKER_AUXILIARY_JSON_FILES),
                     [basename](const std::string& s) { return (s != basename); }) &&
-        filename != "version.json") {
+        filename != "version.json" && basename != BATCH_VARIANTS_MANIFEST &&
+        basename != TUNED_CONFIG_FILE) {
       if (paths->model_json.length() > 0) {
         std::string msg = "Found multiple *.json files: ";
         msg += paths->model_json + " " + filename;
         throw dmlc::Error(msg);
       }
       paths->model_json = filename;
+    } else if (EndsWith(filename, BINARY_GRAPH_EXT)) {
+      if (paths->binary_graph.length() > 0) {
+        std::string msg = "Found multiple *";
+        msg += std::string(BINARY_GRAPH_EXT) + " files: " + paths->binary_graph + " " + filename;
+        throw dmlc::Error(msg);
+      }
+      paths->binary_graph = filename;
     } else if (!EndsWith(filename, LIBDLR) && EndsWith(filename, LIBEXT)) {
       if (paths->model_lib.length() > 0) {
         std::string msg = "Found multiple model lib files: ";
@@ -177,7 +202,7 @@ void dlr::InitModelPath(const std::vector<std::string>& files, ModelPath* paths)
         throw dmlc::Error(msg);
       }
       paths->model_lib = filename;
-    } else if (EndsWith(filename, ".params")) {
+    } else if (IsParamsFile(filename)) {
       if (paths->params.length() > 0) {
         std::string msg = "Found multiple *.params files: ";
         msg += paths->params + " " + filename;
@@ -207,6 +232,155 @@ const std::vector<int64_t>& DLRModel::GetInputShape(int index) const {
   return input_shapes_[index];
 }
 
+void DLRModel::SetInputTyped(const char* name, const int64_t* shape, const void* input, int dim,
+                             const char* dtype) {
+  int index = -1;
+  for (int i = 0; i < GetNumInputs() && index < 0; ++i) {
+    if (std::strcmp(GetInputName(i), name) == 0) index = i;
+  }
+  CHECK_GE(index, 0) << "Input " << name << " was not found.";
+  const DLDataType src_dtype = GetDLDataTypeFromString(dtype);
+  const DLDataType dst_dtype = GetDLDataTypeFromString(GetInputType(index));
+  if (IsSameDLDataType(src_dtype, dst_dtype)) {
+    SetInput(name, shape, input, dim);
+    return;
+  }
+  const int64_t count = std::accumulate(shape, shape + dim, 1, std::multiplies<int64_t>());
+  std::vector<char> buffer(count * ((dst_dtype.bits + 7) / 8));
+  ConvertInputData(name, input, src_dtype, buffer.data(), dst_dtype, count);
+  SetInput(name, shape, buffer.data(), dim);
+}
+
+namespace {
+
+bool ParseQuantizationParams(const nlohmann::json& entry, QuantizationParams* params) {
+  auto quantization = entry.find("quantization");
+  if (quantization == entry.end() || quantization->is_null()) return false;
+  try {
+    params->scale = quantization->at("scale").get<float>();
+    params->zero_point = quantization->value("zero_point", 0);
+  } catch (nlohmann::json::exception& e) {
+    throw dmlc::Error("Invalid quantization in metadata: " + quantization->dump());
+  }
+  CHECK_GT(params->scale, 0.0f) << "Quantization scale must be positive";
+  return true;
+}
+
+}  // namespace
+
+bool DLRModel::GetInputQuantization(const char* name, QuantizationParams* params) const {
+  if (!HasMetadata()) return false;
+  auto model = metadata_.find("Model");
+  if (model == metadata_.end() || !model->contains("Inputs")) return false;
+  for (const auto& input : model->at("Inputs")) {
+    if (input.value("name", "") == name) return ParseQuantizationParams(input, params);
+  }
+  return false;
+}
+
+bool DLRModel::GetOutputQuantization(int index, QuantizationParams* params) const {
+  if (!HasMetadata()) return false;
+  auto model = metadata_.find("Model");
+  if (model == metadata_.end() || !model->contains("Outputs")) return false;
+  const nlohmann::json& outputs = model->at("Outputs");
+  if (index < 0 || index >= static_cast<int>(outputs.size())) return false;
+  return ParseQuantizationParams(outputs.at(index), params);
+}
+
+void DLRModel::ConvertInputData(const char* name, const void* src, const DLDataType& src_dtype,
+                                void* dst, const DLDataType& dst_dtype, int64_t count) const {
+  QuantizationParams params;
+  if ((src_dtype.code == kDLFloat || src_dtype.code == kDLBfloat) &&
+      IsQuantizedDLDataType(dst_dtype) && GetInputQuantization(name, &params)) {
+    QuantizeData(src, src_dtype, dst, dst_dtype, count, params);
+  } else {
+    ConvertData(src, src_dtype, dst, dst_dtype, count);
+  }
+}
+
+void DLRModel::ConvertOutputData(int index, const void* src, const DLDataType& src_dtype,
+                                 void* dst, const DLDataType& dst_dtype, int64_t count) const {
+  QuantizationParams params;
+  if (IsQuantizedDLDataType(src_dtype) &&
+      (dst_dtype.code == kDLFloat || dst_dtype.code == kDLBfloat) &&
+      GetOutputQuantization(index, &params)) {
+    DequantizeData(src, src_dtype, dst, dst_dtype, count, params);
+  } else {
+    ConvertData(src, src_dtype, dst, dst_dtype, count);
+  }
+}
+
+void DLRModel::GetOutputTyped(int index, void* out, const char* dtype) {
+  const DLDataType src_dtype = GetDLDataTypeFromString(GetOutputType(index));
+  const DLDataType dst_dtype = GetDLDataTypeFromString(dtype);
+  if (IsSameDLDataType(src_dtype, dst_dtype)) {
+    GetOutput(index, out);
+    return;
+  }
+  int64_t count;
+  int dim;
+  GetOutputSizeDim(index, &count, &dim);
+  std::vector<char> buffer(count * ((src_dtype.bits + 7) / 8));
+  GetOutput(index, buffer.data());
+  ConvertOutputData(index, buffer.data(), src_dtype, out, dst_dtype, count);
+}
+
+void DLRModel::SetNumOutputBuffers(int num_sets) {
+  CHECK(backend_ == DLRBackend::kTVM || backend_ == DLRBackend::kRELAYVM)
+      << "Output buffering is only supported for TVM and Relay VM models.";
+  CHECK_GE(num_sets, 0) << "Invalid number of output buffer sets.";
+  output_buffers_ = num_sets > 0 ? std::make_shared<OutputBuffers>(num_sets) : nullptr;
+}
+
+int64_t DLRModel::GetOutputTicket() const {
+  CHECK(output_buffers_) << "Outputs are not buffered, call SetNumOutputBuffers() first.";
+  const int64_t ticket = output_buffers_->GetLastTicket();
+  CHECK_GE(ticket, 0) << "The model has not run since its outputs are buffered.";
+  return ticket;
+}
+
+const void* DLRModel::GetTicketOutputPtr(int64_t ticket, int index) const {
+  CHECK(output_buffers_) << "Outputs are not buffered, call SetNumOutputBuffers() first.";
+  return output_buffers_->GetOutputPtr(ticket, index);
+}
+
+void DLRModel::GetTicketOutputShape(int64_t ticket, int index, int64_t* shape) const {
+  CHECK(output_buffers_) << "Outputs are not buffered, call SetNumOutputBuffers() first.";
+  const std::vector<int64_t>& output_shape = output_buffers_->GetOutputShape(ticket, index);
+  std::copy(output_shape.begin(), output_shape.end(), shape);
+}
+
+void DLRModel::ReleaseOutputs(int64_t ticket) {
+  CHECK(output_buffers_) << "Outputs are not buffered, call SetNumOutputBuffers() first.";
+  output_buffers_->Release(ticket);
+}
+
+void DLRModel::RunBuffered(const std::function<void()>& run) {
+  const std::shared_ptr<OutputBuffers> buffers = output_buffers_;
+  if (!buffers) {
+    run();
+    return;
+  }
+  const int set = buffers->Reserve();
+  try {
+    run();
+    for (int i = 0; i < GetNumOutputs(); i++) {
+      int64_t size;
+      int dim;
+      GetOutputSizeDim(i, &size, &dim);
+      std::vector<int64_t>& shape = buffers->GetShape(set, i);
+      shape.resize(dim);
+      GetOutputShape(i, shape.data());
+      const DLDataType dtype = GetDLDataTypeFromString(GetOutputType(i));
+      GetOutput(i, buffers->GetBuffer(set, i, size * ((dtype.bits * dtype.lanes + 7) / 8)));
+    }
+  } catch (...) {
+    buffers->Cancel(set);
+    throw;
+  }
+  buffers->Publish(set);
+}
+
 bool DLRModel::HasMetadata() const { return !this->metadata_.is_null(); }
 
 void DLRModel::ValidateDeviceTypeIfExists() {
@@ -327,3 +501,28 @@ std::vector<std::string> dlr::MakePathVec(std::string model_path) {
 
   return path_vec;
 }
+
+void DLRModel::EnablePerfCounters(bool enable) {
+  perf_counters_ = enable ? std::make_shared<PerfCounters>() : nullptr;
+}
+
+void DLRModel::RunCounted() {
+  const std::shared_ptr<PerfCounters> counters = perf_counters_;
+  if (!counters) {
+    Run();
+    return;
+  }
+  const PerfCounters::Counts start = counters->Start();
+  Run();
+  counters->Stop(start);
+}
+
+void DLRModel::EnableFlightRecorder(int capacity, double slow_threshold_ms) {
+  CHECK_GE(capacity, 0) << "Invalid capacity of the flight recorder";
+  flight_recorder_ =
+      capacity > 0 ? std::make_shared<FlightRecorder>(this, capacity, slow_threshold_ms) : nullptr;
+}
+
+void DLRModel::EnableMetrics(bool enable, const std::string& name) {
+  metrics_ = enable ? std::make_shared<ModelMetrics>(this, name) : nullptr;
+}
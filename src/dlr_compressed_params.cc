@@ -0,0 +1,380 @@
+#include "dlr_compressed_params.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#ifdef DLR_ZSTD
+#include <zstd.h>
+#endif  // DLR_ZSTD
+#ifdef DLR_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif  // DLR_LZ4
+
+#include "dlr_binary_io.h"
+
+using namespace dlr;
+
+namespace {
+
+// Magic numbers of the TVM params format, see NDArray::Save() and GraphRuntime::LoadParams().
+constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
+constexpr uint64_t kTVMNDArrayMagic = 0xDD5E40F096B4A13F;
+
+struct Chunk {
+  const char* src;
+  size_t compressed_bytes;
+  char* dst;
+  size_t raw_bytes;
+};
+
+void DecompressChunk(ParamsCodec codec, const Chunk& chunk) {
+  switch (codec) {
+    case ParamsCodec::kNone:
+      CHECK_EQ(chunk.compressed_bytes, chunk.raw_bytes) << "Invalid params file chunk.";
+      std::memcpy(chunk.dst, chunk.src, chunk.raw_bytes);
+      return;
+#ifdef DLR_ZSTD
+    case ParamsCodec::kZSTD: {
+      const size_t ret =
+          ZSTD_decompress(chunk.dst, chunk.raw_bytes, chunk.src, chunk.compressed_bytes);
+      CHECK(!ZSTD_isError(ret)) << "zstd decompression failed: " << ZSTD_getErrorName(ret);
+      CHECK_EQ(ret, chunk.raw_bytes) << "Invalid params file chunk.";
+      return;
+    }
+#endif  // DLR_ZSTD
+#ifdef DLR_LZ4
+    case ParamsCodec::kLZ4: {
+      const int ret = LZ4_decompress_safe(chunk.src, chunk.dst, chunk.compressed_bytes,
+                                          chunk.raw_bytes);
+      CHECK_EQ(ret, static_cast<int>(chunk.raw_bytes)) << "lz4 decompression failed.";
+      return;
+    }
+#endif  // DLR_LZ4
+    default:
+      throw dmlc::Error("Unsupported params codec.");
+  }
+}
+
+std::string CompressChunk(ParamsCodec codec, const char* src, size_t nbytes, int level) {
+  std::string out;
+  switch (codec) {
+    case ParamsCodec::kNone:
+      out.assign(src, nbytes);
+      return out;
+#ifdef DLR_ZSTD
+    case ParamsCodec::kZSTD: {
+      out.resize(ZSTD_compressBound(nbytes));
+      const size_t ret = ZSTD_compress(&out[0], out.size(), src, nbytes, level);
+      CHECK(!ZSTD_isError(ret)) << "zstd compression failed: " << ZSTD_getErrorName(ret);
+      out.resize(ret);
+      return out;
+    }
+#endif  // DLR_ZSTD
+#ifdef DLR_LZ4
+    case ParamsCodec::kLZ4: {
+      out.resize(LZ4_compressBound(nbytes));
+      const int ret = level > 0 ? LZ4_compress_HC(src, &out[0], nbytes, out.size(), level)
+                                : LZ4_compress_default(src, &out[0], nbytes, out.size());
+      CHECK_GT(ret, 0) << "lz4 compression failed.";
+      out.resize(ret);
+      return out;
+    }
+#endif  // DLR_LZ4
+    default:
+      throw dmlc::Error("Unsupported params codec.");
+  }
+}
+
+void RunParallel(size_t num_tasks, int num_threads, const std::function<void(size_t)>& task) {
+  if (num_threads <= 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t num_workers = std::min<size_t>(num_threads, num_tasks);
+  std::atomic<size_t> next{0};
+  std::mutex error_mutex;
+  std::string error;
+  auto worker = [&]() {
+    for (size_t i = next++; i < num_tasks; i = next++) {
+      try {
+        task(i);
+      } catch (std::exception& e) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (error.empty()) error = e.what();
+        next = num_tasks;
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_workers; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  if (!error.empty()) throw dmlc::Error(error);
+}
+
+/*! \brief Reader of the headers of a params file, skipping over the tensor data. */
+class HeaderReader {
+ public:
+  explicit HeaderReader(const std::string& filename)
+      : filename_(filename), in_(filename, std::ios::binary) {
+    CHECK(in_.good()) << "Could not open " << filename;
+  }
+  template <typename T>
+  T Read() {
+    T value;
+    Read(&value, sizeof(T));
+    return value;
+  }
+  std::string ReadString() {
+    std::string str(Read<uint64_t>(), '\0');
+    if (!str.empty()) Read(&str[0], str.size());
+    return str;
+  }
+  void Skip(uint64_t nbytes) {
+    in_.seekg(nbytes, std::ios::cur);
+    CHECK(in_.good()) << "Invalid params file " << filename_ << ": unexpected end of data.";
+  }
+
+ private:
+  std::string filename_;
+  std::ifstream in_;
+  void Read(void* data, size_t nbytes) {
+    in_.read(static_cast<char*>(data), nbytes);
+    CHECK(in_.good()) << "Invalid params file " << filename_ << ": unexpected end of data.";
+  }
+};
+
+/*! \brief Read the type and shape of a tensor, in the same layout in both params formats. */
+void ReadTensorHeader(HeaderReader* reader, ParamsTensor* tensor) {
+  const int32_t ndim = reader->Read<int32_t>();
+  tensor->dtype = reader->Read<DLDataType>();
+  tensor->shape.resize(ndim);
+  for (int64_t& dim : tensor->shape) {
+    dim = reader->Read<int64_t>();
+  }
+}
+
+}  // namespace
+
+bool dlr::IsParamsFile(const std::string& filename) {
+  return EndsWith(filename, ".params") || EndsWith(filename, ".params.zst") ||
+         EndsWith(filename, ".params.lz4");
+}
+
+bool dlr::IsCompressedParams(const void* data, size_t size) {
+  uint64_t magic;
+  if (size < sizeof(magic)) return false;
+  std::memcpy(&magic, data, sizeof(magic));
+  return magic == kCompressedParamsMagic;
+}
+
+bool dlr::IsParamsCodecSupported(ParamsCodec codec) {
+  switch (codec) {
+    case ParamsCodec::kNone:
+      return true;
+#ifdef DLR_ZSTD
+    case ParamsCodec::kZSTD:
+      return true;
+#endif  // DLR_ZSTD
+#ifdef DLR_LZ4
+    case ParamsCodec::kLZ4:
+      return true;
+#endif  // DLR_LZ4
+    default:
+      return false;
+  }
+}
+
+ParamsCodec dlr::GetParamsCodecFromFilename(const std::string& filename) {
+  if (EndsWith(filename, ".zst")) return ParamsCodec::kZSTD;
+  if (EndsWith(filename, ".lz4")) return ParamsCodec::kLZ4;
+  return ParamsCodec::kNone;
+}
+
+std::vector<ParamsTensor> dlr::ParseParams(const void* data, size_t size) {
+  BinaryReader reader(data, size);
+  CHECK_EQ(reader.Read<uint64_t>(), kTVMNDArrayListMagic) << "Invalid params file.";
+  reader.Read<uint64_t>();  // reserved
+  const uint64_t num_names = reader.Read<uint64_t>();
+  std::vector<ParamsTensor> tensors(num_names);
+  for (ParamsTensor& tensor : tensors) {
+    tensor.name = reader.ReadString();
+  }
+  CHECK_EQ(reader.Read<uint64_t>(), num_names) << "Invalid params file.";
+  for (ParamsTensor& tensor : tensors) {
+    CHECK_EQ(reader.Read<uint64_t>(), kTVMNDArrayMagic) << "Invalid params file.";
+    reader.Read<uint64_t>();  // reserved
+    reader.Read<DLContext>();
+    const int32_t ndim = reader.Read<int32_t>();
+    tensor.dtype = reader.Read<DLDataType>();
+    for (int32_t i = 0; i < ndim; ++i) {
+      tensor.shape.push_back(reader.Read<int64_t>());
+    }
+    tensor.nbytes = static_cast<size_t>(reader.Read<int64_t>());
+    tensor.data = reader.ReadBytes(tensor.nbytes);
+  }
+  return tensors;
+}
+
+std::vector<ParamsTensor> dlr::ReadParamsHeaders(const std::string& filename) {
+  HeaderReader reader(filename);
+  std::vector<ParamsTensor> tensors;
+  const uint64_t magic = reader.Read<uint64_t>();
+  if (magic == kCompressedParamsMagic) {
+    reader.Read<uint32_t>();  // codec
+    reader.Read<uint32_t>();  // reserved
+    tensors.resize(reader.Read<uint64_t>());
+    for (ParamsTensor& tensor : tensors) {
+      tensor.name = reader.ReadString();
+      ReadTensorHeader(&reader, &tensor);
+      tensor.nbytes = static_cast<size_t>(reader.Read<uint64_t>());
+      tensor.data = nullptr;
+      reader.Skip(reader.Read<uint64_t>() * 2 * sizeof(uint64_t));  // chunk table
+    }
+    return tensors;
+  }
+  CHECK_EQ(magic, kTVMNDArrayListMagic) << "Invalid params file " << filename;
+  reader.Read<uint64_t>();  // reserved
+  tensors.resize(reader.Read<uint64_t>());
+  for (ParamsTensor& tensor : tensors) {
+    tensor.name = reader.ReadString();
+  }
+  CHECK_EQ(reader.Read<uint64_t>(), tensors.size()) << "Invalid params file " << filename;
+  for (ParamsTensor& tensor : tensors) {
+    CHECK_EQ(reader.Read<uint64_t>(), kTVMNDArrayMagic) << "Invalid params file " << filename;
+    reader.Read<uint64_t>();  // reserved
+    reader.Read<DLContext>();
+    ReadTensorHeader(&reader, &tensor);
+    tensor.nbytes = static_cast<size_t>(reader.Read<int64_t>());
+    tensor.data = nullptr;
+    reader.Skip(tensor.nbytes);
+  }
+  return tensors;
+}
+
+std::string dlr::CompressParams(const std::vector<ParamsTensor>& tensors, ParamsCodec codec,
+                                size_t chunk_bytes, int level) {
+  CHECK(IsParamsCodecSupported(codec)) << "libdlr was built without support for this codec.";
+  CHECK_GT(chunk_bytes, 0) << "Chunk size must be positive.";
+  std::vector<std::vector<std::string>> chunks(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const ParamsTensor& tensor = tensors[i];
+    for (size_t offset = 0; offset < tensor.nbytes; offset += chunk_bytes) {
+      const size_t nbytes = std::min(chunk_bytes, tensor.nbytes - offset);
+      chunks[i].push_back(CompressChunk(codec, tensor.data + offset, nbytes, level));
+    }
+  }
+  BinaryWriter writer;
+  writer.Write<uint64_t>(kCompressedParamsMagic);
+  writer.Write<uint32_t>(static_cast<uint32_t>(codec));
+  writer.Write<uint32_t>(0);  // reserved
+  writer.Write<uint64_t>(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const ParamsTensor& tensor = tensors[i];
+    writer.WriteString(tensor.name);
+    writer.Write<int32_t>(tensor.shape.size());
+    writer.Write<DLDataType>(tensor.dtype);
+    for (int64_t dim : tensor.shape) {
+      writer.Write<int64_t>(dim);
+    }
+    writer.Write<uint64_t>(tensor.nbytes);
+    writer.Write<uint64_t>(chunks[i].size());
+    for (size_t c = 0; c < chunks[i].size(); ++c) {
+      writer.Write<uint64_t>(std::min(chunk_bytes, tensor.nbytes - c * chunk_bytes));
+      writer.Write<uint64_t>(chunks[i][c].size());
+    }
+  }
+  for (const std::vector<std::string>& tensor_chunks : chunks) {
+    for (const std::string& chunk : tensor_chunks) {
+      writer.Write(chunk.data(), chunk.size());
+    }
+  }
+  return std::move(writer.buffer());
+}
+
+std::vector<std::string> dlr::LoadCompressedParams(tvm::runtime::GraphRuntime* runtime,
+                                                   const void* data, size_t size, int num_threads) {
+  BinaryReader reader(data, size);
+  CHECK_EQ(reader.Read<uint64_t>(), kCompressedParamsMagic) << "Invalid compressed params file.";
+  const ParamsCodec codec = static_cast<ParamsCodec>(reader.Read<uint32_t>());
+  if (!IsParamsCodecSupported(codec)) {
+    throw dmlc::Error(
+        "libdlr was built without support for the codec of this params file. Rebuild with "
+        "USE_ZSTD=ON or USE_LZ4=ON.");
+  }
+  reader.Read<uint32_t>();  // reserved
+  const uint64_t num_tensors = reader.Read<uint64_t>();
+
+  // Parameters on other devices are staged on the host and copied once decompressed.
+  std::vector<std::pair<tvm::runtime::NDArray, std::vector<char>>> staged;
+  staged.reserve(num_tensors);
+  std::vector<Chunk> chunks;
+  std::vector<std::string> names;
+  for (uint64_t t = 0; t < num_tensors; ++t) {
+    const std::string name = reader.ReadString();
+    const int32_t ndim = reader.Read<int32_t>();
+    const DLDataType dtype = reader.Read<DLDataType>();
+    std::vector<int64_t> shape(ndim);
+    for (int64_t& dim : shape) {
+      dim = reader.Read<int64_t>();
+    }
+    const uint64_t nbytes = reader.Read<uint64_t>();
+    const uint64_t num_chunks = reader.Read<uint64_t>();
+
+    char* dst = nullptr;
+    const int index = runtime->GetInputIndex(name);
+    if (index >= 0) {
+      names.push_back(name);
+      tvm::runtime::NDArray arr = runtime->GetInput(index);
+      CHECK_EQ(arr->ndim, ndim) << "Dimension mismatch for parameter " << name;
+      CHECK(std::equal(shape.begin(), shape.end(), arr->shape))
+          << "Shape mismatch for parameter " << name;
+      CHECK(arr->dtype.code == dtype.code && arr->dtype.bits == dtype.bits &&
+            arr->dtype.lanes == dtype.lanes)
+          << "Type mismatch for parameter " << name;
+      CHECK_EQ(tvm::runtime::GetDataSize(*arr.operator->()), nbytes)
+          << "Size mismatch for parameter " << name;
+      if (arr->ctx.device_type == kDLCPU) {
+        dst = static_cast<char*>(arr->data) + arr->byte_offset;
+      } else {
+        staged.emplace_back(arr, std::vector<char>(nbytes));
+        dst = staged.back().second.data();
+      }
+    }
+    uint64_t offset = 0;
+    for (uint64_t c = 0; c < num_chunks; ++c) {
+      const uint64_t raw_bytes = reader.Read<uint64_t>();
+      const uint64_t compressed_bytes = reader.Read<uint64_t>();
+      CHECK_LE(offset + raw_bytes, nbytes) << "Invalid chunk table for parameter " << name;
+      chunks.push_back({nullptr, compressed_bytes, dst ? dst + offset : nullptr, raw_bytes});
+      offset += raw_bytes;
+    }
+    CHECK_EQ(offset, nbytes) << "Invalid chunk table for parameter " << name;
+  }
+  // Compressed data follows the tables in the same order.
+  for (Chunk& chunk : chunks) {
+    chunk.src = reader.ReadBytes(chunk.compressed_bytes);
+  }
+
+  RunParallel(chunks.size(), num_threads, [codec, &chunks](size_t i) {
+    if (chunks[i].dst != nullptr) DecompressChunk(codec, chunks[i]);
+  });
+
+  for (auto& entry : staged) {
+    tvm::runtime::NDArray& arr = entry.first;
+    DLTensor host = *arr.operator->();
+    host.ctx = DLContext{kDLCPU, 0};
+    host.data = entry.second.data();
+    host.strides = nullptr;
+    host.byte_offset = 0;
+    arr.CopyFrom(&host);
+  }
+  return names;
+}
@@ -0,0 +1,173 @@
+#include "dlr_cost.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <unordered_set>
+
+#include "dlr_data_convert.h"
+
+using namespace dlr;
+
+namespace {
+
+/*! \brief Values of a graph attribute, e.g. "shape": ["list_shape", [[1, 3], ...]]. */
+const nlohmann::json& GetGraphAttr(const nlohmann::json& graph, const char* name) {
+  return graph.at("attrs").at(name).at(1);
+}
+
+int64_t GetNumElements(const std::vector<int64_t>& shape) {
+  // Dynamic dimensions of metadata shapes count as 1.
+  return std::accumulate(shape.begin(), shape.end(), int64_t{1},
+                         [](int64_t a, int64_t d) { return d > 0 ? a * d : a; });
+}
+
+int64_t GetBytes(const std::vector<int64_t>& shape, const std::string& dtype) {
+  const DLDataType type = GetDLDataTypeFromString(dtype);
+  return GetNumElements(shape) * ((type.bits * type.lanes + 7) / 8);
+}
+
+/*! \brief Number of output channels of a convolution, for the layouts TVM produces: NCHW, NHWC
+ *  and NCHW[x]c.
+ */
+int64_t GetOutputChannels(const std::vector<int64_t>& output, const std::vector<int64_t>& weight) {
+  if (output.size() == 5) return output[1] * output[4];
+  if (output.size() == 4) return !weight.empty() && weight[0] == output[1] ? output[1] : output[3];
+  return output.empty() ? 1 : output.back();
+}
+
+/*! \brief Multiply-adds of a kernel, or 0 if it is none of the kernels dominated by them. */
+int64_t GetMultiplyAdds(const std::string& func_name, const std::vector<int64_t>& output,
+                        const std::vector<int64_t>& data, const std::vector<int64_t>& weight) {
+  const int64_t output_size = GetNumElements(output);
+  if (func_name.find("conv2d") != std::string::npos ||
+      func_name.find("conv3d") != std::string::npos ||
+      func_name.find("conv1d") != std::string::npos) {
+    // Each output element reduces over the weights of its channel.
+    const int64_t channels = std::max<int64_t>(1, GetOutputChannels(output, weight));
+    return output_size * (GetNumElements(weight) / channels);
+  }
+  if (func_name.find("dense") != std::string::npos) {
+    const int64_t units = output.empty() ? 1 : output.back();
+    return output_size * (GetNumElements(weight) / std::max<int64_t>(1, units));
+  }
+  if (func_name.find("batch_matmul") != std::string::npos) {
+    return output_size * (data.empty() ? 1 : data.back());
+  }
+  return 0;
+}
+
+std::vector<int64_t> GetMetadataShape(const nlohmann::json& tensor) {
+  std::vector<int64_t> shape;
+  for (const nlohmann::json& dim : tensor.at("shape")) {
+    shape.push_back(dim.is_number() ? dim.get<int64_t>() : -1);
+  }
+  return shape;
+}
+
+int64_t GetFileSize(const std::string& path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  CHECK(in.good()) << "Could not open " << path;
+  return static_cast<int64_t>(in.tellg());
+}
+
+}  // namespace
+
+ModelCost dlr::EstimateGraphCost(const nlohmann::json& graph,
+                                 const std::vector<ParamsTensor>& params) {
+  ModelCost cost;
+  cost.backend = DLRBackend::kTVM;
+  cost.flops = 0;
+  try {
+    const nlohmann::json& nodes = graph.at("nodes");
+    const std::vector<int64_t> row_ptr = graph.at("node_row_ptr").get<std::vector<int64_t>>();
+    const std::vector<std::vector<int64_t>> shapes =
+        GetGraphAttr(graph, "shape").get<std::vector<std::vector<int64_t>>>();
+    const std::vector<std::string> dtypes =
+        GetGraphAttr(graph, "dltype").get<std::vector<std::string>>();
+    const std::vector<int64_t> storage_ids =
+        GetGraphAttr(graph, "storage_id").get<std::vector<int64_t>>();
+    CHECK(row_ptr.size() == nodes.size() + 1 && shapes.size() == dtypes.size() &&
+          shapes.size() == storage_ids.size() &&
+          static_cast<size_t>(row_ptr.back()) == shapes.size())
+        << "Invalid graph: sizes of the node entries do not match";
+
+    std::map<std::string, const ParamsTensor*> params_by_name;
+    for (const ParamsTensor& tensor : params) params_by_name[tensor.name] = &tensor;
+    std::map<int64_t, int64_t> storage_bytes;
+    std::unordered_set<int64_t> weight_storage;
+    for (size_t nid = 0; nid < nodes.size(); nid++) {
+      const nlohmann::json& node = nodes[nid];
+      const std::string op = node.at("op").get<std::string>();
+      for (int64_t eid = row_ptr[nid]; eid < row_ptr[nid + 1]; eid++) {
+        int64_t& bytes = storage_bytes[storage_ids[eid]];
+        bytes = std::max(bytes, GetBytes(shapes[eid], dtypes[eid]));
+      }
+      if (op == "null") {
+        auto it = params_by_name.find(node.at("name").get<std::string>());
+        if (it != params_by_name.end()) {
+          weight_storage.insert(storage_ids[row_ptr[nid]]);
+          cost.weight_bytes += it->second->nbytes;
+        }
+        continue;
+      }
+      if (op != "tvm_op") continue;
+      const std::string func_name = node.at("attrs").at("func_name").get<std::string>();
+      auto input_shape = [&](size_t i) {
+        if (i >= node.at("inputs").size()) return std::vector<int64_t>();
+        const nlohmann::json& entry = node.at("inputs")[i];
+        return shapes.at(row_ptr.at(entry.at(0).get<size_t>()) + entry.at(1).get<int64_t>());
+      };
+      const std::vector<int64_t>& output = shapes[row_ptr[nid]];
+      const int64_t multiply_adds =
+          GetMultiplyAdds(func_name, output, input_shape(0), input_shape(1));
+      cost.flops += multiply_adds > 0 ? 2 * multiply_adds : GetNumElements(output);
+    }
+    for (const auto& entry : storage_bytes) {
+      if (weight_storage.count(entry.first) == 0) cost.activation_bytes += entry.second;
+    }
+  } catch (nlohmann::json::exception& e) {
+    throw dmlc::Error(std::string("Invalid graph: ") + e.what());
+  }
+  cost.peak_memory_bytes = cost.weight_bytes + cost.activation_bytes;
+  return cost;
+}
+
+ModelCost dlr::EstimateModelCost(const std::vector<std::string>& files) {
+  const DLRBackend backend = GetBackend(files);
+  ModelPath paths;
+  InitModelPath(files, &paths);
+  if (backend == DLRBackend::kTVM) {
+    CHECK(!paths.model_json.empty())
+        << "Cost estimation needs the graph JSON of the model, found none";
+    nlohmann::json graph;
+    LoadJsonFromFile(paths.model_json, graph);
+    std::vector<ParamsTensor> params;
+    if (!paths.params.empty()) params = ReadParamsHeaders(paths.params);
+    return EstimateGraphCost(graph, params);
+  }
+  if (backend == DLRBackend::kRELAYVM) {
+    CHECK(!paths.metadata.empty()) << "Cost estimation needs the metadata of the model, found none";
+    nlohmann::json metadata;
+    LoadJsonFromFile(paths.metadata, metadata);
+    ModelCost cost;
+    cost.backend = backend;
+    cost.weight_bytes = GetFileSize(paths.relay_executable);
+    try {
+      for (const char* key : {"Inputs", "Outputs"}) {
+        for (const nlohmann::json& tensor : metadata.at("Model").at(key)) {
+          cost.activation_bytes +=
+              GetBytes(GetMetadataShape(tensor), tensor.at("dtype").get<std::string>());
+        }
+      }
+    } catch (nlohmann::json::exception& e) {
+      throw dmlc::Error(std::string("Invalid metadata: ") + e.what());
+    }
+    cost.peak_memory_bytes = cost.weight_bytes + cost.activation_bytes;
+    return cost;
+  }
+  throw dmlc::Error(std::string("Cost estimation is not supported for backend '") +
+                    kBackendToStr[static_cast<int>(backend)] + "'");
+}
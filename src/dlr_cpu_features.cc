@@ -0,0 +1,206 @@
+#include "dlr_cpu_features.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <sstream>
+
+#include "dlr_binary_graph.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DLR_CPU_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // _MSC_VER
+#elif (defined(__aarch64__) || defined(__arm__)) && defined(__linux__)
+#define DLR_CPU_ARM_LINUX
+#include <sys/auxv.h>
+#endif
+
+using namespace dlr;
+
+namespace {
+
+#ifdef DLR_CPU_X86
+void CPUID(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#ifdef _MSC_VER
+  int r[4];
+  __cpuidex(r, leaf, subleaf);
+  for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(r[i]);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif  // _MSC_VER
+}
+
+/*! \brief Register state enabled by the OS (XCR0). */
+uint64_t XGetBV() {
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif  // _MSC_VER
+}
+
+std::vector<std::string> DetectCPUFeatures() {
+  std::vector<std::string> features;
+  unsigned regs[4];
+  CPUID(0, 0, regs);
+  const unsigned max_leaf = regs[0];
+  if (max_leaf < 1) return features;
+  CPUID(1, 0, regs);
+  const bool sse42 = regs[2] & (1u << 20);
+  const bool osxsave = regs[2] & (1u << 27);
+  const bool avx_cpu = regs[2] & (1u << 28);
+  const bool fma = regs[2] & (1u << 12);
+  const uint64_t xcr0 = osxsave ? XGetBV() : 0;
+  // XMM and YMM state for AVX, plus opmask and ZMM state for AVX-512.
+  const bool avx_os = (xcr0 & 0x6) == 0x6;
+  const bool avx512_os = avx_os && (xcr0 & 0xE0) == 0xE0;
+  unsigned ebx7 = 0, ecx7 = 0;
+  if (max_leaf >= 7) {
+    CPUID(7, 0, regs);
+    ebx7 = regs[1];
+    ecx7 = regs[2];
+  }
+  const bool avx = avx_cpu && avx_os;
+  const bool avx2 = avx && fma && (ebx7 & (1u << 5));
+  // AVX-512 F, DQ, BW and VL, as required by skylake-avx512 targets.
+  const unsigned avx512_bits = (1u << 16) | (1u << 17) | (1u << 30) | (1u << 31);
+  const bool avx512 = avx2 && avx512_os && (ebx7 & avx512_bits) == avx512_bits;
+  const bool avx512vnni = avx512 && (ecx7 & (1u << 11));
+  if (avx512vnni) features.push_back("avx512vnni");
+  if (avx512) features.push_back("avx512");
+  if (avx2) features.push_back("avx2");
+  if (avx) features.push_back("avx");
+  if (sse42) features.push_back("sse42");
+  return features;
+}
+#elif defined(DLR_CPU_ARM_LINUX)
+std::vector<std::string> DetectCPUFeatures() {
+  std::vector<std::string> features;
+  const unsigned long hwcap = getauxval(AT_HWCAP);
+#ifdef __aarch64__
+#ifdef HWCAP_SVE
+  if (hwcap & HWCAP_SVE) features.push_back("sve");
+#endif  // HWCAP_SVE
+#ifdef HWCAP_ASIMDDP
+  if (hwcap & HWCAP_ASIMDDP) features.push_back("dotprod");
+#endif  // HWCAP_ASIMDDP
+  // Advanced SIMD is mandatory on AArch64.
+  features.push_back("neon");
+#else
+#ifdef HWCAP_NEON
+  if (hwcap & HWCAP_NEON) features.push_back("neon");
+#endif  // HWCAP_NEON
+#endif  // __aarch64__
+  return features;
+}
+#else
+std::vector<std::string> DetectCPUFeatures() { return {}; }
+#endif  // DLR_CPU_X86
+
+bool IsVariantTag(const std::string& tag) {
+  return std::any_of(std::begin(CPU_VARIANT_TAGS), std::end(CPU_VARIANT_TAGS),
+                     [&tag](const char* t) { return tag == t; });
+}
+
+/*! \brief Get the extension of a model file which can have variants, or an empty string. */
+std::string GetVariantExtension(const std::string& basename) {
+  if (basename == LIBDLR || basename == "version.json" || basename == BATCH_VARIANTS_MANIFEST ||
+      basename == TUNED_CONFIG_FILE ||
+      std::any_of(std::begin(SAGEMAKER_AUXILIARY_JSON_FILES),
+                  std::end(SAGEMAKER_AUXILIARY_JSON_FILES),
+                  [&basename](const char* s) { return basename == s; })) {
+    return "";
+  }
+  for (const char* ext :
+       {LIBEXT, ".json", BINARY_GRAPH_EXT, ".params", ".params.zst", ".params.lz4"}) {
+    if (EndsWith(basename, ext)) return ext;
+  }
+  return "";
+}
+
+/*! \brief Get the variant tag of a model file, or an empty string if it is untagged. */
+std::string GetVariantTag(const std::string& basename, const std::string& ext) {
+  const std::string stem = basename.substr(0, basename.size() - ext.size());
+  const size_t dot = stem.find_last_of('.');
+  if (dot == std::string::npos) return "";
+  const std::string tag = stem.substr(dot + 1);
+  return IsVariantTag(tag) ? tag : "";
+}
+
+std::string JoinTags(const std::vector<std::string>& tags) {
+  std::ostringstream ss;
+  for (size_t i = 0; i < tags.size(); ++i) {
+    ss << (i > 0 ? " " : "") << tags[i];
+  }
+  return ss.str();
+}
+
+}  // namespace
+
+const std::vector<std::string>& dlr::GetCPUFeatures() {
+  static const std::vector<std::string> features = DetectCPUFeatures();
+  return features;
+}
+
+std::vector<std::string> dlr::SelectCPUVariant(const std::vector<std::string>& files,
+                                               const std::vector<std::string>& features,
+                                               std::string* tag) {
+  std::vector<std::string> exts(files.size());
+  std::vector<std::string> tags(files.size());
+  std::set<std::string> available;
+  for (size_t i = 0; i < files.size(); ++i) {
+    const std::string basename = GetBasename(files[i]);
+    exts[i] = GetVariantExtension(basename);
+    if (!exts[i].empty()) tags[i] = GetVariantTag(basename, exts[i]);
+    if (!tags[i].empty()) available.insert(tags[i]);
+  }
+  if (tag != nullptr) tag->clear();
+  if (available.empty()) return files;
+
+  std::string selected;
+  for (const char* t : CPU_VARIANT_TAGS) {
+    if (available.count(t) && std::find(features.begin(), features.end(), t) != features.end()) {
+      selected = t;
+      break;
+    }
+  }
+  // Files of the selected variant replace the untagged files of the same type.
+  std::set<std::string> replaced;
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (!selected.empty() && tags[i] == selected) replaced.insert(exts[i]);
+  }
+  std::vector<std::string> selected_files;
+  bool has_lib = false;
+  for (size_t i = 0; i < files.size(); ++i) {
+    const bool keep = tags[i].empty() ? replaced.count(exts[i]) == 0 : tags[i] == selected;
+    if (!keep) continue;
+    selected_files.push_back(files[i]);
+    has_lib |= exts[i] == LIBEXT;
+  }
+  if (!has_lib) {
+    throw dmlc::Error("None of the model variants (" +
+                      JoinTags(std::vector<std::string>(available.begin(), available.end())) +
+                      ") is supported by this CPU (" + JoinTags(features) +
+                      ") and no untagged model library was found.");
+  }
+  if (tag != nullptr) *tag = selected;
+  return selected_files;
+}
+
+std::vector<std::string> dlr::SelectCPUVariant(const std::vector<std::string>& files,
+                                               std::string* tag) {
+  std::string selected;
+  std::vector<std::string> selected_files = SelectCPUVariant(files, GetCPUFeatures(), &selected);
+  if (selected_files.size() != files.size() || !selected.empty()) {
+    LOG(INFO) << "Selected model variant '" << (selected.empty() ? "default" : selected)
+              << "' for CPU features: " << JoinTags(GetCPUFeatures());
+  }
+  if (tag != nullptr) *tag = selected;
+  return selected_files;
+}
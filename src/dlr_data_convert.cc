@@ -0,0 +1,524 @@
+#include "dlr_data_convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+
+#include "dlr_cpu_features.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define DLR_CONVERT_AVX2
+#include <immintrin.h>
+#endif
+
+using namespace dlr;
+
+namespace {
+
+struct Half {
+  uint16_t bits;
+};
+
+struct BFloat16 {
+  uint16_t bits;
+};
+
+inline uint32_t FloatBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float BitsFloat(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/*! \brief Round to the nearest float16, ties to even. */
+inline uint16_t FloatToHalf(float value) {
+  uint32_t f = FloatBits(value);
+  const uint16_t sign = (f >> 16) & 0x8000;
+  f &= 0x7FFFFFFF;
+  if (f >= 0x47800000) {
+    // Infinity, NaN or too large for float16.
+    return sign | (f > 0x7F800000 ? 0x7E00 : 0x7C00);
+  }
+  if (f < 0x38800000) {
+    // Subnormal float16: adding 0.5 aligns the float16 mantissa at the bottom of the float one.
+    return sign | static_cast<uint16_t>(FloatBits(BitsFloat(f) + 0.5f) - 0x3F000000);
+  }
+  const uint32_t odd = (f >> 13) & 1;
+  f += 0xC8000FFF + odd;  // Rebias the exponent from 127 to 15 and round.
+  return sign | static_cast<uint16_t>(f >> 13);
+}
+
+inline float HalfToFloat(uint16_t half) {
+  constexpr uint32_t kExponent = 0x7C00 << 13;
+  uint32_t f = (half & 0x7FFF) << 13;
+  const uint32_t exponent = f & kExponent;
+  f += (127 - 15) << 23;
+  if (exponent == kExponent) {
+    f += (128 - 16) << 23;  // Infinity or NaN.
+  } else if (exponent == 0) {
+    f = FloatBits(BitsFloat(f + (1 << 23)) - BitsFloat(113 << 23));  // Subnormal.
+  }
+  return BitsFloat(f | static_cast<uint32_t>(half & 0x8000) << 16);
+}
+
+/*! \brief Round to the nearest bfloat16, ties to even. */
+inline uint16_t FloatToBFloat16(float value) {
+  uint32_t f = FloatBits(value);
+  if ((f & 0x7FFFFFFF) > 0x7F800000) return static_cast<uint16_t>((f >> 16) | 0x40);
+  f += 0x7FFF + ((f >> 16) & 1);
+  return static_cast<uint16_t>(f >> 16);
+}
+
+inline float BFloat16ToFloat(uint16_t bfloat) {
+  return BitsFloat(static_cast<uint32_t>(bfloat) << 16);
+}
+
+// Elements are widened to their arithmetic type, then narrowed to the destination type.
+template <typename T>
+inline T Widen(T value) {
+  return value;
+}
+inline float Widen(Half value) { return HalfToFloat(value.bits); }
+inline float Widen(BFloat16 value) { return BFloat16ToFloat(value.bits); }
+
+template <typename T>
+struct Narrow {
+  template <typename W>
+  static T From(W value) {
+    return static_cast<T>(value);
+  }
+};
+
+template <>
+struct Narrow<Half> {
+  template <typename W>
+  static Half From(W value) {
+    return Half{FloatToHalf(static_cast<float>(value))};
+  }
+};
+
+template <>
+struct Narrow<BFloat16> {
+  template <typename W>
+  static BFloat16 From(W value) {
+    return BFloat16{FloatToBFloat16(static_cast<float>(value))};
+  }
+};
+
+typedef void (*ConvertFn)(const void* src, void* dst, int64_t count);
+
+template <typename Dst, typename Src>
+void ConvertLoop(const void* src, void* dst, int64_t count) {
+  const Src* in = static_cast<const Src*>(src);
+  Dst* out = static_cast<Dst*>(dst);
+  for (int64_t i = 0; i < count; ++i) out[i] = Narrow<Dst>::From(Widen(in[i]));
+}
+
+typedef void (*QuantizeFn)(const void* src, void* dst, int64_t count,
+                           const QuantizationParams& params);
+
+// NaN is quantized to the lowest value, as by _mm256_max_ps().
+template <typename Dst, typename Src>
+void QuantizeLoop(const void* src, void* dst, int64_t count, const QuantizationParams& params) {
+  const Src* in = static_cast<const Src*>(src);
+  Dst* out = static_cast<Dst*>(dst);
+  const float inv_scale = 1.0f / params.scale;
+  const float lowest = static_cast<float>(std::numeric_limits<Dst>::lowest()) - params.zero_point;
+  const float highest = static_cast<float>(std::numeric_limits<Dst>::max()) - params.zero_point;
+  for (int64_t i = 0; i < count; ++i) {
+    float value = std::nearbyint(static_cast<float>(Widen(in[i])) * inv_scale);
+    value = value > lowest ? value : lowest;
+    value = value < highest ? value : highest;
+    out[i] = static_cast<Dst>(static_cast<int32_t>(value) + params.zero_point);
+  }
+}
+
+template <typename Dst, typename Src>
+void DequantizeLoop(const void* src, void* dst, int64_t count, const QuantizationParams& params) {
+  const Src* in = static_cast<const Src*>(src);
+  Dst* out = static_cast<Dst*>(dst);
+  for (int64_t i = 0; i < count; ++i) {
+    const float value = static_cast<float>(static_cast<int32_t>(in[i]) - params.zero_point);
+    out[i] = Narrow<Dst>::From(value * params.scale);
+  }
+}
+
+#ifdef DLR_CONVERT_AVX2
+/*! \brief Quantize 8 floats to int32, clamped to [lowest, highest] before adding the zero point. */
+__attribute__((target("avx2"))) inline __m256i QuantizeVectorAVX2(const float* src,
+                                                                   __m256 inv_scale, __m256 lowest,
+                                                                   __m256 highest,
+                                                                   __m256i zero_point) {
+  __m256 value = _mm256_mul_ps(_mm256_loadu_ps(src), inv_scale);
+  value = _mm256_min_ps(_mm256_max_ps(value, lowest), highest);
+  return _mm256_add_epi32(_mm256_cvtps_epi32(value), zero_point);
+}
+
+template <typename Dst>
+__attribute__((target("avx2"))) void QuantizeAVX2(const void* src, void* dst, int64_t count,
+                                                   const QuantizationParams& params) {
+  const float* in = static_cast<const float*>(src);
+  Dst* out = static_cast<Dst*>(dst);
+  const __m256 inv_scale = _mm256_set1_ps(1.0f / params.scale);
+  const __m256 lowest = _mm256_set1_ps(static_cast<float>(std::numeric_limits<Dst>::lowest()) -
+                                       params.zero_point);
+  const __m256 highest =
+      _mm256_set1_ps(static_cast<float>(std::numeric_limits<Dst>::max()) - params.zero_point);
+  const __m256i zero_point = _mm256_set1_epi32(params.zero_point);
+  // Packing interleaves the 128-bit lanes of its operands, this restores the order of the values.
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  int64_t i = 0;
+  for (; i + 32 <= count; i += 32) {
+    __m256i q[4];
+    for (int j = 0; j < 4; ++j) {
+      q[j] = QuantizeVectorAVX2(in + i + 8 * j, inv_scale, lowest, highest, zero_point);
+    }
+    const __m256i low = _mm256_packs_epi32(q[0], q[1]);
+    const __m256i high = _mm256_packs_epi32(q[2], q[3]);
+    const __m256i packed = std::is_signed<Dst>::value ? _mm256_packs_epi16(low, high)
+                                                      : _mm256_packus_epi16(low, high);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_permutevar8x32_epi32(packed, order));
+  }
+  QuantizeLoop<Dst, float>(in + i, out + i, count - i, params);
+}
+
+template <typename Src>
+__attribute__((target("avx2"))) void DequantizeAVX2(const void* src, void* dst, int64_t count,
+                                                     const QuantizationParams& params) {
+  const Src* in = static_cast<const Src*>(src);
+  float* out = static_cast<float*>(dst);
+  const __m256 scale = _mm256_set1_ps(params.scale);
+  const __m256i zero_point = _mm256_set1_epi32(params.zero_point);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+    const __m256i ints =
+        std::is_signed<Src>::value ? _mm256_cvtepi8_epi32(bytes) : _mm256_cvtepu8_epi32(bytes);
+    const __m256 value = _mm256_cvtepi32_ps(_mm256_sub_epi32(ints, zero_point));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(value, scale));
+  }
+  DequantizeLoop<float, Src>(in + i, out + i, count - i, params);
+}
+
+/*! \brief Gather count 4-byte elements spaced by stride elements. */
+__attribute__((target("avx2"))) void GatherAVX2(const char* src, int64_t stride, char* dst,
+                                                 int64_t count) {
+  const float* in = reinterpret_cast<const float*>(src);
+  float* out = reinterpret_cast<float*>(dst);
+  const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                             _mm256_set1_epi32(static_cast<int32_t>(stride)));
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_i32gather_ps(in + i * stride, offsets, 4));
+  }
+  for (; i < count; ++i) out[i] = in[i * stride];
+}
+
+__attribute__((target("avx,f16c"))) void FloatToHalfF16C(const void* src, void* dst,
+                                                          int64_t count) {
+  const float* in = static_cast<const float*>(src);
+  uint16_t* out = static_cast<uint16_t*>(dst);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), half);
+  }
+  for (; i < count; ++i) out[i] = FloatToHalf(in[i]);
+}
+
+__attribute__((target("avx,f16c"))) void HalfToFloatF16C(const void* src, void* dst,
+                                                          int64_t count) {
+  const uint16_t* in = static_cast<const uint16_t*>(src);
+  float* out = static_cast<float*>(dst);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    _mm256_storeu_ps(out + i, _mm256_cvtph_ps(half));
+  }
+  for (; i < count; ++i) out[i] = HalfToFloat(in[i]);
+}
+
+/*! \brief Every CPU with AVX2 also has F16C. */
+bool HasAVX2() {
+  static const bool has_avx2 = [] {
+    const std::vector<std::string>& features = GetCPUFeatures();
+    return std::find(features.begin(), features.end(), "avx2") != features.end();
+  }();
+  return has_avx2;
+}
+#endif  // DLR_CONVERT_AVX2
+
+template <typename T>
+void GatherLoop(const char* src, int64_t stride, char* dst, int64_t count) {
+  const T* in = reinterpret_cast<const T*>(src);
+  T* out = reinterpret_cast<T*>(dst);
+  for (int64_t i = 0; i < count; ++i) out[i] = in[i * stride];
+}
+
+/*! \brief Gather count elements of elem_bytes bytes spaced by stride elements. */
+void Gather(const char* src, int64_t stride, char* dst, int64_t count, size_t elem_bytes) {
+  if (stride == 1) {
+    std::memcpy(dst, src, count * elem_bytes);
+    return;
+  }
+  switch (elem_bytes) {
+    case 1:
+      return GatherLoop<uint8_t>(src, stride, dst, count);
+    case 2:
+      return GatherLoop<uint16_t>(src, stride, dst, count);
+    case 4:
+#ifdef DLR_CONVERT_AVX2
+      // Offsets of 8 elements must fit in 32 bits.
+      if (HasAVX2() && std::abs(stride) <= std::numeric_limits<int32_t>::max() / 8) {
+        return GatherAVX2(src, stride, dst, count);
+      }
+#endif  // DLR_CONVERT_AVX2
+      return GatherLoop<uint32_t>(src, stride, dst, count);
+    case 8:
+      return GatherLoop<uint64_t>(src, stride, dst, count);
+    default:
+      for (int64_t i = 0; i < count; ++i) {
+        std::memcpy(dst + i * elem_bytes, src + i * stride * elem_bytes, elem_bytes);
+      }
+  }
+}
+
+/*! \brief Call visit with a value of the element type of dtype. Returns false if it has none. */
+template <typename Visitor>
+bool VisitElementType(const DLDataType& dtype, Visitor&& visit) {
+  if (dtype.lanes != 1) return false;
+  switch (dtype.code) {
+    case kDLFloat:
+      if (dtype.bits == 64) return visit(double()), true;
+      if (dtype.bits == 32) return visit(float()), true;
+      if (dtype.bits == 16) return visit(Half()), true;
+      return false;
+    case kDLBfloat:
+      if (dtype.bits == 16) return visit(BFloat16()), true;
+      return false;
+    case kDLInt:
+      if (dtype.bits == 64) return visit(int64_t()), true;
+      if (dtype.bits == 32) return visit(int32_t()), true;
+      if (dtype.bits == 16) return visit(int16_t()), true;
+      if (dtype.bits == 8) return visit(int8_t()), true;
+      return false;
+    case kDLUInt:
+      if (dtype.bits == 64) return visit(uint64_t()), true;
+      if (dtype.bits == 32) return visit(uint32_t()), true;
+      if (dtype.bits == 16) return visit(uint16_t()), true;
+      if (dtype.bits == 8) return visit(uint8_t()), true;
+      return false;
+    default:
+      return false;
+  }
+}
+
+/*! \brief Call visit with a value of the element type of a float dtype. */
+template <typename Visitor>
+bool VisitFloatType(const DLDataType& dtype, Visitor&& visit) {
+  if (dtype.lanes != 1) return false;
+  if (dtype.code == kDLFloat && dtype.bits == 64) return visit(double()), true;
+  if (dtype.code == kDLFloat && dtype.bits == 32) return visit(float()), true;
+  if (dtype.code == kDLFloat && dtype.bits == 16) return visit(Half()), true;
+  if (dtype.code == kDLBfloat && dtype.bits == 16) return visit(BFloat16()), true;
+  return false;
+}
+
+/*! \brief Call visit with a value of the element type of a quantized dtype. */
+template <typename Visitor>
+bool VisitQuantizedType(const DLDataType& dtype, Visitor&& visit) {
+  if (dtype.lanes != 1) return false;
+  if (dtype.code == kDLInt && dtype.bits == 16) return visit(int16_t()), true;
+  if (dtype.code == kDLInt && dtype.bits == 8) return visit(int8_t()), true;
+  if (dtype.code == kDLUInt && dtype.bits == 16) return visit(uint16_t()), true;
+  if (dtype.code == kDLUInt && dtype.bits == 8) return visit(uint8_t()), true;
+  return false;
+}
+
+std::string DLDataTypeToString(const DLDataType& dtype) {
+  std::string name;
+  switch (dtype.code) {
+    case kDLFloat:
+      name = "float";
+      break;
+    case kDLBfloat:
+      name = "bfloat";
+      break;
+    case kDLInt:
+      name = "int";
+      break;
+    case kDLUInt:
+      name = "uint";
+      break;
+    default:
+      name = "code" + std::to_string(dtype.code) + "_";
+  }
+  name += std::to_string(dtype.bits);
+  if (dtype.lanes != 1) name += "x" + std::to_string(dtype.lanes);
+  return name;
+}
+
+}  // namespace
+
+DLDataType dlr::GetDLDataTypeFromString(const std::string& dtype) {
+  static const std::pair<const char*, DLDataType> kDataTypes[] = {
+      {"bool", {kDLUInt, 1, 1}},      {"uint8", {kDLUInt, 8, 1}},     {"int8", {kDLInt, 8, 1}},
+      {"uint16", {kDLUInt, 16, 1}},   {"int16", {kDLInt, 16, 1}},     {"uint32", {kDLUInt, 32, 1}},
+      {"int32", {kDLInt, 32, 1}},     {"uint64", {kDLUInt, 64, 1}},   {"int64", {kDLInt, 64, 1}},
+      {"float16", {kDLFloat, 16, 1}}, {"bfloat16", {kDLBfloat, 16, 1}},
+      {"float32", {kDLFloat, 32, 1}}, {"float64", {kDLFloat, 64, 1}}};
+  for (const auto& entry : kDataTypes) {
+    if (dtype == entry.first) return entry.second;
+  }
+  throw dmlc::Error("Unknown dtype: " + dtype);
+}
+
+bool dlr::IsConvertibleDLDataType(const DLDataType& dtype) {
+  return VisitElementType(dtype, [](auto) {});
+}
+
+void dlr::ConvertData(const void* src, const DLDataType& src_dtype, void* dst,
+                      const DLDataType& dst_dtype, int64_t count) {
+  CHECK(IsConvertibleDLDataType(src_dtype))
+      << "Cannot convert data of type " << DLDataTypeToString(src_dtype);
+  CHECK(IsConvertibleDLDataType(dst_dtype))
+      << "Cannot convert data to type " << DLDataTypeToString(dst_dtype);
+  if (IsSameDLDataType(src_dtype, dst_dtype)) {
+    std::memcpy(dst, src, count * (src_dtype.bits / 8));
+    return;
+  }
+  ConvertFn convert = nullptr;
+#ifdef DLR_CONVERT_AVX2
+  const DLDataType kFloat32 = {kDLFloat, 32, 1};
+  const DLDataType kFloat16 = {kDLFloat, 16, 1};
+  if (HasAVX2() && IsSameDLDataType(src_dtype, kFloat32) && IsSameDLDataType(dst_dtype, kFloat16)) {
+    convert = FloatToHalfF16C;
+  } else if (HasAVX2() && IsSameDLDataType(src_dtype, kFloat16) &&
+             IsSameDLDataType(dst_dtype, kFloat32)) {
+    convert = HalfToFloatF16C;
+  }
+#endif  // DLR_CONVERT_AVX2
+  if (convert == nullptr) {
+    VisitElementType(src_dtype, [&](auto src_value) {
+      VisitElementType(dst_dtype, [&](auto dst_value) {
+        convert = ConvertLoop<decltype(dst_value), decltype(src_value)>;
+      });
+    });
+  }
+  convert(src, dst, count);
+}
+
+bool dlr::IsQuantizedDLDataType(const DLDataType& dtype) {
+  return VisitQuantizedType(dtype, [](auto) {});
+}
+
+void dlr::QuantizeData(const void* src, const DLDataType& src_dtype, void* dst,
+                       const DLDataType& dst_dtype, int64_t count,
+                       const QuantizationParams& params) {
+  CHECK_GT(params.scale, 0.0f) << "Quantization scale must be positive";
+  QuantizeFn quantize = nullptr;
+#ifdef DLR_CONVERT_AVX2
+  const DLDataType kFloat32 = {kDLFloat, 32, 1};
+  if (HasAVX2() && IsSameDLDataType(src_dtype, kFloat32) && dst_dtype.bits == 8 &&
+      dst_dtype.lanes == 1) {
+    if (dst_dtype.code == kDLInt) quantize = QuantizeAVX2<int8_t>;
+    if (dst_dtype.code == kDLUInt) quantize = QuantizeAVX2<uint8_t>;
+  }
+#endif  // DLR_CONVERT_AVX2
+  if (quantize == nullptr) {
+    const bool supported = VisitFloatType(src_dtype, [&](auto src_value) {
+      VisitQuantizedType(dst_dtype, [&](auto dst_value) {
+        quantize = QuantizeLoop<decltype(dst_value), decltype(src_value)>;
+      });
+    });
+    CHECK(supported && quantize != nullptr)
+        << "Cannot quantize data of type " << DLDataTypeToString(src_dtype) << " to type "
+        << DLDataTypeToString(dst_dtype);
+  }
+  quantize(src, dst, count, params);
+}
+
+void dlr::DequantizeData(const void* src, const DLDataType& src_dtype, void* dst,
+                         const DLDataType& dst_dtype, int64_t count,
+                         const QuantizationParams& params) {
+  QuantizeFn dequantize = nullptr;
+#ifdef DLR_CONVERT_AVX2
+  const DLDataType kFloat32 = {kDLFloat, 32, 1};
+  if (HasAVX2() && IsSameDLDataType(dst_dtype, kFloat32) && src_dtype.bits == 8 &&
+      src_dtype.lanes == 1) {
+    if (src_dtype.code == kDLInt) dequantize = DequantizeAVX2<int8_t>;
+    if (src_dtype.code == kDLUInt) dequantize = DequantizeAVX2<uint8_t>;
+  }
+#endif  // DLR_CONVERT_AVX2
+  if (dequantize == nullptr) {
+    const bool supported = VisitQuantizedType(src_dtype, [&](auto src_value) {
+      VisitFloatType(dst_dtype, [&](auto dst_value) {
+        dequantize = DequantizeLoop<decltype(dst_value), decltype(src_value)>;
+      });
+    });
+    CHECK(supported && dequantize != nullptr)
+        << "Cannot dequantize data of type " << DLDataTypeToString(src_dtype) << " to type "
+        << DLDataTypeToString(dst_dtype);
+  }
+  dequantize(src, dst, count, params);
+}
+
+bool dlr::IsCompactTensor(const DLTensor& tensor) {
+  if (tensor.strides == nullptr) return true;
+  int64_t expected_stride = 1;
+  for (int i = tensor.ndim - 1; i >= 0; --i) {
+    if (tensor.shape[i] != 1 && tensor.strides[i] != expected_stride) return false;
+    expected_stride *= tensor.shape[i];
+  }
+  return true;
+}
+
+void dlr::CopyStridedData(const DLTensor& src, void* dst) {
+  const size_t elem_bytes = (src.dtype.bits * src.dtype.lanes + 7) / 8;
+  const char* data = static_cast<const char*>(src.data) + src.byte_offset;
+  const int64_t count =
+      std::accumulate(src.shape, src.shape + src.ndim, int64_t(1), std::multiplies<int64_t>());
+  if (count == 0) return;
+  if (IsCompactTensor(src)) {
+    std::memcpy(dst, data, count * elem_bytes);
+    return;
+  }
+  // Drop dimensions of size 1 and merge dimensions which are contiguous with their inner one.
+  std::vector<int64_t> shape, strides;
+  for (int i = 0; i < src.ndim; ++i) {
+    if (src.shape[i] == 1) continue;
+    if (!strides.empty() && strides.back() == src.strides[i] * src.shape[i]) {
+      shape.back() *= src.shape[i];
+      strides.back() = src.strides[i];
+    } else {
+      shape.push_back(src.shape[i]);
+      strides.push_back(src.strides[i]);
+    }
+  }
+  // Gather rows along the innermost dimension, walking the outer ones.
+  const int outer_dims = static_cast<int>(shape.size()) - 1;
+  const int64_t row_size = shape.back();
+  const int64_t row_stride = strides.back();
+  std::vector<int64_t> index(outer_dims, 0);
+  char* out = static_cast<char*>(dst);
+  for (int64_t row = 0; row < count / row_size; ++row) {
+    Gather(data, row_stride, out, row_size, elem_bytes);
+    out += row_size * elem_bytes;
+    for (int d = outer_dims - 1; d >= 0; --d) {
+      data += strides[d] * elem_bytes;
+      if (++index[d] < shape[d]) break;
+      data -= strides[d] * shape[d] * elem_bytes;
+      index[d] = 0;
+    }
+  }
+}
@@ -0,0 +1,59 @@
+#include "dlr_execution_group.h"
+
+#include <algorithm>
+
+using namespace dlr;
+
+void ExecutionGroup::ResizeArena(size_t nbytes) {
+  if (nbytes == arena_bytes_) return;
+  if (nbytes == 0) {
+    arena_ = tvm::runtime::NDArray();
+  } else {
+    arena_ = tvm::runtime::NDArray::Empty({static_cast<int64_t>(nbytes)}, DLDataType{kDLUInt, 8, 1},
+                                          ctx_);
+  }
+  arena_bytes_ = nbytes;
+  // The previous arena is released once every member points to the new one.
+  for (auto& member : members_) {
+    member.first->BindIntermediateStorage(arena_);
+  }
+}
+
+void ExecutionGroup::Join(DLRGraphRuntime* runtime, const DLContext& ctx) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CHECK(members_.find(runtime) == members_.end()) << "Model already joined this execution group.";
+  if (members_.empty()) {
+    ctx_ = ctx;
+  } else {
+    CHECK(ctx.device_type == ctx_.device_type && ctx.device_id == ctx_.device_id)
+        << "All models of an execution group must use the same device.";
+  }
+  const size_t nbytes = runtime->GetIntermediateStorageBytes();
+  if (nbytes > arena_bytes_) ResizeArena(nbytes);
+  if (nbytes > 0) runtime->BindIntermediateStorage(arena_);
+  members_[runtime] = nbytes;
+}
+
+void ExecutionGroup::Leave(DLRGraphRuntime* runtime) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (members_.erase(runtime) == 0) return;
+  size_t max_bytes = 0;
+  for (const auto& member : members_) {
+    max_bytes = std::max(max_bytes, member.second);
+  }
+  if (max_bytes < arena_bytes_) ResizeArena(max_bytes);
+}
+
+size_t ExecutionGroup::GetArenaBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return arena_bytes_;
+}
+
+size_t ExecutionGroup::GetSavedBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t total_bytes = 0;
+  for (const auto& member : members_) {
+    total_bytes += member.second;
+  }
+  return total_bytes > arena_bytes_ ? total_bytes - arena_bytes_ : 0;
+}
@@ -0,0 +1,240 @@
+#include "dlr_flight_recorder.h"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#define DLR_FLIGHT_RECORDER_SIGNAL
+#include <signal.h>
+#include <unistd.h>
+#endif  // _WIN32
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif  // __linux__
+
+using namespace dlr;
+
+constexpr int FlightRecorder::kNumFields;
+
+namespace {
+
+std::mutex registry_mutex;
+std::set<FlightRecorder*> registry;
+
+uint64_t GetThreadId() {
+#ifdef __linux__
+  return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+  return std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif  // __linux__
+}
+
+void ToFields(const FlightRecord& r, uint64_t* f) {
+  f[0] = r.request;
+  f[1] = r.thread;
+  f[2] = r.batch_size;
+  f[3] = r.input_size;
+  f[4] = r.num_inputs;
+  f[5] = r.num_outputs;
+  f[6] = r.set_input_start;
+  f[7] = r.set_input_end;
+  f[8] = r.run_start;
+  f[9] = r.run_end;
+  f[10] = r.get_output_end;
+}
+
+void FromFields(const uint64_t* f, FlightRecord* r) {
+  r->request = f[0];
+  r->thread = f[1];
+  r->batch_size = f[2];
+  r->input_size = f[3];
+  r->num_inputs = f[4];
+  r->num_outputs = f[5];
+  r->set_input_start = f[6];
+  r->set_input_end = f[7];
+  r->run_start = f[8];
+  r->run_end = f[9];
+  r->get_output_end = f[10];
+}
+
+double ToMs(uint64_t start, uint64_t end) { return end > start ? (end - start) / 1e6 : 0.0; }
+
+/*! \brief Phases of a request as a JSON object, durations in milliseconds. */
+std::string FormatRecord(const FlightRecord& r, const void* model, const char* backend) {
+  const uint64_t start = r.set_input_start != 0 ? r.set_input_start : r.run_start;
+  const uint64_t end = r.get_output_end != 0 ? r.get_output_end : r.run_end;
+  std::ostringstream ss;
+  ss << "{\"model\": \"" << model << "\", \"backend\": \"" << backend
+     << "\", \"request\": " << r.request << ", \"thread\": " << r.thread
+     << ", \"batch_size\": " << r.batch_size << ", \"input_size\": " << r.input_size
+     << ", \"num_inputs\": " << r.num_inputs << ", \"num_outputs\": " << r.num_outputs
+     << ", \"start_ns\": " << start
+     << ", \"set_input_ms\": " << ToMs(r.set_input_start, r.set_input_end)
+     << ", \"wait_ms\": " << ToMs(r.set_input_end, r.run_start)
+     << ", \"run_ms\": " << ToMs(r.run_start, r.run_end)
+     << ", \"get_output_ms\": " << ToMs(r.run_end, r.get_output_end)
+     << ", \"total_ms\": " << ToMs(start, end) << "}";
+  return ss.str();
+}
+
+#ifdef DLR_FLIGHT_RECORDER_SIGNAL
+int signal_pipe[2] = {-1, -1};
+
+void OnDumpSignal(int) {
+  const char c = 0;
+  // Only async-signal-safe calls here, the dump runs on the dumper thread.
+  ssize_t ret = write(signal_pipe[1], &c, 1);
+  (void)ret;
+}
+#endif  // DLR_FLIGHT_RECORDER_SIGNAL
+
+}  // namespace
+
+FlightRecorder::FlightRecorder(DLRModel* model, int capacity, double slow_threshold_ms)
+    : model_(model),
+      backend_(kBackendToStr[static_cast<int>(model->GetBackend())]),
+      capacity_(capacity),
+      slow_threshold_ns_(static_cast<uint64_t>(slow_threshold_ms * 1e6)) {
+  CHECK_GT(capacity, 0) << "Invalid capacity of the flight recorder";
+  CHECK_GE(slow_threshold_ms, 0) << "Invalid slow request threshold";
+  slots_.reset(new Slot[capacity]);
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  registry.insert(this);
+}
+
+FlightRecorder::~FlightRecorder() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  registry.erase(this);
+}
+
+uint64_t FlightRecorder::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void FlightRecorder::OnSetInput(uint64_t start, uint64_t end, int64_t batch_size, int64_t size) {
+  if (pending_ran_) {
+    pending_ = FlightRecord();
+    pending_.set_input_start = start;
+    pending_ran_ = false;
+  }
+  pending_.set_input_end = end;
+  pending_.batch_size = batch_size;
+  pending_.input_size += size;
+  pending_.num_inputs++;
+}
+
+void FlightRecorder::OnRun(uint64_t start, uint64_t end) {
+  if (pending_ran_) pending_ = FlightRecord();
+  pending_ran_ = true;
+  pending_.request = next_request_++;
+  pending_.thread = GetThreadId();
+  pending_.run_start = start;
+  pending_.run_end = end;
+  last_slot_ = static_cast<int>(pending_.request % capacity_);
+  Write(last_slot_, pending_);
+
+  const uint64_t request_start =
+      pending_.set_input_start != 0 ? pending_.set_input_start : pending_.run_start;
+  if (slow_threshold_ns_ > 0 && end - request_start > slow_threshold_ns_) {
+    LOG(WARNING) << "Slow request: " << FormatRecord(pending_, model_, backend_);
+  }
+}
+
+void FlightRecorder::OnGetOutput(uint64_t end) {
+  if (last_slot_ < 0 || !pending_ran_) return;
+  pending_.get_output_end = end;
+  pending_.num_outputs++;
+  Write(last_slot_, pending_);
+}
+
+void FlightRecorder::Write(int slot, const FlightRecord& record) {
+  Slot& s = slots_[slot];
+  uint64_t fields[kNumFields];
+  ToFields(record, fields);
+  const uint64_t seq = s.seq.load(std::memory_order_relaxed);
+  s.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (int i = 0; i < kNumFields; i++) s.fields[i].store(fields[i], std::memory_order_relaxed);
+  s.seq.store(seq + 2, std::memory_order_release);
+}
+
+bool FlightRecorder::Read(int slot, FlightRecord* record) const {
+  const Slot& s = slots_[slot];
+  const uint64_t seq = s.seq.load(std::memory_order_acquire);
+  if (seq == 0 || seq % 2 != 0) return false;
+  uint64_t fields[kNumFields];
+  for (int i = 0; i < kNumFields; i++) fields[i] = s.fields[i].load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (s.seq.load(std::memory_order_relaxed) != seq) return false;
+  FromFields(fields, record);
+  return true;
+}
+
+std::vector<FlightRecord> FlightRecorder::GetRecords() const {
+  const uint64_t next = next_request_.load();
+  const uint64_t first = next > static_cast<uint64_t>(capacity_) ? next - capacity_ : 0;
+  std::vector<FlightRecord> records;
+  for (uint64_t request = first; request < next; request++) {
+    FlightRecord record;
+    // Skip slots being written, or already holding a newer request.
+    if (Read(static_cast<int>(request % capacity_), &record) && record.request == request) {
+      records.push_back(record);
+    }
+  }
+  return records;
+}
+
+void FlightRecorder::Dump(std::ostream& os) const {
+  for (const FlightRecord& record : GetRecords()) {
+    os << FormatRecord(record, model_, backend_) << "\n";
+  }
+}
+
+void FlightRecorder::DumpAll(const std::string& path) {
+  std::ofstream out(path, std::ios::app);
+  CHECK(out.good()) << "Could not open " << path;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (const FlightRecorder* recorder : registry) recorder->Dump(out);
+}
+
+void FlightRecorder::InstallDumpSignal(int signum, const std::string& path) {
+#ifdef DLR_FLIGHT_RECORDER_SIGNAL
+  static std::mutex install_mutex;
+  static std::string dump_path;
+  std::lock_guard<std::mutex> lock(install_mutex);
+  if (signal_pipe[0] < 0) {
+    CHECK_EQ(pipe(signal_pipe), 0) << "Could not create the flight recorder signal pipe";
+    std::thread([]() {
+      char c;
+      while (read(signal_pipe[0], &c, 1) == 1) {
+        std::string path;
+        {
+          std::lock_guard<std::mutex> lock(install_mutex);
+          path = dump_path;
+        }
+        try {
+          DumpAll(path);
+        } catch (dmlc::Error& e) {
+          LOG(WARNING) << e.what();
+        }
+      }
+    }).detach();
+  }
+  dump_path = path;
+  struct sigaction action = {};
+  action.sa_handler = OnDumpSignal;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  CHECK_EQ(sigaction(signum, &action, nullptr), 0) << "Could not install a handler of signal "
+                                                   << signum;
+#else
+  throw dmlc::Error("Dumping flight recorders on a signal is not supported on this platform.");
+#endif  // DLR_FLIGHT_RECORDER_SIGNAL
+}
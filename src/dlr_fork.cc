@@ -0,0 +1,72 @@
+#include "dlr_fork.h"
+
+#include <atomic>
+#include <exception>
+#include <shared_mutex>
+#include <thread>
+
+using namespace dlr;
+
+namespace {
+
+std::atomic<bool> prefork_mode{false};
+// Set once prefork mode is enabled or a fork is prepared. Until then, runs skip fork_mutex.
+std::atomic<bool> fork_guarded{false};
+
+// Held shared by inferences and exclusively between PrepareFork() and the post-fork calls.
+// The child gets a new one, since a lock taken by the parent cannot be reliably released there.
+std::shared_timed_mutex* fork_mutex = new std::shared_timed_mutex();
+
+// Nested runs, e.g. the models of a pipeline, are already covered by the outermost one.
+thread_local int run_depth = 0;
+
+struct RunDepthGuard {
+  RunDepthGuard() { ++run_depth; }
+  ~RunDepthGuard() { --run_depth; }
+};
+
+}  // namespace
+
+void dlr::SetPreforkMode(bool enable) {
+  if (enable) fork_guarded = true;
+  prefork_mode = enable;
+}
+
+bool dlr::IsPreforkMode() { return prefork_mode; }
+
+void dlr::PrepareFork() {
+  fork_guarded = true;
+  fork_mutex->lock();
+}
+
+void dlr::PostForkParent() { fork_mutex->unlock(); }
+
+void dlr::PostForkChild() {
+  prefork_mode = false;
+  fork_mutex = new std::shared_timed_mutex();
+}
+
+void dlr::RunForkSafe(const std::function<void()>& fn) {
+  if (run_depth > 0 || !fork_guarded) {
+    fn();
+    return;
+  }
+  std::shared_lock<std::shared_timed_mutex> lock(*fork_mutex);
+  RunDepthGuard guard;
+  if (!prefork_mode) {
+    fn();
+    return;
+  }
+  // Thread-local TVM thread pools and workspaces are released when the thread exits.
+  std::exception_ptr error;
+  std::thread worker([&fn, &error]() {
+    RunDepthGuard worker_guard;
+    try {
+      fn();
+    } catch (...) {
+      error = std::current_exception();
+    }
+  });
+  worker.join();
+  if (error) std::rethrow_exception(error);
+}
@@ -0,0 +1,239 @@
+#include "dlr_graph_runtime.h"
+
+#include <tvm/runtime/data_type.h>
+
+#include <sstream>
+
+using namespace dlr;
+
+namespace {
+
+struct NDArraySlice {
+  tvm::runtime::NDArray buffer;
+  int64_t shape;
+  DLManagedTensor tensor;
+};
+
+inline size_t AlignStorage(size_t nbytes) {
+  return (nbytes + DLRGraphRuntime::kStorageAlignment - 1) / DLRGraphRuntime::kStorageAlignment *
+         DLRGraphRuntime::kStorageAlignment;
+}
+
+}  // namespace
+
+tvm::runtime::NDArray dlr::SliceNDArray(const tvm::runtime::NDArray& buffer, size_t offset,
+                                        size_t nbytes) {
+  const DLTensor* base = buffer.operator->();
+  CHECK_LE(offset + nbytes, tvm::runtime::GetDataSize(*base)) << "Slice is out of range.";
+  NDArraySlice* slice = new NDArraySlice();
+  slice->buffer = buffer;
+  slice->shape = static_cast<int64_t>(nbytes);
+  DLTensor& tensor = slice->tensor.dl_tensor;
+  tensor.data = static_cast<char*>(base->data) + base->byte_offset + offset;
+  tensor.ctx = base->ctx;
+  tensor.ndim = 1;
+  tensor.dtype = DLDataType{kDLUInt, 8, 1};
+  tensor.shape = &slice->shape;
+  tensor.strides = nullptr;
+  tensor.byte_offset = 0;
+  slice->tensor.manager_ctx = slice;
+  slice->tensor.deleter = [](DLManagedTensor* self) {
+    delete static_cast<NDArraySlice*>(self->manager_ctx);
+  };
+  return tvm::runtime::NDArray::FromDLPack(&slice->tensor);
+}
+
+std::vector<int> DLRGraphRuntime::GetIntermediateStorageIds() const {
+  std::vector<bool> pinned(storage_pool_.size(), false);
+  auto pin = [this, &pinned](uint32_t eid) {
+    const int sid = attrs_.storage_id[eid];
+    if (sid >= 0 && sid < static_cast<int>(pinned.size())) pinned[sid] = true;
+  };
+  // Graph inputs include the weights.
+  for (uint32_t nid : input_nodes_) pin(entry_id(nid, 0));
+  // Outputs must stay valid after Run() returns.
+  for (const NodeEntry& e : outputs_) pin(entry_id(e));
+
+  std::vector<int> storage_ids;
+  for (size_t sid = 0; sid < storage_pool_.size(); ++sid) {
+    if (!pinned[sid] && storage_pool_[sid].defined()) storage_ids.push_back(static_cast<int>(sid));
+  }
+  return storage_ids;
+}
+
+size_t DLRGraphRuntime::GetIntermediateStorageBytes() {
+  size_t nbytes = 0;
+  for (int sid : GetIntermediateStorageIds()) {
+    nbytes += AlignStorage(tvm::runtime::GetDataSize(*storage_pool_[sid].operator->()));
+  }
+  return nbytes;
+}
+
+void DLRGraphRuntime::BindIntermediateStorage(const tvm::runtime::NDArray& arena) {
+  CHECK_EQ(ctxs_.size(), 1) << "Heterogeneous graphs cannot use external storage.";
+  const DLContext& arena_ctx = arena->ctx;
+  CHECK(arena_ctx.device_type == ctxs_[0].device_type && arena_ctx.device_id == ctxs_[0].device_id)
+      << "Storage must be allocated on the model's context.";
+  CHECK_GE(tvm::runtime::GetDataSize(*arena.operator->()), GetIntermediateStorageBytes())
+      << "Storage is too small.";
+
+  size_t offset = 0;
+  for (int sid : GetIntermediateStorageIds()) {
+    const size_t nbytes = tvm::runtime::GetDataSize(*storage_pool_[sid].operator->());
+    RebindStorage(sid, SliceNDArray(arena, offset, nbytes));
+    offset += AlignStorage(nbytes);
+  }
+  RebuildOpExecs();
+}
+
+size_t DLRGraphRuntime::GetInputStorageBytes(int index) const {
+  CHECK(index >= 0 && index < static_cast<int>(input_nodes_.size())) << "Invalid input index.";
+  const int sid = attrs_.storage_id[entry_id(input_nodes_[index], 0)];
+  return tvm::runtime::GetDataSize(*storage_pool_[sid].operator->());
+}
+
+void DLRGraphRuntime::BindInputStorage(
+    const std::vector<std::pair<int, tvm::runtime::NDArray>>& storage) {
+  CHECK_EQ(ctxs_.size(), 1) << "Heterogeneous graphs cannot use external storage.";
+  // Validate everything first, so that the runtime is left untouched on error.
+  std::vector<int> storage_ids;
+  for (const auto& entry : storage) {
+    const int index = entry.first;
+    const tvm::runtime::NDArray& buffer = entry.second;
+    const size_t nbytes = GetInputStorageBytes(index);
+    const uint32_t input_eid = entry_id(input_nodes_[index], 0);
+    const int sid = attrs_.storage_id[input_eid];
+    for (size_t eid = 0; eid < data_entry_.size(); ++eid) {
+      CHECK(eid == input_eid || attrs_.storage_id[eid] != sid)
+          << "Storage of input " << index << " is shared with other entries.";
+    }
+    CHECK(buffer->ctx.device_type == ctxs_[0].device_type &&
+          buffer->ctx.device_id == ctxs_[0].device_id)
+        << "Storage must be allocated on the model's context.";
+    CHECK_GE(tvm::runtime::GetDataSize(*buffer.operator->()), nbytes) << "Storage is too small.";
+    storage_ids.push_back(sid);
+  }
+  for (size_t i = 0; i < storage.size(); ++i) {
+    RebindStorage(storage_ids[i], storage[i].second);
+  }
+  RebuildOpExecs();
+}
+
+void DLRGraphRuntime::RebindStorage(int storage_id, tvm::runtime::NDArray storage) {
+  for (size_t eid = 0; eid < data_entry_.size(); ++eid) {
+    if (attrs_.storage_id[eid] != storage_id) continue;
+    data_entry_[eid] =
+        storage.CreateView(attrs_.shape[eid], tvm::runtime::String2DLDataType(attrs_.dltype[eid]));
+  }
+  // Drop the reference to the old buffer, so it is freed once no entry uses it.
+  storage_pool_[storage_id] = storage;
+}
+
+void DLRGraphRuntime::RebuildOpExecs() {
+  // SetupOpExecs() appends to the per-input lists of zero-copy tensors.
+  for (auto& tensors : input_dltensors_) tensors.clear();
+  SetupOpExecs();
+}
+
+void DLRGraphRuntime::InitFromBinary(const void* data, size_t size, tvm::runtime::Module module,
+                                     const std::vector<TVMContext>& ctxs) {
+  BinaryReader reader(data, size);
+  LoadGraph(&reader);
+  // The rest mirrors GraphRuntime::Init().
+  module_ = module;
+  ctxs_ = ctxs;
+  lookup_linked_param_ = tvm::runtime::PackedFunc(
+      [this](tvm::runtime::TVMArgs args, tvm::runtime::TVMRetValue* rv) {
+        this->DefaultLookupLinkedParam(args, rv);
+      });
+  SetupStorage();
+  SetupOpExecs();
+  for (size_t i = 0; i < input_nodes_.size(); i++) {
+    input_map_[nodes_[input_nodes_[i]].name] = i;
+  }
+}
+
+std::string DLRGraphRuntime::SerializeGraph(const std::string& graph_json) {
+  auto runtime = tvm::runtime::make_object<DLRGraphRuntime>();
+  std::istringstream is(graph_json);
+  dmlc::JSONReader reader(&is);
+  runtime->Load(&reader);
+  BinaryWriter writer;
+  runtime->SaveGraph(&writer);
+  return std::move(writer.buffer());
+}
+
+void DLRGraphRuntime::SaveGraph(BinaryWriter* writer) const {
+  auto write_entries = [writer](const std::vector<NodeEntry>& entries) {
+    writer->Write<uint64_t>(entries.size());
+    for (const NodeEntry& e : entries) {
+      writer->Write<uint32_t>(e.node_id);
+      writer->Write<uint32_t>(e.index);
+      writer->Write<uint32_t>(e.version);
+    }
+  };
+  writer->Write<uint64_t>(nodes_.size());
+  for (const Node& node : nodes_) {
+    writer->WriteString(node.op_type);
+    writer->WriteString(node.name);
+    writer->WriteString(node.param.func_name);
+    writer->Write<uint32_t>(node.param.num_inputs);
+    writer->Write<uint32_t>(node.param.num_outputs);
+    writer->Write<uint32_t>(node.param.flatten_data);
+    write_entries(node.inputs);
+    writer->WriteVector(node.control_deps);
+  }
+  writer->WriteVector(input_nodes_);
+  write_entries(outputs_);
+  writer->WriteVector(node_row_ptr_);
+  writer->Write<uint64_t>(attrs_.storage_num_not_alloctaed);
+  writer->WriteVector(attrs_.storage_id);
+  writer->WriteVector(attrs_.device_index);
+  writer->Write<uint64_t>(attrs_.dltype.size());
+  for (const std::string& dltype : attrs_.dltype) writer->WriteString(dltype);
+  writer->Write<uint64_t>(attrs_.shape.size());
+  for (const std::vector<int64_t>& shape : attrs_.shape) writer->WriteVector(shape);
+}
+
+void DLRGraphRuntime::LoadGraph(BinaryReader* reader) {
+  auto read_entries = [reader]() {
+    std::vector<NodeEntry> entries(reader->Read<uint64_t>());
+    for (NodeEntry& e : entries) {
+      e.node_id = reader->Read<uint32_t>();
+      e.index = reader->Read<uint32_t>();
+      e.version = reader->Read<uint32_t>();
+    }
+    return entries;
+  };
+  nodes_.resize(reader->Read<uint64_t>());
+  for (Node& node : nodes_) {
+    node.op_type = reader->ReadString();
+    node.name = reader->ReadString();
+    node.param.func_name = reader->ReadString();
+    node.param.num_inputs = reader->Read<uint32_t>();
+    node.param.num_outputs = reader->Read<uint32_t>();
+    node.param.flatten_data = reader->Read<uint32_t>();
+    node.inputs = read_entries();
+    node.control_deps = reader->ReadVector<uint32_t>();
+  }
+  input_nodes_ = reader->ReadVector<uint32_t>();
+  outputs_ = read_entries();
+  node_row_ptr_ = reader->ReadVector<uint32_t>();
+  attrs_.storage_num_not_alloctaed = reader->Read<uint64_t>();
+  attrs_.storage_id = reader->ReadVector<int>();
+  attrs_.device_index = reader->ReadVector<int>();
+  attrs_.dltype.resize(reader->Read<uint64_t>());
+  for (std::string& dltype : attrs_.dltype) dltype = reader->ReadString();
+  attrs_.shape.resize(reader->Read<uint64_t>());
+  for (std::vector<int64_t>& shape : attrs_.shape) shape = reader->ReadVector<int64_t>();
+
+  // Validate indices the same way the JSON loader would fail on a malformed graph.
+  CHECK(!node_row_ptr_.empty() && node_row_ptr_.size() == nodes_.size() + 1)
+      << "Invalid binary graph.";
+  const size_t num_entries = node_row_ptr_.back();
+  CHECK(attrs_.storage_id.size() == num_entries && attrs_.dltype.size() == num_entries &&
+        attrs_.shape.size() == num_entries)
+      << "Invalid binary graph.";
+  for (uint32_t nid : input_nodes_) CHECK_LT(nid, nodes_.size()) << "Invalid binary graph.";
+  for (const NodeEntry& e : outputs_) CHECK_LT(e.node_id, nodes_.size()) << "Invalid binary graph.";
+}
@@ -0,0 +1,67 @@
+#include "dlr_input_window.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace dlr;
+
+namespace {
+
+// Alignment of the window, which lets it be bound to TVM graphs without copies.
+constexpr size_t kWindowAlignment = 64;
+
+}  // namespace
+
+InputWindow::InputWindow(int64_t length, size_t row_bytes, void* rotated_buffer)
+    : length_(length), row_bytes_(row_bytes), rotated_(rotated_buffer != nullptr) {
+  CHECK_GT(length_, 0) << "Window length must be positive.";
+  CHECK_GT(row_bytes_, 0) << "Window rows must not be empty.";
+  if (rotated_) {
+    replicas_.push_back(static_cast<char*>(rotated_buffer));
+    std::memset(replicas_[0], 0, length_ * row_bytes_);
+    return;
+  }
+  // The window starts at head_ * row_bytes_ in a replica, whose misalignment repeats every
+  // kWindowAlignment / gcd(row_bytes_, kWindowAlignment) rows. A replica per misalignment, each
+  // shifted to cancel it, keeps the window aligned wherever it starts.
+  // kWindowAlignment is a power of two, so the gcd is the lowest bit set in row_bytes_.
+  replica_shift_ = std::min(row_bytes_ & (~row_bytes_ + 1), kWindowAlignment);
+  const size_t num_replicas = kWindowAlignment / replica_shift_;
+  const size_t replica_bytes =
+      (2 * length_ * row_bytes_ + 2 * kWindowAlignment - 1) / kWindowAlignment * kWindowAlignment;
+  storage_.resize(num_replicas * replica_bytes + kWindowAlignment, 0);
+  const size_t misalignment = reinterpret_cast<uintptr_t>(storage_.data()) % kWindowAlignment;
+  char* base = storage_.data() + (misalignment ? kWindowAlignment - misalignment : 0);
+  for (size_t i = 0; i < num_replicas; i++) {
+    // Replica i is used when the window starts i * replica_shift_ bytes past an aligned address.
+    const size_t shift = (kWindowAlignment - i * replica_shift_) % kWindowAlignment;
+    replicas_.push_back(base + i * replica_bytes + shift);
+  }
+}
+
+const void* InputWindow::GetData() const {
+  if (rotated_) return replicas_[0];
+  const size_t start = head_ * row_bytes_;
+  return replicas_[start % kWindowAlignment / replica_shift_] + start;
+}
+
+void InputWindow::Append(const void* rows, int64_t count) {
+  const char* src = static_cast<const char*>(rows);
+  // Rows older than the window would be overwritten anyway.
+  if (count > length_) {
+    src += (count - length_) * row_bytes_;
+    head_ = (head_ + count - length_) % length_;
+    count = length_;
+  }
+  while (count > 0) {
+    const int64_t chunk = std::min(count, length_ - head_);
+    const size_t nbytes = chunk * row_bytes_;
+    for (char* data : replicas_) {
+      std::memcpy(data + head_ * row_bytes_, src, nbytes);
+      if (!rotated_) std::memcpy(data + (head_ + length_) * row_bytes_, src, nbytes);
+    }
+    head_ = (head_ + chunk) % length_;
+    src += nbytes;
+    count -= chunk;
+  }
+}
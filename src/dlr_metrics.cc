@@ -0,0 +1,229 @@
+#include "dlr_metrics.h"
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif  // __linux__
+
+using namespace dlr;
+
+constexpr int ModelMetrics::kNumShards;
+constexpr int ModelMetrics::kNumLatencyBuckets;
+constexpr int ModelMetrics::kNumBatchBuckets;
+
+namespace {
+
+std::mutex registry_mutex;
+std::set<const ModelMetrics*> registry;
+
+// Metric families, in the order they are rendered.
+enum MetricFamily {
+  kFamilyRequests,
+  kFamilyErrors,
+  kFamilyLatency,
+  kFamilyBatchSize,
+  kFamilyBytesCopied,
+  kNumFamilies
+};
+
+const char* kFamilyHeaders[kNumFamilies] = {
+    "# HELP dlr_requests_total Runs of the model.\n"
+    "# TYPE dlr_requests_total counter\n",
+    "# HELP dlr_errors_total Calls to the model which failed.\n"
+    "# TYPE dlr_errors_total counter\n",
+    "# HELP dlr_latency_seconds Latency of the calls to the model.\n"
+    "# TYPE dlr_latency_seconds histogram\n",
+    "# HELP dlr_batch_size Batch size of the runs, the first dimension of the last input set.\n"
+    "# TYPE dlr_batch_size histogram\n",
+    "# HELP dlr_bytes_copied_total Bytes copied into the inputs and out of the outputs.\n"
+    "# TYPE dlr_bytes_copied_total counter\n"};
+
+const char* kPhaseNames[kNumMetricPhases] = {"set_input", "run", "get_output"};
+
+const uint64_t kLatencyBounds[] = {100000,    250000,    500000,     1000000,    2500000,
+                                   5000000,   10000000,  25000000,   50000000,   100000000,
+                                   250000000, 500000000, 1000000000, 2500000000, 5000000000,
+                                   10000000000};
+const uint64_t kBatchBounds[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512};
+
+template <size_t N>
+int GetBucket(const uint64_t (&bounds)[N], uint64_t value) {
+  int bucket = 0;
+  while (bucket < static_cast<int>(N) && value > bounds[bucket]) bucket++;
+  return bucket;
+}
+
+uint64_t Load(const std::atomic<uint64_t>& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+/*! \brief Escape a label value of the Prometheus text format. */
+std::string EscapeLabel(const std::string& value) {
+  std::string escaped;
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+/*! \brief Resident memory of the process in bytes, -1 if unknown on this platform. */
+int64_t GetResidentMemory() {
+#ifdef __linux__
+  std::ifstream statm("/proc/self/statm");
+  int64_t size, resident;
+  if (statm >> size >> resident) return resident * sysconf(_SC_PAGESIZE);
+#endif  // __linux__
+  return -1;
+}
+
+}  // namespace
+
+ModelMetrics::ModelMetrics(DLRModel* model, const std::string& name)
+    : labels_("model=\"" + EscapeLabel(name) + "\",backend=\"" +
+              kBackendToStr[static_cast<int>(model->GetBackend())] + "\""),
+      model_(model),
+      // Value-initialized, so that the counters start at 0.
+      shards_(new Shard[kNumShards]()) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  // Series of two models with the same labels could not be told apart.
+  for (const ModelMetrics* other : registry) {
+    CHECK(other->labels_ != labels_ || other->model_ == model)
+        << "Metrics are already enabled for another model named \"" << name
+        << "\" with this backend, give each model a distinct name.";
+  }
+  registry.insert(this);
+}
+
+ModelMetrics::~ModelMetrics() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  registry.erase(this);
+}
+
+uint64_t ModelMetrics::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+ModelMetrics::Shard& ModelMetrics::GetShard() {
+  static std::atomic<int> next_shard{0};
+  thread_local const int shard = next_shard++ % kNumShards;
+  return shards_[shard];
+}
+
+template <typename Get>
+uint64_t ModelMetrics::Sum(Get get) const {
+  uint64_t sum = 0;
+  for (int i = 0; i < kNumShards; i++) sum += get(shards_[i]);
+  return sum;
+}
+
+void ModelMetrics::OnCall(MetricPhase phase, uint64_t nanoseconds, uint64_t bytes) {
+  Shard& shard = GetShard();
+  shard.calls[phase].fetch_add(1, std::memory_order_relaxed);
+  shard.bytes[phase].fetch_add(bytes, std::memory_order_relaxed);
+  shard.latency_ns[phase].fetch_add(nanoseconds, std::memory_order_relaxed);
+  shard.latency_buckets[phase][GetBucket(kLatencyBounds, nanoseconds)].fetch_add(
+      1, std::memory_order_relaxed);
+  const int64_t batch_size = batch_size_.load(std::memory_order_relaxed);
+  if (phase == kMetricRun && batch_size > 0) {
+    shard.batch_sizes.fetch_add(batch_size, std::memory_order_relaxed);
+    shard.batch_buckets[GetBucket(kBatchBounds, batch_size)].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+}
+
+void ModelMetrics::OnError(MetricPhase phase) {
+  GetShard().errors[phase].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ModelMetrics::Render(std::ostream& os, int family) const {
+  switch (family) {
+    case kFamilyRequests:
+      os << "dlr_requests_total{" << labels_ << "} "
+         << Sum([](const Shard& s) { return Load(s.calls[kMetricRun]); }) << "\n";
+      return;
+    case kFamilyErrors:
+      for (int p = 0; p < kNumMetricPhases; p++) {
+        os << "dlr_errors_total{" << labels_ << ",phase=\"" << kPhaseNames[p] << "\"} "
+           << Sum([p](const Shard& s) { return Load(s.errors[p]); }) << "\n";
+      }
+      return;
+    case kFamilyLatency:
+      for (int p = 0; p < kNumMetricPhases; p++) {
+        const std::string labels = labels_ + ",phase=\"" + kPhaseNames[p] + "\"";
+        uint64_t count = 0;
+        for (int b = 0; b <= kNumLatencyBuckets; b++) {
+          count += Sum([p, b](const Shard& s) { return Load(s.latency_buckets[p][b]); });
+          os << "dlr_latency_seconds_bucket{" << labels << ",le=\"";
+          if (b < kNumLatencyBuckets) {
+            os << kLatencyBounds[b] / 1e9;
+          } else {
+            os << "+Inf";
+          }
+          os << "\"} " << count << "\n";
+        }
+        os << "dlr_latency_seconds_sum{" << labels << "} "
+           << Sum([p](const Shard& s) { return Load(s.latency_ns[p]); }) / 1e9 << "\n";
+        os << "dlr_latency_seconds_count{" << labels << "} " << count << "\n";
+      }
+      return;
+    case kFamilyBatchSize: {
+      uint64_t count = 0;
+      for (int b = 0; b <= kNumBatchBuckets; b++) {
+        count += Sum([b](const Shard& s) { return Load(s.batch_buckets[b]); });
+        os << "dlr_batch_size_bucket{" << labels_ << ",le=\"";
+        if (b < kNumBatchBuckets) {
+          os << kBatchBounds[b];
+        } else {
+          os << "+Inf";
+        }
+        os << "\"} " << count << "\n";
+      }
+      os << "dlr_batch_size_sum{" << labels_ << "} "
+         << Sum([](const Shard& s) { return Load(s.batch_sizes); }) << "\n";
+      os << "dlr_batch_size_count{" << labels_ << "} " << count << "\n";
+      return;
+    }
+    case kFamilyBytesCopied:
+      for (int p : {kMetricSetInput, kMetricGetOutput}) {
+        os << "dlr_bytes_copied_total{" << labels_ << ",phase=\"" << kPhaseNames[p] << "\"} "
+           << Sum([p](const Shard& s) { return Load(s.bytes[p]); }) << "\n";
+      }
+      return;
+    default:
+      throw dmlc::Error("Unknown metric family " + std::to_string(family));
+  }
+}
+
+std::string dlr::GetMetricsText() {
+  std::ostringstream os;
+  // Enough digits for latency sums in seconds to keep nanoseconds.
+  os.precision(15);
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (int family = 0; family < kNumFamilies; family++) {
+      os << kFamilyHeaders[family];
+      for (const ModelMetrics* metrics : registry) metrics->Render(os, family);
+    }
+  }
+  const int64_t resident = GetResidentMemory();
+  if (resident >= 0) {
+    os << "# HELP dlr_resident_memory_bytes Resident memory of the process.\n"
+       << "# TYPE dlr_resident_memory_bytes gauge\n"
+       << "dlr_resident_memory_bytes " << resident << "\n";
+  }
+  return os.str();
+}
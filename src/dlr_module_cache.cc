@@ -0,0 +1,85 @@
+#include "dlr_module_cache.h"
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace dlr;
+
+namespace {
+
+constexpr uint64_t kFNVOffsetBasis = 14695981039346656037ULL;
+constexpr uint64_t kFNVPrime = 1099511628211ULL;
+
+inline uint64_t HashBytes(const char* data, size_t size, uint64_t hash) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= kFNVPrime;
+  }
+  return hash;
+}
+
+std::string FormatKey(const std::string& prefix, uint64_t hash, uint64_t size) {
+  std::ostringstream key;
+  key << prefix << "#" << std::hex << std::setw(16) << std::setfill('0') << hash << "-" << std::dec
+      << size;
+  return key.str();
+}
+
+std::string GetCanonicalPath(const std::string& path) {
+#ifdef _WIN32
+  char buf[_MAX_PATH];
+  if (_fullpath(buf, path.c_str(), _MAX_PATH) != nullptr) return std::string(buf);
+#else
+  char* resolved = realpath(path.c_str(), nullptr);
+  if (resolved != nullptr) {
+    std::string ret(resolved);
+    free(resolved);
+    return ret;
+  }
+#endif  // _WIN32
+  return path;
+}
+
+}  // namespace
+
+std::string dlr::GetArtifactKey(const std::string& path) {
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    throw dmlc::Error("Unable to open model artifact: " + path);
+  }
+  std::vector<char> buf(1 << 20);
+  uint64_t hash = kFNVOffsetBasis;
+  uint64_t size = 0;
+  while (file) {
+    file.read(buf.data(), buf.size());
+    const size_t count = static_cast<size_t>(file.gcount());
+    hash = HashBytes(buf.data(), count, hash);
+    size += count;
+  }
+  return FormatKey(GetCanonicalPath(path), hash, size);
+}
+
+std::string dlr::GetArtifactKey(const void* data, size_t size) {
+  const uint64_t hash = HashBytes(static_cast<const char*>(data), size, kFNVOffsetBasis);
+  return FormatKey("<memory>", hash, size);
+}
+
+static ModuleCache<tvm::runtime::Module>& GetTVMModuleCache() {
+  static ModuleCache<tvm::runtime::Module> cache;
+  return cache;
+}
+
+std::shared_ptr<tvm::runtime::Module> dlr::LoadSharedTVMModule(const std::string& path,
+                                                                std::string* key) {
+  const std::string lib_key = GetArtifactKey(path);
+  if (key != nullptr) *key = lib_key;
+  return GetTVMModuleCache().GetOrLoad(lib_key, [&path]() {
+    return std::make_shared<tvm::runtime::Module>(tvm::runtime::Module::LoadFromFile(path));
+  });
+}
+
+size_t dlr::GetNumSharedTVMModules() { return GetTVMModuleCache().Size(); }
@@ -0,0 +1,87 @@
+#include "dlr_output_buffers.h"
+
+using namespace dlr;
+
+constexpr int64_t OutputBuffers::kFree;
+constexpr int64_t OutputBuffers::kReserved;
+
+OutputBuffers::OutputBuffers(int num_sets) {
+  CHECK_GE(num_sets, 1) << "At least one output buffer set is needed";
+  sets_.resize(num_sets);
+}
+
+int OutputBuffers::Reserve() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    for (int i = 0; i < sets_.size(); i++) {
+      if (sets_[i].ticket == kFree) {
+        sets_[i].ticket = kReserved;
+        return i;
+      }
+    }
+    released_.wait(lock);
+  }
+}
+
+void* OutputBuffers::GetBuffer(int set, int index, size_t nbytes) {
+  BufferSet& buffer_set = sets_[set];
+  if (buffer_set.buffers.size() <= index) buffer_set.buffers.resize(index + 1);
+  buffer_set.buffers[index].resize(nbytes);
+  return buffer_set.buffers[index].data();
+}
+
+std::vector<int64_t>& OutputBuffers::GetShape(int set, int index) {
+  BufferSet& buffer_set = sets_[set];
+  if (buffer_set.shapes.size() <= index) buffer_set.shapes.resize(index + 1);
+  return buffer_set.shapes[index];
+}
+
+int64_t OutputBuffers::Publish(int set) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CHECK_EQ(sets_[set].ticket, kReserved) << "Output buffer set " << set << " is not reserved";
+  sets_[set].ticket = last_ticket_ = next_ticket_++;
+  return last_ticket_;
+}
+
+void OutputBuffers::Cancel(int set) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CHECK_EQ(sets_[set].ticket, kReserved) << "Output buffer set " << set << " is not reserved";
+    sets_[set].ticket = kFree;
+  }
+  released_.notify_one();
+}
+
+int64_t OutputBuffers::GetLastTicket() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_ticket_;
+}
+
+const OutputBuffers::BufferSet& OutputBuffers::FindSet(int64_t ticket) const {
+  for (const BufferSet& buffer_set : sets_) {
+    if (ticket >= 0 && buffer_set.ticket == ticket) return buffer_set;
+  }
+  throw dmlc::Error("Output ticket " + std::to_string(ticket) + " is not held");
+}
+
+const void* OutputBuffers::GetOutputPtr(int64_t ticket, int index) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const BufferSet& buffer_set = FindSet(ticket);
+  CHECK_LT(index, buffer_set.buffers.size()) << "Output index is out of range.";
+  return buffer_set.buffers[index].data();
+}
+
+const std::vector<int64_t>& OutputBuffers::GetOutputShape(int64_t ticket, int index) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const BufferSet& buffer_set = FindSet(ticket);
+  CHECK_LT(index, buffer_set.shapes.size()) << "Output index is out of range.";
+  return buffer_set.shapes[index];
+}
+
+void OutputBuffers::Release(int64_t ticket) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const_cast<BufferSet&>(FindSet(ticket)).ticket = kFree;
+  }
+  released_.notify_one();
+}
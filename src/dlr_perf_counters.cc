@@ -0,0 +1,189 @@
+#include "dlr_perf_counters.h"
+
+#ifdef __linux__
+#define DLR_PERF_COUNTERS_SUPPORTED
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#endif  // __linux__
+
+#include <algorithm>
+#include <vector>
+
+using namespace dlr;
+
+namespace {
+
+#ifdef DLR_PERF_COUNTERS_SUPPORTED
+struct PerfEvent {
+  uint32_t type;
+  uint64_t config;
+  bool exclude_kernel;
+};
+
+// In the order of PerfCounter. Context switches happen in the kernel, so they are not excluded.
+constexpr PerfEvent kPerfEvents[kNumPerfCounters] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, true},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, true},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, true},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, false}};
+
+int OpenPerfEvent(const PerfEvent& event, int tid) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  attr.exclude_kernel = event.exclude_kernel;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // Threads the thread starts later are counted too, and their counts remain once they exit.
+  attr.inherit = 1;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+/*! \brief Count of a counter, scaled to the time it was enabled if it was multiplexed. */
+double ReadPerfEvent(int fd) {
+  uint64_t data[3];
+  if (read(fd, data, sizeof(data)) != sizeof(data) || data[2] == 0) return 0.0;
+  return data[2] < data[1] ? static_cast<double>(data[0]) * data[1] / data[2] : data[0];
+}
+
+int GetThreadId() {
+  thread_local const int tid = static_cast<int>(syscall(SYS_gettid));
+  return tid;
+}
+
+std::vector<int> ListThreads() {
+  std::vector<int> tids;
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) return {static_cast<int>(syscall(SYS_gettid))};
+  while (dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') tids.push_back(atoi(entry->d_name));
+  }
+  closedir(dir);
+  return tids;
+}
+#endif  // DLR_PERF_COUNTERS_SUPPORTED
+
+}  // namespace
+
+namespace dlr {
+
+/*! \brief Counters opened on every thread of the process, shared by the PerfCounters of all
+ *  models.
+ */
+class PerfEventSet {
+ public:
+  /*! \brief Get the set of the process, opening it if no PerfCounters holds it. */
+  static std::shared_ptr<PerfEventSet> Get();
+  ~PerfEventSet();
+
+  bool IsAvailable(int counter) const { return available_[counter]; }
+  /*! \brief Current counts summed over the threads. */
+  std::array<double, kNumPerfCounters> Read() const;
+
+ private:
+  PerfEventSet();
+#ifdef DLR_PERF_COUNTERS_SUPPORTED
+  // File descriptors of the counters of each thread alive when the set was opened, -1 for the
+  // unavailable ones. Threads started since are counted by the counters of the thread which
+  // started them. Descriptors of threads which exited are kept, so that their counts remain.
+  std::vector<std::array<int, kNumPerfCounters>> threads_;
+#endif  // DLR_PERF_COUNTERS_SUPPORTED
+  std::array<bool, kNumPerfCounters> available_;
+};
+
+}  // namespace dlr
+
+std::shared_ptr<PerfEventSet> PerfEventSet::Get() {
+  static std::mutex mutex;
+  static std::weak_ptr<PerfEventSet> instance;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<PerfEventSet> events = instance.lock();
+  if (!events) {
+    events = std::shared_ptr<PerfEventSet>(new PerfEventSet());
+    instance = events;
+  }
+  return events;
+}
+
+PerfEventSet::PerfEventSet() {
+#ifdef DLR_PERF_COUNTERS_SUPPORTED
+  // Probe on the calling thread, then attach to every thread of the process.
+  bool any = false;
+  for (int i = 0; i < kNumPerfCounters; i++) {
+    const int fd = OpenPerfEvent(kPerfEvents[i], GetThreadId());
+    available_[i] = fd >= 0;
+    any |= available_[i];
+    if (fd >= 0) close(fd);
+  }
+  if (!any) {
+    throw dmlc::Error(std::string("Could not open performance counters: ") + strerror(errno) +
+                      ". Check /proc/sys/kernel/perf_event_paranoid.");
+  }
+  // The set is opened once, a thread started while it is being opened may be missed.
+  for (int tid : ListThreads()) {
+    std::array<int, kNumPerfCounters> fds;
+    for (int i = 0; i < kNumPerfCounters; i++) {
+      fds[i] = available_[i] ? OpenPerfEvent(kPerfEvents[i], tid) : -1;
+    }
+    threads_.push_back(fds);
+  }
+#else
+  throw dmlc::Error("Performance counters are only supported on Linux.");
+#endif  // DLR_PERF_COUNTERS_SUPPORTED
+}
+
+PerfEventSet::~PerfEventSet() {
+#ifdef DLR_PERF_COUNTERS_SUPPORTED
+  for (const auto& fds : threads_) {
+    for (int fd : fds) {
+      if (fd >= 0) close(fd);
+    }
+  }
+#endif  // DLR_PERF_COUNTERS_SUPPORTED
+}
+
+std::array<double, kNumPerfCounters> PerfEventSet::Read() const {
+  std::array<double, kNumPerfCounters> counts;
+  counts.fill(0.0);
+#ifdef DLR_PERF_COUNTERS_SUPPORTED
+  for (const auto& fds : threads_) {
+    for (int i = 0; i < kNumPerfCounters; i++) {
+      if (fds[i] >= 0) counts[i] += ReadPerfEvent(fds[i]);
+    }
+  }
+#endif  // DLR_PERF_COUNTERS_SUPPORTED
+  return counts;
+}
+
+PerfCounters::PerfCounters() : events_(PerfEventSet::Get()) { totals_.fill(0.0); }
+
+PerfCounters::~PerfCounters() {}
+
+PerfCounters::Counts PerfCounters::Start() const { return events_->Read(); }
+
+void PerfCounters::Stop(const Counts& start) {
+  const Counts end = events_->Read();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int i = 0; i < kNumPerfCounters; i++) {
+    // Scaling multiplexed counters to the time they were enabled can lower them slightly.
+    totals_[i] += std::max(0.0, end[i] - start[i]);
+  }
+  num_runs_++;
+}
+
+int64_t PerfCounters::Get(int64_t* values) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int i = 0; i < kNumPerfCounters; i++) {
+    values[i] = events_->IsAvailable(i) ? static_cast<int64_t>(totals_[i]) : -1;
+  }
+  return num_runs_;
+}
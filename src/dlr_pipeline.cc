@@ -7,6 +7,8 @@
 #include <iterator>
 #include <numeric>
 
+#include "dlr_probes.h"
+
 using namespace dlr;
 
 void PipelineModel::CheckModelsCompatibility(const DLRModelPtr& m0, const DLRModelPtr& m1,
@@ -121,8 +123,18 @@ const char* PipelineModel::GetOutputType(int index) const {
   return dlr_models_.back()->GetOutputType(index);
 }
 
+const DLRModelPtr& PipelineModel::GetStage(int index) const {
+  CHECK(index >= 0 && index < count_) << "Stage index is out of range.";
+  return dlr_models_[index];
+}
+
+void PipelineModel::EnablePerfCounters(bool enable) {
+  DLRModel::EnablePerfCounters(enable);
+  for (const DLRModelPtr& m : dlr_models_) m->EnablePerfCounters(enable);
+}
+
 void PipelineModel::Run() {
-  dlr_models_[0]->Run();
+  RunStage(0);
   for (int i = 1; i < count_; i++) {
     const DLRModelPtr prev_model = dlr_models_[i - 1];
     const DLRModelPtr curr_model = dlr_models_[i];
@@ -140,10 +152,18 @@ void PipelineModel::Run() {
       curr_model->SetInput(input_name, prev_output_shape.data(), prev_model_output,
                            prev_output_dim);
     }
-    curr_model->Run();
+    RunStage(i);
   }
 }
 
+void PipelineModel::RunStage(int index) {
+  DLRModel* model = dlr_models_[index].get();
+  const ProbeTimer timer(DLR_PROBE_ENABLED(pipeline__stage));
+  model->RunCounted();
+  DLR_PROBE(pipeline__stage, this, index, model,
+            kBackendToStr[static_cast<int>(model->GetBackend())], timer.Elapsed());
+}
+
 void PipelineModel::SetNumThreads(int threads) {
   // Try to set Number of Threads to pipeline models
   // Ignore the errors in case some of the models do not support this feature.
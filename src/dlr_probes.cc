@@ -0,0 +1,32 @@
+#include "dlr_probes.h"
+
+/* Probes of provider "dlr" and their arguments. Backends are names from kBackendToStr and
+ * durations are in nanoseconds.
+ *
+ *   load__start(const char* model_path, int dev_type)
+ *   load__done(DLRModel* model, const char* backend, uint64_t duration)
+ *   set__input(DLRModel* model, const char* backend, const char* name, int64_t size,
+ *              uint64_t duration)
+ *   run__start(DLRModel* model, const char* backend)
+ *   run__done(DLRModel* model, const char* backend, uint64_t duration)
+ *   get__output(DLRModel* model, const char* backend, int index, int64_t size, uint64_t duration)
+ *   pipeline__stage(DLRModel* pipeline, int stage, DLRModel* model, const char* backend,
+ *                   uint64_t duration)
+ *   transform__input(const int64_t* shape, int dim, uint64_t duration)
+ *   transform__output(int index, uint64_t duration)
+ *
+ * For example, to print the runs above 10 ms:
+ *   bpftrace -e 'usdt:libdlr.so:dlr:run__done /arg2 > 10000000/ { printf("%s %d us\n", str(arg1),
+ *                arg2 / 1000); }'
+ */
+#ifdef DLR_USDT
+DLR_DEFINE_PROBE(load__start);
+DLR_DEFINE_PROBE(load__done);
+DLR_DEFINE_PROBE(set__input);
+DLR_DEFINE_PROBE(run__start);
+DLR_DEFINE_PROBE(run__done);
+DLR_DEFINE_PROBE(get__output);
+DLR_DEFINE_PROBE(pipeline__stage);
+DLR_DEFINE_PROBE(transform__input);
+DLR_DEFINE_PROBE(transform__output);
+#endif  // DLR_USDT
@@ -2,14 +2,27 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iterator>
 #include <numeric>
 
+#include "dlr_data_convert.h"
+#include "dlr_fork.h"
+#include "dlr_module_cache.h"
+#include "dlr_probes.h"
+
 using namespace dlr;
 
 const std::string RelayVMModel::ENTRY_FUNCTION = "main";
 
+static ModuleCache<tvm::runtime::Module>& GetVMExecutableCache() {
+  static ModuleCache<tvm::runtime::Module> cache;
+  return cache;
+}
+
+size_t dlr::GetNumSharedRelayVMExecutables() { return GetVMExecutableCache().Size(); }
+
 void RelayVMModel::SetupVMModule(const std::vector<std::string>& files) {
   ModelPath path;
   dlr::InitModelPath(files, &path);
@@ -76,10 +89,22 @@ void RelayVMModel::SetupVMModule(const std::vector<DLRModelElem>& model_elems) {
   LoadJsonFromString(metadata_data, this->metadata_);
   ValidateDeviceTypeIfExists();
 
-  tvm::runtime::Module lib = tvm::runtime::Module::LoadFromFile(model_lib_path);
+  // Models compiled from the same library share a single loaded copy of it.
+  std::string lib_key;
+  vm_lib_ = dlr::LoadSharedTVMModule(model_lib_path, &lib_key);
+
+  // The executable (bytecode and constant pool holding the weights) is immutable once loaded, so
+  // every VM created from the same artifact shares it and only keeps its own registers and
+  // allocator. On CPU the VM uses the constants in place instead of copying them.
+  const std::string exec_key =
+      dlr::GetArtifactKey(code_data.data(), code_data.size()) + "|" + lib_key;
+  vm_executable_ = GetVMExecutableCache().GetOrLoad(exec_key, [this, &code_data]() {
+    return std::make_shared<tvm::runtime::Module>(
+        tvm::runtime::vm::Executable::Load(code_data, *vm_lib_));
+  });
+  code_data.clear();
+  code_data.shrink_to_fit();
 
-  vm_executable_ =
-      std::make_shared<tvm::runtime::Module>(tvm::runtime::vm::Executable::Load(code_data, lib));
   auto vm = tvm::runtime::make_object<tvm::runtime::vm::VirtualMachine>();
   vm->LoadExecutable(static_cast<tvm::runtime::vm::Executable*>(
       const_cast<tvm::runtime::Object*>(vm_executable_->get())));
@@ -214,52 +239,7 @@ const int64_t RelayVMModel::GetInputSize(int index) const {
 }
 
 DLDataType RelayVMModel::GetInputDLDataType(int index) {
-  auto input_type = input_types_[index];
-  DLDataType dtype;
-  dtype.lanes = 1;
-  if (input_type == "bool") {
-    dtype.code = kDLUInt;
-    dtype.bits = 1;
-  } else if (input_type == "uint8") {
-    dtype.code = kDLUInt;
-    dtype.bits = 8;
-  } else if (input_type == "int8") {
-    dtype.code = kDLInt;
-    dtype.bits = 8;
-  } else if (input_type == "uint16") {
-    dtype.code = kDLUInt;
-    dtype.bits = 16;
-  } else if (input_type == "int16") {
-    dtype.code = kDLInt;
-    dtype.bits = 16;
-  } else if (input_type == "uint32") {
-    dtype.code = kDLUInt;
-    dtype.bits = 32;
-  } else if (input_type == "int32") {
-    dtype.code = kDLInt;
-    dtype.bits = 32;
-  } else if (input_type == "uint64") {
-    dtype.code = kDLUInt;
-    dtype.bits = 64;
-  } else if (input_type == "int64") {
-    dtype.code = kDLInt;
-    dtype.bits = 64;
-  } else if (input_type == "float16") {
-    dtype.code = kDLFloat;
-    dtype.bits = 16;
-  } else if (input_type == "bfloat16") {
-    dtype.code = kDLBfloat;
-    dtype.bits = 16;
-  } else if (input_type == "float32") {
-    dtype.code = kDLFloat;
-    dtype.bits = 32;
-  } else if (input_type == "float64") {
-    dtype.code = kDLBfloat;
-    dtype.bits = 64;
-  } else {
-    throw dmlc::Error(std::string("Unknown input dtype: ") + input_type);
-  }
-  return dtype;
+  return GetDLDataTypeFromString(input_types_[index]);
 }
 
 void RelayVMModel::SetInput(const char* name, const int64_t* shape, const void* input, int dim) {
@@ -269,7 +249,9 @@ void RelayVMModel::SetInput(const char* name, const int64_t* shape, const void*
     for (size_t i = 0; i < num_inputs_; ++i) {
       dtypes.emplace_back(GetInputDLDataType(i));
     }
+    const ProbeTimer timer(DLR_PROBE_ENABLED(transform__input));
     data_transform_.TransformInput(metadata_, shape, input, dim, dtypes, ctx_, &inputs_);
+    DLR_PROBE(transform__input, shape, dim, timer.Elapsed());
     return;
   }
   int index = GetInputIndex(name);
@@ -289,6 +271,34 @@ void RelayVMModel::SetInput(const char* name, const int64_t* shape, const void*
   inputs_[index] = input_arr;
 }
 
+void RelayVMModel::SetInputTyped(const char* name, const int64_t* shape, const void* input,
+                                 int dim, const char* dtype) {
+  // Transformed inputs are parsed from JSON, not converted.
+  if (HasMetadata() && data_transform_.HasInputTransform(metadata_)) {
+    SetInput(name, shape, input, dim);
+    return;
+  }
+  const DLDataType src_dtype = GetDLDataTypeFromString(dtype);
+  int index = GetInputIndex(name);
+  DLDataType input_dtype = GetInputDLDataType(index);
+  if (IsSameDLDataType(src_dtype, input_dtype)) {
+    SetInput(name, shape, input, dim);
+    return;
+  }
+  std::vector<int64_t> arr_shape(shape, shape + dim);
+  const int64_t count = std::accumulate(shape, shape + dim, 1, std::multiplies<int64_t>());
+  tvm::runtime::NDArray host_arr =
+      tvm::runtime::NDArray::Empty(arr_shape, input_dtype, DLContext{kDLCPU, 0});
+  ConvertInputData(name, input, src_dtype, host_arr->data, input_dtype, count);
+  if (ctx_.device_type == kDLCPU) {
+    inputs_[index] = host_arr;
+  } else {
+    tvm::runtime::NDArray input_arr = tvm::runtime::NDArray::Empty(arr_shape, input_dtype, ctx_);
+    input_arr.CopyFrom(host_arr);
+    inputs_[index] = input_arr;
+  }
+}
+
 void RelayVMModel::SetInputTensor(const char* name, DLTensor* tensor) {
   // Handle string input.
   if (HasMetadata() && data_transform_.HasInputTransform(metadata_)) {
@@ -296,8 +306,10 @@ void RelayVMModel::SetInputTensor(const char* name, DLTensor* tensor) {
     for (size_t i = 0; i < num_inputs_; ++i) {
       dtypes.emplace_back(GetInputDLDataType(i));
     }
+    const ProbeTimer timer(DLR_PROBE_ENABLED(transform__input));
     data_transform_.TransformInput(metadata_, tensor->shape, tensor->data, tensor->ndim, dtypes,
                                    ctx_, &inputs_);
+    DLR_PROBE(transform__input, tensor->shape, tensor->ndim, timer.Elapsed());
     return;
   }
 
@@ -305,7 +317,22 @@ void RelayVMModel::SetInputTensor(const char* name, DLTensor* tensor) {
   if (index > -1) {
     std::vector<int64_t> arr_shape(tensor->shape, tensor->shape + tensor->ndim);
     tvm::runtime::NDArray input_arr = tvm::runtime::NDArray::Empty(arr_shape, tensor->dtype, ctx_);
-    input_arr.CopyFrom(tensor);
+    if (IsCompactTensor(*tensor)) {
+      DLTensor compact_tensor = *tensor;
+      compact_tensor.strides = nullptr;
+      input_arr.CopyFrom(&compact_tensor);
+    } else {
+      // Gather strided tensors straight into the new input array.
+      CHECK_EQ(tensor->ctx.device_type, kDLCPU) << "Strided input tensors must be on the CPU.";
+      if (ctx_.device_type == kDLCPU) {
+        CopyStridedData(*tensor, input_arr->data);
+      } else {
+        tvm::runtime::NDArray host_arr =
+            tvm::runtime::NDArray::Empty(arr_shape, tensor->dtype, DLContext{kDLCPU, 0});
+        CopyStridedData(*tensor, host_arr->data);
+        input_arr.CopyFrom(host_arr);
+      }
+    }
     inputs_[index] = input_arr;
   }
 }
@@ -329,11 +356,39 @@ void RelayVMModel::UpdateInputs() {
 }
 
 void RelayVMModel::Run() {
-  // Invoke inference
-  UpdateInputs();
-  tvm::runtime::PackedFunc invoke = vm_module_->GetFunction("invoke");
-  output_ref_ = invoke(ENTRY_FUNCTION);
-  UpdateOutputs();
+  RunBuffered([this]() {
+    // Invoke inference
+    UpdateInputs();
+    tvm::runtime::PackedFunc invoke = vm_module_->GetFunction("invoke");
+    dlr::RunForkSafe([this, &invoke]() { output_ref_ = invoke(ENTRY_FUNCTION); });
+    UpdateOutputs();
+  });
+}
+
+void RelayVMModel::RunWithStates(const std::vector<StateBinding>& bindings,
+                                 std::vector<tvm::runtime::NDArray>* states) {
+  CHECK(!HasMetadata() || !data_transform_.HasInputTransform(metadata_))
+      << "State inputs are not supported for models with input transforms.";
+  std::vector<tvm::runtime::NDArray> inputs = inputs_;
+  for (size_t i = 0; i < bindings.size(); i++) {
+    inputs_[bindings[i].input_index] = (*states)[i];
+  }
+  try {
+    Run();
+  } catch (...) {
+    inputs_ = inputs;
+    throw;
+  }
+  inputs_ = inputs;
+  for (size_t i = 0; i < bindings.size(); i++) {
+    const tvm::runtime::NDArray& output = outputs_[bindings[i].output_index];
+    const tvm::runtime::NDArray& state = (*states)[i];
+    CHECK(output->ndim == state->ndim &&
+          std::equal(state->shape, state->shape + state->ndim, output->shape))
+        << "State output " << bindings[i].output_index << " does not have the shape of input "
+        << input_names_[bindings[i].input_index];
+    (*states)[i] = output;
+  }
 }
 
 void RelayVMModel::UpdateOutputs() {
@@ -351,7 +406,9 @@ void RelayVMModel::UpdateOutputs() {
   // Apply DataTransform if needed.
   for (size_t i = 0; i < outputs_.size(); ++i) {
     if (HasMetadata() && data_transform_.HasOutputTransform(metadata_, i)) {
+      const ProbeTimer timer(DLR_PROBE_ENABLED(transform__output));
       data_transform_.TransformOutput(metadata_, i, outputs_[i]);
+      DLR_PROBE(transform__output, static_cast<int>(i), timer.Elapsed());
     }
   }
 }
@@ -0,0 +1,863 @@
+#include "dlr_serve.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#if !defined(_WIN32) && !defined(__ANDROID__)
+#define DLR_SERVE_SUPPORTED
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif  // !_WIN32 && !__ANDROID__
+
+#include "dlr_binary_io.h"
+#include "dlr_data_convert.h"
+
+using namespace dlr;
+
+namespace {
+
+// Largest message on the socket. Tensors go through shared memory, so messages stay small.
+constexpr uint32_t kMaxMessageBytes = 16 << 20;
+// Alignment of the regions of the ring and of the tensors in them.
+constexpr uint64_t kRingAlignment = 64;
+
+inline uint64_t Align(uint64_t value) {
+  return (value + kRingAlignment - 1) / kRingAlignment * kRingAlignment;
+}
+
+int64_t GetNumElements(const std::vector<int64_t>& shape) {
+  return std::accumulate(shape.begin(), shape.end(), int64_t{1}, std::multiplies<int64_t>());
+}
+
+int64_t GetElementBytes(const std::string& dtype) {
+  const DLDataType type = GetDLDataTypeFromString(dtype);
+  return (type.bits * type.lanes + 7) / 8;
+}
+
+/*! \brief Bytes of a tensor of a client, or -1 if a dimension is negative or the dimensions or
+ *  bytes exceed limit. Checked step by step, since the product of the dimensions could overflow.
+ */
+int64_t GetTensorBytes(const std::vector<int64_t>& shape, const std::string& dtype,
+                       uint64_t limit) {
+  uint64_t bytes = GetElementBytes(dtype);
+  for (int64_t d : shape) {
+    if (d < 0 || static_cast<uint64_t>(d) > limit) return -1;
+    if (d > 0 && bytes > limit / d) return -1;
+    bytes *= d;
+  }
+  return bytes;
+}
+
+std::string FormatShape(const std::vector<int64_t>& shape) {
+  std::ostringstream ss;
+  ss << "(";
+  for (size_t i = 0; i < shape.size(); i++) ss << (i > 0 ? ", " : "") << shape[i];
+  ss << ")";
+  return ss.str();
+}
+
+void WriteTensorInfo(BinaryWriter* writer, const ServeTensorInfo& tensor) {
+  writer->WriteString(tensor.name);
+  writer->WriteString(tensor.dtype);
+  writer->WriteVector(tensor.shape);
+}
+
+ServeTensorInfo ReadTensorInfo(BinaryReader* reader) {
+  ServeTensorInfo tensor;
+  tensor.name = reader->ReadString();
+  tensor.dtype = reader->ReadString();
+  tensor.shape = reader->ReadVector<int64_t>();
+  return tensor;
+}
+
+#ifdef DLR_SERVE_SUPPORTED
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif  // MSG_NOSIGNAL
+
+/*! \brief Write a message, its length first. Throws if the peer is gone.
+ *  \param passed_fd Descriptor passed to the peer along with the message, -1 for none.
+ */
+void WriteMessage(int fd, const std::string& body, int passed_fd = -1) {
+  const uint32_t length = static_cast<uint32_t>(body.size());
+  std::string message(reinterpret_cast<const char*>(&length), sizeof(length));
+  message += body;
+  for (size_t sent = 0; sent < message.size();) {
+    iovec iov = {&message[sent], message.size() - sent};
+    msghdr header = {};
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    union {
+      cmsghdr align;
+      char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    // The descriptor goes with the first bytes sent.
+    if (passed_fd >= 0 && sent == 0) {
+      std::memset(&control, 0, sizeof(control));
+      header.msg_control = control.buffer;
+      header.msg_controllen = sizeof(control.buffer);
+      cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+      std::memcpy(CMSG_DATA(cmsg), &passed_fd, sizeof(int));
+    }
+    const ssize_t ret = sendmsg(fd, &header, MSG_NOSIGNAL);
+    if (ret < 0 && errno == EINTR) continue;
+    CHECK_GT(ret, 0) << "Could not send a message: " << strerror(errno);
+    sent += ret;
+  }
+}
+
+/*! \brief Read exactly nbytes, returning false if the peer closed the socket before the first.
+ *  A descriptor passed along with the bytes is kept in passed_fd, if not null, and closed
+ *  otherwise.
+ */
+bool ReadExactly(int fd, char* data, size_t nbytes, int* passed_fd = nullptr) {
+  for (size_t received = 0; received < nbytes;) {
+    iovec iov = {data + received, nbytes - received};
+    msghdr header = {};
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    union {
+      cmsghdr align;
+      char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    header.msg_control = control.buffer;
+    header.msg_controllen = sizeof(control.buffer);
+    const ssize_t ret = recvmsg(fd, &header, 0);
+    if (ret < 0 && errno == EINTR) continue;
+    for (cmsghdr* cmsg = ret > 0 ? CMSG_FIRSTHDR(&header) : nullptr; cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&header, cmsg)) {
+      if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+      int received_fd;
+      std::memcpy(&received_fd, CMSG_DATA(cmsg), sizeof(int));
+      if (passed_fd != nullptr && *passed_fd < 0) {
+        *passed_fd = received_fd;
+      } else {
+        close(received_fd);
+      }
+    }
+    if (ret == 0 && received == 0) return false;
+    CHECK_GT(ret, 0) << "Connection lost in the middle of a message";
+    received += ret;
+  }
+  return true;
+}
+
+/*! \brief Read a message, returning false if the peer closed the socket.
+ *  \param passed_fd Set to a descriptor passed along with the message, if not null. The caller
+ *  closes it.
+ */
+bool ReadMessage(int fd, std::string* body, int* passed_fd = nullptr) {
+  uint32_t length;
+  if (!ReadExactly(fd, reinterpret_cast<char*>(&length), sizeof(length), passed_fd)) {
+    return false;
+  }
+  CHECK_LE(length, kMaxMessageBytes) << "Message of " << length << " bytes is too large";
+  body->resize(length);
+  if (length > 0) CHECK(ReadExactly(fd, &(*body)[0], length, passed_fd)) << "Connection lost";
+  return true;
+}
+
+/*! \brief Create an anonymous shared memory segment of nbytes, returning -1 on failure. */
+int CreateSharedMemory(size_t nbytes) {
+#ifdef MFD_CLOEXEC
+  int fd = memfd_create("dlr_serve", MFD_CLOEXEC);
+#else
+  // Without memfd, a segment of a random name is unlinked as soon as it is created.
+  std::random_device random_device;
+  int fd = -1;
+  for (int attempt = 0; attempt < 16 && fd < 0; attempt++) {
+    const std::string name =
+        "/dlr_serve_" + std::to_string(getpid()) + "_" + std::to_string(random_device());
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) shm_unlink(name.c_str());
+  }
+#endif  // MFD_CLOEXEC
+  if (fd >= 0 && ftruncate(fd, nbytes) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+sockaddr_un GetSocketAddress(const std::string& socket_path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  CHECK_LT(socket_path.size(), sizeof(address.sun_path)) << "Socket path is too long";
+  std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+  return address;
+}
+#endif  // DLR_SERVE_SUPPORTED
+
+}  // namespace
+
+/* ModelServer */
+
+struct ModelServer::Connection {
+  int fd;
+  char* shm = nullptr;
+  size_t shm_bytes = 0;
+  std::mutex write_mutex;
+  std::thread reader;
+  std::atomic<bool> closed{false};
+  explicit Connection(int fd) : fd(fd) {}
+  ~Connection();
+  /*! \brief Send a message, ignoring clients which went away. */
+  void Send(const std::string& body);
+};
+
+struct ModelServer::Request {
+  std::shared_ptr<Connection> connection;
+  uint64_t id;
+  std::vector<uint64_t> offsets;
+  std::vector<std::vector<int64_t>> shapes;
+  uint64_t output_offset;
+  uint64_t output_capacity;
+  int64_t rows;
+  // Whether every input has rows > 0 rows along its first dimension, so that the request can be
+  // batched with others. Other requests run on their own.
+  bool batchable;
+};
+
+struct ModelServer::Pool {
+  ServeModelInfo info;
+  std::vector<DLRModelPtr> instances;
+  int batch_timeout_us;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::shared_ptr<Request>> queue;
+  bool stopped = false;
+};
+
+#ifdef DLR_SERVE_SUPPORTED
+
+namespace {
+
+/*! \brief Whether b can be batched behind a: same inputs but for the number of rows. */
+bool CanBatch(const std::vector<std::vector<int64_t>>& a,
+              const std::vector<std::vector<int64_t>>& b) {
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].size() != b[i].size() || !std::equal(a[i].begin() + 1, a[i].end(), b[i].begin() + 1))
+      return false;
+  }
+  return true;
+}
+
+std::string MakeInferResponse(uint64_t id, const std::string& error) {
+  BinaryWriter writer;
+  writer.Write<uint32_t>(kServeInfer);
+  writer.Write<uint64_t>(id);
+  writer.WriteString(error);
+  writer.Write<uint64_t>(0);
+  return std::move(writer.buffer());
+}
+
+}  // namespace
+
+ModelServer::Connection::~Connection() {
+  if (shm != nullptr) munmap(shm, shm_bytes);
+  close(fd);
+}
+
+void ModelServer::Connection::Send(const std::string& body) {
+  std::lock_guard<std::mutex> lock(write_mutex);
+  try {
+    WriteMessage(fd, body);
+  } catch (dmlc::Error& e) {
+    LOG(INFO) << "Dropping a response: " << e.what();
+  }
+}
+
+ModelServer::~ModelServer() {
+  if (listen_fd_ >= 0) Stop();
+}
+
+void ModelServer::AddModel(const std::string& name, const std::vector<DLRModelPtr>& instances,
+                           int64_t max_batch, int batch_timeout_us) {
+  CHECK(listen_fd_ < 0) << "Models must be added before the server starts";
+  CHECK(!instances.empty()) << "Model " << name << " has no instances";
+  CHECK_GE(max_batch, 1) << "Invalid maximum batch";
+  CHECK_EQ(pools_.count(name), 0) << "Model " << name << " is already served";
+  auto pool = std::make_shared<Pool>();
+  DLRModel* model = instances[0].get();
+  for (int i = 0; i < model->GetNumInputs(); i++) {
+    pool->info.inputs.push_back(
+        {model->GetInputName(i), model->GetInputType(i), model->GetInputShape(i)});
+  }
+  for (int i = 0; i < model->GetNumOutputs(); i++) {
+    int64_t size;
+    int dim;
+    model->GetOutputSizeDim(i, &size, &dim);
+    std::vector<int64_t> shape(dim);
+    model->GetOutputShape(i, shape.data());
+    pool->info.outputs.push_back({"", model->GetOutputType(i), shape});
+  }
+  pool->info.max_batch = max_batch;
+  pool->instances = instances;
+  pool->batch_timeout_us = batch_timeout_us;
+  pools_[name] = pool;
+}
+
+void ModelServer::Start(const std::string& socket_path) {
+  CHECK(listen_fd_ < 0) << "Server is already started";
+  CHECK(!pools_.empty()) << "Server has no models";
+  const sockaddr_un address = GetSocketAddress(socket_path);
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  CHECK_GE(fd, 0) << "Could not create a socket: " << strerror(errno);
+  // A socket file left by a server which did not stop cleanly would fail bind().
+  unlink(socket_path.c_str());
+  // Only the user of the server may connect. No client can connect before listen().
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+      chmod(socket_path.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(fd, SOMAXCONN) != 0) {
+    const std::string error = strerror(errno);
+    close(fd);
+    throw dmlc::Error("Could not listen on " + socket_path + ": " + error);
+  }
+  socket_path_ = socket_path;
+  listen_fd_ = fd;
+  stopping_ = false;
+  for (auto& entry : pools_) {
+    Pool* pool = entry.second.get();
+    pool->stopped = false;
+    for (const DLRModelPtr& model : pool->instances) {
+      threads_.emplace_back(&ModelServer::RunRequests, this, pool, model.get());
+    }
+  }
+  accept_thread_ = std::thread(&ModelServer::Accept, this);
+}
+
+void ModelServer::Stop() {
+  CHECK(listen_fd_ >= 0) << "Server is not started";
+  stopping_ = true;
+  shutdown(listen_fd_, SHUT_RDWR);
+  accept_thread_.join();
+  close(listen_fd_);
+  listen_fd_ = -1;
+  unlink(socket_path_.c_str());
+
+  std::vector<std::shared_ptr<Connection>> connections;
+  {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    connections.swap(connections_);
+  }
+  for (const auto& connection : connections) shutdown(connection->fd, SHUT_RDWR);
+  for (const auto& connection : connections) connection->reader.join();
+
+  for (auto& entry : pools_) {
+    Pool* pool = entry.second.get();
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->stopped = true;
+    for (const auto& request : pool->queue) {
+      request->connection->Send(MakeInferResponse(request->id, "Server is stopping"));
+    }
+    pool->queue.clear();
+    pool->cv.notify_all();
+  }
+  for (std::thread& thread : threads_) thread.join();
+  threads_.clear();
+}
+
+void ModelServer::Accept() {
+  while (!stopping_) {
+    const int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno != EINTR && !stopping_) LOG(WARNING) << "accept() failed: " << strerror(errno);
+      continue;
+    }
+    auto connection = std::make_shared<Connection>(fd);
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    // Forget the connections whose clients went away, their readers are done.
+    for (auto it = connections_.begin(); it != connections_.end();) {
+      if ((*it)->closed) {
+        (*it)->reader.join();
+        it = connections_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    connection->reader = std::thread(&ModelServer::ReadRequests, this, connection);
+    connections_.push_back(connection);
+  }
+}
+
+void ModelServer::ReadRequests(std::shared_ptr<Connection> connection) {
+  std::string body;
+  // Descriptor of the shared memory of the client, passed along with its hello.
+  int shm_fd = -1;
+  try {
+    while (ReadMessage(connection->fd, &body, connection->shm == nullptr ? &shm_fd : nullptr)) {
+      BinaryReader reader(body.data(), body.size());
+      const uint32_t type = reader.Read<uint32_t>();
+      BinaryWriter reply;
+      reply.Write<uint32_t>(type);
+      if (type == kServeHello) {
+        CHECK(reader.Read<uint64_t>() == kServeMagic && reader.Read<uint32_t>() == kServeVersion)
+            << "Client speaks another protocol";
+        const uint64_t shm_bytes = reader.Read<uint64_t>();
+        CHECK(connection->shm == nullptr) << "Client already said hello";
+        std::string error;
+        struct stat st;
+        if (shm_fd < 0) {
+          error = "Client did not pass its shared memory";
+        } else if (fstat(shm_fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < shm_bytes) {
+          error = "Shared memory of the client is smaller than " + std::to_string(shm_bytes);
+        } else {
+          void* addr = mmap(nullptr, shm_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+          if (addr == MAP_FAILED) {
+            error = "Could not map the shared memory of the client";
+          } else {
+            connection->shm = static_cast<char*>(addr);
+            connection->shm_bytes = shm_bytes;
+          }
+        }
+        if (shm_fd >= 0) close(shm_fd);
+        shm_fd = -1;
+        reply.WriteString(error);
+        connection->Send(reply.buffer());
+        continue;
+      }
+
+      const std::string model = reader.ReadString();
+      auto it = pools_.find(model);
+      if (type == kServeModelInfo) {
+        if (it == pools_.end()) {
+          reply.WriteString("Model " + model + " is not served");
+        } else {
+          const ServeModelInfo& info = it->second->info;
+          reply.WriteString("");
+          reply.Write<uint64_t>(info.inputs.size());
+          for (const ServeTensorInfo& tensor : info.inputs) WriteTensorInfo(&reply, tensor);
+          reply.Write<uint64_t>(info.outputs.size());
+          for (const ServeTensorInfo& tensor : info.outputs) WriteTensorInfo(&reply, tensor);
+          reply.Write<int64_t>(info.max_batch);
+        }
+        connection->Send(reply.buffer());
+        continue;
+      }
+      CHECK_EQ(type, kServeInfer) << "Unknown message " << type;
+
+      auto request = std::make_shared<Request>();
+      request->connection = connection;
+      request->id = reader.Read<uint64_t>();
+      const uint64_t num_inputs = reader.Read<uint64_t>();
+      std::vector<uint64_t> nbytes;
+      for (uint64_t i = 0; i < num_inputs; i++) {
+        request->offsets.push_back(reader.Read<uint64_t>());
+        nbytes.push_back(reader.Read<uint64_t>());
+        request->shapes.push_back(reader.ReadVector<int64_t>());
+      }
+      request->output_offset = reader.Read<uint64_t>();
+      request->output_capacity = reader.Read<uint64_t>();
+      request->rows = 0;
+      request->batchable = false;
+
+      // Requests are checked against the ring here, so that runs only touch valid regions.
+      std::string error;
+      const uint64_t shm_bytes = connection->shm_bytes;
+      auto in_ring = [shm_bytes](uint64_t offset, uint64_t size) {
+        return offset <= shm_bytes && size <= shm_bytes - offset;
+      };
+      if (connection->shm == nullptr) {
+        error = "Client did not say hello";
+      } else if (it == pools_.end()) {
+        error = "Model " + model + " is not served";
+      } else if (num_inputs != it->second->info.inputs.size()) {
+        error = "Model " + model + " has " + std::to_string(it->second->info.inputs.size()) +
+                " inputs, got " + std::to_string(num_inputs);
+      } else if (!in_ring(request->output_offset, request->output_capacity)) {
+        error = "Outputs are out of the shared memory";
+      }
+      for (uint64_t i = 0; error.empty() && i < num_inputs; i++) {
+        const ServeTensorInfo& input = it->second->info.inputs[i];
+        const std::vector<int64_t>& shape = request->shapes[i];
+        const int64_t bytes = GetTensorBytes(shape, input.dtype, shm_bytes);
+        if (shape.empty() || bytes < 0) {
+          error = "Invalid shape " + FormatShape(shape) + " of input " + input.name;
+        } else if (static_cast<uint64_t>(bytes) != nbytes[i]) {
+          error = "Input " + input.name + " of shape " + FormatShape(shape) + " and type " +
+                  input.dtype + " does not have " + std::to_string(nbytes[i]) + " bytes";
+        } else if (!in_ring(request->offsets[i], nbytes[i])) {
+          error = "Input " + input.name + " is out of the shared memory";
+        }
+      }
+      if (!error.empty()) {
+        connection->Send(MakeInferResponse(request->id, error));
+        continue;
+      }
+      request->rows = request->shapes[0][0];
+      request->batchable =
+          request->rows > 0 && std::all_of(request->shapes.begin(), request->shapes.end(),
+                                           [&request](const std::vector<int64_t>& shape) {
+                                             return shape[0] == request->rows;
+                                           });
+      Pool* pool = it->second.get();
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      if (pool->stopped) {
+        connection->Send(MakeInferResponse(request->id, "Server is stopping"));
+      } else {
+        pool->queue.push_back(request);
+        pool->cv.notify_one();
+      }
+    }
+  } catch (dmlc::Error& e) {
+    LOG(WARNING) << "Closing a connection: " << e.what();
+  }
+  if (shm_fd >= 0) close(shm_fd);
+  connection->closed = true;
+}
+
+void ModelServer::RunRequests(Pool* pool, DLRModel* model) {
+  const ServeModelInfo& info = pool->info;
+  std::vector<std::vector<char>> inputs(info.inputs.size());
+  std::vector<char> output;
+  while (true) {
+    std::vector<std::shared_ptr<Request>> batch;
+    int64_t rows = 0;
+    {
+      std::unique_lock<std::mutex> lock(pool->mutex);
+      pool->cv.wait(lock, [pool]() { return pool->stopped || !pool->queue.empty(); });
+      if (pool->stopped) return;
+      batch.push_back(pool->queue.front());
+      pool->queue.pop_front();
+      rows = batch[0]->rows;
+      const auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::microseconds(pool->batch_timeout_us);
+      while (batch[0]->batchable && rows < info.max_batch) {
+        if (pool->queue.empty() &&
+            !pool->cv.wait_until(lock, deadline, [pool]() {
+              return pool->stopped || !pool->queue.empty();
+            })) {
+          break;
+        }
+        if (pool->stopped || pool->queue.empty()) break;
+        const std::shared_ptr<Request>& next = pool->queue.front();
+        if (!next->batchable || rows + next->rows > info.max_batch ||
+            !CanBatch(batch[0]->shapes, next->shapes)) {
+          break;
+        }
+        rows += next->rows;
+        batch.push_back(next);
+        pool->queue.pop_front();
+      }
+    }
+
+    try {
+      for (size_t i = 0; i < info.inputs.size(); i++) {
+        std::vector<int64_t> shape = batch[0]->shapes[i];
+        const char* data = batch[0]->connection->shm + batch[0]->offsets[i];
+        if (batch.size() > 1) {
+          // Inputs of a batch are concatenated along their first dimension.
+          const size_t row_bytes =
+              GetNumElements(shape) / shape[0] * GetElementBytes(info.inputs[i].dtype);
+          inputs[i].resize(row_bytes * rows);
+          char* dst = inputs[i].data();
+          for (const auto& request : batch) {
+            const size_t nbytes = row_bytes * request->shapes[i][0];
+            std::memcpy(dst, request->connection->shm + request->offsets[i], nbytes);
+            dst += nbytes;
+          }
+          shape[0] = rows;
+          data = inputs[i].data();
+        }
+        model->SetInput(info.inputs[i].name.c_str(), shape.data(), data, shape.size());
+      }
+      model->Run();
+
+      std::vector<uint64_t> used(batch.size(), 0);
+      std::vector<BinaryWriter> responses(batch.size());
+      for (size_t r = 0; r < batch.size(); r++) {
+        responses[r].Write<uint32_t>(kServeInfer);
+        responses[r].Write<uint64_t>(batch[r]->id);
+        responses[r].WriteString("");
+        responses[r].Write<uint64_t>(info.outputs.size());
+      }
+      for (size_t j = 0; j < info.outputs.size(); j++) {
+        int64_t size;
+        int dim;
+        model->GetOutputSizeDim(j, &size, &dim);
+        std::vector<int64_t> shape(dim);
+        model->GetOutputShape(j, shape.data());
+        const uint64_t nbytes = size * GetElementBytes(info.outputs[j].dtype);
+        if (batch.size() > 1) {
+          CHECK(!shape.empty() && shape[0] == rows)
+              << "Output " << j << " of shape " << FormatShape(shape)
+              << " cannot be split in the requests of a batch of " << rows;
+        }
+        output.resize(nbytes);
+        model->GetOutput(j, output.data());
+        const char* src = output.data();
+        for (size_t r = 0; r < batch.size(); r++) {
+          Request& request = *batch[r];
+          std::vector<int64_t> request_shape = shape;
+          if (batch.size() > 1) request_shape[0] = request.rows;
+          const uint64_t request_bytes = batch.size() > 1 ? nbytes / rows * request.rows : nbytes;
+          CHECK_LE(Align(used[r]) + request_bytes, request.output_capacity)
+              << "Outputs do not fit in the " << request.output_capacity
+              << " bytes reserved by the request";
+          const uint64_t offset = request.output_offset + Align(used[r]);
+          std::memcpy(request.connection->shm + offset, src, request_bytes);
+          src += request_bytes;
+          used[r] = Align(used[r]) + request_bytes;
+          responses[r].Write<uint64_t>(offset);
+          responses[r].Write<uint64_t>(request_bytes);
+          responses[r].WriteVector(request_shape);
+        }
+      }
+      for (size_t r = 0; r < batch.size(); r++) batch[r]->connection->Send(responses[r].buffer());
+    } catch (dmlc::Error& e) {
+      for (const auto& request : batch) {
+        request->connection->Send(MakeInferResponse(request->id, e.what()));
+      }
+    }
+  }
+}
+
+/* ServeClient */
+
+ServeClient::ServeClient(const std::string& socket_path, size_t ring_bytes)
+    : ring_bytes_(Align(ring_bytes)) {
+  CHECK_GT(ring_bytes_, 0) << "Invalid ring size";
+  const sockaddr_un address = GetSocketAddress(socket_path);
+  fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  CHECK_GE(fd_, 0) << "Could not create a socket: " << strerror(errno);
+  if (connect(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    const std::string error = strerror(errno);
+    close(fd_);
+    throw dmlc::Error("Could not connect to " + socket_path + ": " + error);
+  }
+
+  const int shm_fd = CreateSharedMemory(ring_bytes_);
+  void* addr = shm_fd < 0
+                   ? MAP_FAILED
+                   : mmap(nullptr, ring_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+  if (addr == MAP_FAILED) {
+    const std::string error = strerror(errno);
+    if (shm_fd >= 0) close(shm_fd);
+    close(fd_);
+    throw dmlc::Error("Could not create the shared memory of the client: " + error);
+  }
+  ring_ = static_cast<char*>(addr);
+
+  std::string reply;
+  try {
+    BinaryWriter hello;
+    hello.Write<uint32_t>(kServeHello);
+    hello.Write<uint64_t>(kServeMagic);
+    hello.Write<uint32_t>(kServeVersion);
+    hello.Write<uint64_t>(ring_bytes_);
+    WriteMessage(fd_, hello.buffer(), shm_fd);
+    CHECK(ReadMessage(fd_, &reply)) << "Connection closed by the server";
+  } catch (dmlc::Error&) {
+    close(shm_fd);
+    munmap(ring_, ring_bytes_);
+    close(fd_);
+    throw;
+  }
+  // Both sides have it mapped now, the descriptor is no longer needed.
+  close(shm_fd);
+  BinaryReader reader(reply.data(), reply.size());
+  reader.Read<uint32_t>();
+  const std::string error = reader.ReadString();
+  if (!error.empty()) {
+    munmap(ring_, ring_bytes_);
+    close(fd_);
+    throw dmlc::Error(error);
+  }
+}
+
+ServeClient::~ServeClient() {
+  munmap(ring_, ring_bytes_);
+  close(fd_);
+}
+
+const ServeModelInfo& ServeClient::GetModelInfo(const std::string& model) {
+  auto it = models_.find(model);
+  if (it != models_.end()) return it->second;
+  // Responses of requests in flight come first.
+  while (!regions_.empty()) ReadResponse();
+  BinaryWriter request;
+  request.Write<uint32_t>(kServeModelInfo);
+  request.WriteString(model);
+  WriteMessage(fd_, request.buffer());
+  std::string reply;
+  CHECK(ReadMessage(fd_, &reply)) << "Connection closed by the server";
+  BinaryReader reader(reply.data(), reply.size());
+  CHECK_EQ(reader.Read<uint32_t>(), kServeModelInfo) << "Unexpected response";
+  const std::string error = reader.ReadString();
+  if (!error.empty()) throw dmlc::Error(error);
+  ServeModelInfo info;
+  info.inputs.resize(reader.Read<uint64_t>());
+  for (ServeTensorInfo& tensor : info.inputs) tensor = ReadTensorInfo(&reader);
+  info.outputs.resize(reader.Read<uint64_t>());
+  for (ServeTensorInfo& tensor : info.outputs) tensor = ReadTensorInfo(&reader);
+  info.max_batch = reader.Read<int64_t>();
+  return models_[model] = info;
+}
+
+uint64_t ServeClient::Reserve(uint64_t id, size_t nbytes) {
+  nbytes = Align(nbytes);
+  CHECK_LE(nbytes, ring_bytes_) << "Request of " << nbytes << " bytes does not fit in the ring of "
+                                << ring_bytes_ << " bytes";
+  while (true) {
+    // Without requests in flight the whole ring is free, so start over at 0 rather than count the
+    // end of the ring skipped below against it.
+    if (regions_.empty()) head_ = tail_ = 0;
+    // Regions are contiguous: one which would cross the end of the ring starts over at 0.
+    const uint64_t pos = head_ % ring_bytes_;
+    const uint64_t start = pos + nbytes > ring_bytes_ ? head_ + ring_bytes_ - pos : head_;
+    if (start + nbytes - tail_ <= ring_bytes_) {
+      head_ = start + nbytes;
+      regions_.push_back({id, head_, false});
+      return start % ring_bytes_;
+    }
+    ReadResponse();
+  }
+}
+
+uint64_t ServeClient::Submit(const std::string& model, const std::vector<ServeTensor>& inputs,
+                             size_t output_bytes) {
+  const ServeModelInfo& info = GetModelInfo(model);
+  CHECK_EQ(inputs.size(), info.inputs.size())
+      << "Model " << model << " has " << info.inputs.size() << " inputs";
+  CHECK(!inputs[0].shape.empty()) << "Input 0 has no batch dimension";
+  if (output_bytes == 0) {
+    const int64_t rows = inputs[0].shape[0];
+    for (const ServeTensorInfo& output : info.outputs) {
+      CHECK(std::all_of(output.shape.begin(), output.shape.end(), [](int64_t d) { return d > 0; }))
+          << "Output of shape " << FormatShape(output.shape)
+          << " is dynamic, the room for the outputs must be given";
+      const int64_t nbytes = GetNumElements(output.shape) * GetElementBytes(output.dtype);
+      output_bytes += Align(output.shape.empty() ? nbytes : nbytes / output.shape[0] * rows);
+    }
+  }
+  size_t nbytes = output_bytes;
+  for (const ServeTensor& input : inputs) nbytes += Align(input.data.size());
+
+  const uint64_t id = next_id_++;
+  const uint64_t offset = Reserve(id, nbytes);
+  BinaryWriter request;
+  request.Write<uint32_t>(kServeInfer);
+  request.WriteString(model);
+  request.Write<uint64_t>(id);
+  request.Write<uint64_t>(inputs.size());
+  uint64_t pos = offset;
+  for (const ServeTensor& input : inputs) {
+    if (!input.data.empty()) std::memcpy(ring_ + pos, input.data.data(), input.data.size());
+    request.Write<uint64_t>(pos);
+    request.Write<uint64_t>(input.data.size());
+    request.WriteVector(input.shape);
+    pos += Align(input.data.size());
+  }
+  request.Write<uint64_t>(pos);
+  request.Write<uint64_t>(output_bytes);
+  WriteMessage(fd_, request.buffer());
+  return id;
+}
+
+void ServeClient::ReadResponse() {
+  std::string reply;
+  CHECK(ReadMessage(fd_, &reply)) << "Connection closed by the server";
+  BinaryReader reader(reply.data(), reply.size());
+  CHECK_EQ(reader.Read<uint32_t>(), kServeInfer) << "Unexpected response";
+  const uint64_t id = reader.Read<uint64_t>();
+  auto region = std::find_if(regions_.begin(), regions_.end(),
+                             [id](const Region& r) { return r.id == id && !r.done; });
+  CHECK(region != regions_.end()) << "Response to unknown request " << id;
+  Response& response = responses_[id];
+  response.error = reader.ReadString();
+  response.outputs.resize(reader.Read<uint64_t>());
+  for (ServeTensor& output : response.outputs) {
+    const uint64_t offset = reader.Read<uint64_t>();
+    const uint64_t nbytes = reader.Read<uint64_t>();
+    output.shape = reader.ReadVector<int64_t>();
+    CHECK(offset <= ring_bytes_ && nbytes <= ring_bytes_ - offset) << "Invalid response";
+    output.data.assign(ring_ + offset, ring_ + offset + nbytes);
+  }
+  // Outputs are copied out, the region can be reused once the ones before it are done.
+  region->done = true;
+  while (!regions_.empty() && regions_.front().done) {
+    tail_ = regions_.front().end;
+    regions_.pop_front();
+  }
+}
+
+std::vector<ServeTensor> ServeClient::Wait(uint64_t id) {
+  CHECK_LT(id, next_id_) << "Unknown request " << id;
+  while (responses_.count(id) == 0) {
+    CHECK(std::any_of(regions_.begin(), regions_.end(), [id](const Region& r) {
+      return r.id == id;
+    })) << "Request " << id << " was already waited for";
+    ReadResponse();
+  }
+  Response response = std::move(responses_[id]);
+  responses_.erase(id);
+  if (!response.error.empty()) throw dmlc::Error(response.error);
+  return std::move(response.outputs);
+}
+
+std::vector<ServeTensor> ServeClient::Infer(const std::string& model,
+                                            const std::vector<ServeTensor>& inputs,
+                                            size_t output_bytes) {
+  return Wait(Submit(model, inputs, output_bytes));
+}
+
+#else  // DLR_SERVE_SUPPORTED
+
+ModelServer::~ModelServer() {}
+
+void ModelServer::AddModel(const std::string& name, const std::vector<DLRModelPtr>& instances,
+                           int64_t max_batch, int batch_timeout_us) {
+  throw dmlc::Error("Serving is not supported on this platform.");
+}
+
+void ModelServer::Start(const std::string& socket_path) {
+  throw dmlc::Error("Serving is not supported on this platform.");
+}
+
+void ModelServer::Stop() {}
+
+ServeClient::ServeClient(const std::string& socket_path, size_t ring_bytes) {
+  throw dmlc::Error("Serving is not supported on this platform.");
+}
+
+ServeClient::~ServeClient() {}
+
+const ServeModelInfo& ServeClient::GetModelInfo(const std::string& model) {
+  throw dmlc::Error("Serving is not supported on this platform.");
+}
+
+uint64_t ServeClient::Reserve(uint64_t id, size_t nbytes) {
+  throw dmlc::Error("Serving is not supported on this platform.");
+}
+
+uint64_t ServeClient::Submit(const std::string& model, const std::vector<ServeTensor>& inputs,
+                             size_t output_bytes) {
+  throw dmlc::Error("Serving is not supported on this platform.");
+}
+
+void ServeClient::ReadResponse() {
+  throw dmlc::Error("Serving is not supported on this platform.");
+}
+
+std::vector<ServeTensor> ServeClient::Wait(uint64_t id) {
+  throw dmlc::Error("Serving is not supported on this platform.");
+}
+
+std::vector<ServeTensor> ServeClient::Infer(const std::string& model,
+                                            const std::vector<ServeTensor>& inputs,
+                                            size_t output_bytes) {
+  throw dmlc::Error("Serving is not supported on this platform.");
+}
+
+#endif  // DLR_SERVE_SUPPORTED
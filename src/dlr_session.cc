@@ -0,0 +1,105 @@
+#include "dlr_session.h"
+
+#include "dlr_data_convert.h"
+#include "dlr_relayvm.h"
+#include "dlr_tvm.h"
+
+using namespace dlr;
+
+namespace {
+
+// Tensor of host data with the shape and dtype of array.
+DLTensor HostTensor(const tvm::runtime::NDArray& array, const void* data) {
+  DLTensor tensor = *array.operator->();
+  tensor.data = const_cast<void*>(data);
+  tensor.ctx = DLContext{kDLCPU, 0};
+  tensor.strides = nullptr;
+  tensor.byte_offset = 0;
+  return tensor;
+}
+
+// New array of the shape, dtype and context of state, filled with a copy of host data.
+tvm::runtime::NDArray NewState(const tvm::runtime::NDArray& state, const void* data) {
+  tvm::runtime::NDArray new_state = tvm::runtime::NDArray::Empty(
+      std::vector<int64_t>(state->shape, state->shape + state->ndim), state->dtype, state->ctx);
+  DLTensor tensor = HostTensor(state, data);
+  new_state.CopyFrom(&tensor);
+  return new_state;
+}
+
+}  // namespace
+
+Session::Session(DLRModel* model,
+                 const std::vector<std::pair<std::string, std::string>>& bindings)
+    : model_(model) {
+  CHECK(model_->GetBackend() == DLRBackend::kTVM || model_->GetBackend() == DLRBackend::kRELAYVM)
+      << "Sessions are only supported for TVM and Relay VM models.";
+  for (const auto& binding : bindings) {
+    const std::string& output_name = binding.first;
+    const std::string& input_name = binding.second;
+    StateBinding state = {-1, model_->GetOutputIndex(output_name.c_str())};
+    for (int i = 0; i < model_->GetNumInputs(); i++) {
+      if (input_name == model_->GetInputName(i)) state.input_index = i;
+    }
+    CHECK_GE(state.input_index, 0) << "Invalid input node name " << input_name;
+    CHECK_GE(state.output_index, 0) << "Invalid output node name " << output_name;
+    CHECK(GetStateIndex(input_name.c_str()) < 0) << "Input " << input_name << " is bound twice";
+
+    const std::vector<int64_t>& shape = model_->GetInputShape(state.input_index);
+    CHECK(!HasNegative(shape.data(), shape.size()))
+        << "State input " << input_name << " must have a static shape";
+    CHECK_EQ(std::string(model_->GetOutputType(state.output_index)),
+             model_->GetInputType(state.input_index))
+        << "State output " << output_name << " does not have the type of input " << input_name;
+    int64_t size;
+    int dim;
+    model_->GetOutputSizeDim(state.output_index, &size, &dim);
+    std::vector<int64_t> output_shape(dim);
+    model_->GetOutputShape(state.output_index, output_shape.data());
+    // Dynamic output shapes are checked after each run.
+    CHECK(output_shape == shape || HasNegative(output_shape.data(), output_shape.size()))
+        << "State output " << output_name << " does not have the shape of input " << input_name;
+
+    bindings_.push_back(state);
+    states_.push_back(tvm::runtime::NDArray::Empty(
+        shape, GetDLDataTypeFromString(model_->GetInputType(state.input_index)),
+        model_->GetContext()));
+  }
+  Reset();
+}
+
+int Session::GetStateIndex(const char* input_name) const {
+  for (size_t i = 0; i < bindings_.size(); i++) {
+    if (std::string(input_name) == model_->GetInputName(bindings_[i].input_index)) return i;
+  }
+  return -1;
+}
+
+void Session::Run() {
+  if (model_->GetBackend() == DLRBackend::kTVM) {
+    static_cast<TVMModel*>(model_)->RunWithStates(bindings_, &states_);
+  } else {
+    static_cast<RelayVMModel*>(model_)->RunWithStates(bindings_, &states_);
+  }
+}
+
+void Session::Reset() {
+  // Relay VM states are outputs of the model once it ran, so they are replaced, not overwritten.
+  for (tvm::runtime::NDArray& state : states_) {
+    std::vector<char> zeros(tvm::runtime::GetDataSize(*state.operator->()), 0);
+    state = NewState(state, zeros.data());
+  }
+}
+
+void Session::GetState(const char* input_name, void* data) const {
+  const int index = GetStateIndex(input_name);
+  CHECK_GE(index, 0) << "Input " << input_name << " is not a state of the session";
+  DLTensor tensor = HostTensor(states_[index], data);
+  states_[index].CopyTo(&tensor);
+}
+
+void Session::SetState(const char* input_name, const void* data) {
+  const int index = GetStateIndex(input_name);
+  CHECK_GE(index, 0) << "Input " << input_name << " is not a state of the session";
+  states_[index] = NewState(states_[index], data);
+}
@@ -0,0 +1,419 @@
+#include "dlr_shared_weights.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if !defined(_WIN32) && !defined(__ANDROID__)
+#define DLR_SHARED_WEIGHTS_SUPPORTED
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#endif  // !_WIN32 && !__ANDROID__
+
+#include "dlr_binary_io.h"
+
+using namespace dlr;
+
+namespace {
+
+std::mutex store_mutex;
+// The store can be set from the environment, for applications which do not use the C API directly.
+std::string store_location =
+    getenv("DLR_SHARED_WEIGHT_STORE") != nullptr ? getenv("DLR_SHARED_WEIGHT_STORE") : "";
+
+#ifdef DLR_SHARED_WEIGHTS_SUPPORTED
+constexpr uint64_t kSharedWeightsMagic = 0x3154574853524C44;  // "DLRSHWT1"
+constexpr uint32_t kSharedWeightsVersion = 1;
+constexpr uint32_t kSegmentReady = 1;
+// How long to wait for another process to populate a segment before loading weights privately.
+constexpr std::chrono::seconds kAttachTimeout(60);
+// How long a creator may take to lock the segment it just created.
+constexpr time_t kLockGracePeriod = 2;
+
+/*! \brief Start of a segment, followed by the table of weights and their data.
+ *  The table holds a uint64 count, then {name, uint64 offset, uint64 nbytes} for each weight.
+ *
+ * The creator holds an exclusive flock() on the segment from right after creating it until it is
+ * ready, so a segment which is not ready and not locked was abandoned by a creator which died.
+ */
+struct SegmentHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t state;  // accessed atomically, set to kSegmentReady once populated
+  uint64_t size;
+  uint64_t table_offset;
+  uint64_t table_bytes;
+};
+
+struct Mapping {
+  void* addr;
+  size_t size;
+  ~Mapping() { munmap(addr, size); }
+};
+
+inline size_t Align(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+std::string GetSegmentPath(const std::string& location, const std::string& name) {
+  return location == SHARED_WEIGHTS_SHM ? "/" + name : location + "/" + name;
+}
+
+int OpenSegment(const std::string& location, const std::string& name, int flags) {
+  const std::string path = GetSegmentPath(location, name);
+  if (location == SHARED_WEIGHTS_SHM) return shm_open(path.c_str(), flags, 0644);
+  return open(path.c_str(), flags, 0644);
+}
+
+void UnlinkSegment(const std::string& location, const std::string& name) {
+  const std::string path = GetSegmentPath(location, name);
+  if (location == SHARED_WEIGHTS_SHM) {
+    shm_unlink(path.c_str());
+  } else {
+    unlink(path.c_str());
+  }
+}
+
+/*! \brief Size granularity of the segment: the page size, or the huge page size on hugetlbfs. */
+size_t GetSegmentAlignment(int fd) {
+  size_t alignment = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  struct statvfs st;
+  if (fstatvfs(fd, &st) == 0 && st.f_bsize > alignment) alignment = st.f_bsize;
+  return alignment;
+}
+
+/*! \brief Get an NDArray over a mapped segment, which keeps the mapping alive. */
+tvm::runtime::NDArray WrapMapping(const std::shared_ptr<Mapping>& mapping) {
+  struct MappingTensor {
+    std::shared_ptr<Mapping> mapping;
+    int64_t shape;
+    DLManagedTensor tensor;
+  };
+  MappingTensor* holder = new MappingTensor();
+  holder->mapping = mapping;
+  holder->shape = static_cast<int64_t>(mapping->size);
+  DLTensor& tensor = holder->tensor.dl_tensor;
+  tensor.data = mapping->addr;
+  tensor.ctx = DLContext{kDLCPU, 0};
+  tensor.ndim = 1;
+  tensor.dtype = DLDataType{kDLUInt, 8, 1};
+  tensor.shape = &holder->shape;
+  tensor.strides = nullptr;
+  tensor.byte_offset = 0;
+  holder->tensor.manager_ctx = holder;
+  holder->tensor.deleter = [](DLManagedTensor* self) {
+    delete static_cast<MappingTensor*>(self->manager_ctx);
+  };
+  return tvm::runtime::NDArray::FromDLPack(&holder->tensor);
+}
+
+/*! \brief Bind the weights listed in the table of a mapped segment. */
+std::vector<std::string> BindSegment(DLRGraphRuntime* runtime,
+                                     const std::shared_ptr<Mapping>& mapping) {
+  const SegmentHeader* header = static_cast<const SegmentHeader*>(mapping->addr);
+  CHECK_LE(header->table_offset + header->table_bytes, mapping->size)
+      << "Invalid shared weights segment.";
+  BinaryReader reader(static_cast<const char*>(mapping->addr) + header->table_offset,
+                      header->table_bytes);
+  tvm::runtime::NDArray buffer = WrapMapping(mapping);
+  std::vector<std::string> names(reader.Read<uint64_t>());
+  std::vector<std::pair<int, tvm::runtime::NDArray>> storage;
+  for (std::string& name : names) {
+    name = reader.ReadString();
+    const uint64_t offset = reader.Read<uint64_t>();
+    const uint64_t nbytes = reader.Read<uint64_t>();
+    const int index = runtime->GetInputIndex(name);
+    CHECK_GE(index, 0) << "Shared weight " << name << " is not an input of the graph.";
+    CHECK_EQ(nbytes, runtime->GetInputStorageBytes(index))
+        << "Size mismatch for shared weight " << name;
+    storage.emplace_back(index, SliceNDArray(buffer, offset, nbytes));
+  }
+  runtime->BindInputStorage(storage);
+  return names;
+}
+
+struct SegmentEntry {
+  std::string name;
+  int index;
+  uint64_t offset;
+  uint64_t nbytes;
+};
+
+/*! \brief Lay out the weights which are inputs of the graph, each aligned like the runtime's
+ *  storage. Returns the size of the segment, a multiple of alignment.
+ */
+size_t LayoutSegment(DLRGraphRuntime* runtime, const std::vector<std::string>& names,
+                     size_t alignment, std::vector<SegmentEntry>* entries) {
+  for (const std::string& name : names) {
+    const int index = runtime->GetInputIndex(name);
+    if (index >= 0) entries->push_back({name, index, 0, runtime->GetInputStorageBytes(index)});
+  }
+  size_t table_bytes = sizeof(uint64_t);
+  for (const SegmentEntry& e : *entries) table_bytes += 3 * sizeof(uint64_t) + e.name.size();
+  size_t offset = Align(sizeof(SegmentHeader) + table_bytes, DLRGraphRuntime::kStorageAlignment);
+  for (SegmentEntry& e : *entries) {
+    e.offset = offset;
+    offset = Align(offset + e.nbytes, DLRGraphRuntime::kStorageAlignment);
+  }
+  return Align(offset, alignment);
+}
+
+/*! \brief Copy the weights loaded in the runtime to a writable mapping laid out by
+ *  LayoutSegment(), mark it ready and make it read-only.
+ */
+void PopulateSegment(DLRGraphRuntime* runtime, const std::vector<SegmentEntry>& entries,
+                     const Mapping& mapping) {
+  BinaryWriter table;
+  table.Write<uint64_t>(entries.size());
+  for (const SegmentEntry& e : entries) {
+    table.WriteString(e.name);
+    table.Write<uint64_t>(e.offset);
+    table.Write<uint64_t>(e.nbytes);
+  }
+  char* base = static_cast<char*>(mapping.addr);
+  std::memcpy(base + sizeof(SegmentHeader), table.buffer().data(), table.buffer().size());
+  for (const SegmentEntry& e : entries) {
+    tvm::runtime::NDArray arr = runtime->GetInput(e.index);
+    std::memcpy(base + e.offset, static_cast<const char*>(arr->data) + arr->byte_offset,
+                tvm::runtime::GetDataSize(*arr.operator->()));
+  }
+  SegmentHeader* header = static_cast<SegmentHeader*>(mapping.addr);
+  header->magic = kSharedWeightsMagic;
+  header->version = kSharedWeightsVersion;
+  header->size = mapping.size;
+  header->table_offset = sizeof(SegmentHeader);
+  header->table_bytes = table.buffer().size();
+  __atomic_store_n(&header->state, kSegmentReady, __ATOMIC_RELEASE);
+  // Weights are read-only from now on, in this process as in the others.
+  mprotect(mapping.addr, mapping.size, PROT_READ);
+}
+
+/*! \brief Populate a new segment with the weights loaded in the runtime and bind them. */
+void CreateSegment(DLRGraphRuntime* runtime, int fd, const std::vector<std::string>& loaded) {
+  std::vector<SegmentEntry> entries;
+  const size_t size = LayoutSegment(runtime, loaded, GetSegmentAlignment(fd), &entries);
+  if (ftruncate(fd, size) != 0) {
+    throw dmlc::Error(std::string("Could not allocate shared weights: ") + strerror(errno));
+  }
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    throw dmlc::Error(std::string("Could not map shared weights: ") + strerror(errno));
+  }
+  auto mapping = std::make_shared<Mapping>(Mapping{addr, size});
+  PopulateSegment(runtime, entries, *mapping);
+  BindSegment(runtime, mapping);
+}
+
+/*! \brief Lock a segment just created and give it a header, so that attachers can tell whether
+ *  its creator is still alive.
+ */
+void LockNewSegment(int fd) {
+  if (flock(fd, LOCK_EX) != 0) {
+    throw dmlc::Error(std::string("Could not lock shared weights: ") + strerror(errno));
+  }
+  // Room for the header, with state 0 until the segment is populated.
+  if (ftruncate(fd, GetSegmentAlignment(fd)) != 0) {
+    throw dmlc::Error(std::string("Could not allocate shared weights: ") + strerror(errno));
+  }
+}
+
+/*! \brief Whether a segment which is not ready was abandoned by its creator. */
+bool IsAbandoned(int fd) {
+  // Fails while the creator holds its lock, and where flock() is not supported.
+  if (flock(fd, LOCK_SH | LOCK_NB) != 0) return false;
+  flock(fd, LOCK_UN);
+  struct stat st;
+  if (fstat(fd, &st) != 0) return false;
+  // The header is written under the lock, so the creator locked it and is gone.
+  if (static_cast<size_t>(st.st_size) >= sizeof(SegmentHeader)) return true;
+  // Otherwise the creator may not have locked it yet.
+  return time(nullptr) - st.st_ctime > kLockGracePeriod;
+}
+
+/*! \brief Unlink an abandoned segment, unless another process already replaced it. */
+void RemoveAbandoned(const std::string& location, const std::string& name, int fd) {
+  // Held until the caller closes fd, so that only one process checks and unlinks at a time.
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) return;
+  const int current_fd = OpenSegment(location, name, O_RDONLY);
+  if (current_fd < 0) return;
+  struct stat abandoned, current;
+  if (fstat(fd, &abandoned) == 0 && fstat(current_fd, &current) == 0 &&
+      abandoned.st_dev == current.st_dev && abandoned.st_ino == current.st_ino) {
+    UnlinkSegment(location, name);
+  }
+  close(current_fd);
+}
+
+/*! \brief Wait for a segment to be ready and bind it.
+ *  \return false if the segment was abandoned by its creator, and removed.
+ */
+bool AttachSegment(DLRGraphRuntime* runtime, const std::string& location,
+                   const std::string& name, std::vector<std::string>* names) {
+  const int fd = OpenSegment(location, name, O_RDONLY);
+  if (fd < 0) {
+    throw dmlc::Error("Could not open shared weights " + name + ": " + strerror(errno) + ".");
+  }
+  const auto deadline = std::chrono::steady_clock::now() + kAttachTimeout;
+  std::shared_ptr<Mapping> mapping;
+  while (!mapping) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(SegmentHeader)) {
+      void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (addr != MAP_FAILED) {
+        auto candidate = std::make_shared<Mapping>(Mapping{addr, static_cast<size_t>(st.st_size)});
+        const SegmentHeader* header = static_cast<const SegmentHeader*>(addr);
+        if (__atomic_load_n(&header->state, __ATOMIC_ACQUIRE) == kSegmentReady) {
+          if (header->magic != kSharedWeightsMagic || header->version != kSharedWeightsVersion ||
+              header->size != candidate->size) {
+            close(fd);
+            throw dmlc::Error("Invalid shared weights segment " + name + ".");
+          }
+          mapping = candidate;
+        }
+      }
+    }
+    if (!mapping) {
+      if (IsAbandoned(fd)) {
+        RemoveAbandoned(location, name, fd);
+        close(fd);
+        return false;
+      }
+      if (std::chrono::steady_clock::now() > deadline) {
+        close(fd);
+        throw dmlc::Error("Timed out waiting for shared weights " + name + " to be populated.");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  close(fd);
+  *names = BindSegment(runtime, mapping);
+  return true;
+}
+#endif  // DLR_SHARED_WEIGHTS_SUPPORTED
+
+}  // namespace
+
+void dlr::SetSharedWeightStore(const std::string& location) {
+#ifndef DLR_SHARED_WEIGHTS_SUPPORTED
+  if (!location.empty()) throw dmlc::Error("Shared weights are not supported on this platform.");
+#else
+  if (!location.empty() && location != SHARED_WEIGHTS_SHM) {
+    struct stat st;
+    if (stat(location.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+      throw dmlc::Error("Shared weight store " + location + " is not a directory.");
+    }
+  }
+#endif  // DLR_SHARED_WEIGHTS_SUPPORTED
+  std::lock_guard<std::mutex> lock(store_mutex);
+  store_location = location;
+}
+
+std::string dlr::GetSharedWeightStore() {
+  std::lock_guard<std::mutex> lock(store_mutex);
+  return store_location;
+}
+
+std::string dlr::GetSharedWeightKey(const std::string& params_path) {
+#ifndef DLR_SHARED_WEIGHTS_SUPPORTED
+  throw dmlc::Error("Shared weights are not supported on this platform.");
+#else
+  struct stat st;
+  if (stat(params_path.c_str(), &st) != 0) {
+    throw dmlc::Error("Unable to open model artifact: " + params_path);
+  }
+#ifdef __APPLE__
+  const struct timespec& mtime = st.st_mtimespec;
+#else
+  const struct timespec& mtime = st.st_mtim;
+#endif  // __APPLE__
+  std::ostringstream key;
+  key << params_path << "#" << std::hex << st.st_dev << "-" << st.st_ino << "-" << std::dec
+      << st.st_size << "-" << mtime.tv_sec << "." << mtime.tv_nsec;
+  return key.str();
+#endif  // DLR_SHARED_WEIGHTS_SUPPORTED
+}
+
+std::string dlr::GetSharedWeightSegmentName(const std::string& params_key) {
+  // Keys are "<path>#<identity of the params>", only the identity matters here.
+  return "dlr-weights-" + params_key.substr(params_key.find('#') + 1);
+}
+
+void dlr::BindReadOnlyWeights(DLRGraphRuntime* runtime, const std::vector<std::string>& names) {
+#ifndef DLR_SHARED_WEIGHTS_SUPPORTED
+  LOG(WARNING) << "Read-only weights are not supported on this platform.";
+#else
+  std::vector<SegmentEntry> entries;
+  const size_t size =
+      LayoutSegment(runtime, names, static_cast<size_t>(sysconf(_SC_PAGESIZE)), &entries);
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    throw dmlc::Error(std::string("Could not map read-only weights: ") + strerror(errno));
+  }
+  auto mapping = std::make_shared<Mapping>(Mapping{addr, size});
+  PopulateSegment(runtime, entries, *mapping);
+  BindSegment(runtime, mapping);
+#endif  // DLR_SHARED_WEIGHTS_SUPPORTED
+}
+
+std::vector<std::string> dlr::BindSharedWeights(
+    DLRGraphRuntime* runtime, const std::string& location, const std::string& params_key,
+    const std::function<std::vector<std::string>()>& load_params) {
+#ifndef DLR_SHARED_WEIGHTS_SUPPORTED
+  return load_params();
+#else
+  const std::string name = GetSharedWeightSegmentName(params_key);
+  // A segment abandoned by its creator is removed and created again, once.
+  for (int attempt = 0;; attempt++) {
+    const int fd = OpenSegment(location, name, O_RDWR | O_CREAT | O_EXCL);
+    if (fd >= 0) {
+      try {
+        LockNewSegment(fd);
+      } catch (dmlc::Error& e) {
+        UnlinkSegment(location, name);
+        close(fd);
+        LOG(WARNING) << e.what() << " Loading weights privately.";
+        return load_params();
+      }
+      std::vector<std::string> names;
+      bool loaded = false;
+      try {
+        names = load_params();
+        loaded = true;
+        CreateSegment(runtime, fd, names);
+        close(fd);
+        return names;
+      } catch (dmlc::Error& e) {
+        // Let other processes create the segment again instead of waiting for this one.
+        UnlinkSegment(location, name);
+        close(fd);
+        if (!loaded) throw;
+        LOG(WARNING) << e.what() << " Keeping weights private.";
+        return names;
+      }
+    }
+    if (errno != EEXIST) {
+      LOG(WARNING) << "Could not create shared weights " << name << ": " << strerror(errno)
+                   << ". Loading weights privately.";
+      return load_params();
+    }
+    try {
+      std::vector<std::string> names;
+      if (AttachSegment(runtime, location, name, &names)) return names;
+    } catch (dmlc::Error& e) {
+      LOG(WARNING) << e.what() << " Loading weights privately.";
+      return load_params();
+    }
+    LOG(WARNING) << "Shared weights " << name << " were abandoned by the process creating them.";
+    if (attempt > 0) return load_params();
+  }
+#endif  // DLR_SHARED_WEIGHTS_SUPPORTED
+}
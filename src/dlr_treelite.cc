@@ -4,6 +4,8 @@
 #include <cstring>
 #include <fstream>
 
+#include "dlr_module_cache.h"
+
 using namespace dlr;
 
 const std::string TreeliteModel::INPUT_NAME = "data";
@@ -31,6 +33,19 @@ std::string GetVersion(const std::string& json_path) {
   return version;
 }
 
+static std::shared_ptr<TreelitePredictor> LoadSharedTreelitePredictor(const std::string& path,
+                                                                     int num_worker_threads) {
+  static ModuleCache<TreelitePredictor> cache;
+  // The worker pool is part of the predictor, so only share it between equal thread counts.
+  const std::string key = dlr::GetArtifactKey(path) + "@" + std::to_string(num_worker_threads);
+  return cache.GetOrLoad(key, [&path, num_worker_threads]() {
+    auto predictor = std::make_shared<TreelitePredictor>();
+    CHECK_EQ(TreelitePredictorLoad(path.c_str(), num_worker_threads, &predictor->handle), 0)
+        << TreeliteGetLastError();
+    return predictor;
+  });
+}
+
 ModelPath dlr::SetTreelitePaths(const std::vector<std::string>& files) {
   ModelPath paths;
   dlr::InitModelPath(files, &paths);
@@ -51,14 +66,14 @@ void TreeliteModel::SetupTreeliteModule(const std::vector<std::string>& model_pa
   // Give a dummy input name to Treelite model.
   input_names_.push_back(INPUT_NAME);
   input_types_.push_back(INPUT_TYPE);
-  CHECK_EQ(TreelitePredictorLoad(paths.model_lib.c_str(), num_worker_threads, &treelite_model_), 0)
-      << TreeliteGetLastError();
-  CHECK_EQ(TreelitePredictorQueryNumFeature(treelite_model_, &treelite_num_feature_), 0)
+  treelite_model_ = LoadSharedTreelitePredictor(paths.model_lib, num_worker_threads);
+  std::lock_guard<std::mutex> lock(treelite_model_->mutex);
+  CHECK_EQ(TreelitePredictorQueryNumFeature(treelite_model_->handle, &treelite_num_feature_), 0)
       << TreeliteGetLastError();
   treelite_input_.reset(nullptr);
 
   size_t num_output_class;  // > 1 for multi-class classification; 1 otherwise
-  CHECK_EQ(TreelitePredictorQueryNumOutputGroup(treelite_model_, &num_output_class), 0)
+  CHECK_EQ(TreelitePredictorQueryNumOutputGroup(treelite_model_->handle, &num_output_class), 0)
       << TreeliteGetLastError();
   treelite_output_buffer_size_ = num_output_class;
   treelite_output_.empty();
@@ -68,7 +83,7 @@ void TreeliteModel::SetupTreeliteModule(const std::vector<std::string>& model_pa
   //       once.
   std::vector<TreelitePredictorEntry> tmp_in(treelite_num_feature_);
   std::vector<float> tmp_out(num_output_class);
-  CHECK_EQ(TreelitePredictorPredictInst(treelite_model_, tmp_in.data(), 0, tmp_out.data(),
+  CHECK_EQ(TreelitePredictorPredictInst(treelite_model_->handle, tmp_in.data(), 0, tmp_out.data(),
                                         &treelite_output_size_),
            0)
       << TreeliteGetLastError();
@@ -205,7 +220,8 @@ void TreeliteModel::Run() {
   size_t out_result_size;
   CHECK(treelite_input_);
   treelite_output_.resize(treelite_input_->num_row * treelite_output_buffer_size_);
-  CHECK_EQ(TreelitePredictorPredictBatch(treelite_model_, treelite_input_->handle, 1, 0, 0,
+  std::lock_guard<std::mutex> lock(treelite_model_->mutex);
+  CHECK_EQ(TreelitePredictorPredictBatch(treelite_model_->handle, treelite_input_->handle, 1, 0, 0,
                                          treelite_output_.data(), &out_result_size),
            0)
       << TreeliteGetLastError();
@@ -0,0 +1,213 @@
+#include "dlr_tuner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <thread>
+#include <utility>
+
+#include "dlr_data_convert.h"
+
+using namespace dlr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/*! \brief Set every input of the model to zeros, with a batch of batch_size rows. Other dynamic
+ *  dimensions are set to 1.
+ */
+void SetZeroInputs(DLRModel* model, int64_t batch_size) {
+  for (int i = 0; i < model->GetNumInputs(); i++) {
+    std::vector<int64_t> shape = model->GetInputShape(i);
+    CHECK(!shape.empty()) << "Input " << model->GetInputName(i) << " has no batch dimension";
+    shape[0] = batch_size;
+    int64_t size = 1;
+    for (int64_t& d : shape) {
+      if (d < 0) d = 1;
+      size *= d;
+    }
+    const DLDataType dtype = GetDLDataTypeFromString(model->GetInputType(i));
+    std::vector<char> zeros(size * ((dtype.bits * dtype.lanes + 7) / 8), 0);
+    model->SetInput(model->GetInputName(i), shape.data(), zeros.data(), shape.size());
+  }
+}
+
+/*! \brief Run each model from its own thread until the deadline and measure the requests.
+ *  The first run of each thread is a warm-up and is not measured.
+ */
+TunedConfig Measure(const std::vector<DLRModelPtr>& models, double duration) {
+  std::vector<std::vector<double>> latencies(models.size());
+  std::vector<std::exception_ptr> errors(models.size());
+  const Clock::time_point begin = Clock::now();
+  const Clock::time_point end =
+      begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < models.size(); t++) {
+    workers.emplace_back([&, t]() {
+      try {
+        models[t]->Run();
+        while (Clock::now() < end) {
+          const Clock::time_point start = Clock::now();
+          models[t]->Run();
+          latencies[t].push_back(
+              std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+  for (const std::exception_ptr& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+
+  std::vector<double> all;
+  for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  const double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+  TunedConfig result;
+  result.throughput = all.size() / elapsed;
+  if (!all.empty()) {
+    const size_t rank = static_cast<size_t>(std::ceil(0.99 * all.size()));
+    result.p99_ms = all[std::max<size_t>(rank, 1) - 1];
+  }
+  return result;
+}
+
+bool IsBetter(const TunedConfig& a, const TunedConfig& b, double max_p99_ms) {
+  if (max_p99_ms > 0) {
+    const bool a_within = a.p99_ms <= max_p99_ms;
+    const bool b_within = b.p99_ms <= max_p99_ms;
+    if (a_within != b_within) return a_within;
+    if (!a_within) return a.p99_ms < b.p99_ms;
+  }
+  return a.throughput > b.throughput;
+}
+
+}  // namespace
+
+TunerOptions dlr::GetDefaultTunerOptions() {
+  const int hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+  TunerOptions options;
+  for (int n = 1; n <= hardware_threads; n *= 2) {
+    options.instances.push_back(n);
+    options.threads.push_back(n);
+  }
+  options.max_total_threads = hardware_threads;
+  return options;
+}
+
+TunedConfig dlr::TuneModel(const std::function<DLRModelPtr()>& create, const TunerOptions& options,
+                           std::vector<TunedConfig>* results) {
+  CHECK(!options.instances.empty() && !options.threads.empty() && !options.batch_sizes.empty())
+      << "Tuner needs at least one candidate of instances, threads and batch size";
+  CHECK_GT(options.time_budget, 0) << "Invalid time budget";
+  std::vector<DLRModelPtr> models = {create()};
+  std::vector<int> threads = options.threads;
+  try {
+    models[0]->SetNumThreads(threads[0]);
+  } catch (dmlc::Error& e) {
+    LOG(WARNING) << "Number of threads is not tunable for this model: " << e.what();
+    threads.resize(1);
+  }
+  std::vector<std::pair<int, int>> combinations;
+  for (int instances : options.instances) {
+    if (instances <= 0) continue;
+    for (int num_threads : threads) {
+      if (options.max_total_threads > 0 && instances * num_threads > options.max_total_threads) {
+        continue;
+      }
+      combinations.emplace_back(instances, num_threads);
+    }
+  }
+  CHECK(!combinations.empty()) << "No combination of instances and threads to tune";
+  const double slice = options.time_budget / (combinations.size() * options.batch_sizes.size());
+
+  TunedConfig best;
+  bool found = false;
+  bool accepted = false;
+  for (int64_t batch_size : options.batch_sizes) {
+    try {
+      for (const DLRModelPtr& model : models) SetZeroInputs(model.get(), batch_size);
+    } catch (dmlc::Error& e) {
+      LOG(INFO) << "Skipping batch size " << batch_size << ": " << e.what();
+      continue;
+    }
+    accepted = true;
+    for (const auto& combination : combinations) {
+      const int instances = combination.first;
+      const int num_threads = combination.second;
+      // Instances are loaded once the sweep reaches a combination which needs them.
+      while (static_cast<int>(models.size()) < instances) {
+        models.push_back(create());
+        SetZeroInputs(models.back().get(), batch_size);
+      }
+      // Thread pools of the runtime are created by the threads running the model, which are
+      // started after the number of threads is set.
+      if (threads.size() > 1) {
+        for (int i = 0; i < instances; i++) models[i]->SetNumThreads(num_threads);
+      }
+      TunedConfig config =
+          Measure(std::vector<DLRModelPtr>(models.begin(), models.begin() + instances), slice);
+      config.instances = instances;
+      config.threads = num_threads;
+      config.batch_size = batch_size;
+      config.throughput *= batch_size;
+      if (config.throughput == 0) {
+        LOG(INFO) << "Tuner: " << instances << " instances x " << num_threads << " threads, batch "
+                  << batch_size << ": no request completed, skipping";
+        continue;
+      }
+      LOG(INFO) << "Tuner: " << instances << " instances x " << num_threads << " threads, batch "
+                << batch_size << ": " << config.throughput << " rows/s, p99 " << config.p99_ms
+                << " ms";
+      if (results != nullptr) results->push_back(config);
+      if (!found || IsBetter(config, best, options.max_p99_ms)) best = config;
+      found = true;
+    }
+  }
+  CHECK(accepted) << "The model accepts none of the batch sizes to tune";
+  CHECK(found) << "No combination completed a request within its share of the time budget";
+  return best;
+}
+
+void dlr::WriteTunedConfig(const std::string& path, const TunedConfig& config) {
+  nlohmann::json json = {{"instances", config.instances},   {"threads", config.threads},
+                         {"batch_size", config.batch_size}, {"throughput", config.throughput},
+                         {"p99_ms", config.p99_ms}};
+  std::ofstream out(path);
+  out << json.dump(2) << std::endl;
+  CHECK(out.good()) << "Could not write " << path;
+}
+
+TunedConfig dlr::ReadTunedConfig(const std::string& path) {
+  nlohmann::json json;
+  LoadJsonFromFile(path, json);
+  TunedConfig config;
+  try {
+    config.instances = json.at("instances").get<int>();
+    config.threads = json.at("threads").get<int>();
+    config.batch_size = json.at("batch_size").get<int64_t>();
+    config.throughput = json.value("throughput", 0.0);
+    config.p99_ms = json.value("p99_ms", 0.0);
+  } catch (nlohmann::json::exception& e) {
+    throw dmlc::Error("Invalid " + path + ": " + e.what());
+  }
+  return config;
+}
+
+void dlr::ApplyTunedConfig(const std::vector<std::string>& files, DLRModel* model) {
+  for (const std::string& filename : files) {
+    if (GetBasename(filename) != TUNED_CONFIG_FILE) continue;
+    const TunedConfig config = ReadTunedConfig(filename);
+    try {
+      model->SetNumThreads(config.threads);
+    } catch (dmlc::Error& e) {
+      LOG(WARNING) << "Could not apply the threads of " << filename << ": " << e.what();
+    }
+  }
+}
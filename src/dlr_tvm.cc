@@ -3,23 +3,37 @@
 #include <stdlib.h>
 #include <tvm/runtime/registry.h>
 
+#include <cstring>
 #include <fstream>
 #include <iterator>
 #include <numeric>
 
+#include "dlr_binary_graph.h"
+#include "dlr_compressed_params.h"
+#include "dlr_data_convert.h"
+#include "dlr_fork.h"
+#include "dlr_module_cache.h"
+#include "dlr_shared_weights.h"
+
 using namespace dlr;
 
 void TVMModel::SetupTVMModule(const std::vector<std::string>& files) {
   ModelPath path;
   dlr::InitModelPath(files, &path);
-  if (path.model_json.empty() || path.model_lib.empty() || path.params.empty()) {
+  if ((path.model_json.empty() && path.binary_graph.empty()) || path.model_lib.empty() ||
+      path.params.empty()) {
     throw dmlc::Error("Invalid TVM model artifact. Must have .so, .json, and .params files.");
   }
 
   std::vector<DLRModelElem> model_elems = {
-      {DLRModelElemType::TVM_GRAPH, path.model_json.c_str(), nullptr, 0},
       {DLRModelElemType::TVM_PARAMS, path.params.c_str(), nullptr, 0},
       {DLRModelElemType::TVM_LIB, path.model_lib.c_str(), nullptr, 0}};
+  if (!path.binary_graph.empty()) {
+    model_elems.push_back({DLRModelElemType::TVM_GRAPH, path.binary_graph.c_str(), nullptr, 0});
+  }
+  if (!path.model_json.empty()) {
+    model_elems.push_back({DLRModelElemType::TVM_GRAPH, path.model_json.c_str(), nullptr, 0});
+  }
   if (!path.metadata.empty()) {
     model_elems.push_back({DLRModelElemType::NEO_METADATA, path.metadata.c_str(), nullptr, 0});
   }
@@ -43,29 +57,37 @@ void TVMModel::SetupTVMModule(const std::vector<DLRModelElem>& model_elems) {
   }
 
   std::string graph_str;
-  DLRString params_str;
+  std::string binary_graph_str;
+  std::string params_path;
   const char* params_data = nullptr;
   size_t params_size = 0;
   std::string model_lib_path;
   std::string metadata_data;
   for (DLRModelElem el : model_elems) {
     if (el.type == DLRModelElemType::TVM_GRAPH) {
+      std::string graph;
       if (el.path != nullptr) {
-        graph_str = dlr::LoadFileToString(el.path);
+        graph = dlr::LoadFileToString(el.path, std::ios::in | std::ios::binary);
+      } else if (el.data != nullptr && el.data_size > 0) {
+        graph.assign(static_cast<const char*>(el.data), el.data_size);
       } else if (el.data != nullptr) {
-        graph_str = static_cast<const char*>(el.data);
+        graph = static_cast<const char*>(el.data);
       } else {
         throw dmlc::Error("Invalid TVM model element TVM_GRAPH");
       }
+      // Either a graph JSON or a binary graph, which takes precedence when both are given.
+      if (dlr::IsBinaryGraph(graph.data(), graph.size())) {
+        binary_graph_str = std::move(graph);
+      } else {
+        graph_str = std::move(graph);
+      }
     } else if (el.type == DLRModelElemType::TVM_PARAMS) {
       if (el.path != nullptr) {
-        std::ifstream pstream(el.path, std::ios::in | std::ios::binary);
-        DLRStringStream params_blob;
-        params_blob << pstream.rdbuf();
-        params_str = params_blob.str();
-        params_data = params_str.data();
-        params_size = params_str.size();
+        // Read only when loading the params, which processes sharing the weights skip.
+        params_path = el.path;
+        params_data = nullptr;
       } else if (el.data != nullptr && el.data_size > 0) {
+        params_path.clear();
         params_data = static_cast<const char*>(el.data);
         params_size = el.data_size;
       } else {
@@ -85,21 +107,82 @@ void TVMModel::SetupTVMModule(const std::vector<DLRModelElem>& model_elems) {
       }
     }
   }
-  if (graph_str.empty() || params_data == nullptr || params_size <= 0 || model_lib_path.empty()) {
+  BinaryGraph binary_graph = {};
+  bool use_binary_graph = false;
+  if (!binary_graph_str.empty()) {
+    try {
+      binary_graph = dlr::ParseBinaryGraph(binary_graph_str.data(), binary_graph_str.size());
+      use_binary_graph = true;
+    } catch (dmlc::Error& e) {
+      if (graph_str.empty()) throw;
+      LOG(WARNING) << e.what() << " Falling back to the graph JSON.";
+    }
+  }
+  if ((!use_binary_graph && graph_str.empty()) || (params_data == nullptr && params_path.empty()) ||
+      model_lib_path.empty()) {
     throw dmlc::Error("Invalid TVM model. Must have TVM_GRAPH, TVM_PARAMS and TVM_LIB elements");
   }
-  if (!metadata_data.empty()) {
+  if (use_binary_graph && !binary_graph.metadata.is_null()) {
+    // Metadata encoded in the binary graph replaces the metadata JSON.
+    this->metadata_ = std::move(binary_graph.metadata);
+    ValidateDeviceTypeIfExists();
+  } else if (!metadata_data.empty()) {
     LoadJsonFromString(metadata_data, this->metadata_);
     ValidateDeviceTypeIfExists();
   }
 
-  tvm::runtime::Module module;
-  module = tvm::runtime::Module::LoadFromFile(model_lib_path);
+  // Models compiled from the same library share a single loaded copy of it.
+  tvm_lib_ = dlr::LoadSharedTVMModule(model_lib_path);
 
-  tvm_graph_runtime_ = tvm::runtime::make_object<tvm::runtime::GraphRuntime>();
-  tvm_graph_runtime_->Init(graph_str, module, {ctx_}, nullptr);
-  dmlc::MemoryFixedSizeStream strm(const_cast<char*>(params_data), params_size);
-  tvm_graph_runtime_->LoadParams(&strm);
+  tvm_graph_runtime_ = tvm::runtime::make_object<DLRGraphRuntime>();
+  if (use_binary_graph) {
+    tvm_graph_runtime_->InitFromBinary(binary_graph.graph, binary_graph.graph_size, *tvm_lib_,
+                                       {ctx_});
+  } else {
+    tvm_graph_runtime_->Init(graph_str, *tvm_lib_, {ctx_}, nullptr);
+  }
+  DLRString params_str;
+  auto load_params = [&]() {
+    if (!params_path.empty()) {
+      std::ifstream pstream(params_path, std::ios::in | std::ios::binary);
+      DLRStringStream params_blob;
+      params_blob << pstream.rdbuf();
+      params_str = params_blob.str();
+      params_data = params_str.data();
+      params_size = params_str.size();
+      if (params_size == 0) {
+        throw dmlc::Error("Invalid TVM model element TVM_PARAMS: " + params_path + " is empty.");
+      }
+    }
+    if (dlr::IsCompressedParams(params_data, params_size)) {
+      // Chunks are decompressed in parallel straight into the parameter arrays.
+      return dlr::LoadCompressedParams(tvm_graph_runtime_.get(), params_data, params_size);
+    }
+    dmlc::MemoryFixedSizeStream strm(const_cast<char*>(params_data), params_size);
+    tvm_graph_runtime_->LoadParams(&strm);
+    return tvm_graph_runtime_->GetWeightNames();
+  };
+  const std::string shared_weight_store = dlr::GetSharedWeightStore();
+  std::vector<std::string> weight_names;
+  if (!shared_weight_store.empty() && ctx_.device_type == kDLCPU) {
+    // Processes loading the same params share one read-only copy of the weights.
+    // Params files are keyed by their identity, so that attaching never reads them.
+    const std::string params_key = params_path.empty()
+                                       ? dlr::GetArtifactKey(params_data, params_size)
+                                       : dlr::GetSharedWeightKey(params_path);
+    weight_names = dlr::BindSharedWeights(tvm_graph_runtime_.get(), shared_weight_store,
+                                          params_key, load_params);
+  } else {
+    weight_names = load_params();
+    if (dlr::IsPreforkMode() && ctx_.device_type == kDLCPU) {
+      // Keep weights off pages written after fork(), so that children share them.
+      try {
+        dlr::BindReadOnlyWeights(tvm_graph_runtime_.get(), weight_names);
+      } catch (dmlc::Error& e) {
+        LOG(WARNING) << e.what() << " Keeping weights in regular memory.";
+      }
+    }
+  }
 
   tvm_module_ = std::make_shared<tvm::runtime::Module>(tvm::runtime::Module(tvm_graph_runtime_));
 
@@ -110,7 +193,7 @@ void TVMModel::SetupTVMModule(const std::vector<DLRModelElem>& model_elems) {
     input_names.push_back(tvm_graph_runtime_->GetInputName(i));
   }
   // Get list of weights
-  weight_names_ = tvm_graph_runtime_->GetWeightNames();
+  weight_names_ = weight_names;
   num_weights_ = weight_names_.size();
   // tvm_graph_runtime_->GetInputName(*) returns both inputs and weights
   // Compute set difference to get names of inputs only
@@ -122,7 +205,7 @@ void TVMModel::SetupTVMModule(const std::vector<DLRModelElem>& model_elems) {
   num_inputs_ = input_names_.size();
   input_types_.resize(num_inputs_);
   for (int i = 0; i < num_inputs_; i++) {
-    input_types_[i] = tvm_graph_runtime_->GetInputType(i);
+    input_types_[i] = tvm_graph_runtime_->GetInputType(GetGraphInputIndex(i));
   }
 
   // Get the number of output and reserve space to save output tensor
@@ -142,14 +225,20 @@ void TVMModel::UpdateInputShapes() {
   input_shapes_.resize(num_inputs_);
   for (int i = 0; i < num_inputs_; i++) {
     std::vector<int64_t> input_shape;
-    tvm::runtime::NDArray arr = tvm_graph_runtime_->GetInput(i);
+    tvm::runtime::NDArray arr = tvm_graph_runtime_->GetInput(GetGraphInputIndex(i));
     input_shape.assign(arr->shape, arr->shape + arr->ndim);
     input_shapes_[i] = input_shape;
   }
 }
 
+int TVMModel::GetGraphInputIndex(int index) const {
+  const int graph_index = tvm_graph_runtime_->GetInputIndex(input_names_[index]);
+  CHECK_GE(graph_index, 0) << "Input " << input_names_[index] << " was not found.";
+  return graph_index;
+}
+
 std::vector<std::string> TVMModel::GetWeightNames() const {
-  return tvm_graph_runtime_->GetWeightNames();
+  return weight_names_;
 }
 
 const char* TVMModel::GetInputName(int index) const {
@@ -164,13 +253,13 @@ const char* TVMModel::GetInputType(int index) const {
 
 const int TVMModel::GetInputDim(int index) const {
   CHECK_LT(index, num_inputs_) << "Input index is out of range.";
-  tvm::runtime::NDArray arr = tvm_graph_runtime_->GetInput(index);
+  tvm::runtime::NDArray arr = tvm_graph_runtime_->GetInput(GetGraphInputIndex(index));
   return arr->ndim;
 }
 
 const int64_t TVMModel::GetInputSize(int index) const {
   CHECK_LT(index, num_inputs_) << "Input index is out of range.";
-  tvm::runtime::NDArray arr = tvm_graph_runtime_->GetInput(index);
+  tvm::runtime::NDArray arr = tvm_graph_runtime_->GetInput(GetGraphInputIndex(index));
   if (dlr::HasNegative(arr->shape, arr->ndim)) return -1;
   return std::accumulate(arr->shape, arr->shape + arr->ndim, 1, std::multiplies<int64_t>());
 }
@@ -196,6 +285,34 @@ void TVMModel::SetInput(const char* name, const int64_t* shape, const void* inpu
   UpdateInputShapes();
 }
 
+void TVMModel::SetInputTyped(const char* name, const int64_t* shape, const void* input, int dim,
+                             const char* dtype) {
+  std::string str(name);
+  int index = tvm_graph_runtime_->GetInputIndex(str);
+  CHECK_GE(index, 0) << "Input " << name << " was not found.";
+  tvm::runtime::NDArray arr = tvm_graph_runtime_->GetInput(index);
+  const DLDataType src_dtype = GetDLDataTypeFromString(dtype);
+  if (IsSameDLDataType(src_dtype, arr->dtype)) {
+    SetInput(name, shape, input, dim);
+    return;
+  }
+  int64_t read_size = std::accumulate(shape, shape + dim, 1, std::multiplies<int64_t>());
+  int64_t expected_size =
+      std::accumulate(arr->shape, arr->shape + arr->ndim, 1, std::multiplies<int64_t>());
+  CHECK_SHAPE("Mismatch found in input data size", read_size, expected_size);
+  if (arr->ctx.device_type == kDLCPU) {
+    ConvertInputData(name, input, src_dtype, static_cast<char*>(arr->data) + arr->byte_offset,
+                     arr->dtype, read_size);
+  } else {
+    std::vector<int64_t> arr_shape(arr->shape, arr->shape + arr->ndim);
+    tvm::runtime::NDArray host_arr =
+        tvm::runtime::NDArray::Empty(arr_shape, arr->dtype, DLContext{kDLCPU, 0});
+    ConvertInputData(name, input, src_dtype, host_arr->data, arr->dtype, read_size);
+    arr.CopyFrom(host_arr);
+  }
+  UpdateInputShapes();
+}
+
 void TVMModel::SetInputTensor(const char* name, DLTensor* tensor) {
   std::string str(name);
   int index = tvm_graph_runtime_->GetInputIndex(str);
@@ -207,7 +324,25 @@ void TVMModel::SetInputTensor(const char* name, DLTensor* tensor) {
     int64_t expected_size = std::accumulate(
         input_tensor.shape, input_tensor.shape + input_tensor.ndim, 1, std::multiplies<int64_t>());
     CHECK_SHAPE("Mismatch found in input data size", read_size, expected_size);
-    tvm_graph_runtime_->SetInput(index, tensor);
+    if (IsCompactTensor(*tensor)) {
+      DLTensor compact_tensor = *tensor;
+      compact_tensor.strides = nullptr;
+      tvm_graph_runtime_->SetInput(index, &compact_tensor);
+      return;
+    }
+    // Gather strided tensors straight into the input of the graph.
+    CHECK_EQ(tensor->ctx.device_type, kDLCPU) << "Strided input tensors must be on the CPU.";
+    CHECK(IsSameDLDataType(tensor->dtype, arr->dtype))
+        << "Strided input tensors must have the dtype of the input.";
+    if (arr->ctx.device_type == kDLCPU) {
+      CopyStridedData(*tensor, static_cast<char*>(arr->data) + arr->byte_offset);
+    } else {
+      std::vector<int64_t> arr_shape(arr->shape, arr->shape + arr->ndim);
+      tvm::runtime::NDArray host_arr =
+          tvm::runtime::NDArray::Empty(arr_shape, arr->dtype, DLContext{kDLCPU, 0});
+      CopyStridedData(*tensor, host_arr->data);
+      arr.CopyFrom(host_arr);
+    }
   }
 }
 
@@ -229,7 +364,61 @@ void TVMModel::SetInputTensorZeroCopy(const char* name, DLTensor* tensor) {
   for (auto i = 0; i < tensor->ndim; ++i) {
     CHECK_EQ(old_t->shape[i], tensor->shape[i]);
   }
-  tvm_graph_runtime_->SetInputZeroCopy(index, tensor);
+  CHECK(IsCompactTensor(*tensor))
+      << "Data must be contiguous for SetDLRInputTensorZeroCopy, use SetDLRInputTensor to gather "
+         "strided data.";
+  DLTensor compact_tensor = *tensor;
+  compact_tensor.strides = nullptr;
+  tvm_graph_runtime_->SetInputZeroCopy(index, &compact_tensor);
+}
+
+void TVMModel::SetInputWindow(const char* name, int axis, bool rotated) {
+  int index = tvm_graph_runtime_->GetInputIndex(name);
+  CHECK_GE(index, 0) << "Input " << name << " was not found.";
+  tvm::runtime::NDArray arr = tvm_graph_runtime_->GetInput(index);
+  CHECK_EQ(arr->ctx.device_type, kDLCPU) << "Window inputs must be on the CPU.";
+  CHECK(axis >= 0 && axis < arr->ndim) << "Invalid window axis " << axis << " for input " << name;
+  for (int i = 0; i < axis; i++) {
+    CHECK_EQ(arr->shape[i], 1) << "Dimensions of input " << name
+                               << " before the window axis must be 1.";
+  }
+  const int64_t row_size = std::accumulate(arr->shape + axis + 1, arr->shape + arr->ndim,
+                                           int64_t{1}, std::multiplies<int64_t>());
+  const size_t row_bytes = row_size * ((arr->dtype.bits * arr->dtype.lanes + 7) / 8);
+  void* data = static_cast<char*>(arr->data) + arr->byte_offset;
+  input_windows_[index].reset(
+      new InputWindow(arr->shape[axis], row_bytes, rotated ? data : nullptr));
+  BindInputWindow(index);
+}
+
+void TVMModel::AppendInputWindow(const char* name, const void* rows, int64_t count) {
+  int index = tvm_graph_runtime_->GetInputIndex(name);
+  auto it = input_windows_.find(index);
+  CHECK(it != input_windows_.end()) << "Input " << name << " is not a window.";
+  it->second->Append(rows, count);
+  BindInputWindow(index);
+}
+
+int64_t TVMModel::GetInputWindowOffset(const char* name) const {
+  int index = tvm_graph_runtime_->GetInputIndex(name);
+  auto it = input_windows_.find(index);
+  CHECK(it != input_windows_.end()) << "Input " << name << " is not a window.";
+  return it->second->GetOffset();
+}
+
+void TVMModel::BindInputWindow(int index) {
+  const InputWindow& window = *input_windows_[index];
+  tvm::runtime::NDArray arr = tvm_graph_runtime_->GetInput(index);
+  if (window.IsRotated()) {
+    // Rows are written straight to the input.
+    tvm_graph_runtime_->SetInputZeroCopy(index, const_cast<DLTensor*>(arr.operator->()));
+  } else {
+    // The window is aligned for the graph wherever it starts.
+    DLTensor view = *arr.operator->();
+    view.data = const_cast<void*>(window.GetData());
+    view.byte_offset = 0;
+    tvm_graph_runtime_->SetInputZeroCopy(index, &view);
+  }
 }
 
 void TVMModel::GetInput(const char* name, void* input) {
@@ -259,6 +448,20 @@ void TVMModel::GetOutput(int index, void* out) {
   get_output(index, &output_tensor);
 }
 
+void TVMModel::GetOutputTyped(int index, void* out, const char* dtype) {
+  CHECK_LT(index, num_outputs_) << "Output index is out of range.";
+  tvm::runtime::NDArray output = tvm_graph_runtime_->GetOutput(index);
+  const DLDataType dst_dtype = GetDLDataTypeFromString(dtype);
+  if (IsSameDLDataType(output->dtype, dst_dtype) || output->ctx.device_type != kDLCPU) {
+    DLRModel::GetOutputTyped(index, out, dtype);
+    return;
+  }
+  const int64_t count =
+      std::accumulate(output->shape, output->shape + output->ndim, 1, std::multiplies<int64_t>());
+  ConvertOutputData(index, static_cast<const char*>(output->data) + output->byte_offset,
+                    output->dtype, out, dst_dtype, count);
+}
+
 const void* TVMModel::GetOutputPtr(int index) const {
   tvm::runtime::NDArray output = tvm_graph_runtime_->GetOutput(index);
   const DLTensor* tensor = output.operator->();
@@ -296,9 +499,57 @@ const char* TVMModel::GetOutputType(int index) const {
   return output_types_[index].c_str();
 }
 
+TVMModel::~TVMModel() {
+  if (execution_group_) execution_group_->Leave(tvm_graph_runtime_.get());
+}
+
 void TVMModel::Run() {
   tvm::runtime::PackedFunc run = tvm_module_->GetFunction("run");
-  run();
+  RunBuffered([this, &run]() {
+    dlr::RunForkSafe([this, &run]() {
+      if (execution_group_) {
+        std::lock_guard<std::mutex> lock(execution_group_->GetMutex());
+        run();
+      } else {
+        run();
+      }
+    });
+  });
+}
+
+void TVMModel::RunWithStates(const std::vector<StateBinding>& bindings,
+                             std::vector<tvm::runtime::NDArray>* states) {
+  // Bindings hold DLR input indices, which differ from the input indices of the graph.
+  std::vector<int> graph_indices;
+  std::vector<tvm::runtime::NDArray> graph_inputs;
+  for (size_t i = 0; i < bindings.size(); i++) {
+    const int index = GetGraphInputIndex(bindings[i].input_index);
+    graph_indices.push_back(index);
+    graph_inputs.push_back(tvm_graph_runtime_->GetInput(index));
+    tvm_graph_runtime_->SetInputZeroCopy(index, const_cast<DLTensor*>((*states)[i].operator->()));
+  }
+  auto restore_inputs = [&]() {
+    for (size_t i = 0; i < graph_inputs.size(); i++) {
+      tvm_graph_runtime_->SetInputZeroCopy(graph_indices[i],
+                                           const_cast<DLTensor*>(graph_inputs[i].operator->()));
+    }
+  };
+  try {
+    Run();
+  } catch (...) {
+    restore_inputs();
+    throw;
+  }
+  restore_inputs();
+  for (size_t i = 0; i < bindings.size(); i++) {
+    (*states)[i].CopyFrom(tvm_graph_runtime_->GetOutput(bindings[i].output_index));
+  }
+}
+
+void TVMModel::JoinExecutionGroup(const std::shared_ptr<ExecutionGroup>& group) {
+  CHECK(!execution_group_) << "Model already belongs to an execution group.";
+  group->Join(tvm_graph_runtime_.get(), ctx_);
+  execution_group_ = group;
 }
 
 static inline int SetEnv(const char* key, const char* value) {
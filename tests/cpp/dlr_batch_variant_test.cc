@@ -0,0 +1,140 @@
+#include "dlr_batch_variant.h"
+
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+class BatchVariantTest : public ::testing::Test {
+ protected:
+  const std::string model_dir = "./resnet_batch_variants";
+  const std::string manifest = model_dir + "/dlr_batch_variants.json";
+  size_t img_size = 224 * 224 * 3;
+  const int output_size = 1001;
+
+  BatchVariantTest() {
+    mkdir(model_dir.c_str(), 0755);
+    WriteManifest(R"({"BatchVariants": [{"batch_size": 1, "path": "../resnet_v1_5_50"}]})");
+  }
+
+  ~BatchVariantTest() {
+    std::remove(manifest.c_str());
+    rmdir(model_dir.c_str());
+  }
+
+  void WriteManifest(const std::string& data) {
+    std::ofstream out(manifest, std::ios::out | std::ios::trunc);
+    out << data;
+  }
+};
+
+namespace {
+
+/*! \brief Runs of a batch as {variant, offset, count} triples. */
+std::vector<std::vector<int64_t>> PlanRuns(const std::vector<int64_t>& batch_sizes,
+                                           int64_t batch_size) {
+  std::vector<std::vector<int64_t>> runs;
+  for (const dlr::BatchVariantRun& run : dlr::PlanBatchVariantRuns(batch_sizes, batch_size)) {
+    runs.push_back({static_cast<int64_t>(run.variant), run.offset, run.count});
+  }
+  return runs;
+}
+
+}  // namespace
+
+TEST(BatchVariant, TestPlanRuns) {
+  const std::vector<int64_t> batch_sizes = {1, 4, 16};
+  // Exact fits.
+  EXPECT_EQ(PlanRuns(batch_sizes, 1), std::vector<std::vector<int64_t>>({{0, 0, 1}}));
+  EXPECT_EQ(PlanRuns(batch_sizes, 4), std::vector<std::vector<int64_t>>({{1, 0, 4}}));
+  // The smallest variant which fits, padded.
+  EXPECT_EQ(PlanRuns(batch_sizes, 3), std::vector<std::vector<int64_t>>({{1, 0, 3}}));
+  EXPECT_EQ(PlanRuns(batch_sizes, 5), std::vector<std::vector<int64_t>>({{2, 0, 5}}));
+  // No variant fits: chunks of the largest, then the rest on the smallest fit.
+  EXPECT_EQ(PlanRuns(batch_sizes, 36),
+            std::vector<std::vector<int64_t>>({{2, 0, 16}, {2, 16, 16}, {1, 32, 4}}));
+  EXPECT_EQ(PlanRuns(batch_sizes, 37),
+            std::vector<std::vector<int64_t>>({{2, 0, 16}, {2, 16, 16}, {2, 32, 5}}));
+  EXPECT_EQ(PlanRuns({8}, 20),
+            std::vector<std::vector<int64_t>>({{0, 0, 8}, {0, 8, 8}, {0, 16, 4}}));
+
+  EXPECT_THROW(PlanRuns(batch_sizes, 0), dmlc::Error);
+  EXPECT_THROW(PlanRuns({}, 1), dmlc::Error);
+}
+
+TEST_F(BatchVariantTest, TestBackend) {
+  std::vector<std::string> files = dlr::FindFiles({model_dir});
+  EXPECT_EQ(dlr::GetBackend(files), dlr::DLRBackend::kBATCHVARIANT);
+
+  DLRModelHandle handle = NULL;
+  EXPECT_EQ(CreateDLRModel(&handle, model_dir.c_str(), 1, 0), 0) << DLRGetLastError();
+  const char* backend;
+  EXPECT_EQ(GetDLRBackend(&handle, &backend), 0);
+  EXPECT_STREQ(backend, "batch_variant");
+  EXPECT_EQ(DeleteDLRModel(&handle), 0);
+}
+
+TEST_F(BatchVariantTest, TestSplitBatch) {
+  DLContext ctx = {kDLCPU, 0};
+  dlr::BatchVariantModel model(dlr::FindFiles({model_dir}), ctx);
+  EXPECT_EQ(model.GetBatchSizes(), std::vector<int64_t>({1}));
+  EXPECT_EQ(model.GetInputShape(0), std::vector<int64_t>({-1, 224, 224, 3}));
+  EXPECT_EQ(model.GetInputSize(0), -1);
+
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", img_size, 1);
+  const int64_t single_shape[4] = {1, 224, 224, 3};
+  model.SetInput("input_tensor", single_shape, img.data(), 4);
+  model.Run();
+  std::vector<float> expected(output_size);
+  model.GetOutput(1, expected.data());
+
+  const int batch_size = 3;
+  std::vector<float> batch = LoadImageAndPreprocess("cat224-3.txt", img_size, batch_size);
+  const int64_t batch_shape[4] = {batch_size, 224, 224, 3};
+  model.SetInput("input_tensor", batch_shape, batch.data(), 4);
+  model.Run();
+  int64_t size;
+  int dim;
+  model.GetOutputSizeDim(1, &size, &dim);
+  EXPECT_EQ(size, batch_size * output_size);
+  EXPECT_EQ(dim, 2);
+  std::vector<float> output(size);
+  model.GetOutput(1, output.data());
+  for (int i = 0; i < batch_size; i++) {
+    EXPECT_EQ(std::vector<float>(output.begin() + i * output_size,
+                                 output.begin() + (i + 1) * output_size),
+              expected);
+  }
+
+  const int64_t bad_shape[4] = {1, 224, 224, 4};
+  EXPECT_THROW(model.SetInput("input_tensor", bad_shape, batch.data(), 4), dmlc::Error);
+  const int64_t empty_shape[4] = {0, 224, 224, 3};
+  EXPECT_THROW(model.SetInput("input_tensor", empty_shape, batch.data(), 4), dmlc::Error);
+}
+
+TEST_F(BatchVariantTest, TestRunWithoutInput) {
+  DLContext ctx = {kDLCPU, 0};
+  dlr::BatchVariantModel model(dlr::FindFiles({model_dir}), ctx);
+  EXPECT_THROW(model.Run(), dmlc::Error);
+}
+
+TEST_F(BatchVariantTest, TestInvalidManifest) {
+  DLContext ctx = {kDLCPU, 0};
+  // The variant is compiled for batch size 1.
+  WriteManifest(R"({"BatchVariants": [{"batch_size": 4, "path": "../resnet_v1_5_50"}]})");
+  EXPECT_THROW(dlr::BatchVariantModel(dlr::FindFiles({model_dir}), ctx), dmlc::Error);
+  WriteManifest(R"({"Variants": []})");
+  EXPECT_THROW(dlr::BatchVariantModel(dlr::FindFiles({model_dir}), ctx), dmlc::Error);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
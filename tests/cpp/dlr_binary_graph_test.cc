@@ -0,0 +1,102 @@
+#include "dlr_binary_graph.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "dlr.h"
+#include "dlr_tvm.h"
+#include "test_utils.hpp"
+
+class BinaryGraphTest : public ::testing::Test {
+ protected:
+  const std::string graph_file = "./resnet_v1_5_50/compiled_model.json";
+  const std::string params_file = "./resnet_v1_5_50/compiled.params";
+  const std::string so_file = "./resnet_v1_5_50/compiled.so";
+  const std::string meta_file = "./resnet_v1_5_50/compiled.meta";
+  const int64_t input_shape[4] = {1, 224, 224, 3};
+  DLContext ctx = {kDLCPU, 0};
+  std::string graph_str;
+  std::string params_str;
+  std::string meta_str;
+
+  BinaryGraphTest() {
+    graph_str = dlr::LoadFileToString(graph_file);
+    params_str = dlr::LoadFileToString(params_file, std::ios::in | std::ios::binary);
+    meta_str = dlr::LoadFileToString(meta_file);
+  }
+
+  dlr::TVMModel* CreateModel(const std::vector<DLRModelElem>& graph_elems) {
+    std::vector<DLRModelElem> model_elems(graph_elems);
+    model_elems.push_back(
+        {DLRModelElemType::TVM_PARAMS, nullptr, params_str.data(), params_str.size()});
+    model_elems.push_back({DLRModelElemType::TVM_LIB, so_file.c_str(), nullptr, 0});
+    return new dlr::TVMModel(model_elems, ctx);
+  }
+
+  std::vector<float> Run(dlr::TVMModel* model) {
+    std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+    model->SetInput("input_tensor", input_shape, img.data(), 4);
+    model->Run();
+    int64_t size;
+    int dim;
+    model->GetOutputSizeDim(0, &size, &dim);
+    std::vector<float> output(size);
+    model->GetOutput(0, output.data());
+    return output;
+  }
+};
+
+TEST_F(BinaryGraphTest, TestLoadBinaryGraph) {
+  std::unique_ptr<dlr::TVMModel> json_model(
+      CreateModel({{DLRModelElemType::TVM_GRAPH, nullptr, graph_str.c_str(), 0},
+                   {DLRModelElemType::NEO_METADATA, nullptr, meta_str.c_str(), 0}}));
+  const std::string binary = dlr::ConvertGraphToBinary(graph_str, meta_str);
+  EXPECT_TRUE(dlr::IsBinaryGraph(binary.data(), binary.size()));
+  EXPECT_FALSE(dlr::IsBinaryGraph(graph_str.data(), graph_str.size()));
+  std::unique_ptr<dlr::TVMModel> binary_model(
+      CreateModel({{DLRModelElemType::TVM_GRAPH, nullptr, binary.data(), binary.size()}}));
+
+  EXPECT_EQ(binary_model->GetNumInputs(), json_model->GetNumInputs());
+  EXPECT_EQ(binary_model->GetNumOutputs(), json_model->GetNumOutputs());
+  EXPECT_EQ(binary_model->GetWeightNames(), json_model->GetWeightNames());
+  EXPECT_TRUE(binary_model->HasMetadata());
+  EXPECT_STREQ(binary_model->GetOutputName(0), json_model->GetOutputName(0));
+  EXPECT_EQ(Run(binary_model.get()), Run(json_model.get()));
+}
+
+TEST_F(BinaryGraphTest, TestWithoutMetadata) {
+  const std::string binary = dlr::ConvertGraphToBinary(graph_str, "");
+  EXPECT_TRUE(dlr::ParseBinaryGraph(binary.data(), binary.size()).metadata.is_null());
+  std::unique_ptr<dlr::TVMModel> model(
+      CreateModel({{DLRModelElemType::TVM_GRAPH, nullptr, binary.data(), binary.size()}}));
+  EXPECT_FALSE(model->HasMetadata());
+}
+
+TEST_F(BinaryGraphTest, TestFallbackToJson) {
+  std::string binary = dlr::ConvertGraphToBinary(graph_str, meta_str);
+  // Pretend the file was written by a newer converter.
+  binary[8] = static_cast<char>(dlr::kBinaryGraphVersion + 1);
+  EXPECT_THROW(dlr::ParseBinaryGraph(binary.data(), binary.size()), dmlc::Error);
+  EXPECT_THROW(CreateModel({{DLRModelElemType::TVM_GRAPH, nullptr, binary.data(), binary.size()}}),
+               dmlc::Error);
+  std::unique_ptr<dlr::TVMModel> model(
+      CreateModel({{DLRModelElemType::TVM_GRAPH, nullptr, binary.data(), binary.size()},
+                   {DLRModelElemType::TVM_GRAPH, nullptr, graph_str.c_str(), 0}}));
+  EXPECT_EQ(model->GetNumInputs(), 1);
+}
+
+TEST_F(BinaryGraphTest, TestTruncatedBinaryGraph) {
+  std::string binary = dlr::ConvertGraphToBinary(graph_str, meta_str);
+  binary.resize(binary.size() / 2);
+  EXPECT_THROW(dlr::ParseBinaryGraph(binary.data(), binary.size()), dmlc::Error);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
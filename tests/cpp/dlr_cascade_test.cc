@@ -0,0 +1,103 @@
+#include "dlr_cascade.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+namespace {
+
+const size_t kImageSize = 224 * 224 * 3;
+const size_t kNumClasses = 1001;
+
+std::string MakeSpec(const std::string& criterion, float threshold) {
+  return "{\"Stages\": [{\"path\": \"./resnet_v1_5_50\", \"exit\": {\"output\": 1, "
+         "\"criterion\": \"" +
+         criterion + "\", \"threshold\": " + std::to_string(threshold) +
+         "}}, {\"path\": \"./resnet_v1_5_50\"}]}";
+}
+
+std::vector<float> RunProbabilities(DLRModelHandle model, const std::vector<float>& images,
+                                    int64_t batch_size) {
+  const int64_t shape[4] = {batch_size, 224, 224, 3};
+  std::vector<float> probs(batch_size * kNumClasses);
+  if (SetDLRInput(&model, "input_tensor", shape, images.data(), 4) != 0) return {};
+  if (RunDLRModel(&model) != 0) return {};
+  if (GetDLROutput(&model, 1, probs.data()) != 0) return {};
+  return probs;
+}
+
+}  // namespace
+
+TEST(DLR, TestCascade) {
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", kImageSize, 1);
+  std::vector<float> images(img);
+  images.resize(2 * kImageSize, 0.0f);
+  images.insert(images.end(), img.begin(), img.end());
+
+  DLRModelHandle single = nullptr;
+  ASSERT_EQ(CreateDLRModel(&single, "./resnet_v1_5_50", 1, 0), 0);
+  std::vector<float> expected;
+  for (int i = 0; i < 3; i++) {
+    const std::vector<float> image(images.begin() + i * kImageSize,
+                                   images.begin() + (i + 1) * kImageSize);
+    const std::vector<float> probs = RunProbabilities(single, image, 1);
+    ASSERT_FALSE(probs.empty());
+    expected.insert(expected.end(), probs.begin(), probs.end());
+  }
+  DeleteDLRModel(&single);
+
+  DLRModelHandle cascade = nullptr;
+  ASSERT_EQ(CreateDLRCascade(&cascade, MakeSpec("max_prob", 0.0f).c_str(), 1, 0), 0);
+  const char* backend;
+  ASSERT_EQ(GetDLRBackend(&cascade, &backend), 0);
+  EXPECT_STREQ(backend, "cascade");
+  // Every row exits at the first stage.
+  EXPECT_EQ(RunProbabilities(cascade, images, 3), expected);
+  int num_stages = 0;
+  ASSERT_EQ(GetDLRCascadeExitCounts(&cascade, nullptr, &num_stages), 0);
+  ASSERT_EQ(num_stages, 2);
+  int64_t exit_counts[2];
+  ASSERT_EQ(GetDLRCascadeExitCounts(&cascade, exit_counts, &num_stages), 0);
+  EXPECT_EQ(num_stages, 2);
+  EXPECT_EQ(exit_counts[0], 3);
+  EXPECT_EQ(exit_counts[1], 0);
+  DeleteDLRModel(&cascade);
+
+  // No probability is above 2, so every row is forwarded to the last stage.
+  ASSERT_EQ(CreateDLRCascade(&cascade, MakeSpec("margin", 2.0f).c_str(), 1, 0), 0);
+  EXPECT_EQ(RunProbabilities(cascade, images, 3), expected);
+  ASSERT_EQ(GetDLRCascadeExitCounts(&cascade, exit_counts, nullptr), 0);
+  EXPECT_EQ(exit_counts[0], 0);
+  EXPECT_EQ(exit_counts[1], 3);
+  DeleteDLRModel(&cascade);
+
+  // Only the rows more confident than the midpoint exit at the first stage, the cat or the blank.
+  const float cat_max = *std::max_element(expected.begin(), expected.begin() + kNumClasses);
+  const float blank_max =
+      *std::max_element(expected.begin() + kNumClasses, expected.begin() + 2 * kNumClasses);
+  ASSERT_NE(cat_max, blank_max);
+  const float threshold = (cat_max + blank_max) / 2;
+  ASSERT_EQ(CreateDLRCascade(&cascade, MakeSpec("max_prob", threshold).c_str(), 1, 0), 0);
+  EXPECT_EQ(RunProbabilities(cascade, images, 3), expected);
+  ASSERT_EQ(GetDLRCascadeExitCounts(&cascade, exit_counts, nullptr), 0);
+  EXPECT_EQ(exit_counts[0], cat_max > blank_max ? 2 : 1);
+  EXPECT_EQ(exit_counts[1], cat_max > blank_max ? 1 : 2);
+  DeleteDLRModel(&cascade);
+
+  EXPECT_EQ(CreateDLRCascade(&cascade, MakeSpec("entropy", 0.5f).c_str(), 1, 0), -1);
+  EXPECT_EQ(CreateDLRCascade(&cascade, "{\"Stages\": [{\"path\": \"./resnet_v1_5_50\"}, "
+                                       "{\"path\": \"./resnet_v1_5_50\"}]}",
+                             1, 0),
+            -1);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
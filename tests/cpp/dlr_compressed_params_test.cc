@@ -0,0 +1,129 @@
+#include "dlr_compressed_params.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "dlr.h"
+#include "dlr_data_convert.h"
+#include "dlr_tvm.h"
+#include "test_utils.hpp"
+
+class CompressedParamsTest : public ::testing::Test {
+ protected:
+  const std::string graph_file = "./resnet_v1_5_50/compiled_model.json";
+  const std::string params_file = "./resnet_v1_5_50/compiled.params";
+  const std::string so_file = "./resnet_v1_5_50/compiled.so";
+  const int64_t input_shape[4] = {1, 224, 224, 3};
+  DLContext ctx = {kDLCPU, 0};
+  std::string graph_str;
+  std::string params_str;
+
+  CompressedParamsTest() {
+    graph_str = dlr::LoadFileToString(graph_file);
+    params_str = dlr::LoadFileToString(params_file, std::ios::in | std::ios::binary);
+  }
+
+  std::vector<float> RunModel(const std::string& params) {
+    std::vector<DLRModelElem> model_elems = {
+        {DLRModelElemType::TVM_GRAPH, nullptr, graph_str.c_str(), 0},
+        {DLRModelElemType::TVM_PARAMS, nullptr, params.data(), params.size()},
+        {DLRModelElemType::TVM_LIB, so_file.c_str(), nullptr, 0}};
+    dlr::TVMModel model(model_elems, ctx);
+    // Parameters must not be reported as inputs.
+    EXPECT_EQ(model.GetNumInputs(), 1);
+    EXPECT_EQ(model.GetWeightNames().size(), static_cast<size_t>(model.GetNumWeights()));
+    std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+    model.SetInput("input_tensor", input_shape, img.data(), 4);
+    model.Run();
+    int64_t size;
+    int dim;
+    model.GetOutputSizeDim(0, &size, &dim);
+    std::vector<float> output(size);
+    model.GetOutput(0, output.data());
+    return output;
+  }
+
+  std::vector<dlr::ParamsCodec> SupportedCodecs() {
+    std::vector<dlr::ParamsCodec> codecs;
+    for (auto codec : {dlr::ParamsCodec::kNone, dlr::ParamsCodec::kZSTD, dlr::ParamsCodec::kLZ4}) {
+      if (dlr::IsParamsCodecSupported(codec)) codecs.push_back(codec);
+    }
+    return codecs;
+  }
+};
+
+TEST_F(CompressedParamsTest, TestParseParams) {
+  std::vector<dlr::ParamsTensor> tensors = dlr::ParseParams(params_str.data(), params_str.size());
+  EXPECT_FALSE(tensors.empty());
+  for (const dlr::ParamsTensor& tensor : tensors) {
+    EXPECT_FALSE(tensor.name.empty());
+    EXPECT_GE(tensor.data, params_str.data());
+    EXPECT_LE(tensor.data + tensor.nbytes, params_str.data() + params_str.size());
+  }
+  EXPECT_FALSE(dlr::IsCompressedParams(params_str.data(), params_str.size()));
+  EXPECT_THROW(dlr::ParseParams(params_str.data(), params_str.size() / 2), dmlc::Error);
+}
+
+TEST_F(CompressedParamsTest, TestFileNames) {
+  EXPECT_TRUE(dlr::IsParamsFile("model/compiled.params"));
+  EXPECT_TRUE(dlr::IsParamsFile("model/compiled.params.zst"));
+  EXPECT_TRUE(dlr::IsParamsFile("model/compiled.params.lz4"));
+  EXPECT_FALSE(dlr::IsParamsFile("model/compiled.json"));
+  EXPECT_EQ(dlr::GetParamsCodecFromFilename("compiled.params.zst"), dlr::ParamsCodec::kZSTD);
+  EXPECT_EQ(dlr::GetParamsCodecFromFilename("compiled.params.lz4"), dlr::ParamsCodec::kLZ4);
+  EXPECT_EQ(dlr::GetBackend({"m/compiled.so", "m/compiled.json", "m/compiled.params.zst"}),
+            dlr::DLRBackend::kTVM);
+}
+
+TEST_F(CompressedParamsTest, TestLoadCompressedParams) {
+  const std::vector<float> expected = RunModel(params_str);
+  std::vector<dlr::ParamsTensor> tensors = dlr::ParseParams(params_str.data(), params_str.size());
+  for (dlr::ParamsCodec codec : SupportedCodecs()) {
+    // Small chunks so that large tensors are split across threads.
+    std::string compressed = dlr::CompressParams(tensors, codec, 64 * 1024);
+    EXPECT_TRUE(dlr::IsCompressedParams(compressed.data(), compressed.size()));
+    EXPECT_EQ(RunModel(compressed), expected);
+  }
+}
+
+TEST_F(CompressedParamsTest, TestTruncatedCompressedParams) {
+  std::vector<dlr::ParamsTensor> tensors = dlr::ParseParams(params_str.data(), params_str.size());
+  std::string compressed = dlr::CompressParams(tensors, dlr::ParamsCodec::kNone, 64 * 1024);
+  compressed.resize(compressed.size() - 1);
+  EXPECT_THROW(RunModel(compressed), dmlc::Error);
+}
+
+TEST_F(CompressedParamsTest, TestReadParamsHeaders) {
+  std::vector<dlr::ParamsTensor> tensors = dlr::ParseParams(params_str.data(), params_str.size());
+  auto expect_headers = [&tensors](const std::vector<dlr::ParamsTensor>& headers) {
+    ASSERT_EQ(headers.size(), tensors.size());
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      EXPECT_EQ(headers[i].name, tensors[i].name);
+      EXPECT_TRUE(dlr::IsSameDLDataType(headers[i].dtype, tensors[i].dtype));
+      EXPECT_EQ(headers[i].shape, tensors[i].shape);
+      EXPECT_EQ(headers[i].nbytes, tensors[i].nbytes);
+      EXPECT_EQ(headers[i].data, nullptr);
+    }
+  };
+  expect_headers(dlr::ReadParamsHeaders(params_file));
+
+  const std::string compressed_file = "compressed_headers.params.zst";
+  {
+    std::ofstream out(compressed_file, std::ios::binary);
+    out << dlr::CompressParams(tensors, dlr::ParamsCodec::kNone, 64 * 1024);
+  }
+  expect_headers(dlr::ReadParamsHeaders(compressed_file));
+  std::remove(compressed_file.c_str());
+  EXPECT_THROW(dlr::ReadParamsHeaders(graph_file), dmlc::Error);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
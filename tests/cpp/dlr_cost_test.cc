@@ -0,0 +1,82 @@
+#include "dlr_cost.h"
+
+#include <gtest/gtest.h>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+namespace {
+
+// data[1, 3, 8, 8] -> conv2d with weight[4, 3, 3, 3] -> [1, 4, 8, 8] -> relu -> [1, 4, 8, 8]
+const char* kGraph = R"({
+  "nodes": [
+    {"op": "null", "name": "data", "inputs": []},
+    {"op": "null", "name": "weight", "inputs": []},
+    {"op": "tvm_op", "name": "conv", "inputs": [[0, 0, 0], [1, 0, 0]],
+     "attrs": {"func_name": "fused_nn_conv2d", "num_inputs": "2", "num_outputs": "1",
+               "flatten_data": "0"}},
+    {"op": "tvm_op", "name": "relu", "inputs": [[2, 0, 0]],
+     "attrs": {"func_name": "fused_nn_relu", "num_inputs": "1", "num_outputs": "1",
+               "flatten_data": "0"}}
+  ],
+  "arg_nodes": [0, 1],
+  "node_row_ptr": [0, 1, 2, 3, 4],
+  "heads": [[3, 0, 0]],
+  "attrs": {
+    "dltype": ["list_str", ["float32", "float32", "float32", "float32"]],
+    "storage_id": ["list_int", [0, 1, 2, 0]],
+    "shape": ["list_shape", [[1, 3, 8, 8], [4, 3, 3, 3], [1, 4, 8, 8], [1, 4, 8, 8]]]
+  }
+})";
+
+}  // namespace
+
+TEST(ModelCost, TestGraphCost) {
+  const nlohmann::json graph = nlohmann::json::parse(kGraph);
+  dlr::ParamsTensor weight;
+  weight.name = "weight";
+  weight.shape = {4, 3, 3, 3};
+  weight.nbytes = 4 * 3 * 3 * 3 * 4;
+  weight.data = nullptr;
+
+  const dlr::ModelCost cost = dlr::EstimateGraphCost(graph, {weight});
+  EXPECT_EQ(cost.backend, dlr::DLRBackend::kTVM);
+  // 2 FLOPs per multiply-add of the convolution, 1 per output of the relu.
+  EXPECT_EQ(cost.flops, 2 * (4 * 8 * 8) * (3 * 3 * 3) + 4 * 8 * 8);
+  EXPECT_EQ(cost.weight_bytes, 4 * 3 * 3 * 3 * 4);
+  // The relu output reuses the storage of the input, which is large enough for it.
+  EXPECT_EQ(cost.activation_bytes, (4 * 8 * 8 + 4 * 8 * 8) * 4);
+  EXPECT_EQ(cost.peak_memory_bytes, cost.weight_bytes + cost.activation_bytes);
+
+  // Without params, the weight is an input.
+  const dlr::ModelCost no_params = dlr::EstimateGraphCost(graph, {});
+  EXPECT_EQ(no_params.weight_bytes, 0);
+  EXPECT_EQ(no_params.activation_bytes, cost.activation_bytes + cost.weight_bytes);
+
+  nlohmann::json invalid = graph;
+  invalid["node_row_ptr"] = {0, 1};
+  EXPECT_THROW(dlr::EstimateGraphCost(invalid, {}), dmlc::Error);
+  invalid.erase("attrs");
+  EXPECT_THROW(dlr::EstimateGraphCost(invalid, {}), dmlc::Error);
+}
+
+TEST(ModelCost, TestCAPI) {
+  DLRModelCost cost;
+  ASSERT_EQ(EstimateDLRModelCost("./resnet_v1_5_50", &cost), 0);
+  // ResNet-50 has about 4 billion multiply-adds and 25 million float32 weights.
+  EXPECT_GT(cost.flops, 6e9);
+  EXPECT_LT(cost.flops, 1.2e10);
+  EXPECT_GT(cost.weight_bytes, 90e6);
+  EXPECT_LT(cost.weight_bytes, 110e6);
+  EXPECT_GE(cost.activation_bytes, 224 * 224 * 3 * 4 + 1001 * 4);
+  EXPECT_EQ(cost.peak_memory_bytes, cost.weight_bytes + cost.activation_bytes);
+  EXPECT_EQ(EstimateDLRModelCost("./no_such_model", &cost), -1);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,79 @@
+#include "dlr_cpu_features.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "dlr.h"
+
+namespace {
+
+std::vector<std::string> Sorted(std::vector<std::string> files) {
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+}  // namespace
+
+TEST(CPUFeatures, TestDetectedFeaturesAreKnownTags) {
+  for (const std::string& feature : dlr::GetCPUFeatures()) {
+    EXPECT_TRUE(std::any_of(std::begin(dlr::CPU_VARIANT_TAGS), std::end(dlr::CPU_VARIANT_TAGS),
+                            [&feature](const char* tag) { return feature == tag; }))
+        << feature;
+  }
+  const char* features;
+  EXPECT_EQ(GetDLRCPUFeatures(&features), 0);
+  EXPECT_NE(features, nullptr);
+}
+
+TEST(CPUFeatures, TestNoVariants) {
+  std::vector<std::string> files = {"m/compiled.so", "m/compiled.json", "m/compiled.params",
+                                    "m/compiled.meta"};
+  std::string tag = "unset";
+  EXPECT_EQ(dlr::SelectCPUVariant(files, {"avx2"}, &tag), files);
+  EXPECT_EQ(tag, "");
+}
+
+TEST(CPUFeatures, TestSelectBestVariant) {
+  std::vector<std::string> files = {"m/compiled.so",       "m/compiled.avx2.so",
+                                    "m/compiled.avx512.so", "m/compiled.json",
+                                    "m/compiled.params",   "m/compiled.meta"};
+  std::string tag;
+  EXPECT_EQ(Sorted(dlr::SelectCPUVariant(files, {"avx512", "avx2", "avx"}, &tag)),
+            Sorted({"m/compiled.avx512.so", "m/compiled.json", "m/compiled.params",
+                    "m/compiled.meta"}));
+  EXPECT_EQ(tag, "avx512");
+  EXPECT_EQ(Sorted(dlr::SelectCPUVariant(files, {"avx2", "avx"}, &tag)),
+            Sorted({"m/compiled.avx2.so", "m/compiled.json", "m/compiled.params",
+                    "m/compiled.meta"}));
+  EXPECT_EQ(tag, "avx2");
+  // Falls back to the untagged library.
+  EXPECT_EQ(Sorted(dlr::SelectCPUVariant(files, {"neon"}, &tag)),
+            Sorted({"m/compiled.so", "m/compiled.json", "m/compiled.params", "m/compiled.meta"}));
+  EXPECT_EQ(tag, "");
+}
+
+TEST(CPUFeatures, TestTaggedGraphAndParams) {
+  std::vector<std::string> files = {"m/compiled.so",          "m/compiled.json",
+                                    "m/compiled.params",      "m/compiled.neon.so",
+                                    "m/compiled.neon.params", "m/model-shapes.json"};
+  std::string tag;
+  EXPECT_EQ(Sorted(dlr::SelectCPUVariant(files, {"dotprod", "neon"}, &tag)),
+            Sorted({"m/compiled.neon.so", "m/compiled.json", "m/compiled.neon.params",
+                    "m/model-shapes.json"}));
+  EXPECT_EQ(tag, "neon");
+}
+
+TEST(CPUFeatures, TestNoSupportedVariant) {
+  std::vector<std::string> files = {"m/compiled.avx512.so", "m/compiled.json",
+                                    "m/compiled.params"};
+  EXPECT_THROW(dlr::SelectCPUVariant(files, {"avx2"}, nullptr), dmlc::Error);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
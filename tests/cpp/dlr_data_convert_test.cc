@@ -0,0 +1,206 @@
+#include "dlr_data_convert.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include "dlr.h"
+#include "dlr_tvm.h"
+#include "test_utils.hpp"
+
+namespace {
+
+const DLDataType kFloat64 = {kDLFloat, 64, 1};
+const DLDataType kFloat32 = {kDLFloat, 32, 1};
+const DLDataType kFloat16 = {kDLFloat, 16, 1};
+const DLDataType kBFloat16 = {kDLBfloat, 16, 1};
+const DLDataType kInt32 = {kDLInt, 32, 1};
+const DLDataType kUInt8 = {kDLUInt, 8, 1};
+
+}  // namespace
+
+TEST(DataConvert, TestGetDLDataTypeFromString) {
+  EXPECT_TRUE(dlr::IsSameDLDataType(dlr::GetDLDataTypeFromString("float64"), kFloat64));
+  EXPECT_TRUE(dlr::IsSameDLDataType(dlr::GetDLDataTypeFromString("bfloat16"), kBFloat16));
+  EXPECT_TRUE(dlr::IsSameDLDataType(dlr::GetDLDataTypeFromString("uint8"), kUInt8));
+  EXPECT_THROW(dlr::GetDLDataTypeFromString("float8"), dmlc::Error);
+  EXPECT_FALSE(dlr::IsConvertibleDLDataType(dlr::GetDLDataTypeFromString("bool")));
+}
+
+TEST(DataConvert, TestFloat16) {
+  // Long enough for the vectorized loop and its remainder.
+  const std::vector<float> values = {0.0f,       -0.0f,    1.0f,  -2.5f, 65504.0f,
+                                     65520.0f,   1e-7f,    6e-8f, 1.0009765f, 3.14159f,
+                                     1e-3f,      -7.0f,    std::numeric_limits<float>::infinity()};
+  const std::vector<uint16_t> expected = {0x0000, 0x8000, 0x3C00, 0xC100, 0x7BFF, 0x7C00, 0x0002,
+                                          0x0001, 0x3C01, 0x4248, 0x1419, 0xC700, 0x7C00};
+  std::vector<uint16_t> halves(values.size());
+  dlr::ConvertData(values.data(), kFloat32, halves.data(), kFloat16, values.size());
+  EXPECT_EQ(halves, expected);
+
+  std::vector<float> floats(halves.size());
+  dlr::ConvertData(halves.data(), kFloat16, floats.data(), kFloat32, halves.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (std::abs(values[i]) > 65504.0f) continue;
+    EXPECT_NEAR(floats[i], values[i], 1e-3 * std::abs(values[i]) + 1e-7);
+  }
+  EXPECT_TRUE(std::isinf(floats[5]));
+
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  uint16_t half;
+  dlr::ConvertData(&nan, kFloat32, &half, kFloat16, 1);
+  float back;
+  dlr::ConvertData(&half, kFloat16, &back, kFloat32, 1);
+  EXPECT_TRUE(std::isnan(back));
+}
+
+TEST(DataConvert, TestBFloat16) {
+  const std::vector<double> values = {1.0, -3.0, 1.00390625, 1.01171875, 3e38};
+  const std::vector<uint16_t> expected = {0x3F80, 0xC040, 0x3F80, 0x3F82, 0x7F62};
+  std::vector<uint16_t> bfloats(values.size());
+  dlr::ConvertData(values.data(), kFloat64, bfloats.data(), kBFloat16, values.size());
+  EXPECT_EQ(bfloats, expected);
+}
+
+TEST(DataConvert, TestIntegers) {
+  const std::vector<double> values = {-2.7, 0.0, 3.9, 255.0};
+  std::vector<int32_t> ints(values.size());
+  dlr::ConvertData(values.data(), kFloat64, ints.data(), kInt32, values.size());
+  EXPECT_EQ(ints, std::vector<int32_t>({-2, 0, 3, 255}));
+
+  const std::vector<uint8_t> bytes = {0, 7, 128, 255};
+  std::vector<float> floats(bytes.size());
+  dlr::ConvertData(bytes.data(), kUInt8, floats.data(), kFloat32, bytes.size());
+  EXPECT_EQ(floats, std::vector<float>({0.0f, 7.0f, 128.0f, 255.0f}));
+}
+
+TEST(DataConvert, TestQuantize) {
+  // Long enough for the vectorized loop and its remainder.
+  std::vector<float> values;
+  for (int i = 0; i < 75; ++i) values.push_back((i - 37) * 0.13f);
+  values.push_back(std::numeric_limits<float>::quiet_NaN());
+  values.push_back(1e10f);
+  const dlr::QuantizationParams params = {0.05f, 3};
+
+  std::vector<int8_t> ints(values.size());
+  dlr::QuantizeData(values.data(), kFloat32, ints.data(), {kDLInt, 8, 1}, values.size(), params);
+  std::vector<uint8_t> uints(values.size());
+  dlr::QuantizeData(values.data(), kFloat32, uints.data(), kUInt8, values.size(), params);
+  for (size_t i = 0; i + 2 < values.size(); ++i) {
+    const float expected = std::nearbyint(values[i] / params.scale) + params.zero_point;
+    EXPECT_EQ(ints[i], std::min(std::max(expected, -128.0f), 127.0f)) << i;
+    EXPECT_EQ(uints[i], std::min(std::max(expected, 0.0f), 255.0f)) << i;
+  }
+  EXPECT_EQ(ints[values.size() - 2], -128);
+  EXPECT_EQ(ints[values.size() - 1], 127);
+
+  std::vector<float> floats(values.size());
+  dlr::DequantizeData(uints.data(), kUInt8, floats.data(), kFloat32, uints.size(), params);
+  for (size_t i = 0; i + 2 < values.size(); ++i) {
+    EXPECT_FLOAT_EQ(floats[i], (uints[i] - params.zero_point) * params.scale) << i;
+  }
+  EXPECT_THROW(
+      dlr::QuantizeData(values.data(), kFloat32, floats.data(), kInt32, values.size(), params),
+      dmlc::Error);
+}
+
+TEST(DataConvert, TestCopyStridedData) {
+  std::vector<float> data(4 * 5 * 6);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = i;
+  int64_t shape[3] = {4, 5, 6};
+  int64_t strides[3] = {30, 6, 1};
+  DLTensor tensor = {data.data(), {kDLCPU, 0}, 3, kFloat32, shape, strides, 0};
+  EXPECT_TRUE(dlr::IsCompactTensor(tensor));
+
+  // Transposed to {6, 5, 4}: gathered element by element.
+  int64_t transposed_shape[3] = {6, 5, 4};
+  int64_t transposed_strides[3] = {1, 6, 30};
+  DLTensor transposed = {data.data(), {kDLCPU, 0}, 3, kFloat32, transposed_shape,
+                         transposed_strides, 0};
+  EXPECT_FALSE(dlr::IsCompactTensor(transposed));
+  std::vector<float> out(data.size());
+  dlr::CopyStridedData(transposed, out.data());
+  for (int i = 0; i < 6; ++i) {
+    for (int j = 0; j < 5; ++j) {
+      for (int k = 0; k < 4; ++k) EXPECT_EQ(out[(i * 5 + j) * 4 + k], data[k * 30 + j * 6 + i]);
+    }
+  }
+
+  // Rows 1 to 3 reversed, columns 2 to 5: copied by runs of 4 elements.
+  int64_t slice_shape[3] = {4, 3, 4};
+  int64_t slice_strides[3] = {30, -6, 1};
+  DLTensor slice = {data.data(), {kDLCPU, 0}, 3, kFloat32, slice_shape, slice_strides,
+                    (3 * 6 + 2) * sizeof(float)};
+  out.assign(4 * 3 * 4, 0);
+  dlr::CopyStridedData(slice, out.data());
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      for (int k = 0; k < 4; ++k) {
+        EXPECT_EQ(out[(i * 3 + j) * 4 + k], data[i * 30 + (3 - j) * 6 + 2 + k]);
+      }
+    }
+  }
+}
+
+TEST(DataConvert, TestSetDLRInputTyped) {
+  DLContext ctx = {kDLCPU, 0};
+  std::unique_ptr<dlr::TVMModel> model(
+      new dlr::TVMModel(dlr::FindFiles({"./resnet_v1_5_50"}), ctx));
+  DLRModelHandle handle = model.get();
+  const int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  std::vector<double> img64(img.begin(), img.end());
+
+  EXPECT_EQ(SetDLRInputTyped(&handle, "input_tensor", shape, img64.data(), 4, "float64"), 0);
+  std::vector<float> converted(img.size());
+  model->GetInput("input_tensor", converted.data());
+  EXPECT_EQ(converted, img);
+
+  EXPECT_EQ(SetDLRInputTyped(&handle, "input_tensor", shape, img64.data(), 3, "float64"), -1);
+  EXPECT_EQ(SetDLRInputTyped(&handle, "input_tensor", shape, img64.data(), 4, "complex"), -1);
+}
+
+TEST(DataConvert, TestQuantizationMetadata) {
+  DLContext ctx = {kDLCPU, 0};
+  std::unique_ptr<dlr::TVMModel> model(
+      new dlr::TVMModel(dlr::FindFiles({"./resnet_v1_5_50"}), ctx));
+  DLRModelHandle handle = model.get();
+  int quantized;
+  float scale;
+  int zero_point;
+  EXPECT_EQ(GetDLROutputQuantization(&handle, 0, &quantized, &scale, &zero_point), 0);
+  EXPECT_EQ(quantized, 0);
+  model->metadata_["Model"]["Outputs"][0]["quantization"] = {{"scale", 0.5}, {"zero_point", 7}};
+  EXPECT_EQ(GetDLROutputQuantization(&handle, 0, &quantized, &scale, &zero_point), 0);
+  EXPECT_EQ(quantized, 1);
+  EXPECT_EQ(scale, 0.5f);
+  EXPECT_EQ(zero_point, 7);
+  model->metadata_["Model"]["Outputs"][0]["quantization"] = {{"zero_point", 7}};
+  EXPECT_EQ(GetDLROutputQuantization(&handle, 0, &quantized, &scale, &zero_point), -1);
+  EXPECT_EQ(GetDLRInputQuantization(&handle, "input_tensor", &quantized, &scale, &zero_point), 0);
+  EXPECT_EQ(quantized, 0);
+
+  // Float outputs are converted, not dequantized.
+  const int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  model->SetInput("input_tensor", shape, img.data(), 4);
+  model->Run();
+  int64_t size;
+  int dim;
+  model->GetOutputSizeDim(1, &size, &dim);
+  std::vector<float> output(size);
+  model->GetOutput(1, output.data());
+  std::vector<double> output64(size);
+  EXPECT_EQ(GetDLROutputTyped(&handle, 1, output64.data(), "float64"), 0);
+  EXPECT_EQ(output64, std::vector<double>(output.begin(), output.end()));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+class ExecutionGroupTest : public ::testing::Test {
+ protected:
+  std::vector<float> img;
+  size_t img_size = 224 * 224 * 3;
+  const int64_t input_shape[4] = {1, 224, 224, 3};
+  const int input_dim = 4;
+  const int output_size = 1001;
+
+  ExecutionGroupTest() { img = LoadImageAndPreprocess("cat224-3.txt", img_size, 1); }
+
+  DLRModelHandle CreateModel() {
+    DLRModelHandle model = NULL;
+    EXPECT_EQ(CreateDLRModel(&model, "./resnet_v1_5_50", 1, 0), 0) << DLRGetLastError();
+    return model;
+  }
+
+  std::vector<float> Predict(DLRModelHandle* model) {
+    std::vector<float> output(output_size);
+    EXPECT_EQ(SetDLRInput(model, "input_tensor", input_shape, img.data(), input_dim), 0);
+    EXPECT_EQ(RunDLRModel(model), 0);
+    EXPECT_EQ(GetDLROutput(model, 1, output.data()), 0);
+    return output;
+  }
+};
+
+TEST_F(ExecutionGroupTest, TestSharedArena) {
+  DLRModelHandle model1 = CreateModel();
+  DLRModelHandle model2 = CreateModel();
+  std::vector<float> expected = Predict(&model1);
+
+  DLRExecutionGroupHandle group = NULL;
+  EXPECT_EQ(CreateDLRExecutionGroup(&group), 0);
+  EXPECT_EQ(JoinDLRExecutionGroup(&group, &model1), 0) << DLRGetLastError();
+  EXPECT_EQ(JoinDLRExecutionGroup(&group, &model2), 0) << DLRGetLastError();
+  EXPECT_EQ(JoinDLRExecutionGroup(&group, &model2), -1);
+
+  int64_t saved_bytes = 0;
+  int64_t arena_bytes = 0;
+  EXPECT_EQ(GetDLRExecutionGroupSavedBytes(&group, &saved_bytes, &arena_bytes), 0);
+  EXPECT_GT(arena_bytes, 0);
+  // Two identical models: the second one's activations are saved entirely.
+  EXPECT_EQ(saved_bytes, arena_bytes);
+
+  // Members overwrite each other's activations but not their outputs.
+  std::vector<float> output1 = Predict(&model1);
+  std::vector<float> output2 = Predict(&model2);
+  EXPECT_EQ(output1, expected);
+  EXPECT_EQ(output2, expected);
+  EXPECT_EQ(GetDLROutput(&model1, 1, output1.data()), 0);
+  EXPECT_EQ(output1, expected);
+
+  // The group outlives its handle as long as it has members.
+  EXPECT_EQ(DeleteDLRExecutionGroup(&group), 0);
+  EXPECT_EQ(DeleteDLRModel(&model1), 0);
+  EXPECT_EQ(Predict(&model2), expected);
+  EXPECT_EQ(DeleteDLRModel(&model2), 0);
+}
+
+TEST_F(ExecutionGroupTest, TestUnsupportedBackend) {
+  DLRModelHandle model = NULL;
+  EXPECT_EQ(CreateDLRModel(&model, "./xgboost_test", 1, 0), 0) << DLRGetLastError();
+  DLRExecutionGroupHandle group = NULL;
+  EXPECT_EQ(CreateDLRExecutionGroup(&group), 0);
+  EXPECT_EQ(JoinDLRExecutionGroup(&group, &model), -1);
+  EXPECT_EQ(DeleteDLRExecutionGroup(&group), 0);
+  EXPECT_EQ(DeleteDLRModel(&model), 0);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+#include "dlr_flight_recorder.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+class FlightRecorderTest : public ::testing::Test {
+ protected:
+  DLRModelHandle model = nullptr;
+  void SetUp() override { ASSERT_EQ(CreateDLRModel(&model, "./resnet_v1_5_50", 1, 0), 0); }
+  void TearDown() override { DeleteDLRModel(&model); }
+  dlr::DLRModel* GetModel() { return static_cast<dlr::DLRModel*>(model); }
+};
+
+TEST_F(FlightRecorderTest, TestPhases) {
+  dlr::FlightRecorder recorder(GetModel(), 4, 0);
+  EXPECT_TRUE(recorder.GetRecords().empty());
+  recorder.OnSetInput(100, 200, 2, 6);
+  recorder.OnSetInput(200, 300, 2, 4);
+  recorder.OnRun(400, 1000);
+  recorder.OnGetOutput(1100);
+  recorder.OnGetOutput(1200);
+  // A run without inputs set since the previous one is a request of its own.
+  recorder.OnRun(2000, 2500);
+
+  const std::vector<dlr::FlightRecord> records = recorder.GetRecords();
+  ASSERT_EQ(records.size(), 2);
+  EXPECT_EQ(records[0].request, 0);
+  EXPECT_EQ(records[0].batch_size, 2);
+  EXPECT_EQ(records[0].input_size, 10);
+  EXPECT_EQ(records[0].num_inputs, 2);
+  EXPECT_EQ(records[0].num_outputs, 2);
+  EXPECT_EQ(records[0].set_input_start, 100);
+  EXPECT_EQ(records[0].set_input_end, 300);
+  EXPECT_EQ(records[0].run_start, 400);
+  EXPECT_EQ(records[0].run_end, 1000);
+  EXPECT_EQ(records[0].get_output_end, 1200);
+  EXPECT_EQ(records[1].request, 1);
+  EXPECT_EQ(records[1].num_inputs, 0);
+  EXPECT_EQ(records[1].set_input_start, 0);
+  EXPECT_EQ(records[1].run_start, 2000);
+  EXPECT_EQ(records[1].get_output_end, 0);
+}
+
+TEST_F(FlightRecorderTest, TestWrap) {
+  dlr::FlightRecorder recorder(GetModel(), 3, 0);
+  for (uint64_t i = 0; i < 5; i++) {
+    recorder.OnSetInput(i * 10, i * 10 + 1, 1, 1);
+    recorder.OnRun(i * 10 + 2, i * 10 + 3);
+  }
+  const std::vector<dlr::FlightRecord> records = recorder.GetRecords();
+  ASSERT_EQ(records.size(), 3);
+  for (int i = 0; i < 3; i++) EXPECT_EQ(records[i].request, i + 2);
+}
+
+TEST_F(FlightRecorderTest, TestCAPI) {
+  EXPECT_EQ(DumpDLRFlightRecorder(&model, "flight_recorder.jsonl"), -1);
+  ASSERT_EQ(EnableDLRFlightRecorder(&model, 8, 0), 0);
+
+  int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  std::vector<float> output(1001);
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(SetDLRInput(&model, "input_tensor", shape, img.data(), 4), 0);
+    ASSERT_EQ(RunDLRModel(&model), 0);
+    ASSERT_EQ(GetDLROutput(&model, 1, output.data()), 0);
+  }
+  const std::vector<dlr::FlightRecord> records = GetModel()->GetFlightRecorder()->GetRecords();
+  ASSERT_EQ(records.size(), 2);
+  for (const dlr::FlightRecord& record : records) {
+    EXPECT_EQ(record.batch_size, 1);
+    EXPECT_EQ(record.input_size, 224 * 224 * 3);
+    EXPECT_EQ(record.num_outputs, 1);
+    EXPECT_LE(record.set_input_end, record.run_start);
+    EXPECT_LT(record.run_start, record.run_end);
+    EXPECT_LE(record.run_end, record.get_output_end);
+  }
+
+  std::remove("flight_recorder.jsonl");
+  ASSERT_EQ(DumpDLRFlightRecorder(&model, "flight_recorder.jsonl"), 0);
+  std::ifstream in("flight_recorder.jsonl");
+  std::string line;
+  int num_lines = 0;
+  while (std::getline(in, line)) {
+    EXPECT_NE(line.find("\"run_ms\""), std::string::npos);
+    num_lines++;
+  }
+  EXPECT_EQ(num_lines, 2);
+  std::remove("flight_recorder.jsonl");
+
+  ASSERT_EQ(EnableDLRFlightRecorder(&model, 0, 0), 0);
+  EXPECT_EQ(DumpDLRFlightRecorder(&model, "flight_recorder.jsonl"), -1);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+#include "dlr_fork.h"
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+namespace {
+
+const int64_t input_shape[4] = {1, 224, 224, 3};
+
+std::vector<float> RunModel(DLRModelHandle model) {
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  if (SetDLRInput(&model, "input_tensor", input_shape, img.data(), 4) != 0) return {};
+  if (RunDLRModel(&model) != 0) return {};
+  int64_t size;
+  int dim;
+  if (GetDLROutputSizeDim(&model, 0, &size, &dim) != 0) return {};
+  std::vector<float> output(size);
+  if (GetDLROutput(&model, 0, output.data()) != 0) return {};
+  return output;
+}
+
+/*! \brief Sum, over the read-only anonymous mappings of this process, of the pages resident and of
+ *  the pages private to it.
+ */
+void GetReadOnlyAnonymousMemory(size_t* rss_kb, size_t* private_kb) {
+  std::ifstream smaps("/proc/self/smaps");
+  std::string line;
+  bool read_only_anonymous = false;
+  *rss_kb = 0;
+  *private_kb = 0;
+  while (std::getline(smaps, line)) {
+    std::istringstream fields(line);
+    std::string key, perms, offset, dev, inode, path;
+    fields >> key;
+    if (key.back() != ':') {
+      fields >> perms >> offset >> dev >> inode >> path;
+      read_only_anonymous = perms == "r--p" && path.empty();
+      continue;
+    }
+    if (!read_only_anonymous) continue;
+    size_t kb;
+    fields >> kb;
+    if (key == "Rss:") *rss_kb += kb;
+    if (key == "Private_Clean:" || key == "Private_Dirty:") *private_kb += kb;
+  }
+}
+
+}  // namespace
+
+TEST(DLR, TestPreforkMode) {
+  EXPECT_EQ(SetDLRPreforkMode(1), 0);
+  DLRModelHandle model = nullptr;
+  ASSERT_EQ(CreateDLRModel(&model, "./resnet_v1_5_50", 1, 0), 0);
+  const std::vector<float> expected = RunModel(model);
+  ASSERT_FALSE(expected.empty());
+
+  ASSERT_EQ(DLRPrepareFork(), 0);
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    int code = 0;
+    if (DLRPostForkChild() != 0) code |= 1;
+    if (RunModel(model) != expected) code |= 2;
+    // The weights were not touched by the inference, so they are all still shared with the parent.
+    size_t rss_kb, private_kb;
+    GetReadOnlyAnonymousMemory(&rss_kb, &private_kb);
+    if (rss_kb < 10 * 1024 || private_kb != 0) code |= 4;
+    _exit(code);
+  }
+  EXPECT_EQ(DLRPostForkParent(), 0);
+  EXPECT_EQ(RunModel(model), expected);
+  int status;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+
+  DeleteDLRModel(&model);
+  EXPECT_EQ(SetDLRPreforkMode(0), 0);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+#include "dlr_input_window.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+namespace {
+
+std::vector<int> GetWindow(const dlr::InputWindow& window) {
+  const int* data = static_cast<const int*>(window.GetData());
+  return std::vector<int>(data, data + window.GetLength());
+}
+
+}  // namespace
+
+TEST(InputWindow, TestAppend) {
+  dlr::InputWindow window(4, sizeof(int));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(window.GetData()) % 64, 0);
+  EXPECT_EQ(GetWindow(window), std::vector<int>({0, 0, 0, 0}));
+  const std::vector<int> samples = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  window.Append(samples.data(), 3);
+  EXPECT_EQ(GetWindow(window), std::vector<int>({0, 1, 2, 3}));
+  window.Append(samples.data() + 3, 2);
+  EXPECT_EQ(GetWindow(window), std::vector<int>({2, 3, 4, 5}));
+  window.Append(samples.data(), samples.size());
+  EXPECT_EQ(GetWindow(window), std::vector<int>({6, 7, 8, 9}));
+  EXPECT_EQ(window.GetOffset(), 0);
+}
+
+TEST(InputWindow, TestUnalignedRows) {
+  // Rows of 3 bytes, so that the window starts at every misalignment.
+  const int64_t length = 5;
+  dlr::InputWindow window(length, 3);
+  std::vector<char> rows;
+  for (int i = 0; i < 200; i++) {
+    const char row[3] = {static_cast<char>(i), static_cast<char>(i + 1), static_cast<char>(i + 2)};
+    rows.insert(rows.end(), row, row + 3);
+    window.Append(row, 1);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(window.GetData()) % 64, 0);
+    std::vector<char> expected(length * 3, 0);
+    const size_t kept = std::min<size_t>(rows.size(), expected.size());
+    std::copy(rows.end() - kept, rows.end(), expected.end() - kept);
+    const char* data = static_cast<const char*>(window.GetData());
+    EXPECT_EQ(std::vector<char>(data, data + length * 3), expected);
+  }
+}
+
+TEST(InputWindow, TestRotated) {
+  std::vector<int> buffer(4, -1);
+  dlr::InputWindow window(4, sizeof(int), buffer.data());
+  EXPECT_EQ(buffer, std::vector<int>({0, 0, 0, 0}));
+  const std::vector<int> samples = {1, 2, 3, 4, 5, 6};
+  window.Append(samples.data(), 3);
+  EXPECT_EQ(buffer, std::vector<int>({1, 2, 3, 0}));
+  EXPECT_EQ(window.GetOffset(), 3);
+  window.Append(samples.data() + 3, 3);
+  EXPECT_EQ(buffer, std::vector<int>({5, 6, 3, 4}));
+  EXPECT_EQ(window.GetOffset(), 2);
+}
+
+TEST(InputWindow, TestTVMModel) {
+  DLRModelHandle model = nullptr;
+  ASSERT_EQ(CreateDLRModel(&model, "./resnet_v1_5_50", 1, 0), 0);
+  const int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  ASSERT_EQ(SetDLRInput(&model, "input_tensor", shape, img.data(), 4), 0);
+  ASSERT_EQ(RunDLRModel(&model), 0);
+  std::vector<float> expected(1001);
+  ASSERT_EQ(GetDLROutput(&model, 1, expected.data()), 0);
+
+  EXPECT_EQ(SetDLRInputWindow(&model, "input_tensor", 2, 0), -1);
+  const size_t row_size = 224 * 3;
+  for (int rotated = 0; rotated < 2; rotated++) {
+    // Image rows are samples.
+    ASSERT_EQ(SetDLRInputWindow(&model, "input_tensor", 1, rotated), 0);
+    ASSERT_EQ(AppendDLRInputWindow(&model, "input_tensor", img.data(), 100), 0);
+    ASSERT_EQ(AppendDLRInputWindow(&model, "input_tensor", img.data() + 100 * row_size, 124), 0);
+    int64_t offset;
+    ASSERT_EQ(GetDLRInputWindowOffset(&model, "input_tensor", &offset), 0);
+    EXPECT_EQ(offset, 0);
+    ASSERT_EQ(RunDLRModel(&model), 0);
+    std::vector<float> output(1001);
+    ASSERT_EQ(GetDLROutput(&model, 1, output.data()), 0);
+    EXPECT_EQ(output, expected);
+  }
+
+  // Rotated by 10 rows.
+  ASSERT_EQ(AppendDLRInputWindow(&model, "input_tensor", img.data(), 10), 0);
+  int64_t offset;
+  ASSERT_EQ(GetDLRInputWindowOffset(&model, "input_tensor", &offset), 0);
+  EXPECT_EQ(offset, 10);
+  DeleteDLRModel(&model);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,142 @@
+#include "dlr_metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+class MetricsTest : public ::testing::Test {
+ protected:
+  DLRModelHandle model = nullptr;
+  void SetUp() override { ASSERT_EQ(CreateDLRModel(&model, "./resnet_v1_5_50", 1, 0), 0); }
+  void TearDown() override { DeleteDLRModel(&model); }
+  dlr::DLRModel* GetModel() { return static_cast<dlr::DLRModel*>(model); }
+
+  std::string GetText() {
+    int64_t size = 0;
+    EXPECT_EQ(GetDLRMetricsText(nullptr, 0, &size), 0);
+    std::vector<char> buf(size);
+    EXPECT_EQ(GetDLRMetricsText(buf.data(), buf.size(), &size), 0);
+    return std::string(buf.data());
+  }
+};
+
+TEST_F(MetricsTest, TestCAPI) {
+  ASSERT_EQ(EnableDLRMetrics(&model, 1, "resnet"), 0);
+  int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  std::vector<float> output(1001);
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(SetDLRInput(&model, "input_tensor", shape, img.data(), 4), 0);
+    ASSERT_EQ(RunDLRModel(&model), 0);
+    ASSERT_EQ(GetDLROutput(&model, 1, output.data()), 0);
+  }
+  EXPECT_EQ(GetDLROutput(&model, 5, output.data()), -1);
+
+  const std::string text = GetText();
+  const std::string labels = "model=\"resnet\",backend=\"tvm\"";
+  EXPECT_NE(text.find("# TYPE dlr_latency_seconds histogram\n"), std::string::npos);
+  EXPECT_NE(text.find("dlr_requests_total{" + labels + "} 2\n"), std::string::npos);
+  EXPECT_NE(text.find("dlr_errors_total{" + labels + ",phase=\"get_output\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("dlr_errors_total{" + labels + ",phase=\"run\"} 0\n"), std::string::npos);
+  EXPECT_NE(text.find("dlr_latency_seconds_count{" + labels + ",phase=\"run\"} 2\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("dlr_latency_seconds_bucket{" + labels + ",phase=\"run\",le=\"+Inf\"} 2\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("dlr_batch_size_bucket{" + labels + ",le=\"1\"} 2\n"), std::string::npos);
+  EXPECT_NE(text.find("dlr_bytes_copied_total{" + labels + ",phase=\"set_input\"} " +
+                      std::to_string(2 * 224 * 224 * 3 * 4) + "\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("dlr_bytes_copied_total{" + labels + ",phase=\"get_output\"} " +
+                      std::to_string(2 * 1001 * 4) + "\n"),
+            std::string::npos);
+
+  int64_t size = 0;
+  char small[8];
+  EXPECT_EQ(GetDLRMetricsText(small, sizeof(small), &size), -1);
+  EXPECT_EQ(size, text.size() + 1);
+
+  ASSERT_EQ(EnableDLRMetrics(&model, 0, nullptr), 0);
+  EXPECT_EQ(GetText().find(labels), std::string::npos);
+}
+
+TEST_F(MetricsTest, TestTensorCalls) {
+  ASSERT_EQ(EnableDLRMetrics(&model, 1, "resnet"), 0);
+  int64_t input_shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  DLTensor input = {img.data(), {kDLCPU, 0}, 4, {kDLFloat, 32, 1}, input_shape, nullptr, 0};
+  int64_t output_shape[2] = {1, 1001};
+  std::vector<float> output(1001);
+  DLTensor out = {output.data(), {kDLCPU, 0}, 2, {kDLFloat, 32, 1}, output_shape, nullptr, 0};
+  ASSERT_EQ(SetDLRInputTensor(&model, "input_tensor", &input), 0);
+  ASSERT_EQ(RunDLRModel(&model), 0);
+  ASSERT_EQ(GetDLROutputTensor(&model, 1, &out), 0);
+  const void* ptr = nullptr;
+  ASSERT_EQ(GetDLROutputPtr(&model, 1, &ptr), 0);
+
+  const std::string text = GetText();
+  const std::string labels = "model=\"resnet\",backend=\"tvm\"";
+  EXPECT_NE(text.find("dlr_latency_seconds_count{" + labels + ",phase=\"set_input\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("dlr_latency_seconds_count{" + labels + ",phase=\"get_output\"} 2\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("dlr_bytes_copied_total{" + labels + ",phase=\"set_input\"} " +
+                      std::to_string(224 * 224 * 3 * 4) + "\n"),
+            std::string::npos);
+  // The output pointer is not a copy.
+  EXPECT_NE(text.find("dlr_bytes_copied_total{" + labels + ",phase=\"get_output\"} " +
+                      std::to_string(1001 * 4) + "\n"),
+            std::string::npos);
+}
+
+TEST_F(MetricsTest, TestDuplicateNames) {
+  ASSERT_EQ(EnableDLRMetrics(&model, 1, "resnet"), 0);
+  DLRModelHandle other = nullptr;
+  ASSERT_EQ(CreateDLRModel(&other, "./resnet_v1_5_50", 1, 0), 0);
+  // The series of both models would have the same labels.
+  EXPECT_EQ(EnableDLRMetrics(&other, 1, "resnet"), -1);
+  EXPECT_NE(std::string(DLRGetLastError()).find("distinct name"), std::string::npos);
+  EXPECT_EQ(EnableDLRMetrics(&other, 1, "resnet-2"), 0);
+  // A model can enable its metrics again under its own name.
+  EXPECT_EQ(EnableDLRMetrics(&model, 1, "resnet"), 0);
+  DeleteDLRModel(&other);
+}
+
+TEST_F(MetricsTest, TestConcurrentUpdates) {
+  dlr::ModelMetrics metrics(GetModel(), "a\"b\\c");
+  const int num_threads = 8;
+  const int num_calls = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&metrics]() {
+      for (int i = 0; i < num_calls; i++) metrics.OnCall(dlr::kMetricRun, 2000000, 0);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  const std::string text = dlr::GetMetricsText();
+  const std::string labels = "model=\"a\\\"b\\\\c\",backend=\"tvm\"";
+  const std::string count = std::to_string(num_threads * num_calls);
+  EXPECT_NE(text.find("dlr_requests_total{" + labels + "} " + count + "\n"), std::string::npos);
+  // 2 ms falls in the bucket of 2.5 ms.
+  EXPECT_NE(text.find("dlr_latency_seconds_bucket{" + labels + ",phase=\"run\",le=\"0.001\"} 0\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("dlr_latency_seconds_bucket{" + labels + ",phase=\"run\",le=\"0.0025\"} " +
+                      count + "\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("dlr_latency_seconds_sum{" + labels + ",phase=\"run\"} 160\n"),
+            std::string::npos);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,143 @@
+#include "dlr_module_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "dlr_tvm.h"
+#include "test_utils.hpp"
+
+namespace {
+
+void WriteFile(const std::string& path, const std::string& data) {
+  std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  out << data;
+}
+
+}  // namespace
+
+TEST(ModuleCache, TestSharesLiveEntries) {
+  dlr::ModuleCache<int> cache;
+  int num_loads = 0;
+  auto loader = [&num_loads]() {
+    num_loads++;
+    return std::make_shared<int>(42);
+  };
+  std::shared_ptr<int> a = cache.GetOrLoad("key", loader);
+  std::shared_ptr<int> b = cache.GetOrLoad("key", loader);
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_EQ(num_loads, 1);
+  EXPECT_EQ(cache.Size(), 1);
+
+  cache.GetOrLoad("other", loader);
+  EXPECT_EQ(num_loads, 2);
+  // Nobody holds "other", so it is not kept alive by the cache.
+  EXPECT_EQ(cache.Size(), 1);
+}
+
+TEST(ModuleCache, TestReloadsReleasedEntries) {
+  dlr::ModuleCache<int> cache;
+  int num_loads = 0;
+  auto loader = [&num_loads]() {
+    num_loads++;
+    return std::make_shared<int>(num_loads);
+  };
+  cache.GetOrLoad("key", loader).reset();
+  EXPECT_EQ(cache.Size(), 0);
+  std::shared_ptr<int> a = cache.GetOrLoad("key", loader);
+  EXPECT_EQ(num_loads, 2);
+  EXPECT_EQ(*a, 2);
+}
+
+TEST(ModuleCache, TestConcurrentLoads) {
+  dlr::ModuleCache<int> cache;
+  // A load of one key must not block the load of another: "slow" waits for "fast" to load.
+  std::promise<void> fast_loaded;
+  std::future<void> fast_done = fast_loaded.get_future();
+  std::shared_ptr<int> slow_entry;
+  std::thread slow([&cache, &fast_done, &slow_entry]() {
+    slow_entry = cache.GetOrLoad("slow", [&fast_done]() {
+      const bool ready = fast_done.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+      return std::make_shared<int>(ready ? 1 : 0);
+    });
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::shared_ptr<int> fast = cache.GetOrLoad("fast", []() { return std::make_shared<int>(2); });
+  fast_loaded.set_value();
+  slow.join();
+  EXPECT_EQ(*slow_entry, 1);
+
+  // Concurrent requests of one key load it once.
+  std::atomic<int> num_loads(0);
+  std::vector<std::shared_ptr<int>> entries(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < entries.size(); i++) {
+    threads.emplace_back([&cache, &num_loads, &entries, i]() {
+      entries[i] = cache.GetOrLoad("key", [&num_loads]() {
+        num_loads++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return std::make_shared<int>(3);
+      });
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(num_loads, 1);
+  for (const auto& entry : entries) EXPECT_EQ(entry.get(), entries[0].get());
+}
+
+TEST(ModuleCache, TestArtifactKey) {
+  const std::string path = "./dlr_module_cache_test.bin";
+  WriteFile(path, "compiled model v1");
+  const std::string key = dlr::GetArtifactKey(path);
+  EXPECT_EQ(dlr::GetArtifactKey(path), key);
+  // Replacing the file in place must change the key.
+  WriteFile(path, "compiled model v2");
+  EXPECT_NE(dlr::GetArtifactKey(path), key);
+  std::remove(path.c_str());
+  EXPECT_THROW(dlr::GetArtifactKey(path), dmlc::Error);
+
+  const std::string data = "compiled model v1";
+  EXPECT_EQ(dlr::GetArtifactKey(data.data(), data.size()),
+            dlr::GetArtifactKey(data.data(), data.size()));
+  EXPECT_NE(dlr::GetArtifactKey(data.data(), data.size()),
+            dlr::GetArtifactKey(data.data(), data.size() - 1));
+}
+
+TEST(ModuleCache, TestTVMModelsShareLibrary) {
+  DLContext ctx = {kDLCPU, 0};
+  std::vector<std::string> files = dlr::FindFiles({"./resnet_v1_5_50"});
+  const size_t num_modules = dlr::GetNumSharedTVMModules();
+  {
+    dlr::TVMModel model1(files, ctx);
+    dlr::TVMModel model2(files, ctx);
+    EXPECT_EQ(dlr::GetNumSharedTVMModules(), num_modules + 1);
+
+    // Both handles must still produce the same results.
+    size_t img_size = 224 * 224 * 3;
+    std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", img_size, 1);
+    const int64_t shape[4] = {1, 224, 224, 3};
+    std::vector<float> out1(1001), out2(1001);
+    for (dlr::TVMModel* model : {&model1, &model2}) {
+      model->SetInput("input_tensor", shape, img.data(), 4);
+      model->Run();
+    }
+    model1.GetOutput(1, out1.data());
+    model2.GetOutput(1, out2.data());
+    EXPECT_EQ(out1, out2);
+  }
+  EXPECT_EQ(dlr::GetNumSharedTVMModules(), num_modules);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
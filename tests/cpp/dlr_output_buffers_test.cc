@@ -0,0 +1,110 @@
+#include "dlr_output_buffers.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+TEST(OutputBuffers, TestTickets) {
+  dlr::OutputBuffers buffers(2);
+  EXPECT_EQ(buffers.GetLastTicket(), -1);
+  const int first_set = buffers.Reserve();
+  std::memcpy(buffers.GetBuffer(first_set, 0, sizeof(int)), &first_set, sizeof(int));
+  buffers.GetShape(first_set, 0) = {1};
+  const int64_t first = buffers.Publish(first_set);
+  EXPECT_EQ(buffers.GetLastTicket(), first);
+
+  // A failed run gives its set back.
+  buffers.Cancel(buffers.Reserve());
+  const int second_set = buffers.Reserve();
+  EXPECT_NE(second_set, first_set);
+  buffers.GetBuffer(second_set, 0, sizeof(int));
+  buffers.GetShape(second_set, 0) = {1};
+  const int64_t second = buffers.Publish(second_set);
+  EXPECT_NE(second, first);
+  EXPECT_EQ(*static_cast<const int*>(buffers.GetOutputPtr(first, 0)), first_set);
+  EXPECT_EQ(buffers.GetOutputShape(second, 0), std::vector<int64_t>({1}));
+  EXPECT_THROW(buffers.GetOutputPtr(second, 1), dmlc::Error);
+
+  // Both sets are held, so the next run waits for one to be released.
+  std::atomic<bool> reserved{false};
+  std::thread run([&]() {
+    buffers.Cancel(buffers.Reserve());
+    reserved = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(reserved);
+  buffers.Release(first);
+  run.join();
+  EXPECT_TRUE(reserved);
+  EXPECT_THROW(buffers.Release(first), dmlc::Error);
+  EXPECT_THROW(buffers.GetOutputPtr(first, 0), dmlc::Error);
+}
+
+TEST(OutputBuffers, TestPingPong) {
+  DLRModelHandle model = nullptr;
+  ASSERT_EQ(CreateDLRModel(&model, "./resnet_v1_5_50", 1, 0), 0);
+  const int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  std::vector<float> zeros(img.size(), 0.0f);
+  int64_t ticket;
+  EXPECT_EQ(GetDLROutputTicket(&model, &ticket), -1);
+  ASSERT_EQ(SetDLROutputBuffers(&model, 2), 0);
+  EXPECT_EQ(GetDLROutputTicket(&model, &ticket), -1);
+
+  int64_t size;
+  int dim;
+  ASSERT_EQ(GetDLROutputSizeDim(&model, 1, &size, &dim), 0);
+  std::vector<std::vector<float>> expected;
+  std::vector<int64_t> tickets;
+  for (const std::vector<float>* input : {&img, &zeros}) {
+    ASSERT_EQ(SetDLRInput(&model, "input_tensor", shape, input->data(), 4), 0);
+    ASSERT_EQ(RunDLRModel(&model), 0);
+    ASSERT_EQ(GetDLROutputTicket(&model, &ticket), 0);
+    tickets.push_back(ticket);
+    expected.emplace_back(size);
+    ASSERT_EQ(GetDLROutput(&model, 1, expected.back().data()), 0);
+  }
+  EXPECT_NE(expected[0], expected[1]);
+
+  // The outputs of the first run are still readable after the second one.
+  for (int i = 0; i < 2; i++) {
+    const void* out;
+    ASSERT_EQ(GetDLRTicketOutputPtr(&model, tickets[i], 1, &out), 0);
+    const float* data = static_cast<const float*>(out);
+    EXPECT_EQ(std::vector<float>(data, data + size), expected[i]);
+    std::vector<int64_t> output_shape(dim);
+    ASSERT_EQ(GetDLRTicketOutputShape(&model, tickets[i], 1, output_shape.data()), 0);
+    EXPECT_EQ(output_shape, std::vector<int64_t>({1, 1001}));
+  }
+
+  // A third run can only start once a ticket is released.
+  std::thread release([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ReleaseDLROutputs(&model, tickets[0]);
+  });
+  ASSERT_EQ(RunDLRModel(&model), 0);
+  release.join();
+  ASSERT_EQ(GetDLROutputTicket(&model, &ticket), 0);
+  const void* out;
+  EXPECT_EQ(GetDLRTicketOutputPtr(&model, tickets[0], 1, &out), -1);
+  EXPECT_EQ(ReleaseDLROutputs(&model, tickets[1]), 0);
+  EXPECT_EQ(ReleaseDLROutputs(&model, ticket), 0);
+
+  EXPECT_EQ(SetDLROutputBuffers(&model, 0), 0);
+  EXPECT_EQ(RunDLRModel(&model), 0);
+  DeleteDLRModel(&model);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,95 @@
+#include "dlr_perf_counters.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+namespace {
+
+// Hosts without a PMU, e.g. some virtual machines, or forbidding perf_event_open() cannot count.
+bool HasPerfCounters() {
+  try {
+    dlr::PerfCounters counters;
+    return true;
+  } catch (dmlc::Error& e) {
+    LOG(INFO) << "Skipping: " << e.what();
+    return false;
+  }
+}
+
+}  // namespace
+
+TEST(PerfCounters, TestCount) {
+  if (!HasPerfCounters()) return;
+  dlr::PerfCounters counters;
+  int64_t values[dlr::kNumPerfCounters];
+  EXPECT_EQ(counters.Get(values), 0);
+
+  // A thread started before the run is counted as well as the calling thread.
+  volatile bool start = false;
+  volatile double sum = 0;
+  std::thread worker([&]() {
+    while (!start) std::this_thread::yield();
+    for (int i = 0; i < 10000000; i++) sum += i;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  dlr::PerfCounters::Counts run = counters.Start();
+  start = true;
+  worker.join();
+  counters.Stop(run);
+  EXPECT_EQ(counters.Get(values), 1);
+  for (int i = 0; i < dlr::kNumPerfCounters; i++) EXPECT_GE(values[i], -1);
+  if (values[dlr::kPerfInstructions] >= 0) EXPECT_GT(values[dlr::kPerfInstructions], 10000000);
+}
+
+TEST(PerfCounters, TestThreadStartedDuringRun) {
+  if (!HasPerfCounters()) return;
+  dlr::PerfCounters counters;
+  // A thread started and finished within the run is counted, its counts remain once it exited.
+  volatile double sum = 0;
+  dlr::PerfCounters::Counts run = counters.Start();
+  std::thread([&]() {
+    for (int i = 0; i < 10000000; i++) sum += i;
+  }).join();
+  counters.Stop(run);
+  int64_t values[dlr::kNumPerfCounters];
+  EXPECT_EQ(counters.Get(values), 1);
+  if (values[dlr::kPerfInstructions] >= 0) EXPECT_GT(values[dlr::kPerfInstructions], 10000000);
+}
+
+TEST(PerfCounters, TestModel) {
+  if (!HasPerfCounters()) return;
+  DLRModelHandle model = nullptr;
+  ASSERT_EQ(CreateDLRModel(&model, "./resnet_v1_5_50", 1, 0), 0);
+  int64_t counters[5];
+  int64_t num_runs;
+  EXPECT_EQ(GetDLRPerfCounters(&model, counters, &num_runs), -1);
+  ASSERT_EQ(EnableDLRPerfCounters(&model, 1), 0);
+  const int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  ASSERT_EQ(SetDLRInput(&model, "input_tensor", shape, img.data(), 4), 0);
+  for (int i = 0; i < 2; i++) ASSERT_EQ(RunDLRModel(&model), 0);
+  ASSERT_EQ(GetDLRPerfCounters(&model, counters, &num_runs), 0);
+  EXPECT_EQ(num_runs, 2);
+  if (counters[0] >= 0) EXPECT_GT(counters[0], 0);
+
+  // Enabling again resets the counts.
+  ASSERT_EQ(EnableDLRPerfCounters(&model, 1), 0);
+  ASSERT_EQ(GetDLRPerfCounters(&model, counters, &num_runs), 0);
+  EXPECT_EQ(num_runs, 0);
+  ASSERT_EQ(EnableDLRPerfCounters(&model, 0), 0);
+  EXPECT_EQ(GetDLRPerfCounters(&model, counters, &num_runs), -1);
+  DeleteDLRModel(&model);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "test_utils.hpp"
 
 int main(int argc, char** argv) {
@@ -135,3 +137,27 @@ TEST_F(RelayVMTest, TestGetOutput) {
     EXPECT_EQ(output3_p[i], output3[i]);
   }
 }
+
+TEST_F(RelayVMTest, TestSharedExecutable) {
+  const size_t num_executables = dlr::GetNumSharedRelayVMExecutables();
+  DLContext ctx = {kDLCPU, 0};
+  std::vector<std::string> files = dlr::FindFiles({"./ssd_mobilenet_v1"});
+  dlr::RelayVMModel model2(files, ctx);
+  EXPECT_EQ(dlr::GetNumSharedRelayVMExecutables(), num_executables);
+
+  // Each VM keeps its own registers, so both can run at the same time.
+  std::vector<float> output1(100), output2(100);
+  std::thread thread1([&]() {
+    model->SetInput("image_tensor", input_shape, img.data(), input_dim);
+    model->Run();
+    model->GetOutput(3, output1.data());
+  });
+  std::thread thread2([&]() {
+    model2.SetInput("image_tensor", input_shape, img.data(), input_dim);
+    model2.Run();
+    model2.GetOutput(3, output2.data());
+  });
+  thread1.join();
+  thread2.join();
+  EXPECT_EQ(output1, output2);
+}
@@ -0,0 +1,196 @@
+#include "dlr_serve.h"
+
+#include <gtest/gtest.h>
+
+#if !defined(_WIN32) && !defined(__ANDROID__)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !_WIN32 && !__ANDROID__
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+#if !defined(_WIN32) && !defined(__ANDROID__)
+
+class ServeTest : public ::testing::Test {
+ protected:
+  const std::string socket_path = "/tmp/dlr_serve_test_" + std::to_string(getpid()) + ".sock";
+  DLRModelHandle model = nullptr;
+  dlr::ModelServer server;
+  dlr::ServeTensor input;
+  std::vector<float> expected = std::vector<float>(1001);
+
+  void SetUp() override {
+    ASSERT_EQ(CreateDLRModel(&model, "./resnet_v1_5_50", 1, 0), 0);
+    std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+    input.shape = {1, 224, 224, 3};
+    input.data.resize(img.size() * sizeof(float));
+    std::memcpy(input.data.data(), img.data(), input.data.size());
+    ASSERT_EQ(SetDLRInput(&model, "input_tensor", input.shape.data(), img.data(), 4), 0);
+    ASSERT_EQ(RunDLRModel(&model), 0);
+    ASSERT_EQ(GetDLROutput(&model, 1, expected.data()), 0);
+
+    // The server shares the model, which outlives it.
+    dlr::DLRModelPtr instance(static_cast<dlr::DLRModel*>(model), [](dlr::DLRModel*) {});
+    server.AddModel("resnet", {instance});
+    server.Start(socket_path);
+  }
+  void TearDown() override {
+    server.Stop();
+    DeleteDLRModel(&model);
+  }
+
+  void ExpectOutputs(const std::vector<dlr::ServeTensor>& outputs) {
+    ASSERT_EQ(outputs.size(), 2);
+    EXPECT_EQ(outputs[1].shape, std::vector<int64_t>({1, 1001}));
+    ASSERT_EQ(outputs[1].data.size(), expected.size() * sizeof(float));
+    const float* output = reinterpret_cast<const float*>(outputs[1].data.data());
+    for (size_t i = 0; i < expected.size(); i++) EXPECT_EQ(output[i], expected[i]);
+  }
+};
+
+TEST_F(ServeTest, TestInfer) {
+  dlr::ServeClient client(socket_path);
+  const dlr::ServeModelInfo& info = client.GetModelInfo("resnet");
+  ASSERT_EQ(info.inputs.size(), 1);
+  EXPECT_EQ(info.inputs[0].name, "input_tensor");
+  EXPECT_EQ(info.inputs[0].dtype, "float32");
+  EXPECT_EQ(info.inputs[0].shape, input.shape);
+  ASSERT_EQ(info.outputs.size(), 2);
+  EXPECT_EQ(info.outputs[1].dtype, "float32");
+  ExpectOutputs(client.Infer("resnet", {input}));
+}
+
+TEST_F(ServeTest, TestPipelinedRequests) {
+  // Room for two requests, so that later ones wait for earlier responses and wrap around.
+  dlr::ServeClient client(socket_path, 2 * (input.data.size() + 8192));
+  std::vector<uint64_t> ids;
+  for (int i = 0; i < 5; i++) ids.push_back(client.Submit("resnet", {input}));
+  for (uint64_t id : ids) ExpectOutputs(client.Wait(id));
+  EXPECT_THROW(client.Wait(ids[0]), dmlc::Error);
+}
+
+TEST_F(ServeTest, TestMixedRequestSizes) {
+  const size_t ring_bytes = 2 * (input.data.size() + 8192);
+  dlr::ServeClient client(socket_path, ring_bytes);
+  ExpectOutputs(client.Infer("resnet", {input}));
+  // Neither fits before the end of the ring nor before the previous region, but the ring is idle.
+  ExpectOutputs(client.Infer("resnet", {input}, ring_bytes - input.data.size()));
+  std::vector<uint64_t> ids;
+  for (size_t output_bytes : {8192, 100000, 8192, 400000, 8192}) {
+    ids.push_back(client.Submit("resnet", {input}, output_bytes));
+  }
+  for (uint64_t id : ids) ExpectOutputs(client.Wait(id));
+}
+
+TEST_F(ServeTest, TestErrors) {
+  dlr::ServeClient client(socket_path);
+  EXPECT_THROW(client.GetModelInfo("unknown"), dmlc::Error);
+
+  dlr::ServeTensor bad = input;
+  bad.data.resize(16);
+  EXPECT_THROW(client.Infer("resnet", {bad}), dmlc::Error);
+  // Too little room for the outputs.
+  EXPECT_THROW(client.Infer("resnet", {input}, 64), dmlc::Error);
+  // Dimensions whose product overflows to the size of the data.
+  dlr::ServeTensor overflow;
+  overflow.shape = {int64_t{1} << 62, 224, 224, 3};
+  EXPECT_THROW(client.Infer("resnet", {overflow}, 8192), dmlc::Error);
+  // The connection is still usable after failed requests.
+  ExpectOutputs(client.Infer("resnet", {input}));
+}
+
+TEST(Serve, TestBatching) {
+  // A batch-variant model of batch 1 runs batches of any size one row at a time.
+  const std::string model_dir = "./resnet_serve_batch";
+  const std::string manifest = model_dir + "/dlr_batch_variants.json";
+  mkdir(model_dir.c_str(), 0755);
+  {
+    std::ofstream out(manifest);
+    out << R"({"BatchVariants": [{"batch_size": 1, "path": "../resnet_v1_5_50"}]})";
+  }
+  DLRModelHandle model = nullptr;
+  ASSERT_EQ(CreateDLRModel(&model, model_dir.c_str(), 1, 0), 0) << DLRGetLastError();
+  std::remove(manifest.c_str());
+  rmdir(model_dir.c_str());
+
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  const int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> expected(1001);
+  ASSERT_EQ(SetDLRInput(&model, "input_tensor", shape, img.data(), 4), 0);
+  ASSERT_EQ(RunDLRModel(&model), 0);
+  ASSERT_EQ(GetDLROutput(&model, 1, expected.data()), 0);
+
+  const std::string socket_path =
+      "/tmp/dlr_serve_batch_test_" + std::to_string(getpid()) + ".sock";
+  dlr::ModelServer server;
+  dlr::DLRModelPtr instance(static_cast<dlr::DLRModel*>(model), [](dlr::DLRModel*) {});
+  // Requests queued within 100 ms are batched, up to 4 rows.
+  server.AddModel("resnet", {instance}, 4, 100000);
+  server.Start(socket_path);
+  {
+    dlr::ServeClient client(socket_path);
+    const size_t image_bytes = img.size() * sizeof(float);
+    std::vector<dlr::ServeTensor> inputs;
+    for (int64_t rows : {1, 2, 1, 3}) {
+      dlr::ServeTensor input;
+      input.shape = {rows, 224, 224, 3};
+      input.data.resize(rows * image_bytes);
+      for (int64_t r = 0; r < rows; r++) {
+        std::memcpy(input.data.data() + r * image_bytes, img.data(), image_bytes);
+      }
+      inputs.push_back(input);
+    }
+    // Outputs of the batch-variant model have a dynamic batch, so their room is given.
+    const size_t output_bytes = 3 * 1024 * sizeof(float) + 3 * 64;
+    std::vector<uint64_t> ids;
+    for (const dlr::ServeTensor& input : inputs) {
+      ids.push_back(client.Submit("resnet", {input}, output_bytes));
+    }
+    // A request without rows is not batched and fails on its own.
+    dlr::ServeTensor empty;
+    empty.shape = {0, 224, 224, 3};
+    const uint64_t empty_id = client.Submit("resnet", {empty}, output_bytes);
+
+    for (size_t i = 0; i < ids.size(); i++) {
+      const std::vector<dlr::ServeTensor> outputs = client.Wait(ids[i]);
+      ASSERT_EQ(outputs.size(), 2);
+      const int64_t rows = inputs[i].shape[0];
+      EXPECT_EQ(outputs[1].shape, std::vector<int64_t>({rows, 1001}));
+      ASSERT_EQ(outputs[1].data.size(), rows * expected.size() * sizeof(float));
+      const float* output = reinterpret_cast<const float*>(outputs[1].data.data());
+      for (int64_t r = 0; r < rows; r++) {
+        for (size_t j = 0; j < expected.size(); j++) {
+          EXPECT_EQ(output[r * expected.size() + j], expected[j]);
+        }
+      }
+    }
+    EXPECT_THROW(client.Wait(empty_id), dmlc::Error);
+  }
+  server.Stop();
+  DeleteDLRModel(&model);
+}
+
+#else  // !_WIN32 && !__ANDROID__
+
+TEST(Serve, TestNotSupported) {
+  dlr::ModelServer server;
+  EXPECT_THROW(server.Start("dlr_serve_test.sock"), dmlc::Error);
+  EXPECT_THROW(dlr::ServeClient client("dlr_serve_test.sock"), dmlc::Error);
+}
+
+#endif  // !_WIN32 && !__ANDROID__
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+#include "dlr_session.h"
+
+#include <gtest/gtest.h>
+
+#include "dlr.h"
+#include "test_utils.hpp"
+
+TEST(DLR, TestSessionBindings) {
+  DLRModelHandle model = nullptr;
+  ASSERT_EQ(CreateDLRModel(&model, "./resnet_v1_5_50", 1, 0), 0);
+  const char* output_name;
+  ASSERT_EQ(GetDLROutputName(&model, 1, &output_name), 0);
+  const char* input_name = "input_tensor";
+
+  // The output does not have the shape of the input it would feed.
+  DLRSessionHandle session = nullptr;
+  EXPECT_EQ(CreateDLRSession(&session, &model, 1, &output_name, &input_name), -1);
+  EXPECT_NE(std::string(DLRGetLastError()).find("does not have the shape"), std::string::npos);
+  const char* unknown_name = "h_in";
+  EXPECT_EQ(CreateDLRSession(&session, &model, 1, &output_name, &unknown_name), -1);
+  EXPECT_EQ(CreateDLRSession(&session, &model, 1, &unknown_name, &input_name), -1);
+
+  // Without states, a session runs the model as usual.
+  ASSERT_EQ(CreateDLRSession(&session, &model, 0, nullptr, nullptr), 0);
+  const int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  ASSERT_EQ(SetDLRInput(&model, input_name, shape, img.data(), 4), 0);
+  EXPECT_EQ(RunDLRSession(&session), 0);
+  float state;
+  EXPECT_EQ(GetDLRSessionState(&session, input_name, &state), -1);
+  EXPECT_EQ(DeleteDLRSession(&session), 0);
+  DeleteDLRModel(&model);
+}
+
+namespace {
+
+// Graph with inputs x and h_in, in that order, copied to outputs y and h_out by the runtime's
+// builtin __copy op. Sorted by name, h_in is DLR input 0 but graph input 1.
+const char* kCopyGraph = R"({
+  "nodes": [
+    {"op": "null", "name": "x", "inputs": []},
+    {"op": "null", "name": "h_in", "inputs": []},
+    {"op": "tvm_op", "name": "y", "inputs": [[0, 0, 0]],
+     "attrs": {"func_name": "__copy", "num_inputs": "1", "num_outputs": "1",
+               "flatten_data": "0"}},
+    {"op": "tvm_op", "name": "h_out", "inputs": [[1, 0, 0]],
+     "attrs": {"func_name": "__copy", "num_inputs": "1", "num_outputs": "1",
+               "flatten_data": "0"}}
+  ],
+  "arg_nodes": [0, 1],
+  "node_row_ptr": [0, 1, 2, 3, 4],
+  "heads": [[2, 0, 0], [3, 0, 0]],
+  "attrs": {
+    "dltype": ["list_str", ["float32", "float32", "float32", "float32"]],
+    "shape": ["list_shape", [[1, 4], [1, 4], [1, 4], [1, 4]]],
+    "storage_id": ["list_int", [0, 1, 2, 3]]
+  }
+})";
+
+const char* kCopyMetadata = R"({"Model": {"Outputs": [{"name": "y"}, {"name": "h_out"}]}})";
+
+// Params without any weights: magic, reserved, no names and no arrays.
+const uint64_t kNoParams[4] = {0xF7E58D4F05049CB7, 0, 0, 0};
+
+}  // namespace
+
+TEST(DLR, TestSessionStates) {
+  const std::string so_file = "./resnet_v1_5_50/compiled.so";
+  std::vector<DLRModelElem> model_elems = {
+      {DLRModelElemType::TVM_GRAPH, nullptr, kCopyGraph, 0},
+      {DLRModelElemType::TVM_PARAMS, nullptr, kNoParams, sizeof(kNoParams)},
+      {DLRModelElemType::TVM_LIB, so_file.c_str(), nullptr, 0},
+      {DLRModelElemType::NEO_METADATA, nullptr, kCopyMetadata, 0}};
+  DLRModelHandle model = nullptr;
+  ASSERT_EQ(CreateDLRModelFromModelElem(&model, model_elems.data(), model_elems.size(), 1, 0), 0)
+      << DLRGetLastError();
+  const char* input_name;
+  ASSERT_EQ(GetDLRInputName(&model, 0, &input_name), 0);
+  EXPECT_STREQ(input_name, "h_in");
+
+  const char* output_name = "h_out";
+  DLRSessionHandle session = nullptr;
+  ASSERT_EQ(CreateDLRSession(&session, &model, 1, &output_name, &input_name), 0)
+      << DLRGetLastError();
+  const int64_t shape[2] = {1, 4};
+  const std::vector<float> x = {1, 2, 3, 4};
+  const std::vector<float> saved = {5, 6, 7, 8};
+  std::vector<float> state(4), y(4);
+
+  // States start at zero and are fed to h_in, not to the graph's first input.
+  ASSERT_EQ(SetDLRInput(&model, "x", shape, x.data(), 2), 0);
+  EXPECT_EQ(RunDLRSession(&session), 0);
+  EXPECT_EQ(GetDLROutput(&model, 0, y.data()), 0);
+  EXPECT_EQ(y, x);
+  EXPECT_EQ(GetDLRSessionState(&session, "h_in", state.data()), 0);
+  EXPECT_EQ(state, std::vector<float>(4, 0));
+
+  // A restored state carries over from one run to the next.
+  EXPECT_EQ(SetDLRSessionState(&session, "h_in", saved.data()), 0);
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(RunDLRSession(&session), 0);
+    EXPECT_EQ(GetDLROutput(&model, 0, y.data()), 0);
+    EXPECT_EQ(y, x);
+    EXPECT_EQ(GetDLROutput(&model, 1, state.data()), 0);
+    EXPECT_EQ(state, saved);
+    EXPECT_EQ(GetDLRSessionState(&session, "h_in", state.data()), 0);
+    EXPECT_EQ(state, saved);
+  }
+
+  EXPECT_EQ(ResetDLRSession(&session), 0);
+  EXPECT_EQ(RunDLRSession(&session), 0);
+  EXPECT_EQ(GetDLROutput(&model, 1, state.data()), 0);
+  EXPECT_EQ(state, std::vector<float>(4, 0));
+  EXPECT_EQ(DeleteDLRSession(&session), 0);
+  DeleteDLRModel(&model);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+#include "dlr_shared_weights.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#include "dlr.h"
+#include "dlr_module_cache.h"
+#include "dlr_tvm.h"
+#include "test_utils.hpp"
+
+class SharedWeightsTest : public ::testing::Test {
+ protected:
+  const std::string model_path = "./resnet_v1_5_50";
+  const std::string params_file = "./resnet_v1_5_50/compiled.params";
+  const int64_t input_shape[4] = {1, 224, 224, 3};
+  DLContext ctx = {kDLCPU, 0};
+  std::string segment_name;
+
+  SharedWeightsTest() {
+    segment_name = dlr::GetSharedWeightSegmentName(dlr::GetSharedWeightKey(params_file));
+    shm_unlink(("/" + segment_name).c_str());
+  }
+
+  ~SharedWeightsTest() {
+    dlr::SetSharedWeightStore("");
+    shm_unlink(("/" + segment_name).c_str());
+  }
+
+  dlr::TVMModel* CreateModel() { return new dlr::TVMModel(dlr::FindFiles({model_path}), ctx); }
+
+  std::vector<float> Run(dlr::TVMModel* model) {
+    std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+    model->SetInput("input_tensor", input_shape, img.data(), 4);
+    model->Run();
+    int64_t size;
+    int dim;
+    model->GetOutputSizeDim(0, &size, &dim);
+    std::vector<float> output(size);
+    model->GetOutput(0, output.data());
+    return output;
+  }
+};
+
+TEST_F(SharedWeightsTest, TestShareWeights) {
+  std::unique_ptr<dlr::TVMModel> private_model(CreateModel());
+  const std::vector<float> expected = Run(private_model.get());
+
+  EXPECT_EQ(SetDLRSharedWeightStore(dlr::SHARED_WEIGHTS_SHM), 0);
+  // The first model populates the segment, the second one maps it.
+  std::unique_ptr<dlr::TVMModel> creator(CreateModel());
+  struct stat st;
+  EXPECT_EQ(stat(("/dev/shm/" + segment_name).c_str(), &st), 0);
+  std::unique_ptr<dlr::TVMModel> attached(CreateModel());
+
+  EXPECT_EQ(creator->GetNumInputs(), 1);
+  EXPECT_EQ(attached->GetNumInputs(), 1);
+  EXPECT_EQ(attached->GetNumWeights(), private_model->GetNumWeights());
+  EXPECT_EQ(attached->GetWeightNames(), private_model->GetWeightNames());
+  EXPECT_EQ(Run(creator.get()), expected);
+  EXPECT_EQ(Run(attached.get()), expected);
+}
+
+TEST_F(SharedWeightsTest, TestAbandonedSegment) {
+  std::unique_ptr<dlr::TVMModel> private_model(CreateModel());
+  const std::vector<float> expected = Run(private_model.get());
+
+  // A segment left unpopulated and unlocked, as by a creator which died.
+  const int fd = shm_open(("/" + segment_name).c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  ASSERT_GE(fd, 0);
+  EXPECT_EQ(ftruncate(fd, 4096), 0);
+  struct stat abandoned;
+  EXPECT_EQ(fstat(fd, &abandoned), 0);
+  close(fd);
+
+  EXPECT_EQ(SetDLRSharedWeightStore(dlr::SHARED_WEIGHTS_SHM), 0);
+  const auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<dlr::TVMModel> model(CreateModel());
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+  // The segment was replaced by a populated one.
+  struct stat st;
+  EXPECT_EQ(stat(("/dev/shm/" + segment_name).c_str(), &st), 0);
+  EXPECT_NE(st.st_ino, abandoned.st_ino);
+  EXPECT_EQ(Run(model.get()), expected);
+}
+
+TEST_F(SharedWeightsTest, TestInvalidStore) {
+  EXPECT_THROW(dlr::SetSharedWeightStore("./resnet_v1_5_50/compiled.params"), dmlc::Error);
+  EXPECT_EQ(SetDLRSharedWeightStore(nullptr), 0);
+  EXPECT_EQ(dlr::GetSharedWeightStore(), "");
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}
@@ -384,6 +384,31 @@ TEST(DLR, TestSetInputTensorZeroCopy_TVM) {
   DeleteDLRModel(&model);
 }
 
+TEST(DLR, TestSetInputTensorStrided_TVM) {
+  auto model = GetDLRModel();
+  int64_t shape[4] = {1, 224, 224, 3};
+  std::vector<float> img = LoadImageAndPreprocess("cat224-3.txt", 224 * 224 * 3, 1);
+  EXPECT_EQ(SetDLRInput(&model, "input_tensor", shape, img.data(), 4), 0);
+  EXPECT_EQ(RunDLRModel(&model), 0);
+  std::vector<float> expected(1001);
+  EXPECT_EQ(GetDLROutput(&model, 1, expected.data()), 0);
+
+  // The image is a view of the first 3 channels of a 4-channel image.
+  std::vector<float> rgba(224 * 224 * 4);
+  for (size_t i = 0; i < 224 * 224; ++i) {
+    std::copy(&img[i * 3], &img[i * 3] + 3, &rgba[i * 4]);
+  }
+  int64_t strides[4] = {224 * 224 * 4, 224 * 4, 4, 1};
+  DLTensor input = {rgba.data(), {kDLCPU, 0}, 4, {kDLFloat, 32, 1}, shape, strides, 0};
+  EXPECT_EQ(SetDLRInputTensor(&model, "input_tensor", &input), 0);
+  EXPECT_EQ(SetDLRInputTensorZeroCopy(&model, "input_tensor", &input), -1);
+  EXPECT_EQ(RunDLRModel(&model), 0);
+  std::vector<float> output(1001);
+  EXPECT_EQ(GetDLROutput(&model, 1, output.data()), 0);
+  EXPECT_EQ(output, expected);
+  DeleteDLRModel(&model);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
 #ifndef _WIN32
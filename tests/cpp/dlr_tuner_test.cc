@@ -0,0 +1,87 @@
+#include "dlr_tuner.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+
+#include "dlr.h"
+#include "dlr_tvm.h"
+
+TEST(DLR, TestTunedConfigFile) {
+  dlr::TunedConfig config;
+  config.instances = 2;
+  config.threads = 4;
+  config.batch_size = 8;
+  config.throughput = 123.5;
+  config.p99_ms = 7.25;
+  const std::string path = "./dlr_tuned_config_test.json";
+  dlr::WriteTunedConfig(path, config);
+  const dlr::TunedConfig read = dlr::ReadTunedConfig(path);
+  EXPECT_EQ(read.instances, 2);
+  EXPECT_EQ(read.threads, 4);
+  EXPECT_EQ(read.batch_size, 8);
+  EXPECT_DOUBLE_EQ(read.throughput, 123.5);
+  EXPECT_DOUBLE_EQ(read.p99_ms, 7.25);
+  std::remove(path.c_str());
+}
+
+TEST(DLR, TestTuneDLRModel) {
+  // Batch size 4 is skipped, the model has a static batch size of 1.
+  const int64_t batch_sizes[2] = {1, 4};
+  const std::string path = "./dlr_tuned_config_test.json";
+  int instances = 0;
+  int threads = 0;
+  int64_t batch_size = 0;
+  ASSERT_EQ(TuneDLRModel("./resnet_v1_5_50", 1, 0, batch_sizes, 2, 2.0f, 0.0f, path.c_str(),
+                         &instances, &threads, &batch_size),
+            0);
+  EXPECT_GE(instances, 1);
+  EXPECT_GE(threads, 1);
+  EXPECT_EQ(batch_size, 1);
+  const dlr::TunedConfig config = dlr::ReadTunedConfig(path);
+  EXPECT_EQ(config.instances, instances);
+  EXPECT_EQ(config.threads, threads);
+  EXPECT_GT(config.throughput, 0);
+  std::remove(path.c_str());
+
+  EXPECT_EQ(GetDLRTunedConfig("./resnet_v1_5_50", &instances, &threads, &batch_size), -1);
+}
+
+TEST(DLR, TestTuneModelCombinations) {
+  dlr::TunerOptions options;
+  options.instances = {1, 2, 4};
+  options.threads = {1, 2};
+  options.time_budget = 2.0;
+  options.max_total_threads = 2;
+  int created = 0;
+  auto create = [&created]() -> dlr::DLRModelPtr {
+    created++;
+    return std::make_shared<dlr::TVMModel>(dlr::FindFiles({"./resnet_v1_5_50"}),
+                                           DLContext{kDLCPU, 0});
+  };
+  std::vector<dlr::TunedConfig> results;
+  const dlr::TunedConfig best = dlr::TuneModel(create, options, &results);
+  // 4 instances exceed the limit on their own, so no more than 2 are loaded.
+  EXPECT_EQ(created, 2);
+  // 1x1, 1x2 and 2x1, unless the model's threads are not tunable.
+  EXPECT_GE(results.size(), 2);
+  for (const dlr::TunedConfig& config : results) {
+    EXPECT_LE(config.instances * config.threads, 2);
+    EXPECT_GT(config.throughput, 0);
+    EXPECT_GT(config.p99_ms, 0);
+  }
+  EXPECT_LE(best.instances * best.threads, 2);
+
+  options.max_total_threads = 0;
+  options.instances = {0};
+  EXPECT_THROW(dlr::TuneModel(create, options), dmlc::Error);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+#ifndef _WIN32
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+#endif  // _WIN32
+  return RUN_ALL_TESTS();
+}